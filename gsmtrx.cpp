@@ -25,7 +25,8 @@
 using namespace TelEngine;
 namespace { // anonymous
 
-class GsmTrxQMF;                         // The transceiver
+class GsmTrxQMF;                         // The transceiver (QMF channelizer)
+class GsmTrxPFB;                         // The transceiver (polyphase filter bank channelizer)
 class GsmTrxModule;                      // The module
 
 
@@ -52,6 +53,15 @@ protected:
     virtual void syncGSMTimeSent(const GSMTime& time);
 };
 
+class GsmTrxPFB : public TransceiverPFB
+{
+public:
+    GsmTrxPFB();
+    virtual void fatalError();
+protected:
+    virtual void syncGSMTimeSent(const GSMTime& time);
+};
+
 class GsmTrxModule : public Module
 {
 public:
@@ -78,7 +88,7 @@ public:
 	}
     void readCtrlLoop();
     void workerTerminated(GsmTrxThread* thread);
-    inline bool getTransceiver(RefPointer<GsmTrxQMF>& trx, bool take = false) {
+    inline bool getTransceiver(RefPointer<Transceiver>& trx, bool take = false) {
 	    Lock lck(m_stateMutex);
 	    trx = m_trx;
 	    if (take && m_trx) {
@@ -111,7 +121,7 @@ private:
     Mutex m_stateMutex;                  // Protect state changes
     int m_state;                         // Current state
     Configuration m_cfg;                 // The configuration file
-    GsmTrxQMF* m_trx;                    // The transceiver
+    Transceiver* m_trx;                  // The transceiver
     TransceiverSockIface m_ctrl;         // Control interface
     TransceiverQMF* m_dummy;             // Dummy transceiver used for socket iface
     GsmTrxThread* m_ctrlThread;          // Control thread
@@ -181,6 +191,26 @@ void GsmTrxQMF::syncGSMTimeSent(const GSMTime& time)
 }
 
 
+//
+// GsmTrxPFB
+//
+GsmTrxPFB::GsmTrxPFB()
+    : TransceiverPFB("gsmtrx")
+{
+}
+
+void GsmTrxPFB::fatalError()
+{
+    TransceiverPFB::fatalError();
+    __plugin.setCheckTrx();
+}
+
+void GsmTrxPFB::syncGSMTimeSent(const GSMTime& time)
+{
+    __plugin.syncGSMTimeSent(time);
+}
+
+
 //
 // GsmTrxModule
 //
@@ -240,7 +270,7 @@ void GsmTrxModule::readCtrlLoop()
 	    stopRecv = true;
 	}
 	else {
-	    RefPointer<GsmTrxQMF> trx;
+	    RefPointer<Transceiver> trx;
 	    if (getTransceiver(trx)) {
 		if (s.startSkip("CMD STATISTICS ",false)) {
 		    trx->statistics(s.toLower().toBoolean());
@@ -374,7 +404,7 @@ void GsmTrxModule::onTimer(const Time& time)
 	if (m_checkTrx) {
 	    m_checkTrx = false;
 	    lck.drop();
-	    RefPointer<GsmTrxQMF> trx;
+	    RefPointer<Transceiver> trx;
 	    if (getTransceiver(trx)) {
 		if (trx->inError())
 		    trxStop("In error");
@@ -442,7 +472,7 @@ bool GsmTrxModule::onCmdControl(Message& msg)
 	return true;
     }
     // Transceiver commands
-    RefPointer<GsmTrxQMF> trx;
+    RefPointer<Transceiver> trx;
     if (getTransceiver(trx))
 	return trx->control(oper,msg);
     return false;
@@ -534,17 +564,36 @@ int GsmTrxModule::trxStart(String& cmdLine)
     int pos = cmdLine.find(' ');
     unsigned int arfcns = cmdLine.substr(0,pos).toInteger(1,0,1);
     params.setParam(YSTRING("arfcns"),String(arfcns));
+    // Data transports offered by upper layer: 'data=name[,name...]'
+    params.clearParam(YSTRING("data_offer"));
+    if (pos > 0) {
+	ObjList* list = cmdLine.substr(pos + 1).split(' ',false);
+	for (ObjList* o = list->skipNull(); o; o = o->skipNext()) {
+	    String* s = static_cast<String*>(o->get());
+	    if (s->startSkip("data=",false))
+		params.setParam(YSTRING("data_offer"),*s);
+	}
+	TelEngine::destruct(list);
+    }
     params.setParam(YSTRING("remoteaddr"),m_ctrl.m_remote.host());
     params.setParam(YSTRING("localaddr"),m_ctrl.m_local.host());
     params.setParam(YSTRING("port"),String(m_port));
     TelEngine::destruct(m_trx);
-    m_trx = new GsmTrxQMF;
+    const String& chan = params[YSTRING("channelizer")];
+    if (chan == YSTRING("pfb"))
+	m_trx = new GsmTrxPFB;
+    else {
+	if (chan && chan != YSTRING("qmf"))
+	    Debug(this,DebugConf,"Unknown channelizer '%s', using 'qmf'",chan.c_str());
+	m_trx = new GsmTrxQMF;
+    }
     m_trx->debugChain(this);
     unsigned int code = 0;
     bool ok = m_trx->init(r,params,code);
     cmdLine = "";
     if (ok && m_trx->start()) {
 	changeState(Running);
+	m_trx->dataTransportParam(cmdLine);
 	return 0;
     }
     if (!ok && code)
@@ -557,7 +606,7 @@ int GsmTrxModule::trxStart(String& cmdLine)
 
 void GsmTrxModule::trxStop(const char* reason, int level, bool dumpStat, bool notify)
 {
-    RefPointer<GsmTrxQMF> trx;
+    RefPointer<Transceiver> trx;
     if (!getTransceiver(trx,true))
 	return;
     Debug(this,level,"Stopping transceiver: %s",reason);
@@ -3,3 +3,18 @@ typedef unsigned short  u16;
 typedef unsigned   int  u32;
 
 void A53_GSM( u8 *key, int klen, int count, u8 *block1, u8 *block2 );
+
+/* KASUMI round subkeys */
+typedef struct {
+	u16 KLi1[8], KLi2[8], KOi1[8], KOi2[8], KOi3[8], KIi1[8], KIi2[8], KIi3[8];
+} A53Subkeys;
+
+/* Expanded A5/3 key, for the modified key and for the key */
+typedef struct {
+	A53Subkeys km;
+	A53Subkeys k;
+} A53Key;
+
+/* Key expanded once, both directions from one KGCORE run, same output as A53_GSM() */
+void A53_GSM_key( const u8 *key, A53Key *k );
+void A53_GSM_fast( const A53Key *k, int count, u8 *block1, u8 *block2 );
@@ -1,6 +1,7 @@
 #include "a53.h"
 extern "C" {
 #include "a5.h"
+#include "kasumi.h"
 };
 #include <stdio.h>
 
@@ -27,3 +28,49 @@ void A53_GSM( u8 *key, int klen, int count, u8 *block1, u8 *block2 )
 	block1[14] &= 0xC0;
 	block2[14] &= 0xC0;
 }
+
+
+static void expand(const u8 *key, A53Subkeys *s)
+{
+	_kasumi_key_expand(key, s->KLi1, s->KLi2, s->KOi1, s->KOi2, s->KOi3, s->KIi1, s->KIi2, s->KIi3);
+}
+
+static inline uint64_t kasumi(uint64_t p, const A53Subkeys *s)
+{
+	A53Subkeys *k = const_cast<A53Subkeys*>(s);
+	return _kasumi(p, k->KLi1, k->KLi2, k->KOi1, k->KOi2, k->KOi3, k->KIi1, k->KIi2, k->KIi3);
+}
+
+void A53_GSM_key( const u8 *key, A53Key *k )
+{
+	// 64 bit key is expanded by concatenation (see osmo_a5_3)
+	u8 ck[16];
+	u8 ckm[16];
+	for (int i = 0; i < 16; i++) {
+		ck[i] = key[i & 7];
+		ckm[i] = ck[i] ^ 0x55;
+	}
+	expand(ckm, &k->km);
+	expand(ck, &k->k);
+}
+
+// KGCORE (see _kasumi_kgcore) with CA=0xF, CB=0, CD=0, 228 output bits:
+// downlink is bits 0..113, uplink bits 114..227
+void A53_GSM_fast( const A53Key *k, int count, u8 *block1, u8 *block2 )
+{
+	uint64_t a = (((uint64_t)(uint32_t)count) << 32) | (0xFULL << 16);
+	a = kasumi(a, &k->km);
+	u8 gamma[32];
+	uint64_t blk = 0;
+	for (unsigned int i = 0; i < 4; i++) {
+		blk = kasumi(a ^ i ^ blk, &k->k);
+		for (int j = 0; j < 8; j++)
+			gamma[i*8+j] = blk >> (56 - 8*j);
+	}
+	for (int i = 0; i < 15; i++) {
+		block1[i] = gamma[i];
+		block2[i] = (gamma[i + 14] << 2) | (gamma[i + 15] >> 6);
+	}
+	block1[14] &= 0xC0;
+	block2[14] &= 0xC0;
+}
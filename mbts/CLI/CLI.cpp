@@ -253,6 +253,8 @@ int printStats(int argc, char** argv, ostream& os)
 	os << "SDCCH load: " << gBTS.SDCCHActive() << '/' << gBTS.SDCCHTotal() << endl;
 	os << "TCH/F load: " << gBTS.TCHActive() << '/' << gBTS.TCHTotal() << endl;
 	os << "AGCH/PCH load: " << gBTS.AGCHLoad() << ',' << gBTS.PCHLoad() << endl;
+	GSM::gL1Scheduler.stats(os);
+	GSM::gL2Executor.stats(os);
 	// paging table size
 	os << "Paging table size: " << gBTS.pager().pagingEntryListSize() << endl;
 	// 3122 timer current value (the number of seconds an MS should hold off the next RACH)
@@ -226,3 +226,123 @@ void A51_GSM( byte *key, int klen, int count, byte *block1, byte *block2 )
 	keysetup(key, count); // TODO - frame and count are not the same
 	run(block1, block2);
 }
+
+
+/*
+ * Table driven, reentrant A5/1.
+ *
+ * Loading the key and the frame number clocks all three registers and XORs
+ * the input bits, which is linear. So the registers after loading are the XOR
+ * of a key part, computed once per key in A51_GSM_key(), and a frame number
+ * part, looked up one byte at a time. The registers are local so several
+ * channels may generate keystreams at the same time.
+ */
+
+/* Clocked register values */
+static inline word step1(word r)
+{
+	return ((r<<1) & R1MASK) | (1 & (r>>18 ^ r>>17 ^ r>>16 ^ r>>13));
+}
+
+static inline word step2(word r)
+{
+	return ((r<<1) & R2MASK) | (1 & (r>>21 ^ r>>20));
+}
+
+static inline word step3(word r)
+{
+	return ((r<<1) & R3MASK) | (1 & (r>>22 ^ r>>21 ^ r>>20 ^ r>>7));
+}
+
+static inline void clockall(word *r)
+{
+	r[0] = step1(r[0]);
+	r[1] = step2(r[1]);
+	r[2] = step3(r[2]);
+}
+
+/* Majority clocking, each register is replaced by itself or its
+ * clocked value using masks. */
+static inline void clockmaj(word *r)
+{
+	word b1 = (r[0]>>8) & 1;
+	word b2 = (r[1]>>10) & 1;
+	word b3 = (r[2]>>10) & 1;
+	word maj = (b1 & b2) | (b1 & b3) | (b2 & b3);
+	word m1 = (b1 ^ maj) - 1;
+	word m2 = (b2 ^ maj) - 1;
+	word m3 = (b3 ^ maj) - 1;
+	r[0] ^= m1 & (r[0] ^ step1(r[0]));
+	r[1] ^= m2 & (r[1] ^ step2(r[1]));
+	r[2] ^= m3 & (r[2] ^ step3(r[2]));
+}
+
+/* Register contributions of each byte of the 22 bit frame number. */
+class A51FrameTable {
+public:
+	word mRegs[3][256][3];
+
+	A51FrameTable()
+	{
+		for (int b=0; b<3; b++) {
+			for (int v=0; v<256; v++) {
+				word frame = (word)v << (8*b);
+				word r[3] = {0, 0, 0};
+				for (int i=0; i<22; i++) {
+					clockall(r);
+					word framebit = (frame >> i) & 1;
+					r[0] ^= framebit; r[1] ^= framebit; r[2] ^= framebit;
+				}
+				for (int k=0; k<3; k++) mRegs[b][v][k] = r[k];
+			}
+		}
+	}
+};
+
+static const A51FrameTable sFrameTable;
+
+void A51_GSM_key( const byte *key, A51Key *k )
+{
+	word r[3] = {0, 0, 0};
+	for (int i=0; i<64; i++) {
+		clockall(r);
+		word keybit = (key[i/8] >> (i&7)) & 1;
+		r[0] ^= keybit; r[1] ^= keybit; r[2] ^= keybit;
+	}
+	/* The frame number clocks shift the key part too. */
+	for (int i=0; i<22; i++) clockall(r);
+	k->R1 = r[0];
+	k->R2 = r[1];
+	k->R3 = r[2];
+}
+
+/* Generate 114 bits MSB first, the last byte is padded with 0. */
+static inline void runfast(word *r, byte *out)
+{
+	for (int i=0; i<14; i++) {
+		unsigned acc = 0;
+		for (int j=0; j<8; j++) {
+			clockmaj(r);
+			acc = (acc<<1) | (((r[0]>>18) ^ (r[1]>>21) ^ (r[2]>>22)) & 1);
+		}
+		out[i] = acc;
+	}
+	unsigned acc = 0;
+	for (int j=0; j<2; j++) {
+		clockmaj(r);
+		acc = (acc<<1) | (((r[0]>>18) ^ (r[1]>>21) ^ (r[2]>>22)) & 1);
+	}
+	out[14] = acc << 6;
+}
+
+void A51_GSM_fast( const A51Key *k, int count, byte *block1, byte *block2 )
+{
+	word r[3] = {k->R1, k->R2, k->R3};
+	for (int b=0; b<3; b++) {
+		const word *f = sFrameTable.mRegs[b][(count >> (8*b)) & 0xff];
+		r[0] ^= f[0]; r[1] ^= f[1]; r[2] ^= f[2];
+	}
+	for (int i=0; i<100; i++) clockmaj(r);
+	runfast(r, block1);
+	runfast(r, block2);
+}
@@ -9,3 +9,12 @@ typedef word bit;
 
 void A51_GSM( byte *key, int klen, int count, byte *block1, byte *block2 );
 
+/* Register contents after loading a 64 bit key */
+typedef struct {
+	word R1, R2, R3;
+} A51Key;
+
+/* Table driven, reentrant A5/1, same output as A51_GSM() */
+void A51_GSM_key( const byte *key, A51Key *k );
+void A51_GSM_fast( const A51Key *k, int count, byte *block1, byte *block2 );
+
@@ -156,7 +156,40 @@ void test() {
 	printf("A51_GSM takes %g seconds per iteration\n", t);
 }
 
+/* Compare the table driven version with the reference one
+ * for random keys and frame numbers, then time it. */
+void testfast() {
+	byte key[8];
+	byte AtoB[15], BtoA[15], AtoB2[15], BtoA2[15];
+	A51Key k;
+	int i, j;
+	for (i=0; i<1000; i++) {
+		for (j=0; j<8; j++)
+			key[j] = random();
+		int count = random() & 0x3fffff;
+		A51_GSM(key, 64, count, AtoB, BtoA);
+		A51_GSM_key(key, &k);
+		A51_GSM_fast(&k, count, AtoB2, BtoA2);
+		for (j=0; j<15; j++) {
+			if (AtoB[j] == AtoB2[j] && BtoA[j] == BtoA2[j])
+				continue;
+			printf("A51_GSM_fast differs for frame 0x%06X\n", count);
+			exit(1);
+		}
+	}
+	printf("A51_GSM_fast self-check succeeded\n");
+
+	int n = 100000;
+	float t = clock();
+	for (i = 0; i < n; i++) {
+		A51_GSM_fast(&k, i & 0x3fffff, AtoB, BtoA);
+	}
+	t = (clock() - t) / (CLOCKS_PER_SEC * (float)n);
+	printf("A51_GSM_fast takes %g seconds per iteration\n", t);
+}
+
 int main(void) {
 	test();
+	testfast();
 	return 0;
 }
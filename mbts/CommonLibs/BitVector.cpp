@@ -295,6 +295,7 @@ ViterbiR2O4::ViterbiR2O4()
 	computeStateTables(0);
 	computeStateTables(1);
 	computeGeneratorTable();
+	computeBranchMasks();
 }
 
 
@@ -446,6 +447,55 @@ BitVector SoftVector::sliced() const
 
 
 
+// Run the Viterbi decoder over precomputed history and cost metric tables.
+static void viterbiDecode(ViterbiR2O4 &decoder, const uint32_t *history,
+	const float *matchCostTable, const float *mismatchCostTable, size_t ctsz,
+	BitVector& target)
+{
+	const unsigned deferral = decoder.deferral();
+	decoder.initializeStates();
+	// Each sample of history[] carries its history.
+	// So we only have to process every iRate-th sample.
+	const unsigned step = decoder.iRate();
+	// input pointer
+	const uint32_t *ip = history + step - 1;
+	// output pointers
+	char *op = target.begin();
+	const char *const opt = target.end();
+	// table pointers
+	const float* match = matchCostTable;
+	const float* mismatch = mismatchCostTable;
+	size_t oCount = 0;
+	while (op<opt) {
+		// Viterbi algorithm
+		assert((size_t)(match-matchCostTable)<ctsz-1);
+		assert((size_t)(mismatch-mismatchCostTable)<ctsz-1);
+		const ViterbiR2O4::vCand &minCost = decoder.step(*ip, match, mismatch);
+		ip += step;
+		match += step;
+		mismatch += step;
+		// output
+		if (oCount>=deferral) *op++ = (minCost.iState >> deferral)&0x01;
+		oCount++;
+	}
+}
+
+
+// Soft bit cost metrics, see SoftVector::decode().
+static void softCost(float pVal, float& match, float& mismatch)
+{
+	// pVal is the probability that a bit is correct.
+	// ipVal is the probability that a bit is incorrect.
+	if (pVal>0.5F) pVal = 1.0F-pVal;
+	float ipVal = 1.0F-pVal;
+	// This is a cheap approximation to an ideal cost function.
+	if (pVal<0.01F) pVal = 0.01;
+	if (ipVal<0.01F) ipVal = 0.01;
+	match = 0.25F/ipVal;
+	mismatch = 0.25F/pVal;
+}
+
+
 void SoftVector::decode(ViterbiR2O4 &decoder, BitVector& target) const
 {
 	const size_t sz = size();
@@ -474,18 +524,8 @@ void SoftVector::decode(ViterbiR2O4 &decoder, BitVector& target) const
 	float mismatchCostTable[ctsz];
 	{
 		const float *dp = mStart;
-		for (size_t i=0; i<sz; i++) {
-			// pVal is the probability that a bit is correct.
-			// ipVal is the probability that a bit is incorrect.
-			float pVal = dp[i];
-			if (pVal>0.5F) pVal = 1.0F-pVal;
-			float ipVal = 1.0F-pVal;
-			// This is a cheap approximation to an ideal cost function.
-			if (pVal<0.01F) pVal = 0.01;
-			if (ipVal<0.01F) ipVal = 0.01;
-			matchCostTable[i] = 0.25F/ipVal;
-			mismatchCostTable[i] = 0.25F/pVal;
-		}
+		for (size_t i=0; i<sz; i++)
+			softCost(dp[i],matchCostTable[i],mismatchCostTable[i]);
 	
 		// pad end of table with unknowns
 		for (size_t i=sz; i<ctsz; i++) {
@@ -494,33 +534,7 @@ void SoftVector::decode(ViterbiR2O4 &decoder, BitVector& target) const
 		}
 	}
 
-	{
-		decoder.initializeStates();
-		// Each sample of history[] carries its history.
-		// So we only have to process every iRate-th sample.
-		const unsigned step = decoder.iRate();
-		// input pointer
-		const uint32_t *ip = history + step - 1;
-		// output pointers
-		char *op = target.begin();
-		const char *const opt = target.end();
-		// table pointers
-		const float* match = matchCostTable;
-		const float* mismatch = mismatchCostTable;
-		size_t oCount = 0;
-		while (op<opt) {
-			// Viterbi algorithm
-			assert(match-matchCostTable<sizeof(matchCostTable)/sizeof(matchCostTable[0])-1);
-			assert(mismatch-mismatchCostTable<sizeof(mismatchCostTable)/sizeof(mismatchCostTable[0])-1);
-			const ViterbiR2O4::vCand &minCost = decoder.step(*ip, match, mismatch);
-			ip += step;
-			match += step;
-			mismatch += step;
-			// output
-			if (oCount>=deferral) *op++ = (minCost.iState >> deferral)&0x01;
-			oCount++;
-		}
-	}
+	viterbiDecode(decoder,history,matchCostTable,mismatchCostTable,ctsz,target);
 }
 
 
@@ -553,6 +567,329 @@ ostream& operator<<(ostream& os, const SoftVector& sv)
 }
 
 
+SoftVector::SoftVector(const SoftVector8& source)
+{
+	resize(source.size());
+	for (size_t i=0; i<size(); i++) mStart[i] = SoftVector8::toFloat(source[i]);
+}
+
+
+void SoftVector::copyToSegment(SoftVector8& other, size_t start) const
+{
+	const size_t sz = size();
+	assert(start+sz<=other.size());
+	int8_t *dp = other.begin() + start;
+	for (size_t i=0; i<sz; i++) dp[i] = SoftVector8::fromFloat(mStart[i]);
+}
+
+
+
+
+SoftVector8::SoftVector8(const SoftVector& source)
+{
+	resize(source.size());
+	source.copyToSegment(*this,0);
+}
+
+
+SoftVector8::SoftVector8(const BitVector& source)
+{
+	resize(source.size());
+	for (size_t i=0; i<size(); i++) mStart[i] = source.bit(i) ? One : Zero;
+}
+
+
+BitVector SoftVector8::sliced() const
+{
+	size_t sz = size();
+	BitVector newSig(sz);
+	for (size_t i=0; i<sz; i++) newSig[i] = mStart[i]>0 ? 1 : 0;
+	return newSig;
+}
+
+
+// Cost metrics of all soft bit values, indexed by value+128.
+// The costs are rounded to multiples of 1/VITERBI_SCALE so the float path
+// metrics of decodeFloat() are exact sums, at most 236 steps of 2*25 are far
+// below the 24 bit float mantissa. The int16 decoder adds the scaled extra cost
+// of a mismatch, the match cost is the same for all the paths, so both decoders
+// compare the same numbers and make the same decisions.
+// The int16 metrics are normalized to the best path in each step. Any state is
+// reached from the best one in (order) steps so, with the step being added,
+// the spread is at most 5*2*24.75*VITERBI_SCALE and int16 never saturates.
+#define VITERBI_SCALE 128
+
+struct SoftCost8 {
+	float match[256];
+	float mismatch[256];
+	int16_t delta[256];
+	SoftCost8()
+	{
+		for (int v=-128; v<128; v++) {
+			float m, mm;
+			softCost(SoftVector8::toFloat(v),m,mm);
+			const int16_t mq = (int16_t)(m*VITERBI_SCALE + 0.5F);
+			const int16_t mmq = (int16_t)(mm*VITERBI_SCALE + 0.5F);
+			match[v+128] = (float)mq / VITERBI_SCALE;
+			mismatch[v+128] = (float)mmq / VITERBI_SCALE;
+			delta[v+128] = mmq - mq;
+		}
+	}
+};
+static const SoftCost8 sSoftCost8;
+
+// Decoder input, one entry per step (2 soft bits).
+struct ViterbiStep {
+	int16_t delta1;		// cost if the first bit mismatches
+	int16_t delta0;		// cost if the second bit mismatches
+	int16_t r1;			// first hard bit, 0 or -1
+	int16_t r0;			// second hard bit, 0 or -1
+};
+
+// Add-compare-select over all steps with register exchange of the input
+// history, same decisions and tie breaking as ViterbiR2O4::step().
+// States are 4 bit input histories, new state i comes from states i>>1 (low)
+// or 8+(i>>1) (high), branch j=i or i+16 outputs generator bits g[j].
+// The loops work on the even and odd new states of the 8 low/high pairs
+// so they can be vectorized.
+// g1/g0 hold the generator output bits as 0/-1 masks: [0..7] low even,
+// [8..15] low odd, [16..23] high even, [24..31] high odd branches.
+// All paths start as zeros so in the first steps the state index is not
+// the path history yet, these steps use the generator table gen[] of the paths.
+static inline __attribute__((always_inline))
+void viterbiAcs(const ViterbiStep* in, unsigned steps, unsigned deferral,
+	const uint32_t* gen, const int16_t* g1, const int16_t* g0, char* out)
+{
+	int16_t m[16] __attribute__((aligned(32)));
+	uint32_t p[16] __attribute__((aligned(32)));
+	for (unsigned i=0; i<16; i++) {
+		m[i] = 0;
+		p[i] = 0;
+	}
+	unsigned t = 0;
+	for (; t<steps && t<4; t++) {
+		const ViterbiStep& st = in[t];
+		int16_t nm[16];
+		uint32_t np[16];
+		for (unsigned i=0; i<16; i++) {
+			int16_t c[2];
+			uint32_t cp[2];
+			for (unsigned h=0; h<2; h++) {
+				const uint32_t path = (p[h*8 + (i>>1)] << 1) | (i & 0x01);
+				const uint32_t g = gen[path & 0x1f];
+				cp[h] = path;
+				c[h] = m[h*8 + (i>>1)]
+					+ (st.delta1 & (((g & 0x02) ? -1 : 0) ^ st.r1))
+					+ (st.delta0 & (((g & 0x01) ? -1 : 0) ^ st.r0));
+			}
+			const unsigned h = (c[0] < c[1]) ? 0 : 1;
+			nm[i] = c[h];
+			np[i] = cp[h];
+		}
+		int16_t best = nm[0];
+		for (unsigned i=0; i<16; i++)
+			if (nm[i]<best) best = nm[i];
+		for (unsigned i=0; i<16; i++) {
+			m[i] = nm[i] - best;
+			p[i] = np[i];
+		}
+		if (t<deferral) continue;
+		unsigned i = 0;
+		while (m[i]) i++;
+		*out++ = (p[i] >> deferral) & 0x01;
+	}
+	for (; t<steps; t++) {
+		const ViterbiStep& st = in[t];
+		int16_t bm[32] __attribute__((aligned(32)));
+		for (unsigned j=0; j<32; j++)
+			bm[j] = (st.delta1 & (g1[j] ^ st.r1)) + (st.delta0 & (g0[j] ^ st.r0));
+		int16_t nm[16] __attribute__((aligned(32)));
+		uint32_t np[16] __attribute__((aligned(32)));
+		for (unsigned k=0; k<8; k++) {
+			// even state 2k
+			int16_t lo = m[k] + bm[k];
+			int16_t hi = m[8+k] + bm[16+k];
+			bool sel = lo < hi;
+			nm[k] = sel ? lo : hi;
+			np[k] = (sel ? p[k] : p[8+k]) << 1;
+			// odd state 2k+1
+			lo = m[k] + bm[8+k];
+			hi = m[8+k] + bm[24+k];
+			sel = lo < hi;
+			nm[8+k] = sel ? lo : hi;
+			np[8+k] = ((sel ? p[k] : p[8+k]) << 1) | 1;
+		}
+		// Back to state order, find the best path (first one on ties).
+		int16_t best = nm[0];
+		for (unsigned k=0; k<8; k++) {
+			m[2*k] = nm[k];
+			m[2*k+1] = nm[8+k];
+			p[2*k] = np[k];
+			p[2*k+1] = np[8+k];
+			if (nm[k]<best) best = nm[k];
+			if (nm[8+k]<best) best = nm[8+k];
+		}
+		for (unsigned i=0; i<16; i++) m[i] -= best;
+		if (t<deferral) continue;
+		unsigned i = 0;
+		while (m[i]) i++;
+		*out++ = (p[i] >> deferral) & 0x01;
+	}
+}
+
+static void viterbiAcsDefault(const ViterbiStep* in, unsigned steps, unsigned deferral,
+	const uint32_t* gen, const int16_t* g1, const int16_t* g0, char* out)
+{
+	viterbiAcs(in,steps,deferral,gen,g1,g0,out);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2")))
+static void viterbiAcsAvx2(const ViterbiStep* in, unsigned steps, unsigned deferral,
+	const uint32_t* gen, const int16_t* g1, const int16_t* g0, char* out)
+{
+	viterbiAcs(in,steps,deferral,gen,g1,g0,out);
+}
+
+static bool avx2Supported()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+#endif
+
+typedef void (*ViterbiAcsFunc)(const ViterbiStep*, unsigned, unsigned,
+	const uint32_t*, const int16_t*, const int16_t*, char*);
+
+// The add-compare-select implementation for this CPU.
+static ViterbiAcsFunc viterbiAcsFunc()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	static const ViterbiAcsFunc func = avx2Supported() ? viterbiAcsAvx2 : viterbiAcsDefault;
+	return func;
+#else
+	return viterbiAcsDefault;
+#endif
+}
+
+
+void ViterbiR2O4::computeBranchMasks()
+{
+	// See viterbiAcs() for the branch order.
+	for (unsigned j=0; j<32; j++) {
+		const unsigned hi = j>>4;
+		const unsigned odd = (j>>3) & 0x01;
+		const unsigned k = j & 0x07;
+		const uint32_t g = mGeneratorTable[hi*16 + 2*k + odd];
+		mBranchMask1[j] = (g & 0x02) ? -1 : 0;
+		mBranchMask0[j] = (g & 0x01) ? -1 : 0;
+	}
+}
+
+
+void ViterbiR2O4::decode(const SoftVector8& in, BitVector& target) const
+{
+	const size_t sz = in.size();
+	const size_t steps = target.size() + mDeferral;
+	assert(sz <= mIRate*target.size());
+	ViterbiStep st[steps];
+	const size_t full = sz/2;
+	const int8_t* ip = in.begin();
+	for (size_t t=0; t<full; t++, ip+=2) {
+		st[t].delta1 = sSoftCost8.delta[ip[0]+128];
+		st[t].delta0 = sSoftCost8.delta[ip[1]+128];
+		st[t].r1 = ip[0]>0 ? -1 : 0;
+		st[t].r0 = ip[1]>0 ? -1 : 0;
+	}
+	// Repeat last bit at the end, pad with unknowns.
+	const int16_t last = (sz && in[sz-1]>0) ? -1 : 0;
+	for (size_t t=full; t<steps; t++) {
+		st[t].delta1 = st[t].delta0 = 0;
+		st[t].r1 = st[t].r0 = last;
+	}
+	if (sz & 0x01) {
+		st[full].delta1 = sSoftCost8.delta[ip[0]+128];
+		st[full].r1 = last;
+	}
+	viterbiAcsFunc()(st,steps,mDeferral,mGeneratorTable,mBranchMask1,mBranchMask0,target.begin());
+}
+
+
+void SoftVector8::decode(ViterbiR2O4 &decoder, BitVector& target) const
+{
+	decoder.decode(*this,target);
+}
+
+
+void SoftVector8::decodeFloat(ViterbiR2O4 &decoder, BitVector& target) const
+{
+	const size_t sz = size();
+	const unsigned deferral = decoder.deferral();
+	const size_t ctsz = sz + deferral*decoder.iRate();
+	assert(sz <= decoder.iRate()*target.size());
+
+	// Build the history and metric tables in one pass.
+	// The metrics are looked up, there is no arithmetic per bit.
+	uint32_t history[ctsz];
+	float matchCostTable[ctsz];
+	float mismatchCostTable[ctsz];
+	uint32_t accum = 0;
+	for (size_t i=0; i<sz; i++) {
+		const int v = mStart[i];
+		accum = (accum<<1) | (v>0);
+		history[i] = accum;
+		matchCostTable[i] = sSoftCost8.match[v+128];
+		mismatchCostTable[i] = sSoftCost8.mismatch[v+128];
+	}
+	// Repeat last bit at the end, pad end of table with unknowns.
+	for (size_t i=sz; i<ctsz; i++) {
+		accum = (accum<<1) | (accum & 0x01);
+		history[i] = accum;
+		matchCostTable[i] = 0.5F;
+		mismatchCostTable[i] = 0.5F;
+	}
+
+	viterbiDecode(decoder,history,matchCostTable,mismatchCostTable,ctsz,target);
+}
+
+
+float SoftVector8::getEnergy(float *plow) const
+{
+	int len = size();
+	unsigned sum = 0;
+	unsigned low = 127;
+	for (int i = 0; i < len; i++) {
+		unsigned energy = mStart[i] < 0 ? -mStart[i] : mStart[i];
+		if (energy > 127) energy = 127;
+		if (energy < low) low = energy;
+		sum += energy;
+	}
+	if (plow) { *plow = len ? low / 127.0F : 1; }
+	return len ? sum / (127.0F * len) : 0;
+}
+
+
+void SoftVector8::invert(const unsigned char* mask)
+{
+	const size_t sz = size();
+	for (size_t i=0; i<sz; i++) {
+		if (mask[i/8] & (0x80 >> (i%8))) mStart[i] = -mStart[i];
+	}
+}
+
+
+ostream& operator<<(ostream& os, const SoftVector8& sv)
+{
+	// Same thresholds as the SoftVector: 0.25 and 0.75.
+	for (size_t i=0; i<sv.size(); i++) {
+		if (sv[i]<-63) os << "0";
+		else if (sv[i]>63) os << "1";
+		else os << "-";
+	}
+	return os;
+}
+
+
 
 void BitVector::pack(unsigned char* targ) const
 {
@@ -622,4 +959,159 @@ bool BitVector::unhex(const char* src)
 	return true;
 }
 
+
+
+PackedBitVector::PackedBitVector(size_t wSize)
+	:mWords(NULL),mSize(0),mAlloc(0)
+{
+	resize(wSize);
+}
+
+
+PackedBitVector::PackedBitVector(const BitVector& source)
+	:mWords(NULL),mSize(0),mAlloc(0)
+{
+	pack(source);
+}
+
+
+PackedBitVector::PackedBitVector(const PackedBitVector& other)
+	:mWords(NULL),mSize(0),mAlloc(0)
+{
+	*this = other;
+}
+
+
+void PackedBitVector::operator=(const PackedBitVector& other)
+{
+	if (&other==this) return;
+	resize(other.mSize);
+	memcpy(mWords,other.mWords,words()*sizeof(uint64_t));
+}
+
+
+void PackedBitVector::resize(size_t wSize)
+{
+	size_t n = (wSize+63)/64;
+	if (n>mAlloc) {
+		delete[] mWords;
+		mWords = new uint64_t[n];
+		mAlloc = n;
+	}
+	mSize = wSize;
+	zero();
+}
+
+
+void PackedBitVector::zero()
+{
+	if (mWords) memset(mWords,0,mAlloc*sizeof(uint64_t));
+}
+
+
+void PackedBitVector::invert()
+{
+	const size_t n = words();
+	for (size_t i=0; i<n; i++) mWords[i] = ~mWords[i];
+	// Keep the unused bits zero.
+	if (mSize&63) mWords[n-1] &= ~0ULL << (64-(mSize&63));
+}
+
+
+void PackedBitVector::xorBytes(const unsigned char* src)
+{
+	size_t bytes = (mSize+7)/8;
+	for (size_t i=0, w=0; i<bytes; w++) {
+		uint64_t v = 0;
+		for (unsigned k=0; k<8; k++, i++)
+			v = (v<<8) | (i<bytes ? src[i] : 0);
+		mWords[w] ^= v;
+	}
+	if (mSize&63) mWords[words()-1] &= ~0ULL << (64-(mSize&63));
+}
+
+
+void PackedBitVector::xorWith(const PackedBitVector& other)
+{
+	assert(other.mSize==mSize);
+	const size_t n = words();
+	for (size_t i=0; i<n; i++) mWords[i] ^= other.mWords[i];
+}
+
+
+uint64_t PackedBitVector::peekField(size_t readIndex, unsigned length) const
+{
+	assert(length<=64);
+	assert(readIndex+length<=mSize);
+	if (!length) return 0;
+	size_t w = readIndex>>6;
+	unsigned off = readIndex&63;
+	uint64_t v = mWords[w] << off;
+	if (off && off+length>64) v |= mWords[w+1] >> (64-off);
+	return v >> (64-length);
+}
+
+
+void PackedBitVector::fillField(size_t writeIndex, uint64_t value, unsigned length)
+{
+	assert(length<=64);
+	assert(writeIndex+length<=mSize);
+	for (unsigned i=0; i<length; i++)
+		settfb(writeIndex+i,(value >> (length-1-i)) & 0x01);
+}
+
+
+void PackedBitVector::pack(const BitVector& source)
+{
+	const size_t sz = source.size();
+	if (sz!=mSize) resize(sz);
+	const char *dp = source.begin();
+	for (size_t i=0, w=0; i<sz; w++) {
+		uint64_t v = 0;
+		unsigned n = 0;
+		for (; n<64 && i<sz; n++, i++) v = (v<<1) | (dp[i] & 0x01);
+		mWords[w] = v << (64-n);
+	}
+}
+
+
+void PackedBitVector::unpack(BitVector& dest, size_t start) const
+{
+	const size_t sz = dest.size();
+	assert(start+sz<=mSize);
+	char *dp = dest.begin();
+	for (size_t i=0; i<sz; i++, start++)
+		dp[i] = (mWords[start>>6] >> (63-(start&63))) & 0x01;
+}
+
+
+unsigned PackedBitVector::sum() const
+{
+	unsigned sum = 0;
+	const size_t n = words();
+	for (size_t i=0; i<n; i++) sum += __builtin_popcountll(mWords[i]);
+	return sum;
+}
+
+
+uint64_t PackedBitVector::syndrome(Generator& gen) const
+{
+	gen.clear();
+	for (size_t i=0; i<mSize; i++)
+		gen.syndromeShift((mWords[i>>6] >> (63-(i&63))) & 0x01);
+	return gen.state();
+}
+
+
+ostream& operator<<(ostream& os, const PackedBitVector& pv)
+{
+	for (size_t i=0; i<pv.size(); i++) {
+		if (pv.bit(i)) os << '1';
+		else os << '0';
+	}
+	return os;
+}
+
+
+
 // vim: ts=4 sw=4
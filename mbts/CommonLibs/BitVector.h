@@ -32,6 +32,7 @@
 
 class BitVector;
 class SoftVector;
+class SoftVector8;
 
 
 
@@ -144,6 +145,8 @@ class ViterbiR2O4 {
 		uint32_t mCoeffs[mIRate];					///< polynomial for each generator
 		uint32_t mStateTable[mIRate][2*mIStates];	///< precomputed generator output tables
 		uint32_t mGeneratorTable[2*mIStates];		///< precomputed coder output table
+		int16_t mBranchMask1[2*mIStates];			///< first coder output bit per branch, as 0/-1
+		int16_t mBranchMask0[2*mIStates];			///< second coder output bit per branch, as 0/-1
 		//@}
 	
 	public:
@@ -194,6 +197,17 @@ class ViterbiR2O4 {
 		*/
 		const vCand& step(uint32_t inSample, const float *probs, const float *iprobs);
 
+		/**
+			Decode a block of soft bits with int16 metrics.
+			The add-compare-select loop is vectorized (AVX2 when the CPU has it).
+			The result is bit-exact with SoftVector8::decodeFloat(),
+			the metrics are the same costs scaled to integers.
+			This object is not modified so it may be shared by threads.
+			@param in The soft bits, 2 per decoded bit.
+			@param target The decoded bits.
+		*/
+		void decode(const SoftVector8& in, BitVector& target) const;
+
 	private:
 
 		/** Branch survivors into new candidates. */
@@ -220,6 +234,12 @@ class ViterbiR2O4 {
 		*/
 		void computeGeneratorTable();
 
+		/**
+			Precompute the branch output masks used by decode().
+			mGeneratorTable must be defined first.
+		*/
+		void computeBranchMasks();
+
 };
 
 
@@ -368,6 +388,102 @@ std::ostream& operator<<(std::ostream&, const BitVector&);
 
 
 
+/**
+	The PackedBitVector class stores bits packed in 64-bit words, MSB first:
+	bit 0 is the most significant bit of the first word.
+	This is the same order as the A5 cipher streams and BitVector::pack(),
+	so whole bursts can be ciphered or scrambled a word at a time.
+*/
+class PackedBitVector {
+
+	private:
+
+	uint64_t* mWords;	///< packed bits, unused low bits of the last word are zero
+	size_t mSize;		///< size in bits
+	size_t mAlloc;		///< allocated words
+
+	public:
+
+	/** Build a zeroed PackedBitVector of a given size in bits. */
+	PackedBitVector(size_t wSize=0);
+
+	/** Build a PackedBitVector from a BitVector. */
+	PackedBitVector(const BitVector& source);
+
+	/** Build a PackedBitVector by copying another. */
+	PackedBitVector(const PackedBitVector& other);
+
+	~PackedBitVector() { delete[] mWords; }
+
+	/** Assign from another PackedBitVector, copying. */
+	void operator=(const PackedBitVector& other);
+
+	/** Change the size, discarding content. */
+	void resize(size_t wSize);
+
+	/** Return the size in bits. */
+	size_t size() const { return mSize; }
+
+	/** Return the number of words holding the bits. */
+	size_t words() const { return (mSize+63)/64; }
+
+	/** Return a packed word. */
+	uint64_t word(size_t index) const
+		{ assert(index<words()); return mWords[index]; }
+
+	/** Index a single bit. */
+	bool bit(size_t index) const
+	{
+		assert(index<mSize);
+		return (mWords[index>>6] >> (63-(index&63))) & 0x01;
+	}
+
+	/** Set a bit */
+	void settfb(size_t index, int value)
+	{
+		assert(index<mSize);
+		const uint64_t mask = 1ULL << (63-(index&63));
+		if (value & 0x01) mWords[index>>6] |= mask;
+		else mWords[index>>6] &= ~mask;
+	}
+
+	void zero();
+
+	/** Invert 0<->1. */
+	void invert();
+
+	/** Exclusive or with a MSB-first packed char array of size() bits, like a cipher stream. */
+	void xorBytes(const unsigned char* src);
+
+	/** Exclusive or with another vector of the same size. */
+	void xorWith(const PackedBitVector& other);
+
+	/**@name Serialization and deserialization. */
+	//@{
+	uint64_t peekField(size_t readIndex, unsigned length) const;
+	void fillField(size_t writeIndex, uint64_t value, unsigned length);
+	//@}
+
+	/** Pack all of a BitVector, the size is changed to the source size. */
+	void pack(const BitVector& source);
+
+	/** Unpack bits starting at a given index to fill a BitVector (or a segment alias). */
+	void unpack(BitVector& dest, size_t start=0) const;
+
+	/** Sum of bits. */
+	unsigned sum() const;
+
+	/** Calculate the syndrome of the vector with the given Generator. */
+	uint64_t syndrome(Generator& gen) const;
+};
+
+
+
+std::ostream& operator<<(std::ostream&, const PackedBitVector&);
+
+
+
+
 
 
 /**
@@ -387,6 +503,9 @@ class SoftVector: public Vector<float> {
 	/** Construct a SoftVector from a BitVector. */
 	SoftVector(const BitVector& source);
 
+	/** Construct a SoftVector from a SoftVector8. */
+	SoftVector(const SoftVector8& source);
+
 	/**
 		Wrap a SoftVector around a block of floats.
 		The block will be delete[]ed upon desctuction.
@@ -428,6 +547,10 @@ class SoftVector: public Vector<float> {
 	const SoftVector head(size_t span) const { return segment(0,span); }
 	SoftVector tail(size_t start) { return segment(start,size()-start); }
 	const SoftVector tail(size_t start) const { return segment(start,size()-start); }
+
+	using Vector<float>::copyToSegment;
+	/** Copy all of this vector to a segment of a SoftVector8, saturating. */
+	void copyToSegment(SoftVector8& other, size_t start) const;
 	//@}
 
 	/** Decode soft symbols with the GSM rate-1/2 Viterbi decoder. */
@@ -477,6 +600,126 @@ std::ostream& operator<<(std::ostream&, const SoftVector&);
 
 
 
+/**
+  The SoftVector8 class is a compact soft-decision signal used by the L1 decoders.
+  Soft bits are saturated signed bytes: -127 is a certain "0", 127 a certain "1"
+  and 0 is unknown, so the value is (probability-0.5)*254 of a SoftVector.
+  It carries the same information in a quarter of the memory.
+ */
+class SoftVector8: public Vector<int8_t> {
+
+	public:
+
+	static const int8_t One = 127;		///< a certain "1"
+	static const int8_t Zero = -127;	///< a certain "0"
+
+	/** Build a SoftVector8 of a given length. */
+	SoftVector8(size_t wSize=0):Vector<int8_t>(wSize) {}
+
+	/** Construct a SoftVector8 from a SoftVector. */
+	SoftVector8(const SoftVector& source);
+
+	/** Construct a SoftVector8 from a BitVector. */
+	SoftVector8(const BitVector& source);
+
+	SoftVector8(int8_t* wData, int8_t* wStart, int8_t* wEnd)
+		:Vector<int8_t>(wData,wStart,wEnd)
+	{ }
+
+	/**
+		Casting from a Vector<int8_t>.
+		Note that this is NOT pass-by-reference.
+	*/
+	SoftVector8(Vector<int8_t> source)
+		:Vector<int8_t>(source)
+	{}
+
+	/** Convert a probability that a bit is "true" into a soft bit. */
+	static int8_t fromFloat(float p)
+	{
+		float v = (p - 0.5F) * 254.0F;
+		if (v >= 127.0F) return One;
+		if (v <= -127.0F) return Zero;
+		return (int8_t)(v < 0 ? v - 0.5F : v + 0.5F);
+	}
+
+	/** Convert a soft bit into the probability that it is "true". */
+	static float toFloat(int8_t v)
+		{ return 0.5F + v / 254.0F; }
+
+
+	/**@name Casts and overrides of Vector operators. */
+	//@{
+	SoftVector8 segment(size_t start, size_t span)
+	{
+		int8_t* wStart = mStart + start;
+		int8_t* wEnd = wStart + span;
+		assert(wEnd<=mEnd);
+		return SoftVector8(NULL,wStart,wEnd);
+	}
+
+	SoftVector8 alias()
+		{ return segment(0,size()); }
+
+	const SoftVector8 segment(size_t start, size_t span) const
+		{ return (SoftVector8)(Vector<int8_t>::segment(start,span)); }
+
+	SoftVector8 head(size_t span) { return segment(0,span); }
+	const SoftVector8 head(size_t span) const { return segment(0,span); }
+	SoftVector8 tail(size_t start) { return segment(start,size()-start); }
+	const SoftVector8 tail(size_t start) const { return segment(start,size()-start); }
+	//@}
+
+	/** Decode soft symbols with the GSM rate-1/2 Viterbi decoder, int16 metrics. */
+	void decode(ViterbiR2O4 &decoder, BitVector& target) const;
+
+	/** Decode with the float ViterbiR2O4::step() decoder, the reference for decode(). */
+	void decodeFloat(ViterbiR2O4 &decoder, BitVector& target) const;
+
+	/** Same as SoftVector::getEnergy(). */
+	float getEnergy(float *low=0) const;
+
+	/** Fill with "unknown" values. */
+	void unknown() { fill(0); }
+
+	/** Return a hard bit value from a given index by slicing. */
+	bool bit(size_t index) const
+	{
+		const int8_t *dp = mStart+index;
+		assert(dp<mEnd);
+		return (*dp)>0;
+	}
+
+	/** Slice the whole signal into bits. */
+	BitVector sliced() const;
+
+	/** Return a soft bit as a probability, like SoftVector::softbit(). */
+	float softbit(size_t index) const
+	{
+		const int8_t *dp = mStart+index;
+		assert(dp<mEnd);
+		return toFloat(*dp);
+	}
+
+	/** Set a soft bit from a probability. */
+	void settfb(size_t index, float value)
+	{
+		int8_t *dp = mStart+index;
+		assert(dp<mEnd);
+		*dp = fromFloat(value);
+	}
+
+	/** Invert the soft bits selected by a MSB-first packed char array (deciphering). */
+	void invert(const unsigned char* mask);
+};
+
+
+
+std::ostream& operator<<(std::ostream&, const SoftVector8&);
+
+
+
+
 
 
 #endif
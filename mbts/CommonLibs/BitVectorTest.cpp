@@ -27,12 +27,230 @@
 
 
 #include "BitVector.h"
+#include "Timeval.h"
 #include <iostream>
 #include <cstdlib>
  
 using namespace std;
 
 
+static void randomBits(BitVector& v)
+{
+	for (unsigned i=0; i<v.size(); i++) v[i] = random() & 1;
+}
+
+
+// Random soft bits around a hard value, some of them on the wrong side.
+static void noisySoft(const BitVector& bits, SoftVector& soft, float noise)
+{
+	for (unsigned i=0; i<bits.size(); i++) {
+		float n = noise * (random() % 1000) / 1000.0F;
+		soft[i] = bits.bit(i) ? 1.0F - n : n;
+	}
+}
+
+
+// Packed and int8 containers must give the same results as BitVector and SoftVector.
+static int testEquivalence()
+{
+	int failed = 0;
+	// Pack/unpack, fields, parity, ciphering stream.
+	for (unsigned n=0; n<100; n++) {
+		BitVector v(1 + random() % 460);
+		randomBits(v);
+		PackedBitVector p(v);
+		BitVector u(v.size());
+		p.unpack(u);
+		bool ok = u.size()==v.size() && p.sum()==v.sum();
+		for (unsigned i=0; ok && i<v.size(); i++) ok = u[i]==v[i] && p.bit(i)==v.bit(i);
+		for (unsigned i=0; ok && i<20; i++) {
+			unsigned start = random() % v.size();
+			unsigned len = random() % 65;
+			if (start+len>v.size()) len = v.size()-start;
+			ok = p.peekField(start,len)==v.peekField(start,len);
+		}
+		Parity parity(0x10004820009ULL,40,224);
+		Parity parity2(0x10004820009ULL,40,224);
+		ok = ok && p.syndrome(parity)==v.syndrome(parity2);
+		unsigned char stream[64];
+		for (unsigned i=0; i<sizeof(stream); i++) stream[i] = random();
+		p.xorBytes(stream);
+		for (unsigned i=0; ok && i<v.size(); i++)
+			ok = p.bit(i)==(v.bit(i) ^ ((stream[i/8] >> (7-i%8)) & 1));
+		if (!ok) {
+			cout << "FAILED PackedBitVector size=" << v.size() << endl;
+			failed++;
+			break;
+		}
+	}
+	// Soft decoding of XCCH size blocks.
+	ViterbiR2O4 vCoder;
+	unsigned errors[2] = {0, 0};
+	for (unsigned n=0; n<200; n++) {
+		BitVector u(228);
+		randomBits(u);
+		u.fillField(224,0,4);
+		BitVector c(456);
+		u.encode(vCoder,c);
+		SoftVector soft(456);
+		noisySoft(c,soft,n<100 ? 0.4F : 0.7F);
+		for (unsigned i=0; i<456/8; i++) soft[random()%456] = 0.5F;
+		SoftVector8 soft8(soft);
+		BitVector d1(228), d2(228);
+		soft.decode(vCoder,d1);
+		soft8.decode(vCoder,d2);
+		if (n<100 && d1.peekField(0,64)!=u.peekField(0,64)) {
+			cout << "FAILED SoftVector decode n=" << n << endl;
+			failed++;
+		}
+		for (unsigned i=0; i<224; i++) {
+			errors[0] += d1[i]!=u[i];
+			errors[1] += d2[i]!=u[i];
+		}
+		for (unsigned i=0; i<456; i++) {
+			if (soft8.bit(i)!=(soft[i]>0.5F && SoftVector8::fromFloat(soft[i])>0)) {
+				cout << "FAILED SoftVector8 slicing n=" << n << " i=" << i << endl;
+				failed++;
+				break;
+			}
+		}
+	}
+	cout << "decoded bit errors: SoftVector=" << errors[0] << " SoftVector8=" << errors[1] << endl;
+	// Quantization may only move a few decisions on very noisy blocks.
+	if (errors[1]>errors[0]+errors[0]/20+10) {
+		cout << "FAILED SoftVector8 decode" << endl;
+		failed++;
+	}
+	return failed;
+}
+
+
+// The int16 Viterbi decoder must be bit-exact with the float decoder,
+// on hard bits with erasures, noisy soft bits up to the limit of the code
+// and random soft bits that push the metrics spread to its maximum.
+static int testViterbi()
+{
+	int failed = 0;
+	ViterbiR2O4 vCoder;
+	static const unsigned blocks = 500;
+	static const float noise[4] = {0.0F, 0.5F, 0.6F, 0.7F};
+	unsigned diffBlocks = 0;
+	unsigned errors = 0;
+	for (unsigned n=0; n<blocks; n++) {
+		const unsigned cls = n/100;
+		BitVector u(228);
+		randomBits(u);
+		u.fillField(224,0,4);
+		BitVector c(456);
+		u.encode(vCoder,c);
+		SoftVector soft(456);
+		if (!cls) soft = SoftVector(c);
+		else if (cls<4) noisySoft(c,soft,noise[cls]);
+		SoftVector8 s8(soft);
+		if (cls<4) {
+			for (unsigned i=0; i<456/8; i++) s8[random()%456] = 0;
+		}
+		else {
+			for (unsigned i=0; i<456; i++) s8[i] = (random() & 1) ? SoftVector8::One : SoftVector8::Zero;
+		}
+		BitVector ref(228), d(228);
+		s8.decodeFloat(vCoder,ref);
+		s8.decode(vCoder,d);
+		unsigned diff = 0;
+		for (unsigned i=0; i<228; i++) diff += ref[i]!=d[i];
+		if (cls<4) {
+			for (unsigned i=0; i<224; i++) errors += d[i]!=u[i];
+		}
+		if (!diff) continue;
+		diffBlocks++;
+		cout << "FAILED int16 viterbi n=" << n << " differing bits=" << diff << endl;
+		failed++;
+	}
+	cout << "int16 viterbi: blocks=" << blocks << " differing blocks=" << diffBlocks
+		<< " bit errors=" << errors << endl;
+	return failed;
+}
+
+
+// XCCH decoder and encoder inner loops on both representations.
+static void benchmark()
+{
+	static const unsigned loops = 20000;
+	SoftVector fI[4], fC(456);
+	SoftVector8 iI[4], iC(456);
+	BitVector bI[4], burst(148), u(228);
+	PackedBitVector pI[4];
+	for (int B=0; B<4; B++) {
+		fI[B] = SoftVector(114);
+		iI[B] = SoftVector8(114);
+		bI[B] = BitVector(114);
+		randomBits(bI[B]);
+		pI[B].pack(bI[B]);
+		fI[B] = SoftVector(bI[B]);
+		iI[B] = SoftVector8(bI[B]);
+	}
+	unsigned char stream[15];
+	for (unsigned i=0; i<sizeof(stream); i++) stream[i] = random();
+	ViterbiR2O4 vCoder;
+	long t[6];
+	Timeval start;
+	for (unsigned n=0; n<loops; n++) {
+		for (int k=0; k<456; k++) {
+			int B = k%4;
+			int j = 2*((49*k) % 57) + ((k%8)/4);
+			fC[k] = fI[B][j];
+		}
+		for (int j=0; j<114; j++)
+			if (stream[j/8] & (0x80 >> (j%8))) fI[0].settfb(j,1.0-fI[0].softbit(j));
+	}
+	t[0] = start.elapsed();
+	start = Timeval();
+	for (unsigned n=0; n<loops; n++) {
+		for (int k=0; k<456; k++) {
+			int B = k%4;
+			int j = 2*((49*k) % 57) + ((k%8)/4);
+			iC[k] = iI[B][j];
+		}
+		iI[0].invert(stream);
+	}
+	t[1] = start.elapsed();
+	start = Timeval();
+	for (unsigned n=0; n<loops/10; n++) fC.decode(vCoder,u);
+	t[2] = start.elapsed() * 10;
+	start = Timeval();
+	for (unsigned n=0; n<loops/10; n++) iC.decode(vCoder,u);
+	t[3] = start.elapsed() * 10;
+	start = Timeval();
+	for (unsigned n=0; n<loops; n++) {
+		BitVector e(114);
+		for (int i=0; i<114; i++) e.settfb(i,bI[n%4].bit(i) ^ ((stream[i/8] >> (7-(i%8))) & 1));
+		e.segment(0,57).copyToSegment(burst,3);
+		e.segment(57,57).copyToSegment(burst,88);
+	}
+	t[4] = start.elapsed();
+	start = Timeval();
+	for (unsigned n=0; n<loops; n++) {
+		PackedBitVector e(pI[n%4]);
+		e.xorBytes(stream);
+		BitVector s1(burst.segment(3,57)), s2(burst.segment(88,57));
+		e.unpack(s1,0);
+		e.unpack(s2,57);
+	}
+	t[5] = start.elapsed();
+	cout << "per block (usec): deinterleave+decrypt float=" << (t[0] * 1000.0 / loops)
+		<< " int8=" << (t[1] * 1000.0 / loops)
+		<< ", viterbi float=" << (t[2] * 1000.0 / loops)
+		<< " int8=" << (t[3] * 1000.0 / loops)
+		<< ", burst cipher bytes=" << (t[4] * 1000.0 / loops)
+		<< " packed=" << (t[5] * 1000.0 / loops) << endl;
+	// Decoded bits per second, elapsed() is in msec.
+	cout << "viterbi decoded bits/s: float=" << (228.0 * loops / t[2] * 1000)
+		<< " int16=" << (228.0 * loops / t[3] * 1000) << endl;
+	cout << "memory per block: SoftVector i[]+c[]=" << (4*114+456)*sizeof(float)
+		<< " SoftVector8=" << (4*114+456)*sizeof(int8_t) << " bytes" << endl;
+}
+
+
 int main(int argc, char *argv[])
 {
 	BitVector v1("0000111100111100101011110000");
@@ -85,4 +303,10 @@ int main(int argc, char *argv[])
 	cout << "tp=" << tp << endl;
 	tp.pack(ts);
 	cout << "ts=" << ts << endl;
+
+	int failed = testEquivalence();
+	failed += testViterbi();
+	benchmark();
+	cout << (failed ? "FAILED" : "OK") << endl;
+	return failed ? 1 : 0;
 }
@@ -86,6 +86,7 @@ bool ConfigurationRecord::strToBoolean(const std::string& str, bool defVal)
 
 
 ConfigurationTable::ConfigurationTable(const char* filename, const char *wCmdName, ConfigurationKeyMap wSchema)
+	: mGeneration(1)
 {
 	gLogEarly(LOG_INFO, "opening configuration file from path %s", filename);
 	if (wCmdName) {
@@ -244,6 +245,8 @@ bool ConfigurationTable::load(const char* filename)
 		mCache[prefix + key] = ConfigurationRecord(val);
 	}
 	::fclose(f);
+	changed();
+	gLogLevelsChanged();
 	return true;
 }
 
@@ -735,12 +738,27 @@ std::vector<unsigned> ConfigurationTable::getVector(const string& key)
 	return retVal;
 }
 
+void ConfigurationTable::checkLogLevel(const string& key)
+{
+	if (key.compare(0,9,"Log.Level") == 0)
+		gLogLevelsChanged();
+}
+
+void ConfigurationTable::changed()
+{
+	// Generation 0 is used by ConfigKey as not cached, skip it on wrap
+	if (!__atomic_add_fetch(&mGeneration,1,__ATOMIC_RELEASE))
+		__atomic_add_fetch(&mGeneration,1,__ATOMIC_RELEASE);
+}
+
 bool ConfigurationTable::remove(const string& key)
 {
 	ScopedLock lock(mLock);
 	// Clear the cache entry and the database.
 	ConfigurationMap::iterator where = mCache.find(key);
 	if (where!=mCache.end()) mCache.erase(where);
+	changed();
+	checkLogLevel(key);
 	return true;
 }
 
@@ -774,6 +792,8 @@ bool ConfigurationTable::set(const string& key, const string& value)
 {
 	ScopedLock lock(mLock);
 	mCache[key] = ConfigurationRecord(value);
+	changed();
+	checkLogLevel(key);
 	return true;
 }
 
@@ -784,6 +804,22 @@ bool ConfigurationTable::set(const string& key, long value)
 	return set(key,buffer);
 }
 
+bool ConfigurationTable::updateDefaultValue(const string& key, const string& value)
+{
+	ScopedLock lock(mLock);
+	ConfigurationKeyMap::iterator sp = mSchema.find(key);
+	if (sp == mSchema.end())
+		return false;
+	// Drop a cached copy of the old default, keep values set explicitly
+	ConfigurationMap::iterator where = mCache.find(key);
+	if (where != mCache.end() && where->second.value() == sp->second.getDefaultValue())
+		mCache.erase(where);
+	sp->second.updateDefaultValue(value);
+	changed();
+	checkLogLevel(key);
+	return true;
+}
+
 void ConfigurationTable::setCrossCheckHook(vector<string> (*wCrossCheck)(const string&))
 {
 	mCrossCheck = wCrossCheck;
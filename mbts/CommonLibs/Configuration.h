@@ -192,6 +192,7 @@ class ConfigurationTable {
 	ConfigurationMap mCache;	///< cache of recently access configuration values
 	mutable Mutex mLock;		///< control for multithreaded access to the cache
 	std::vector<std::string> (*mCrossCheck)(const std::string&);	///< cross check callback pointer
+	volatile uint32_t mGeneration;	///< incremented on every change, never 0
 
 	public:
 
@@ -268,6 +269,13 @@ class ConfigurationTable {
 	/** Set or change a value in the table.  */
 	bool set(const std::string& key, long value);
 
+	/**
+		Change the default value of a key defined in the schema.
+		Values cached by ConfigKey handles are refreshed.
+		@return false if the key is not defined in the schema.
+	*/
+	bool updateDefaultValue(const std::string& key, const std::string& value);
+
 	/**
 		Remove an entry from the table.
 		Will not alter required values.
@@ -298,9 +306,102 @@ class ConfigurationTable {
 	*/
 	const ConfigurationRecord& lookup(const std::string& key);
 
+	/** Invalidate cached logging levels if the key is a Log.Level one. */
+	static void checkLogLevel(const std::string& key);
+
+	/**
+		Invalidate values cached by ConfigKey handles.
+		Caller must hold mLock while changing the cache and calling this.
+	*/
+	void changed();
+
+	public:
+
+	/**
+		Return the current generation of the table.
+		The generation changes each time a value is set, removed or (re)loaded.
+	*/
+	uint32_t generation() const
+		{ return __atomic_load_n(&mGeneration,__ATOMIC_ACQUIRE); }
+
 };
 
 
+extern ConfigurationTable gConfig;
+
+/**
+	A typed handle to a configuration value, intended for hot paths.
+	The key is resolved once and the value is cached in the handle; gets do not
+	lock the table while its generation is unchanged.
+	The value is refreshed from the table after any set(), remove() or load().
+	Supported types are long (getNum), float (getFloat) and bool (getBool).
+*/
+template <class T> class ConfigKey {
+
+	private:
+
+	ConfigurationTable& mTable;
+	std::string mName;
+	T mValue;			///< last value read from the table
+	volatile uint32_t mGeneration;	///< table generation of mValue, 0 while being updated
+	Mutex mLock;			///< serialize refreshes
+
+	/**
+		Read the value from the table.
+		Called with the handle mLock held, the table getters take the table mLock.
+	*/
+	T read();
+
+	/** Refresh the value from the table if needed. */
+	T refresh()
+	{
+		ScopedLock lock(mLock);
+		uint32_t gen = mTable.generation();
+		if (__atomic_load_n(&mGeneration,__ATOMIC_RELAXED) == gen)
+			return mValue;
+		// If the table changes while reading the stored generation is an old one
+		//  and the next get() will refresh again
+		T val = read();
+		__atomic_store_n(&mGeneration,0,__ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		mValue = val;
+		__atomic_store_n(&mGeneration,gen,__ATOMIC_RELEASE);
+		return val;
+	}
+
+	public:
+
+	ConfigKey(const char* name, ConfigurationTable& table = gConfig)
+		:mTable(table), mName(name), mValue(), mGeneration(0)
+	{ }
+
+	/** Return the key name. */
+	const std::string& name() const { return mName; }
+
+	/**
+		Get the value.
+		Throw ConfigurationTableKeyNotFound if not found.
+	*/
+	T get()
+	{
+		uint32_t gen = __atomic_load_n(&mGeneration,__ATOMIC_ACQUIRE);
+		if (gen && gen == mTable.generation()) {
+			T val = mValue;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&mGeneration,__ATOMIC_RELAXED) == gen)
+				return val;
+		}
+		return refresh();
+	}
+
+	operator T() { return get(); }
+};
+
+template <> inline long ConfigKey<long>::read() { return mTable.getNum(mName); }
+template <> inline float ConfigKey<float>::read() { return mTable.getFloat(mName); }
+template <> inline bool ConfigKey<bool>::read() { return mTable.getBool(mName); }
+
+
 typedef std::map<HashString, std::string> HashStringMap;
 
 class SimpleKeyValue {
@@ -389,6 +490,7 @@ class ConfigurationKey {
 
 	const std::string& getName() const { return mName; }
 	const std::string& getDefaultValue() const { return mDefaultValue; }
+	/** Change the key default. Use ConfigurationTable::updateDefaultValue() for a key in a table schema. */
 	void updateDefaultValue(const std::string& newValue) { mDefaultValue = newValue; }
 	void updateDefaultValue(const int newValue) { std::stringstream ss; ss << newValue; updateDefaultValue(ss.str()); }
 	const std::string& getUnits() const { return mUnits; }
@@ -29,6 +29,7 @@
 
 #include "Logger.h"
 #include "Configuration.h"
+#include "Timeval.h"
 
 ConfigurationTable gConfig;
 //ConfigurationTable gConfig("example.config");
@@ -41,8 +42,39 @@ void printAlarms()
     std::copy( alarms.begin(), alarms.end(), output );
 }
 
+// Print the cost of a disabled LOG(DEBUG):
+// cached call site level versus logging level retrieved on each call
+void benchmark()
+{
+	static const unsigned loops = 1000000;
+	static const unsigned cachedLoops = 100000000;
+	unsigned n = 0;
+	Timeval start;
+	for (unsigned i = 0; i < loops; i++)
+		if (gGetLoggingLevel(__FILE__)>=LOG_DEBUG) n++;
+	long lookup = start.elapsed();
+	start = Timeval();
+	for (unsigned i = 0; i < cachedLoops; i++)
+		if (IS_LOG_LEVEL(DEBUG)) n++;
+	long cached = start.elapsed();
+	std::cout << "disabled LOG() cost: lookup " << (lookup * 1000000.0 / loops)
+		<< " ns/call, cached " << (cached * 1000000.0 / cachedLoops) << " ns/call" << std::endl;
+	if (n)
+		std::cout << "unexpected enabled level" << std::endl;
+	// Level changes must be seen by call sites
+	gConfig.set("Log.Level","DEBUG");
+	if (!IS_LOG_LEVEL(DEBUG))
+		std::cout << "FAILED: level change not applied" << std::endl;
+	gConfig.set("Log.Level","NOTICE");
+	if (IS_LOG_LEVEL(DEBUG))
+		std::cout << "FAILED: level change not applied" << std::endl;
+}
+
 int main(int argc, char *argv[])
 {
+	// No schema in test configuration, set the keys used by logger
+	gConfig.set("Log.File","");
+	gConfig.set("Log.Alarms.Max",10);
 	gLogInit("LogTest","NOTICE",LOG_LOCAL7);
 
 	LOG(EMERG) << " testing the logger.";
@@ -63,6 +95,7 @@ int main(int argc, char *argv[])
     }
     std::cout << "you should see ten lines with the numbers 10..19:" << std::endl;
     printAlarms();
+    benchmark();
 }
 
 
@@ -121,29 +121,48 @@ int getLoggingLevel(const char* filename)
 
 
 
+// Starts at 1, a zero initialized LogLevelCache never matches it
+volatile uint32_t gLogLevelGeneration = 1;
+
+void gLogLevelsChanged()
+{
+	// Skip generation 0 on wrap around
+	if (!(__atomic_add_fetch(&gLogLevelGeneration,1,__ATOMIC_RELEASE) & 0x0fffffff))
+		__atomic_add_fetch(&gLogLevelGeneration,1,__ATOMIC_RELEASE);
+}
+
+
+int LogLevelCache::update(const char* filename, uint32_t gen)
+{
+	int level = gGetLoggingLevel(filename);
+	if (level >= 0 && level <= 0x0f)
+		__atomic_store_n(&mState,((gen & 0x0fffffff) << 4) | level,__ATOMIC_RELAXED);
+	return level;
+}
+
+
 int gGetLoggingLevel(const char* filename)
 {
-	// This is called a lot and needs to be efficient.
+	// Called by LOG() call sites when the logging levels configuration changed.
 
 	static Mutex sLogCacheLock;
 	static map<uint64_t,int>  sLogCache;
-	static unsigned sCacheCount;
-	static const unsigned sCacheRefreshCount = 1000;
+	static uint32_t sCacheGeneration;
 
 	if (filename==NULL) return gGetLoggingLevel("");
 
 	HashString hs(filename);
 	uint64_t key = hs.hash();
 
+	uint32_t gen = __atomic_load_n(&gLogLevelGeneration,__ATOMIC_ACQUIRE);
 	sLogCacheLock.lock();
-	// Time for a cache flush?
-	if (sCacheCount>sCacheRefreshCount) {
+	// Configuration changed since cached?
+	if (sCacheGeneration!=gen) {
 		sLogCache.clear();
-		sCacheCount=0;
+		sCacheGeneration=gen;
 	}
 	// Is it cached already?
 	map<uint64_t,int>::const_iterator where = sLogCache.find(key);
-	sCacheCount++;
 	if (where!=sLogCache.end()) {
 		int retVal = where->second;
 		sLogCacheLock.unlock();
@@ -155,7 +174,9 @@ int gGetLoggingLevel(const char* filename)
 	sLogCacheLock.unlock();
 	int level = getLoggingLevel(filename);
 	sLogCacheLock.lock();
-	sLogCache.insert(pair<uint64_t,int>(key,level));
+	// Don't cache a level retrieved while the configuration was changing
+	if (sCacheGeneration==gen)
+		sLogCache.insert(pair<uint64_t,int>(key,level));
 	sLogCacheLock.unlock();
 	return level;
 }
@@ -48,7 +48,12 @@
 #define _LOG(level) \
 	Log(LOG_##level).get() << "proc " << getpid() << " " __FILE__  ":"  << __LINE__ << ":" << __FUNCTION__ << ": " << "thread " << pthread_self() << ": "
 
-#define IS_LOG_LEVEL(wLevel) (gGetLoggingLevel(__FILE__)>=LOG_##wLevel)
+// The logging level is cached by each call site and refreshed when the
+// logging levels configuration changes, a disabled LOG() costs a few loads and a compare.
+#define LOG_SITE_LEVEL() \
+	({ static LogLevelCache sLogLevelCache; sLogLevelCache.level(__FILE__); })
+
+#define IS_LOG_LEVEL(wLevel) (LOG_SITE_LEVEL()>=LOG_##wLevel)
 
 #ifdef NDEBUG
 #define LOG(wLevel) \
@@ -136,11 +141,43 @@ std::list<std::string> gGetLoggerAlarms();		///< Get a copy of the recent alarm
 void gLogInit(const char* name, const char* level=NULL, int facility=LOG_USER);
 /** Get the logging level associated with a given file. */
 int gGetLoggingLevel(const char *filename=NULL);
+/** Notify a change of logging levels configuration (Log.Level keys), invalidate cached levels. */
+void gLogLevelsChanged();
+/** Logging levels configuration generation, incremented by gLogLevelsChanged(). */
+extern volatile uint32_t gLogLevelGeneration;
 /** Allow early logging when still in constructors */
 void gLogEarly(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
 //@}
 
 
+/**
+	Logging level cached by a LOG() call site.
+	Must be a static object: it relies on zero initialization and has no constructor
+	so no guard is needed. The level is stored with the configuration generation
+	it was retrieved for in a single word.
+*/
+class LogLevelCache {
+
+	public:
+
+	uint32_t mState;			///< (generation << 4) | level, 0 if not retrieved
+
+	/** Retrieve the logging level for the file holding the call site. */
+	inline int level(const char* filename)
+	{
+		uint32_t gen = __atomic_load_n(&gLogLevelGeneration,__ATOMIC_ACQUIRE);
+		uint32_t state = __atomic_load_n(&mState,__ATOMIC_RELAXED);
+		if ((state >> 4) == (gen & 0x0fffffff))
+			return state & 0x0f;
+		return update(filename,gen);
+	}
+
+	private:
+
+	int update(const char* filename, uint32_t gen);
+};
+
+
 #endif
 
 // vim: ts=4 sw=4
@@ -220,6 +220,38 @@ int DatagramSocket::read(char* buffer)
 }
 
 
+int DatagramSocket::read(char* buffers, int* lengths, unsigned count)
+{
+	if (!count)
+		return 0;
+#ifdef __linux__
+	if (count > MAX_UDP_BATCH)
+		count = MAX_UDP_BATCH;
+	struct mmsghdr msgs[MAX_UDP_BATCH];
+	struct iovec iovs[MAX_UDP_BATCH];
+	memset(msgs,0,sizeof(msgs));
+	for (unsigned i=0; i<count; i++) {
+		iovs[i].iov_base = buffers + i*MAX_UDP_LENGTH;
+		iovs[i].iov_len = MAX_UDP_LENGTH;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	// Wait for the first packet only
+	int num = recvmmsg(mSocketFD, msgs, count, MSG_WAITFORONE, NULL);
+	if ((num==-1) && (errno!=EAGAIN)) {
+		perror("DatagramSocket::read() batch failed");
+		throw SocketError();
+	}
+	for (int i=0; i<num; i++)
+		lengths[i] = msgs[i].msg_len;
+	return num;
+#else
+	lengths[0] = read(buffers);
+	return (lengths[0] < 0) ? -1 : 1;
+#endif
+}
+
+
 int DatagramSocket::read(char* buffer, unsigned timeout)
 {
 	fd_set fds;
@@ -42,6 +42,7 @@
 
 
 #define MAX_UDP_LENGTH 1500
+#define MAX_UDP_BATCH 16
 
 /** A function to resolve IP host names. */
 bool resolveAddress(struct sockaddr_in *address, const char *host, unsigned short port);
@@ -118,6 +119,16 @@ public:
 	*/
 	int read(char* buffer, unsigned timeout);
 
+	/**
+		Receive a batch of packets. Block until at least one is available,
+		then retrieve the ones already queued (recvmmsg() where supported).
+		@param buffers count consecutive char[MAX_UDP_LENGTH] procured by the caller.
+		@param lengths Destination for the length of received packets.
+		@param count Maximum number of packets to receive (up to MAX_UDP_BATCH).
+		@return The number of packets received or -1 on non-blocking pass.
+	*/
+	int read(char* buffers, int* lengths, unsigned count);
+
 
 	/** Send a packet to a given destination, other than the default. */
 	int send(const struct sockaddr *dest, const char * buffer, size_t length);
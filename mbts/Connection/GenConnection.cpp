@@ -23,22 +23,322 @@
 #include "GenConnection.h"
 
 #include <Logger.h>
+#include <Timeval.h>
 
 #include <sys/time.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 
+#define BUF_LEN 1024
+// Maximum messages read from a socket in one system call
+#define RECV_BATCH 16
+// Maximum events retrieved by one epoll_wait() call
+#define MAX_EVENTS 8
+// Interval in milliseconds between calls of idle()
+#define IDLE_MS 20
+// Maximum messages queued by handlers while a socket is not writable
+#define MAX_PENDING 1024
+
+namespace Connection {
+
+// Thread serving the receive side of the connections attached to it
+// Sockets are watched edge triggered and drained in batches, messages sent
+//  by handlers running in this thread are sent together at end of iteration
+//  without blocking, the rest waits for the socket to become writable
+class ConnReactor
+{
+public:
+    ConnReactor(const char* name);
+    bool attach(GenConnection* conn, const char* name);
+    void detach(GenConnection* conn);
+    bool defer(GenConnection* conn, const void* buffer, size_t len, bool& ok);
+private:
+    static void* runFunc(void* ptr);
+    void run();
+    void listConns(std::vector<GenConnection*>& conns);
+    bool drain(GenConnection* conn);
+    void flush(GenConnection* conn);
+    void waitOut(GenConnection* conn, bool on);
+    void remove(GenConnection* conn);
+    Mutex mLock;
+    Signal mReady;
+    std::string mName;
+    int mEpollFd;
+    bool mRunning;
+    pthread_t mThreadId;
+    std::vector<GenConnection*> mConns;
+    Thread mThread;
+};
+
+}; // namespace Connection
+
 using namespace Connection;
 
-#define BUF_LEN 1024
-#define SLEEP_US 20000
+// Reactor shared by connections that don't ask for their own thread
+// Never destroyed so connections can detach at any time during exit
+static ConnReactor& reactor()
+{
+    static ConnReactor* s_reactor = new ConnReactor("bts:reactor");
+    return *s_reactor;
+}
+
+ConnReactor::ConnReactor(const char* name)
+    : mName(name ? name : "bts:conn"),
+    mEpollFd(-1), mRunning(false), mThreadId((pthread_t)0)
+{
+}
+
+bool ConnReactor::attach(GenConnection* conn, const char* name)
+{
+    ScopedLock lck(mLock);
+    int fd = conn->mSockFd;
+    if (fd < 0)
+	return false;
+    for (unsigned int i = 0; i < mConns.size(); i++)
+	if (mConns[i] == conn)
+	    return true;
+    if (mEpollFd < 0) {
+	mEpollFd = ::epoll_create(MAX_EVENTS);
+	if (mEpollFd < 0) {
+	    LOG(ERR) << "epoll_create() error " << errno << ": " << strerror(errno);
+	    return false;
+	}
+    }
+    if (!mRunning) {
+	mRunning = true;
+	mThread.start(runFunc,this,"%s",mName.c_str());
+	// Handlers may send as soon as the socket is watched,
+	//  the thread must know its identity before
+	while (mThreadId == (pthread_t)0)
+	    mReady.wait(mLock);
+    }
+    if (!conn->mRecvBuf)
+	conn->mRecvBuf = new unsigned char[conn->mBufSize * RECV_BATCH];
+    conn->mName = name ? name : "";
+    conn->mWaitOut = false;
+    struct epoll_event ev;
+    ::memset(&ev,0,sizeof(ev));
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = conn;
+    if (::epoll_ctl(mEpollFd,EPOLL_CTL_ADD,fd,&ev) && errno != EEXIST) {
+	LOG(ERR) << "epoll_ctl() error " << errno << ": " << strerror(errno);
+	return false;
+    }
+    conn->mStarted = false;
+    mConns.push_back(conn);
+    LOG(INFO) << "attached connection " << conn->mName << " socket " << fd << " to " << mName;
+    return true;
+}
+
+void ConnReactor::detach(GenConnection* conn)
+{
+    ScopedLock lck(mLock);
+    for (std::vector<GenConnection*>::iterator it = mConns.begin(); it != mConns.end(); ++it) {
+	if (*it != conn)
+	    continue;
+	mConns.erase(it);
+	int fd = conn->mSockFd;
+	if (fd >= 0 && mEpollFd >= 0)
+	    ::epoll_ctl(mEpollFd,EPOLL_CTL_DEL,fd,0);
+	break;
+    }
+}
+
+// Queue a message sent by a handler running in this reactor thread
+// Return false if called from another thread, ok is set to the queuing result
+bool ConnReactor::defer(GenConnection* conn, const void* buffer, size_t len, bool& ok)
+{
+    if (!::pthread_equal(__atomic_load_n(&mThreadId,__ATOMIC_ACQUIRE),::pthread_self()))
+	return false;
+    ok = conn->mPending.size() < MAX_PENDING;
+    if (ok)
+	conn->mPending.push_back(std::string(static_cast<const char*>(buffer),len));
+    else
+	LOG(ERR) << "connection " << conn->mName << " send queue full, dropping message";
+    return true;
+}
+
+void* ConnReactor::runFunc(void* ptr)
+{
+    static_cast<ConnReactor*>(ptr)->run();
+    return 0;
+}
+
+void ConnReactor::listConns(std::vector<GenConnection*>& conns)
+{
+    ScopedLock lck(mLock);
+    conns = mConns;
+}
+
+void ConnReactor::run()
+{
+    mLock.lock();
+    __atomic_store_n(&mThreadId,::pthread_self(),__ATOMIC_RELEASE);
+    mReady.broadcast();
+    mLock.unlock();
+    LOG(INFO) << "starting connections loop " << mName;
+    struct epoll_event events[MAX_EVENTS];
+    std::vector<GenConnection*> conns;
+    Timeval idleTime(IDLE_MS);
+    while (true) {
+	pthread_testcancel();
+	listConns(conns);
+	for (unsigned int i = 0; i < conns.size(); i++) {
+	    if (conns[i]->mStarted)
+		continue;
+	    conns[i]->mStarted = true;
+	    conns[i]->started();
+	    flush(conns[i]);
+	}
+	long tOut = idleTime.remaining();
+	if (tOut < 0)
+	    tOut = 0;
+	int n = ::epoll_wait(mEpollFd,events,MAX_EVENTS,tOut);
+	if (n < 0) {
+	    if (errno != EINTR) {
+		LOG(ERR) << "epoll_wait() error " << errno << ": " << strerror(errno);
+		break;
+	    }
+	    n = 0;
+	}
+	// Writable sockets are flushed below with all the others
+	for (int i = 0; i < n; i++) {
+	    if (!(events[i].events & ~EPOLLOUT))
+		continue;
+	    GenConnection* conn = static_cast<GenConnection*>(events[i].data.ptr);
+	    if (!drain(conn))
+		remove(conn);
+	}
+	bool idle = idleTime.passed();
+	if (idle)
+	    idleTime.future(IDLE_MS);
+	listConns(conns);
+	for (unsigned int i = 0; i < conns.size(); i++) {
+	    if (idle && conns[i]->valid())
+		conns[i]->idle();
+	    flush(conns[i]);
+	}
+    }
+    mLock.lock();
+    mRunning = false;
+    __atomic_store_n(&mThreadId,(pthread_t)0,__ATOMIC_RELEASE);
+    mLock.unlock();
+}
+
+// Read all available messages, return false if the connection must be removed
+bool ConnReactor::drain(GenConnection* conn)
+{
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iov[RECV_BATCH];
+    ::memset(msgs,0,sizeof(msgs));
+    for (int i = 0; i < RECV_BATCH; i++) {
+	iov[i].iov_base = conn->mRecvBuf + i * conn->mBufSize;
+	iov[i].iov_len = conn->mBufSize;
+	msgs[i].msg_hdr.msg_iov = &iov[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (true) {
+	int fd = conn->mSockFd;
+	if (fd < 0)
+	    return false;
+	int n = ::recvmmsg(fd,msgs,RECV_BATCH,MSG_DONTWAIT,0);
+	if (n < 0) {
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		return true;
+	    if (errno == EINTR)
+		continue;
+	    LOG(ERR) << "connection " << conn->mName << " recvmmsg() error " << errno << ": " << strerror(errno);
+	    return false;
+	}
+	for (int i = 0; i < n; i++) {
+	    size_t len = msgs[i].msg_len;
+	    if (!len) {
+		LOG(WARNING) << "connection " << conn->mName << " received EOF on socket " << fd;
+		return false;
+	    }
+	    unsigned char* buf = static_cast<unsigned char*>(iov[i].iov_base);
+	    if (len < (size_t)conn->mBufSize)
+		buf[len] = 0;
+	    conn->process(buf,len);
+	}
+	if (!n)
+	    return true;
+    }
+}
+
+// Send the queued messages without blocking the loop
+// If the socket is full keep the rest for when it becomes writable
+void ConnReactor::flush(GenConnection* conn)
+{
+    unsigned int n = conn->mPending.size();
+    if (!n)
+	return;
+    int fd = conn->mSockFd;
+    if (fd >= 0) {
+	struct mmsghdr msgs[n];
+	struct iovec iov[n];
+	::memset(msgs,0,sizeof(msgs));
+	for (unsigned int i = 0; i < n; i++) {
+	    iov[i].iov_base = const_cast<char*>(conn->mPending[i].data());
+	    iov[i].iov_len = conn->mPending[i].size();
+	    msgs[i].msg_hdr.msg_iov = &iov[i];
+	    msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	unsigned int sent = 0;
+	while (sent < n) {
+	    int r = ::sendmmsg(fd,msgs + sent,n - sent,MSG_DONTWAIT);
+	    if (r > 0) {
+		sent += r;
+		continue;
+	    }
+	    if (r < 0 && errno == EINTR)
+		continue;
+	    if (!r || errno == EAGAIN || errno == EWOULDBLOCK) {
+		conn->mPending.erase(conn->mPending.begin(),conn->mPending.begin() + sent);
+		waitOut(conn,true);
+		return;
+	    }
+	    LOG(ERR) << "connection " << conn->mName << " sendmmsg() error " << errno << ": " << strerror(errno);
+	    break;
+	}
+    }
+    conn->mPending.clear();
+    waitOut(conn,false);
+}
+
+// Watch or stop watching a socket for becoming writable
+void ConnReactor::waitOut(GenConnection* conn, bool on)
+{
+    if (conn->mWaitOut == on)
+	return;
+    conn->mWaitOut = on;
+    int fd = conn->mSockFd;
+    if (fd < 0)
+	return;
+    struct epoll_event ev;
+    ::memset(&ev,0,sizeof(ev));
+    ev.events = EPOLLIN | EPOLLET | (on ? EPOLLOUT : 0);
+    ev.data.ptr = conn;
+    if (::epoll_ctl(mEpollFd,EPOLL_CTL_MOD,fd,&ev) && errno != ENOENT)
+	LOG(ERR) << "epoll_ctl() error " << errno << ": " << strerror(errno);
+}
+
+void ConnReactor::remove(GenConnection* conn)
+{
+    LOG(INFO) << "stopped receiving on connection " << conn->mName << " socket " << conn->mSockFd;
+    detach(conn);
+}
+
 
 GenConnection::~GenConnection()
 {
+    if (mReactor)
+	mReactor->detach(this);
     clear();
+    delete[] mRecvBuf;
 }
 
 void GenConnection::clear()
@@ -64,71 +364,38 @@ bool GenConnection::initialize(int fileDesc)
     return true;
 }
 
-bool GenConnection::start(const char* name)
+// Connections whose handlers may block get their own reactor thread
+//  so they don't delay the others
+bool GenConnection::start(const char* name, bool ownThread)
 {
-    struct Local {
-	static void* runFunc(void* ptr) {
-	    static_cast<GenConnection*>(ptr)->run();
-	    return 0;
-	}
-    };
-
     if (!valid())
 	return false;
-    mRecvThread.start(Local::runFunc,this,name);
-    return true;
+    if (!mReactor)
+	mReactor = ownThread ? new ConnReactor(name) : &reactor();
+    return mReactor->attach(this,name);
 }
 
 bool GenConnection::send(const void* buffer, size_t len)
 {
     int fd = mSockFd;
-    return (fd >= 0) && (::send(fd,buffer,len,0) == (int)len);
+    if (fd < 0)
+	return false;
+    bool ok = false;
+    if (mReactor && mReactor->defer(this,buffer,len,ok))
+	return ok;
+    return ::send(fd,buffer,len,0) == (int)len;
 }
 
-void GenConnection::run()
+// Never blocks, fails if the socket buffer is full
+bool GenConnection::sendNoWait(const void* buffer, size_t len)
 {
-    unsigned char buf[mBufSize];
-    struct timeval tOut;
-    fd_set fSet;
-    FD_ZERO(&fSet);
-    LOG(INFO) << "starting thread loop";
-    started();
-    while (valid()) {
-	pthread_testcancel();
-	int fd = mSockFd;
-	if (fd < 0)
-	    break;
-	tOut.tv_sec = 0;
-	tOut.tv_usec = SLEEP_US;
-	FD_SET(fd,&fSet);
-	if (::select(fd + 1,&fSet,0,0,&tOut) < 0) {
-	    if (errno != EAGAIN && errno != EINTR) {
-		LOG(ERR) << "select() error " << errno << ": " << strerror(errno);
-		break;
-	    }
-	    ::usleep(SLEEP_US);
-	    idle();
-	    continue;
-	}
-	if (!FD_ISSET(fd,&fSet)) {
-	    idle();
-	    continue;
-	}
-	ssize_t len = ::recv(fd,buf,mBufSize,MSG_DONTWAIT);
-	if (!len) {
-	    LOG(DEBUG) << "received EOF on socket";
-	    break;
-	}
-	if (len > 0) {
-	    if (len < mBufSize)
-		buf[len] = 0;
-	    process(buf,len);
-	}
-	else if (errno != EAGAIN && errno != EINTR) {
-	    LOG(ERR) << "recv() error " << errno << ": " << strerror(errno);
-	    break;
-	}
-    }
+    int fd = mSockFd;
+    if (fd < 0)
+	return false;
+    bool ok = false;
+    if (mReactor && mReactor->defer(this,buffer,len,ok))
+	return ok;
+    return ::send(fd,buffer,len,MSG_DONTWAIT) == (int)len;
 }
 
 void GenConnection::started()
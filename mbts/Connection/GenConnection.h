@@ -26,30 +26,42 @@
 #include <Threads.h>
 
 #include <sys/types.h>
+#include <string>
+#include <vector>
 
 namespace Connection {
 
+class ConnReactor;
+
 class GenConnection
 {
+    friend class ConnReactor;
 public:
     inline bool valid() const
 	{ return mSockFd >= 0; }
-    bool start(const char* name = 0);
+    bool start(const char* name = 0, bool ownThread = false);
     void clear();
 protected:
     inline GenConnection(int fileDesc = -1, int bufSize = 0)
-	: mSockFd(-1), mBufSize(bufSize)
+	: mSockFd(-1), mBufSize(bufSize), mReactor(0), mRecvBuf(0),
+	  mStarted(false), mWaitOut(false)
 	{ initialize(fileDesc); }
     virtual ~GenConnection();
     bool initialize(int fileDesc);
     virtual bool send(const void* buffer, size_t len);
+    bool sendNoWait(const void* buffer, size_t len);
     virtual void process(const unsigned char* data, size_t len) = 0;
     virtual void started();
     virtual void idle();
-    virtual void run();
     int mSockFd;
     int mBufSize;
-    Thread mRecvThread;
+private:
+    ConnReactor* mReactor;
+    std::string mName;
+    unsigned char* mRecvBuf;
+    bool mStarted;
+    bool mWaitOut;
+    std::vector<std::string> mPending;
 };
 
 }; // namespace Connection
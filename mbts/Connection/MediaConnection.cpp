@@ -48,6 +48,18 @@ bool MediaConnection::send(unsigned int id, const void* data, size_t len, const
     return GenConnection::send(buf,len + len2 + 2);
 }
 
+// Send a message from a thread that must not block, drop it if the socket is full
+bool MediaConnection::sendNoWait(unsigned int id, const void* data, size_t len)
+{
+    if (!valid())
+	return false;
+    unsigned char buf[len + 2];
+    buf[0] = (unsigned char)(id >> 8);
+    buf[1] = (unsigned char)id;
+    ::memcpy(buf + 2,data,len);
+    return GenConnection::sendNoWait(buf,len + 2);
+}
+
 void MediaConnection::process(const unsigned char* data, size_t len)
 {
     if (len < 3) {
@@ -34,6 +34,7 @@ public:
 	: GenConnection(fileDesc,1508)
 	{ }
     bool send(unsigned int id, const void* data, size_t len, const void* data2 = 0, size_t len2 = 0);
+    bool sendNoWait(unsigned int id, const void* data, size_t len);
 private:
     virtual void process(const unsigned char* data, size_t len);
     void process(unsigned int id, const unsigned char* data, size_t len);
@@ -260,6 +260,13 @@ void SigConnection::process(BtsPrimitive prim, unsigned char info)
 void SigConnection::process(BtsPrimitive prim, unsigned char info, const unsigned char* data, size_t len)
 {
     switch (prim) {
+	case SigHandshake:
+	    // Capabilities accepted by peer, tag=value separated by spaces
+	    __atomic_store_n(&mBinaryPhyInfo,
+		std::string((const char*)data,len).find("phyinfo=binary") != std::string::npos,
+		__ATOMIC_RELEASE);
+	    LOG(INFO) << "peer handshake, binary physical info " << (binaryPhyInfo() ? "enabled" : "disabled");
+	    break;
 	case SigStartPaging:
 	    if (len >= 12)
 		processPaging((const char*)data,info);
@@ -607,7 +614,10 @@ void SigConnection::started()
 {
     mHbRecv.future(HB_TIMEOUT);
     mHbSend.future(HB_MAXTIME);
-    send(SigHandshake);
+    __atomic_store_n(&mBinaryPhyInfo,false,__ATOMIC_RELEASE);
+    // Advertise capabilities, older peers ignore them
+    static const char caps[] = "phyinfo=binary";
+    send(SigHandshake,0,caps,sizeof(caps) - 1);
 }
 
 void SigConnection::idle()
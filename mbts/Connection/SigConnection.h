@@ -36,8 +36,12 @@ class SigConnection : public GenConnection
 {
 public:
     inline SigConnection(int fileDesc = -1)
-	: GenConnection(fileDesc,2600), mHbRecv(0,0), mHbSend(0,0)
+	: GenConnection(fileDesc,2600), mHbRecv(0,0), mHbSend(0,0), mBinaryPhyInfo(false)
 	{ }
+    // Check if peer accepted binary physical channel information
+    // Set by the reactor thread on handshake, read by the dispatch threads
+    inline bool binaryPhyInfo() const
+	{ return __atomic_load_n(&mBinaryPhyInfo,__ATOMIC_ACQUIRE); }
     bool send(BtsPrimitive prim, unsigned char info = 0, const void* data = 0, size_t len = 0);
     bool send(BtsPrimitive prim, unsigned char info, unsigned int id);
     bool send(BtsPrimitive prim, unsigned char info, unsigned int id, const void* data, size_t len);
@@ -56,6 +60,7 @@ private:
     void process(BtsPrimitive prim, unsigned char info, unsigned int id, const unsigned char* data, size_t len);
     Timeval mHbRecv;
     Timeval mHbSend;
+    bool mBinaryPhyInfo;
 };
 
 }; // namespace Connection
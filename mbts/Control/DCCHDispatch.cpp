@@ -38,6 +38,7 @@
 #include <Timeval.h>
 
 #include <stdio.h>
+#include <math.h>
 
 using namespace std;
 using namespace GSM;
@@ -47,15 +48,136 @@ using namespace Connection;
 
 #define PHY_INTERVAL 200
 
+// Uplink speech frames receiver of a traffic connection
+// Frames are pushed by the TCH decoder and sent right away on the media socket,
+//  they are dropped if the socket is full as the radio thread can't wait
+class ConnMediaSink : public TCHFrameSink
+{
+public:
+	ConnMediaSink(TCHFACCHLogicalChannel* tch, unsigned int id);
+	virtual ~ConnMediaSink();
+	void detach();
+	virtual void writeTCH(const unsigned char* frame, bool good, uint32_t fn);
+	inline unsigned int frames() const
+		{ return mFrames; }
+	inline unsigned int bad() const
+		{ return mBad; }
+	inline unsigned int dropped() const
+		{ return mDropped; }
+	// Interarrival jitter in ms, as in RFC 3550 6.4.1
+	inline float jitter() const
+		{ return mJitter; }
+private:
+	TCHFACCHLogicalChannel* mTCH;
+	unsigned int mId;
+	unsigned int mFrames;
+	unsigned int mBad;
+	unsigned int mDropped;
+	uint32_t mLastFN;
+	Timeval mLastTime;
+	float mJitter;
+};
+
+ConnMediaSink::ConnMediaSink(TCHFACCHLogicalChannel* tch, unsigned int id)
+	: mTCH(tch), mId(id), mFrames(0), mBad(0), mDropped(0), mLastFN(0), mJitter(0)
+{
+	if (mTCH)
+		mTCH->setTCHSink(this);
+}
+
+ConnMediaSink::~ConnMediaSink()
+{
+	detach();
+}
+
+// Stop receiving frames, returns after any frame in progress was sent
+void ConnMediaSink::detach()
+{
+	if (mTCH)
+		mTCH->setTCHSink(0);
+	mTCH = 0;
+}
+
+// Called from the radio receive thread
+void ConnMediaSink::writeTCH(const unsigned char* frame, bool good, uint32_t fn)
+{
+	if (!gMediaConn.sendNoWait(mId,frame,33))
+		mDropped++;
+	Timeval now;
+	if (mFrames) {
+		// Compare wall clock spacing with the air interface spacing of frames
+		float dTime = (now.sec() - mLastTime.sec()) * 1000.0F +
+			((int)now.usec() - (int)mLastTime.usec()) / 1000.0F;
+		float dAir = FNDelta(fn,mLastFN) * 120.0F / 26.0F;
+		mJitter += (fabsf(dTime - dAir) - mJitter) / 16.0F;
+	}
+	mFrames++;
+	if (!good)
+		mBad++;
+	mLastFN = fn;
+	mLastTime = now;
+}
+
+// Store a value in network byte order
+static inline unsigned char* putNet(unsigned char* p, uint32_t val, unsigned int len)
+{
+	for (unsigned int i = len; i; i--) {
+		p[i - 1] = (unsigned char)val;
+		val >>= 8;
+	}
+	return p + len;
+}
+
+// Clamp a value to a signed 16 bit range
+static inline uint32_t clamp16(long val)
+{
+	if (val > 32767)
+		val = 32767;
+	else if (val < -32768)
+		val = -32768;
+	return (uint32_t)val;
+}
+
+// Send physical channel information in binary format (see BtsPhyInfoField)
+static void sendPhyInfoBinary(LogicalChannel* chan, unsigned int id, const ConnMediaSink* sink)
+{
+	unsigned char buf[PhyInfoMediaLen];
+	unsigned char* p = buf;
+	double t = chan->timestamp();
+	uint32_t sec = (uint32_t)t;
+	p = putNet(p,chan->actualMSTiming(),1);
+	p = putNet(p,clamp16(lroundf(chan->timingError() * 1000.0F)),2);
+	p = putNet(p,clamp16(lroundf(chan->RSSI())),2);
+	p = putNet(p,chan->actualMSPower(),1);
+	p = putNet(p,chan->measurementResults().RXLEV_FULL_SERVING_CELL_dBm(),1);
+	p = putNet(p,sec,4);
+	p = putNet(p,(uint32_t)((t - sec) * 1000.0) % 1000,2);
+	if (sink && sink->frames()) {
+		p = putNet(p,sink->frames(),4);
+		p = putNet(p,sink->bad(),4);
+		p = putNet(p,clamp16(lroundf(sink->jitter() * 10.0F)),2);
+	}
+	gSigConn.send(Connection::SigPhysicalInfo,PhyInfoBinary,id,buf,p - buf);
+}
+
 // Send physical channel information
-static void sendPhyInfo(LogicalChannel* chan, unsigned int id)
+static void sendPhyInfo(LogicalChannel* chan, unsigned int id, const ConnMediaSink* sink = 0)
 {
-	char buf[128];
+	if (gSigConn.binaryPhyInfo()) {
+		sendPhyInfoBinary(chan,id,sink);
+		return;
+	}
+	char buf[192];
 	int len = snprintf(buf, sizeof(buf), "TA=%d TE=%0.3f UpRSSI=%0.0f TxPwr=%d DnRSSIdBm=%d time=%9.3lf",
 		chan->actualMSTiming(), chan->timingError(),
 		chan->RSSI(), chan->actualMSPower(),
 		chan->measurementResults().RXLEV_FULL_SERVING_CELL_dBm(),
 		chan->timestamp());
+	if (len > 0 && sink && sink->frames() && len < (int)sizeof(buf))
+		len += snprintf(buf + len, sizeof(buf) - len, " UpFrames=%u UpBadFrames=%u UpJitter=%0.1f",
+			sink->frames(), sink->bad(), sink->jitter());
+	if (len >= (int)sizeof(buf))
+		len = sizeof(buf) - 1;
 	if (len > 0)
 		gSigConn.send(Connection::SigPhysicalInfo,0,id,buf,len);
 }
@@ -101,18 +223,10 @@ static void connDispatchLoop(LogicalChannel* chan, unsigned int id)
 	if (chan->SACCH())
 		chan->SACCH()->measurementHoldOff();
 	Timeval tPhy(PHY_INTERVAL);
-	unsigned int maxQ = gConfig.getNum("GSM.MaxSpeechLatency");
-	unsigned int tOut = tch ? 5 : 20; // TODO
+	// Uplink voice is pushed to the media socket by the TCH decoder
+	ConnMediaSink sink(tch,id);
+	unsigned int tOut = 20; // TODO
 	while (gSigConn.valid() && (gConnMap.find(id) == chan)) {
-		if (tch) {
-			while (tch->queueSize() > maxQ)
-				delete[] tch->recvTCH();
-			unsigned char* mFrame = tch->recvTCH();
-			if (mFrame) {
-				gMediaConn.send(id,mFrame,33);
-				delete mFrame;
-			}
-		}
 		unsigned char sapi;
 		L3Frame* frame = 0;
 		for (sapi = 1; sapi < 4; sapi++) {
@@ -135,7 +249,7 @@ static void connDispatchLoop(LogicalChannel* chan, unsigned int id)
 			case UNIT_DATA:
 				if (tPhy.passed()) {
 					tPhy.future(PHY_INTERVAL);
-					sendPhyInfo(chan,id);
+					sendPhyInfo(chan,id,tch ? &sink : 0);
 				}
 				if (!connDispatchRR(chan,id,frame))
 					gSigConn.send(sapi,id,frame);
@@ -161,6 +275,7 @@ static void connDispatchLoop(LogicalChannel* chan, unsigned int id)
 		delete frame;
 		break;
 	}
+	sink.detach();
 	const LogicalChannel* ch = gConnMap.find(id);
 	if (ch == chan)
 		gSigConn.send(Connection::SigConnLost,0,id);
@@ -168,6 +283,10 @@ static void connDispatchLoop(LogicalChannel* chan, unsigned int id)
 		chan->send(GSM::RELEASE);
 	LOG(INFO) << "ending dispatch loop for connection " << id <<
 		(ch ? ((ch == chan) ? " (remote release)" : " (reassigned)") : " (local close)");
+	if (sink.frames())
+		LOG(INFO) << "connection " << id << " uplink voice frames=" << sink.frames() <<
+			" bad=" << sink.bad() << " dropped=" << sink.dropped() <<
+			" jitter=" << sink.jitter() << "ms";
 }
 
 // Dispatch new channel establishing frame
@@ -25,6 +25,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <list>
 #include <sstream>
 
@@ -455,6 +456,31 @@ void Control::HandoverDetermination(const L3MeasurementResults& measurements, SA
 
 
 
+PagingIndexBucket& Pager::bucket(const L3MobileIdentity& id)
+{
+	// Must match L3MobileIdentity::operator==, TMSIs are compared by value only.
+	unsigned hash = id.type();
+	if (id.type()==TMSIType) hash = id.TMSI();
+	else {
+		for (const char* d = id.digits(); d && *d; d++) hash = hash*31 + *d;
+	}
+	return mIndex[hash % sPagingIndexSize];
+}
+
+
+unsigned Pager::group(const L3MobileIdentity& id) const
+{
+	// The MS computes its paging group from the IMSI, see GSM 05.02 6.5.2.
+	// A TMSI identity may also carry the IMSI.
+	unsigned groups = mPageIDs.size() - 1;
+	const char* digits = id.digits();
+	if (!groups || !digits || (id.type()!=IMSIType && id.type()!=TMSIType)) return groups;
+	size_t len = strlen(digits);
+	if (len > 3) digits += len - 3;
+	return gBTS.pagingGroup(atoi(digits));
+}
+
+
 void Pager::addID(const L3MobileIdentity& newID, ChannelType chanType,
 		unsigned wLife)
 {
@@ -462,21 +488,34 @@ void Pager::addID(const L3MobileIdentity& newID, ChannelType chanType,
 	//transaction.setTimer("3113",wLife);
 	// Add a mobile ID to the paging list for a given lifetime.
 	ScopedLock lock(mLock);
-	// If this ID is already in the list, just reset its timer.
-	// Uhg, another linear time search.
-	// This would be faster if the paging list were ordered by ID.
-	// But the list should usually be short, so it may not be worth the effort.
-	for (PagingEntryList::iterator lp = mPageIDs.begin(); lp != mPageIDs.end(); ++lp) {
-		if (lp->ID()==newID) {
+	if (mPageIDs.empty()) {
+		LOG(WARNING) << "pager not started, not paging " << newID;
+		return;
+	}
+	unsigned g = group(newID);
+	// If this ID is already in the list, reset its timer.
+	// A TMSI may now come with the IMSI: move the entry to its real paging group.
+	// Keep the known group if the IMSI is missing this time.
+	PagingIndexBucket& b = bucket(newID);
+	for (PagingIndexBucket::iterator bp = b.begin(); bp != b.end(); ++bp) {
+		if ((*bp)->ID()==newID) {
 			LOG(DEBUG) << newID << " already in table";
-			lp->renew(wLife);
+			unsigned old = (*bp)->group();
+			if (g != old && g < mPageIDs.size() - 1) {
+				LOG(INFO) << newID << " paging group changed from " << old << " to " << g;
+				mPageIDs[g].splice(mPageIDs[g].end(),mPageIDs[old],*bp);
+				(*bp)->update(newID,g);
+			}
+			(*bp)->renew(wLife);
 			mPageSignal.signal();
 			return;
 		}
 	}
-	// If this ID is new, put it in the list.
-	mPageIDs.push_back(PagingEntry(newID,chanType,0,wLife));
-	LOG(INFO) << newID << " added to table";
+	// If this ID is new, put it in the list of its paging group.
+	PagingEntryList& list = mPageIDs[g];
+	b.push_back(list.insert(list.end(),PagingEntry(newID,chanType,0,wLife,g)));
+	mCount++;
+	LOG(INFO) << newID << " added to table, paging group " << g;
 	mPageSignal.signal();
 }
 
@@ -486,10 +525,13 @@ unsigned Pager::removeID(const L3MobileIdentity& delID)
 	// Return the associated transaction ID, or 0 if none found.
 	LOG(INFO) << delID;
 	ScopedLock lock(mLock);
-	for (PagingEntryList::iterator lp = mPageIDs.begin(); lp != mPageIDs.end(); ++lp) {
-		if (lp->ID()==delID) {
-			unsigned retVal = lp->transactionID();
-			mPageIDs.erase(lp);
+	PagingIndexBucket& b = bucket(delID);
+	for (PagingIndexBucket::iterator bp = b.begin(); bp != b.end(); ++bp) {
+		if ((*bp)->ID()==delID) {
+			unsigned retVal = (*bp)->transactionID();
+			mPageIDs[(*bp)->group()].erase(*bp);
+			b.erase(bp);
+			mCount--;
 			return retVal;
 		}
 	}
@@ -500,75 +542,132 @@ unsigned Pager::removeID(const L3MobileIdentity& delID)
 
 unsigned Pager::pageAll()
 {
-	// Traverse the full list and page all IDs.
+	// Traverse the paging lists and page all IDs.
 	// Remove expired IDs.
 	// Return the number of IDs paged.
-	// This is a linear time operation.
 
 	ScopedLock lock(mLock);
 
 	// Clear expired entries.
-	PagingEntryList::iterator lp = mPageIDs.begin();
 	// FIXME YATEBTS -- We should probably be looking at a connection table,
 	// to see what paging activity is still meaningful.
-	while (lp != mPageIDs.end()) {
-		bool expired = lp->expired();
-		//bool defunct = gTransactionTable.find(lp->transactionID()) == NULL;
-		//if (!expired && !defunct) ++lp;
-		if (!expired) ++lp;
-		else {
+	for (unsigned g = 0; g < mPageIDs.size(); g++) {
+		PagingEntryList& list = mPageIDs[g];
+		PagingEntryList::iterator lp = list.begin();
+		while (lp != list.end()) {
+			if (!lp->expired()) {
+				++lp;
+				continue;
+			}
 			LOG(INFO) << "erasing " << lp->ID();
-			// Non-responsive, dead transaction?
-			//gTransactionTable.removePaging(lp->transactionID());
-			// remove from the list
-			lp=mPageIDs.erase(lp);
+			PagingIndexBucket& b = bucket(lp->ID());
+			for (PagingIndexBucket::iterator bp = b.begin(); bp != b.end(); ++bp) {
+				if (*bp == lp) {
+					b.erase(bp);
+					break;
+				}
+			}
+			lp = list.erase(lp);
+			mCount--;
 		}
 	}
 
-	LOG(INFO) << "paging " << mPageIDs.size() << " mobile(s)";
+	LOG(INFO) << "paging " << mCount << " mobile(s)";
+	if (!mCount) return 0;
 
-	// Page remaining entries, two at a time if possible.
+	// Page each group in its own paging blocks.
 	// These PCH send operations are non-blocking.
-	lp = mPageIDs.begin();
-	while (lp != mPageIDs.end()) {
-		// FIXME -- This completely ignores the paging groups.
-		// HACK -- So we send every page twice.
-		// That will probably mean a different Pager for each subchannel.
-		// See GSM 04.08 10.5.2.11 and GSM 05.02 6.5.2.
-		const L3MobileIdentity& id1 = lp->ID();
-		ChannelType type1 = lp->type();
-		++lp;
-		if (lp==mPageIDs.end()) {
-			// Just one ID left?
-			LOG(DEBUG) << "paging " << id1;
-			gBTS.getPCH(0)->send(L3PagingRequestType1(id1,type1));
-			gBTS.getPCH(0)->send(L3PagingRequestType1(id1,type1));
-			SGSN::Sgsn::sendPaging(id1.digits(),id1.TMSI(),type1);
-			break;
+	// IDs with unknown paging group are paged in all groups.
+	unsigned groups = mPageIDs.size() - 1;
+	const PagingEntryList& all = mPageIDs[groups];
+	std::vector<const PagingEntry*> tmsis;
+	std::vector<const PagingEntry*> others;
+	for (unsigned g = 0; g < groups; g++) {
+		tmsis.clear();
+		others.clear();
+		for (int n = 0; n < 2; n++) {
+			const PagingEntryList& list = n ? all : mPageIDs[g];
+			for (PagingEntryList::const_iterator lp = list.begin(); lp != list.end(); ++lp) {
+				if (lp->ID().type()==TMSIType) tmsis.push_back(&*lp);
+				else others.push_back(&*lp);
+			}
 		}
-		// Page by pairs when possible.
-		const L3MobileIdentity& id2 = lp->ID();
-		ChannelType type2 = lp->type();
-		++lp;
-		LOG(DEBUG) << "paging " << id1 << " and " << id2;
-		gBTS.getPCH(0)->send(L3PagingRequestType1(id1,type1,id2,type2));
-		gBTS.getPCH(0)->send(L3PagingRequestType1(id1,type1,id2,type2));
-		SGSN::Sgsn::sendPaging(id1.digits(),id1.TMSI(),type1);
-		SGSN::Sgsn::sendPaging(id2.digits(),id2.TMSI(),type2);
+		if (tmsis.size() || others.size()) pageGroup(g,tmsis,others);
 	}
 
-	return mPageIDs.size();
+	for (unsigned g = 0; g < mPageIDs.size(); g++) {
+		const PagingEntryList& list = mPageIDs[g];
+		for (PagingEntryList::const_iterator lp = list.begin(); lp != list.end(); ++lp) {
+			const L3MobileIdentity& id = lp->ID();
+			SGSN::Sgsn::sendPaging(id.digits(),id.TMSI(),lp->type());
+		}
+	}
+
+	return mCount;
+}
+
+
+void Pager::pageGroup(unsigned group, const std::vector<const PagingEntry*>& tmsis,
+	const std::vector<const PagingEntry*>& others)
+{
+	// Pack as many IDs as possible in each paging request, GSM 04.08 9.1.22-9.1.24:
+	// Type 3 carries 4 TMSIs, Type 2 carries 2 TMSIs and another ID, Type 1 carries any 2 IDs.
+	size_t t = 0;
+	size_t o = 0;
+	while (t < tmsis.size() || o < others.size()) {
+		size_t tLeft = tmsis.size() - t;
+		size_t oLeft = others.size() - o;
+		if (tLeft >= 4) {
+			L3MobileIdentity ids[4];
+			ChannelType types[4];
+			for (unsigned i = 0; i < 4; i++, t++) {
+				ids[i] = tmsis[t]->ID();
+				types[i] = tmsis[t]->type();
+			}
+			LOG(DEBUG) << "paging group " << group << " " << ids[0] << ", " << ids[1]
+				<< ", " << ids[2] << " and " << ids[3];
+			gBTS.sendPCH(L3PagingRequestType3(ids,types),group);
+		}
+		else if (tLeft >= 2 && tLeft + oLeft >= 3) {
+			const PagingEntry* e1 = tmsis[t++];
+			const PagingEntry* e2 = tmsis[t++];
+			const PagingEntry* e3 = (tLeft > 2) ? tmsis[t++] : others[o++];
+			LOG(DEBUG) << "paging group " << group << " " << e1->ID() << ", " << e2->ID()
+				<< " and " << e3->ID();
+			gBTS.sendPCH(L3PagingRequestType2(e1->ID(),e1->type(),e2->ID(),e2->type(),
+				e3->ID(),e3->type()),group);
+		}
+		else {
+			const PagingEntry* e1 = (t < tmsis.size()) ? tmsis[t++] : others[o++];
+			const PagingEntry* e2 = NULL;
+			if (t < tmsis.size()) e2 = tmsis[t++];
+			else if (o < others.size()) e2 = others[o++];
+			if (e2) {
+				LOG(DEBUG) << "paging group " << group << " " << e1->ID() << " and " << e2->ID();
+				gBTS.sendPCH(L3PagingRequestType1(e1->ID(),e1->type(),e2->ID(),e2->type()),group);
+			}
+			else {
+				LOG(DEBUG) << "paging group " << group << " " << e1->ID();
+				gBTS.sendPCH(L3PagingRequestType1(e1->ID(),e1->type()),group);
+			}
+		}
+	}
 }
 
 size_t Pager::pagingEntryListSize()
 {
 	ScopedLock lock(mLock);
-	return mPageIDs.size();
+	return mCount;
 }
 
 void Pager::start()
 {
 	if (mRunning) return;
+	mLock.lock();
+	// One list for each paging group and one for IDs paged in all groups
+	mPageIDs.resize(gBTS.pagingGroups() + 1);
+	mLock.unlock();
+	LOG(INFO) << "paging groups: " << gBTS.pagingGroups();
 	mRunning=true;
 	mPagingThread.start((void* (*)(void*))PagerServiceLoopAdapter, (void*)this);
 }
@@ -587,17 +686,19 @@ void Pager::serviceLoop()
 
 		LOG(DEBUG) << "Pager blocking for signal";
 		mLock.lock();
-		while (mPageIDs.size()==0) mPageSignal.wait(mLock);
+		while (mCount==0) mPageSignal.wait(mLock);
 		mLock.unlock();
 
 		// page everything
 		pageAll();
 
-		// Wait for pending activity to clear the channel.
-		// This wait is what causes PCH to have lower priority than AGCH.
-		unsigned load = gBTS.getPCH()->load();
-		LOG(DEBUG) << "Pager waiting for " << load << " multiframes";
-		if (load) sleepFrames(51*load);
+		// Wait for the paging requests to be sent in their paging blocks.
+		// Each paging group gets one paging block in each paging cycle.
+		unsigned cycle = 51 * gBTS.pagingMultiframes();
+		do {
+			LOG(DEBUG) << "Pager waiting for " << gBTS.pagingLoad() << " paging requests";
+			sleepFrames(cycle);
+		} while (mRunning && gBTS.pagingLoad());
 	}
 }
 
@@ -606,10 +707,12 @@ void Pager::serviceLoop()
 void Pager::dump(ostream& os) const
 {
 	ScopedLock lock(mLock);
-	PagingEntryList::const_iterator lp = mPageIDs.begin();
-	while (lp != mPageIDs.end()) {
-		os << lp->ID() << " " << lp->type() << " " << lp->expired() << endl;
-		++lp;
+	for (unsigned g = 0; g < mPageIDs.size(); g++) {
+		PagingEntryList::const_iterator lp = mPageIDs[g].begin();
+		while (lp != mPageIDs[g].end()) {
+			os << lp->ID() << " " << lp->type() << " " << lp->expired() << " " << g << endl;
+			++lp;
+		}
 	}
 }
 
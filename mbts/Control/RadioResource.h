@@ -23,6 +23,7 @@
 #define RADIORESOURCE_H
 
 #include <list>
+#include <vector>
 #include <GSML3CommonElements.h>
 #include <Interthread.h>
 
@@ -110,6 +111,7 @@ class PagingEntry {
 	GSM::ChannelType mType;			///< The needed channel type.
 	unsigned mTransactionID;		///< The associated transaction ID.
 	Timeval mExpiration;			///< The expiration time for this entry.
+	unsigned mGroup;			///< The paging group.
 
 	public:
 
@@ -117,10 +119,12 @@ class PagingEntry {
 		Create a new entry, with current timestamp.
 		@param wID The ID to be paged.
 		@param wLife The number of milliseconds to keep paging.
+		@param wGroup The paging group of the ID.
 	*/
 	PagingEntry(const GSM::L3MobileIdentity& wID, GSM::ChannelType wType,
-			unsigned wTransactionID, unsigned wLife)
-		:mID(wID),mType(wType),mTransactionID(wTransactionID),mExpiration(wLife)
+			unsigned wTransactionID, unsigned wLife, unsigned wGroup)
+		:mID(wID),mType(wType),mTransactionID(wTransactionID),mExpiration(wLife),
+		mGroup(wGroup)
 	{}
 
 	/** Access the ID. */
@@ -131,9 +135,19 @@ class PagingEntry {
 
 	unsigned transactionID() const { return mTransactionID; }
 
+	/** Access the paging group. */
+	unsigned group() const { return mGroup; }
+
 	/** Renew the timer. */
 	void renew(unsigned wLife) { mExpiration = Timeval(wLife); }
 
+	/**
+		Update the ID and its paging group, the IMSI may have become known.
+		@param wID The new ID, equal to the current one.
+		@param wGroup The paging group of the new ID.
+	*/
+	void update(const GSM::L3MobileIdentity& wID, unsigned wGroup) { mID = wID; mGroup = wGroup; }
+
 	/** Returns true if the entry is expired. */
 	bool expired() const { return mExpiration.passed(); }
 
@@ -141,19 +155,29 @@ class PagingEntry {
 
 typedef std::list<PagingEntry> PagingEntryList;
 
+/** A bucket of the paging index, entries having the same ID hash. */
+typedef std::list<PagingEntryList::iterator> PagingIndexBucket;
+
+/** Number of buckets in the paging index. */
+const unsigned sPagingIndexSize = 256;
+
 
 /**
 	The pager is a global object that generates paging messages on the CCCH.
 	To page a mobile, add the mobile ID to the pager.
 	The entry will be deleted automatically when it expires.
-	All pager operations are linear time.
-	Not much point in optimizing since the main operation is inherently linear.
+	Entries are kept in a list for each paging group and are paged only in the
+	paging blocks of their group, GSM 05.02 6.5.
+	IDs without a known IMSI are paged in all groups.
+	Entries are also indexed by mobile ID so adding and removing IDs take constant time.
 */
 class Pager {
 
 	private:
 
-	PagingEntryList mPageIDs;				///< List of ID's to be paged.
+	std::vector<PagingEntryList> mPageIDs;	///< ID's to be paged, per paging group, the last one for all groups.
+	std::vector<PagingIndexBucket> mIndex;	///< Entries indexed by ID hash.
+	size_t mCount;						///< Number of ID's to be paged.
 	mutable Mutex mLock;					///< Lock for thread-safe access.
 	Signal mPageSignal;						///< signal to wake the paging loop
 	Thread mPagingThread;					///< Thread for the paging loop.
@@ -162,7 +186,7 @@ class Pager {
 	public:
 
 	Pager()
-		:mRunning(false)
+		:mIndex(sPagingIndexSize),mCount(0),mRunning(false)
 	{}
 
 	/** Set the output FIFO and start the paging loop. */
@@ -190,12 +214,27 @@ class Pager {
 
 	private:
 
+	/** Return the index bucket of a mobile ID. */
+	PagingIndexBucket& bucket(const GSM::L3MobileIdentity&);
+
+	/** Return the paging group of a mobile ID, the last group if the IMSI is unknown. */
+	unsigned group(const GSM::L3MobileIdentity&) const;
+
 	/**
-		Traverse the paging list, paging all IDs.
+		Traverse the paging lists, paging all IDs in their paging groups.
 		@return Number of IDs paged.
 	*/
 	unsigned pageAll();
 
+	/**
+		Pack the IDs of a paging group in paging requests and send them.
+		@param group The paging group.
+		@param tmsis Entries to be paged by TMSI.
+		@param others Entries to be paged by other identities.
+	*/
+	void pageGroup(unsigned group, const std::vector<const PagingEntry*>& tmsis,
+		const std::vector<const PagingEntry*>& others);
+
 	/** A loop that repeatedly calls pageAll. */
 	void serviceLoop();
 
@@ -22,6 +22,14 @@
 #define FEC_DEBUG 0
 
 namespace GPRS {
+
+// Configuration values used per RLC block
+static ConfigKey<bool> cfgGprsTap("Control.GSMTAP.GPRS");
+static ConfigKey<long> cfgSendIdleFrames("GPRS.SendIdleFrames");
+static ConfigKey<long> cfgPowerAlpha("GPRS.MS.Power.Alpha");
+static ConfigKey<long> cfgPowerGamma("GPRS.MS.Power.Gamma");
+static ConfigKey<long> cfgPowerRSSITarget("GPRS.MS.Power.RSSITarget");
+static ConfigKey<long> cfgPowerRSSIInterval("GPRS.MS.Power.RSSIInterval");
 static BitVector *decodeLowSide(const RxBurst &inBurst, int B, GprsDecoder &decoder, ChannelCodingType *ccPtr);
 //static int sFecDebug = 1;
 
@@ -42,10 +50,53 @@ const int GPRSUSFEncoding[8] = {
 	07240  // 111 010 100 000
 };
 
+const int GPRSUSFEncodingCS23[8] = {
+	// from table at GSM05.03 sec 5.1.2.2, used by both CS-2 and CS-3.
+	// 3 bits in, 6 bits out; the first 3 bits are the usf itself.
+	000, // 000 000
+	013, // 001 011
+	026, // 010 110
+	035, // 011 101
+	045, // 100 101
+	056, // 101 110
+	063, // 110 011
+	070  // 111 000
+};
+
+// Positions of the 456 transmitted bits within the unpunctured convolutional code
+// for CS-2 and CS-3.  Index is ChannelCodingCS2 - 1 or ChannelCodingCS3 - 1.
+// GSM05.03 sec 5.1.2.3: CS-2 punctures C(4i+3) for i = 3..146 except i = 9,21,33,...,141.
+// GSM05.03 sec 5.1.3.3: CS-3 punctures C(6i+3) and C(6i+5) for i = 2..111.
+static struct GprsPuncture {
+	short mKept[2][456];
+	GprsPuncture() {
+		for (int k = 0, j = 0; k < 588; k++) {
+			int i = k / 4;
+			if (k % 4 == 3 && i >= 3 && i <= 146 && i % 12 != 9) { continue; }
+			assert(j < 456);
+			mKept[0][j++] = k;
+		}
+		for (int k = 0, j = 0; k < 676; k++) {
+			int i = k / 6;
+			if ((k % 6 == 3 || k % 6 == 5) && i >= 2 && i <= 111) { continue; }
+			assert(j < 456);
+			mKept[1][j++] = k;
+		}
+	}
+	const short *kept(ChannelCodingType cs) const { return mKept[cs == ChannelCodingCS3]; }
+} sPuncture;
+
+// Number of data bits, bytes and u[] bits for CS-2 and CS-3, see GprsEncoder.
+static inline unsigned cs23DataBits(ChannelCodingType cs) { return cs == ChannelCodingCS3 ? 315 : 271; }
+static inline unsigned cs23DataBytes(ChannelCodingType cs) { return cs == ChannelCodingCS3 ? 39 : 33; }
+static inline unsigned cs23USize(ChannelCodingType cs) { return cs23DataBits(cs) + 3 + 16 + 4; }
+// Steps of known zero input appended past the tail bits when decoding CS-2 and CS-3.
+static const unsigned cs23Flush = 4;
+
 
 // Do the reverse encoding on usf, and return the reversed usf,
 // ie, the returned usf is byte-swapped.
-static int decodeUSF(SoftVector &mC)
+static int decodeUSF(SoftVector8 &mC)
 {
 	// TODO: Make this more robust.
 	// Update: No dont bother, should always be zero anyway.
@@ -234,7 +285,7 @@ static GSM::TypeAndOffset frame2GsmTapType(BitVector &frame)
 
 void PDCHL1Downlink::send1Frame(BitVector& frame,ChannelCodingType encoding, bool idle)
 {
-	if (!idle && gConfig.getBool("Control.GSMTAP.GPRS")) {
+	if (!idle && cfgGprsTap.get()) {
 		// Send to GSMTAP.
 		gWriteGSMTAP(ARFCN(),TN(),gBSNNext.FN(),
 				frame2GsmTapType(frame),
@@ -251,6 +302,14 @@ void PDCHL1Downlink::send1Frame(BitVector& frame,ChannelCodingType encoding, boo
 		mchEnc.encodeCS1(frame);
 		transmit(gBSNNext,mchEnc.mI,qCS1,0);
 		break;
+	case ChannelCodingCS2:
+		mchEnc.encodeCS2(frame);	// Result left in mI[].
+		transmit(gBSNNext,mchEnc.mI,qCS2,0);
+		break;
+	case ChannelCodingCS3:
+		mchEnc.encodeCS3(frame);	// Result left in mI[].
+		transmit(gBSNNext,mchEnc.mI,qCS3,0);
+		break;
 	case ChannelCodingCS4:
 		//std::cout << "WARNING: Using CS4\n";
 		// This did not help the 3105/3101 errors:
@@ -394,7 +453,7 @@ bool PDCHL1Downlink::send1MsgFrame(
 	
 	bool dummy = msg->mMessageType == RLCDownlinkMessage::PacketDownlinkDummyControlBlock;
 	bool idle = dummy && msg->isMacUnused();
-	if (idle && 0 == gConfig.getNum("GPRS.SendIdleFrames")) {
+	if (idle && 0 == cfgSendIdleFrames.get()) {
 		delete msg;		// Let the transceiver send an idle frame.
 		return false;	// This return value will not be checked.
 	}
@@ -455,15 +514,21 @@ void PDCHL1Downlink::initBursts(L1FEC *oldfec)
 
 
 // Determine CS from the qbits.
+// The stealing bit patterns of CS-2, CS-3 and CS-4 are 5, 6 and 5 bits apart from CS-1
+// and at least 5 bits apart from each other, so picking the one closest to what we
+// received survives up to 2 bit errors.
 ChannelCodingType GprsDecoder::getCS()
 {
-	// TODO: Make this more robust.
-	// Currently we only support CS1 or CS4, so just look at the first bit.
-	if (qbits[0]) {
-		return ChannelCodingCS1;
-	} else {
-		return ChannelCodingCS4;
+	static const int *patterns[4] = { qCS1, qCS2, qCS3, qCS4 };
+	int best = ChannelCodingCS1, bestDist = 9;
+	for (int cs = ChannelCodingCS1; cs <= ChannelCodingCS4; cs++) {
+		int dist = 0;
+		for (int i = 0; i < 8; i++) {
+			if ((qbits[i] != 0) != (patterns[cs][i] != 0)) { dist++; }
+		}
+		if (dist < bestDist) { best = cs; bestDist = dist; }
 	}
+	return (ChannelCodingType) best;
 }
 
 BitVector *GprsDecoder::getResult()
@@ -471,16 +536,54 @@ BitVector *GprsDecoder::getResult()
 	switch (getCS()) {
 	case ChannelCodingCS4:
 		return &mD_CS4;
+	case ChannelCodingCS3:
+		return &mD_CS3;
+	case ChannelCodingCS2:
+		return &mD_CS2;
 	case ChannelCodingCS1:
 		return &mD;
-	default: devassert(0);	// Others not supported yet.
+	default: devassert(0);
 		return NULL;
 	}
 }
 
+// Decode CS-2 or CS-3.  The result is left in mD_CS2 or mD_CS3, the head of dp.
+bool GprsDecoder::decodeCS23(ChannelCodingType cs, Parity &coder, BitVector &dp)
+{
+	// Incoming data is in SoftVector8 mC(456) and has already been deinterleaved.
+	// Put it back into the unpunctured positions; the punctured ones are unknown (0).
+	// The tail bits return the encoder to state 0 but the decoder just picks the best
+	// end state, so with the puncturing a single bit error in the last bits could move
+	// the decoded path.  Past the tail the encoder would send only zeros, append them.
+	unsigned usize = cs23USize(cs);
+	SoftVector8 cc(mCC_CS23.head(2*(usize+cs23Flush)));
+	cc.fill(0);
+	const short *kept = sPuncture.kept(cs);
+	for (int j = 0; j < 456; j++) { cc[kept[j]] = mC[j]; }
+	for (unsigned k = 2*usize; k < cc.size(); k++) { cc[k] = SoftVector8::Zero; }
+	BitVector u(mU_CS23.head(usize+cs23Flush));
+	cc.decode(mVCoder,u);
+
+	// The first 6 bits are the precoded usf.  Pick the nearest codeword.
+	unsigned precoded = u.peekField(0,6), reverseUsf = 0, bestDist = 7;
+	for (unsigned i = 0; i < 8; i++) {
+		unsigned diff = precoded ^ GPRSUSFEncodingCS23[i], dist = 0;
+		for (; diff; diff &= diff - 1) { dist++; }
+		if (dist < bestDist) { reverseUsf = i; bestDist = dist; }
+	}
+	// Rebuild d[]:p[] with the 3 bit usf, and check the parity.
+	unsigned databits = cs23DataBits(cs);
+	dp.fillField(0,reverseUsf,3);
+	u.segment(6,databits-3+16).copyToSegment(dp,3);
+	BitVector parity(dp.segment(databits,16));
+	parity.invert();
+	unsigned syndrome = coder.syndrome(dp);
+	return (syndrome==0);
+}
+
 bool GprsDecoder::decodeCS4()
 {
-	// Incoming data is in SoftVector mC(456) and has already been deinterleaved.
+	// Incoming data is in SoftVector8 mC(456) and has already been deinterleaved.
 	// Convert the SoftVector directly into bits: data + parity:
 	// The first 12 bits need to be reconverted to 3 bits of usf.
 	// Yes, they do this even on uplink, where there is no usf 5.03 sec 5.1.
@@ -489,10 +592,10 @@ bool GprsDecoder::decodeCS4()
 	unsigned reverseUsf = decodeUSF(mC);
 	mDP_CS4.fillField(0,reverseUsf,3);
 	// We are grubbing into the arrays.  TODO: move this into the classes somewhere.
-	float *in = mC.begin() + 12;
+	int8_t *in = mC.begin() + 12;
 	char *out = mDP_CS4.begin() + 3;
 	for (int i = 12; i < 456; i++) {
-		*out++ = *in++ > 0.5 ? 1 : 0;
+		*out++ = *in++ > 0 ? 1 : 0;
 	}
 	BitVector parity(mDP_CS4.segment(440-12+3,16));
 	parity.invert();
@@ -508,6 +611,34 @@ void GprsEncoder::encodeCS1(const BitVector &src)
 	encodeFrame41(src,0);
 }
 
+// Process the 271 (CS-2) or 315 (CS-3) bit frame, add parity, encode, puncture.
+// Result is left in mI, representing 4 radio bursts.
+void GprsEncoder::encodeCS23(const BitVector &src, ChannelCodingType cs, Parity &coder)
+{
+	unsigned databits = cs23DataBits(cs);
+	unsigned databytes = cs23DataBytes(cs);
+	unsigned usize = cs23USize(cs);
+	// Data goes after the first 3 bits so the usf lands at the start of u[] where it will
+	// be overwritten by its 6 bit precoded version, just like CS-4.
+	BitVector d(mU_CS23.segment(3,databits));
+	BitVector p(mU_CS23.segment(3+databits,16));
+	src.copyToSegment(d,0,databytes*8);
+	d.fillField(databytes*8,0,databits-databytes*8);	// zero out spare bits.
+	d.LSB8MSB();	// Ignores the last incomplete byte of spare bits.
+	// Parity is computed on original d before precoding the usf.
+	coder.writeParityWord(d,p);
+	mU_CS23.fillField(3+databits+16,0,4);	// tail bits.
+	int reverseUsf = d.peekField(0,3);
+	mU_CS23.fillField(0,GPRS::GPRSUSFEncodingCS23[reverseUsf],6);
+	BitVector u(mU_CS23.head(usize));
+	BitVector c(mC_CS23.head(2*usize));
+	u.encode(mVCoder,c);
+	// Puncture down to 456 bits in mC.
+	const short *kept = sPuncture.kept(cs);
+	for (int j = 0; j < 456; j++) { mC[j] = c.bit(kept[j]); }
+	interleave41();	// Interleaves mC into mI.
+}
+
 static BitVector mCcopy;
 void GprsEncoder::encodeCS4(const BitVector &src)
 {
@@ -557,12 +688,22 @@ static BitVector *decodeLowSide(const RxBurst &inBurst, int B, GprsDecoder &deco
 		GPRSLOG(DEBUG,GPRS_LOOP) << "CS-4 success=" << success;
 		result = &decoder.mD_CS4;
 		break;
+	case ChannelCodingCS3:
+		success = decoder.decodeCS3();
+		GPRSLOG(DEBUG,GPRS_LOOP) << "CS-3 success=" << success;
+		result = &decoder.mD_CS3;
+		break;
+	case ChannelCodingCS2:
+		success = decoder.decodeCS2();
+		GPRSLOG(DEBUG,GPRS_LOOP) << "CS-2 success=" << success;
+		result = &decoder.mD_CS2;
+		break;
 	case ChannelCodingCS1:
 		success = decoder.decode();
 		GPRSLOG(DEBUG,GPRS_LOOP) << "CS-1 success=" << success;
 		result = &decoder.mD;
 		break;
-	default: devassert(0);	// Others not supported yet.
+	default: devassert(0);
 		return NULL;
 	}
 
@@ -673,7 +814,7 @@ void PDCHL1Uplink::writeLowSideRx(const RxBurst &inBurst)
 			countGoodFrame();
 
 			// The four frame radio block has been decoded and is in mD.
-			if (gConfig.getBool("Control.GSMTAP.GPRS")) {
+			if (cfgGprsTap.get()) {
 				// Send to GSMTAP.  Untested.
 				gWriteGSMTAP(ARFCN(),TN(),gBSNNext.FN(), //GSM::TDMA_PACCH,
 						frame2GsmTapType(*result),
@@ -916,7 +1057,7 @@ TBF *PDCHCommon::getTFITBF(int tfi, RLCDirType dir)
 int GetPowerAlpha()
 {
 	// God only knows what this should be.
-	int alpha = gConfig.getNum("GPRS.MS.Power.Alpha");
+	int alpha = cfgPowerAlpha.get();
 	// The value runs 0..10 representing increments of 10%
 	return RN_BOUND(alpha,0,10);		// Bound to allowed values.
 }
@@ -924,7 +1065,7 @@ int GetPowerAlpha()
 int GetPowerGamma()
 {
 	// 0 means full power and let the MS control power.
-	int gamma = gConfig.getNum("GPRS.MS.Power.Gamma");
+	int gamma = cfgPowerGamma.get();
 	return RN_BOUND(gamma,0,31);		// Bound to allowed values, 5 bits.
 }
 
@@ -947,13 +1088,13 @@ int GetPowerGammaAdjust(int rssi, int gamma)
 
 int GetGprsTargetRSSI()
 {
-	int rssi = gConfig.getNum("GPRS.MS.Power.RSSITarget");
+	int rssi = cfgPowerRSSITarget.get();
 	return RN_BOUND(rssi,-75,-5);
 }
 
 int GetTargetRSSIInterval()
 {
-	int tolerance = gConfig.getNum("GPRS.MS.Power.RSSIInterval");
+	int tolerance = cfgPowerRSSIInterval.get();
 	return RN_BOUND(tolerance,0,10);
 }
 
@@ -129,24 +129,50 @@ class PDCHL1FEC :
 std::ostream& operator<<(std::ostream& os, PDCHL1FEC *ch);
 
 // For CS-1 decoding, just uses SharedL1Decoder.
+// For CS-2 and CS-3 decoding: Uses the SharedL1Decoder deinterleaving into mC,
+// then depunctures into mCC_CS23 and runs the convolutional decoder into mU_CS23.
 // For CS-4 decoding: Uses the SharedL1Decoder through deinterleaving into mC.
 class GprsDecoder : public SharedL1Decoder
 {
 	Parity mBlockCoder_CS4;
 	BitVector mDP_CS4;
+	Parity mBlockCoder_CS2;
+	Parity mBlockCoder_CS3;
+	SoftVector8 mCC_CS23;	// Depunctured convolutional code and flush, 596 (CS-2) or 684 (CS-3) bits used.
+	BitVector mU_CS23;		// Decoded usf+data+parity+tail+flush, 298 (CS-2) or 342 (CS-3) bits used.
+	BitVector mDP_CS2;
+	BitVector mDP_CS3;
+	bool decodeCS23(ChannelCodingType cs, Parity &coder, BitVector &dp);
 	public:
 	BitVector mD_CS4;
+	BitVector mD_CS2;
+	BitVector mD_CS3;
 	short qbits[8];
 	ChannelCodingType getCS();	// Determine CS from the qbits.
 	BitVector *getResult();
 	GprsDecoder() :
 		mBlockCoder_CS4(sCS4Generator,16,431+16),
 		mDP_CS4(431+16),
-		mD_CS4(mDP_CS4.head(424))
+		mBlockCoder_CS2(sCS4Generator,16,271+16),
+		mBlockCoder_CS3(sCS4Generator,16,315+16),
+		mCC_CS23(2*(338+4)),
+		mU_CS23(338+4),
+		mDP_CS2(271+16),
+		mDP_CS3(315+16),
+		mD_CS4(mDP_CS4.head(424)),
+		mD_CS2(mDP_CS2.head(264)),
+		mD_CS3(mDP_CS3.head(312))
 		{}
+	bool decodeCS2() { return decodeCS23(ChannelCodingCS2,mBlockCoder_CS2,mDP_CS2); }
+	bool decodeCS3() { return decodeCS23(ChannelCodingCS3,mBlockCoder_CS3,mDP_CS3); }
 	bool decodeCS4();
 };
 
+// CS-2 has 271 input data bits, which are 264 real data bits (33 bytes) plus 7 spare bits;
+// CS-3 has 315 input data bits, which are 312 real data bits (39 bytes) plus 3 spare bits.
+// 16 bit parity is computed on the data bits, then the first 3 bits are usf precoded to 6 bits
+// and 4 tail bits are added, yielding 294 (CS-2) or 338 (CS-3) bits.
+// They are convolutionally coded like CS-1 and punctured down to 456 bits.
 // CS-4 has 431 input data bits, which are always 424 real data bits (53 bytes)
 // plus 7 unused bits that are set to 0, to make 431 data bits.
 // The first 3 bits are usf encoded to 12 bits, to yield 440 bits.
@@ -154,6 +180,11 @@ class GprsDecoder : public SharedL1Decoder
 class GprsEncoder : public SharedL1Encoder
 {
 	Parity mBlockCoder_CS4;
+	Parity mBlockCoder_CS2;
+	Parity mBlockCoder_CS3;
+	BitVector mU_CS23;	// u[] for CS-2 and CS-3, 294 (CS-2) or 338 (CS-3) bits used.
+	BitVector mC_CS23;	// Unpunctured convolutional code, 588 (CS-2) or 676 (CS-3) bits used.
+	void encodeCS23(const BitVector&src, ChannelCodingType cs, Parity &coder);
 	public:
 	// Uses SharedL1Encoder::mC for result vector
 	// Uses SharedL1Encoder::mI for the 4-way interleaved result vector.
@@ -163,11 +194,17 @@ class GprsEncoder : public SharedL1Encoder
 	GprsEncoder() :
 		SharedL1Encoder(),
 		mBlockCoder_CS4(sCS4Generator,16,431+16),
+		mBlockCoder_CS2(sCS4Generator,16,271+16),
+		mBlockCoder_CS3(sCS4Generator,16,315+16),
+		mU_CS23(338),
+		mC_CS23(2*338),
 		mP_CS4(mC.segment(440,16)),
 		mU_CS4(mC.segment(0,12)),
 		mD_CS4(mC.segment(12-3,431))
 		{}
 	void encodeCS4(const BitVector&src);
+	void encodeCS2(const BitVector&src) { encodeCS23(src,ChannelCodingCS2,mBlockCoder_CS2); }
+	void encodeCS3(const BitVector&src) { encodeCS23(src,ChannelCodingCS3,mBlockCoder_CS3); }
 	void encodeCS1(const BitVector &src);
 };
 
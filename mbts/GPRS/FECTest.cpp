@@ -0,0 +1,150 @@
+/*
+* Copyright 2011 Range Networks, Inc.
+* All Rights Reserved.
+*
+* This software is distributed under multiple licenses;
+* see the COPYING file in the main directory for licensing
+* information for this specific distribuion.
+*
+* This use of this software may be subject to additional restrictions.
+* See the LEGAL file in the main directory for details.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+// CS-2 and CS-3 encode/decode round trip through the interleaver and the stealing bits.
+
+#include "FEC.h"
+#include <Reporting.h>
+#include <TRXManager.h>
+#include <PhysicalStatus.h>
+#include <NeighborTable.h>
+#include <SigConnection.h>
+#include <MediaConnection.h>
+#include <ConnectionMap.h>
+#include <GprsConnMap.h>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+using namespace GPRS;
+
+// The coders come in the libraries with the rest of the BTS,
+// which needs the globals of apps/OpenBTS.cpp.  No radio or YBTS is connected.
+ConfigurationKeyMap getConfigurationKeys();
+ConfigurationTable gConfig("/dev/null","FECTest",getConfigurationKeys());
+ReportingTable gReports(":memory:");
+GSM::PhysicalStatus gPhysStatus;
+GSMConfig gBTS;
+TransceiverManager gTRX(0,gConfig.getNum("TRX.Port"));
+Peering::NeighborTable gNeighborTable;
+Connection::SigConnection gSigConn;
+Connection::MediaConnection gMediaConn;
+Connection::ConnectionMap gConnMap;
+Connection::GprsConnMap gGprsMap;
+
+
+// Send an encoded block through the decoder, with one certain bit error at position
+// k of c[] if k >= 0, plus some weak wrong bits and erasures.
+static void channel(GprsEncoder &enc, GprsDecoder &dec, const int *qbits, int k, unsigned weak, unsigned erasures)
+{
+	for (int B = 0; B < 4; B++) {
+		dec.mI[B] = SoftVector8(enc.mI[B]);
+		dec.qbits[2*B] = qbits[2*B];
+		dec.qbits[2*B+1] = qbits[2*B+1];
+	}
+	if (k >= 0) {
+		// Interleaver position of c[k], GSM 05.03 4.1.4.
+		int8_t &v = dec.mI[k%4][2*((49*k) % 57) + ((k%8)/4)];
+		v = -v;
+	}
+	for (unsigned i = 0; i < weak; i++) {
+		int8_t &v = dec.mI[random()%4][random()%114];
+		v = v > 0 ? -40 : 40;
+	}
+	for (unsigned i = 0; i < erasures; i++) { dec.mI[random()%4][random()%114] = 0; }
+	dec.deinterleave();
+}
+
+
+// Encode random blocks, clean ones and ones with a certain bit error at any position
+// of c[] must all come back.  With weak wrong bits and erasures CS-3, having the least
+// redundancy, may lose a few blocks, allow 1%.
+static int testCS23(ChannelCodingType cs)
+{
+	const char *name = cs == ChannelCodingCS3 ? "CS-3" : "CS-2";
+	const unsigned databytes = cs == ChannelCodingCS3 ? 39 : 33;
+	const int *qbits = cs == ChannelCodingCS3 ? qCS3 : qCS2;
+	GprsEncoder enc;
+	GprsDecoder dec;
+	int failed = 0;
+	unsigned good = 0, noisyGood = 0;
+	static const unsigned noisy = 200;
+	static const unsigned blocks = 100 + 456 + noisy;
+	for (unsigned n = 0; n < blocks; n++) {
+		BitVector src(databytes*8);
+		for (unsigned i = 0; i < src.size(); i++) { src[i] = random() & 1; }
+		if (cs == ChannelCodingCS3) { enc.encodeCS3(src); } else { enc.encodeCS2(src); }
+		if (n < 100) { channel(enc,dec,qbits,-1,0,0); }
+		else if (n < 100 + 456) { channel(enc,dec,qbits,n - 100,0,0); }
+		else { channel(enc,dec,qbits,-1,4,4); }
+		if (dec.getCS() != cs) {
+			cout << "FAILED " << name << " getCS n=" << n << endl;
+			failed++;
+			continue;
+		}
+		bool ok = cs == ChannelCodingCS3 ? dec.decodeCS3() : dec.decodeCS2();
+		BitVector *result = dec.getResult();
+		if (ok) {
+			result->LSB8MSB();
+			for (unsigned i = 0; ok && i < src.size(); i++) { ok = result->bit(i) == src.bit(i); }
+		}
+		if (ok) {
+			good++;
+			if (n >= 100 + 456) { noisyGood++; }
+		} else if (n < 100 + 456) {
+			cout << "FAILED " << name << " decode n=" << n << endl;
+			failed++;
+		}
+	}
+	cout << name << ": blocks=" << blocks << " good=" << good << " noisy=" << noisy << " good=" << noisyGood << endl;
+	if (noisyGood + noisy/100 < noisy) {
+		cout << "FAILED " << name << " decode noisy blocks" << endl;
+		failed++;
+	}
+	return failed;
+}
+
+
+// The coding scheme must survive up to 2 stealing bit errors.
+static int testStealingBits()
+{
+	static const int *patterns[4] = { qCS1, qCS2, qCS3, qCS4 };
+	GprsDecoder dec;
+	int failed = 0;
+	for (int cs = ChannelCodingCS1; cs <= ChannelCodingCS4; cs++) {
+		for (int e1 = -1; e1 < 8; e1++) {
+			for (int e2 = -1; e2 < 8; e2++) {
+				for (int i = 0; i < 8; i++) {
+					dec.qbits[i] = patterns[cs][i] ^ (i == e1) ^ (i == e2);
+				}
+				if (dec.getCS() == cs) { continue; }
+				cout << "FAILED getCS cs=" << cs << " errors=" << e1 << "," << e2 << endl;
+				failed++;
+			}
+		}
+	}
+	return failed;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int failed = testStealingBits();
+	failed += testCS23(ChannelCodingCS2);
+	failed += testCS23(ChannelCodingCS3);
+	cout << (failed ? "FAILED" : "OK") << endl;
+	return failed ? 1 : 0;
+}
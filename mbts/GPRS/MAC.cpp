@@ -34,6 +34,12 @@
 
 namespace GPRS {
 
+// Configuration values used per RLC block
+static ConfigKey<long> cfgRRBPMin("GPRS.RRBP.Min");
+static ConfigKey<long> cfgAGCHQMax("GSM.CCCH.AGCH.QMax");
+static ConfigKey<long> cfgMSResponseTime("GPRS.MS.ResponseTime");
+static ConfigKey<long> cfgAdvanceBlocks("GPRS.advanceblocks");
+
 struct TFIList *gTFIs;
 RLCBSN_t gBSNNext = 0;		// The next Block Sequence Number that will be sent on the downlink.
 RLCBSN_t gBSNPrev = 0;
@@ -450,11 +456,39 @@ void L2MAC::macForgetTBF(TBF *tbf, bool forever)
 	}
 }
 
-void L2MAC::macAddMS(MSInfo *ms) { macMSs.push_back(ms); }
+void L2MAC::macAddMS(MSInfo *ms) { macMSs.push_back(ms); macIndexMS(ms); }
+
+void L2MAC::macIndexMS(MSInfo *ms)
+{
+	macMSTlliMap.insert(MSTlliMap_t::value_type(TLLI_MASK_LOCAL(ms->msTlli),ms));
+	if (TLLI_MASK_LOCAL(ms->msOldTlli) != TLLI_MASK_LOCAL(ms->msTlli)) {
+		macMSTlliMap.insert(MSTlliMap_t::value_type(TLLI_MASK_LOCAL(ms->msOldTlli),ms));
+	}
+}
+
+// Return true if the MS was indexed.
+bool L2MAC::macUnindexMS(MSInfo *ms)
+{
+	bool found = false;
+	uint32_t keys[2] = { TLLI_MASK_LOCAL(ms->msTlli), TLLI_MASK_LOCAL(ms->msOldTlli) };
+	for (int i = 0; i < 2; i++) {
+		std::pair<MSTlliMap_t::iterator,MSTlliMap_t::iterator> range = macMSTlliMap.equal_range(keys[i]);
+		for (MSTlliMap_t::iterator it = range.first; it != range.second; ) {
+			if (it->second == ms) {
+				macMSTlliMap.erase(it++);
+				found = true;
+			} else {
+				it++;
+			}
+		}
+	}
+	return found;
+}
 
 void L2MAC::macForgetMS(MSInfo *ms, bool forever)
 {
 	macMSs.remove(ms);
+	macUnindexMS(ms);
 	// lock unnecessary, using macLock now:
 	//macMSs.remove_safely(ms); // Usually already locked, so lock is recursive
 	//ScopedLock lock2(macExpiredMSs.mListLock);
@@ -480,14 +514,17 @@ void L2MAC::macForgetMS(MSInfo *ms, bool forever)
 	}
 }
 
-// The MS list will be short.  Just look through linearly.
+// The MS list may be long (many attached M2M devices), so use the TLLI index.
 MSInfo *L2MAC::macFindMSByTlli(uint32_t tlli, int create /*=0*/)
 {
 	MSInfo *ms;
-	RN_MAC_FOR_ALL_MS(ms) {
-		// When the MS performs a Detach procedure, it will change its existing tlli
-		// from a local tlli to a foreign tlli.  Instead of having the SGSN inform us
-		// of these events, just ignore whether the tlli is local or foreign.
+	// When the MS performs a Detach procedure, it will change its existing tlli
+	// from a local tlli to a foreign tlli.  Instead of having the SGSN inform us
+	// of these events, just ignore whether the tlli is local or foreign.
+	// The index ignores the local bit, tlliEq decides if it matters.
+	std::pair<MSTlliMap_t::iterator,MSTlliMap_t::iterator> range = macMSTlliMap.equal_range(TLLI_MASK_LOCAL(tlli));
+	for (MSTlliMap_t::iterator it = range.first; it != range.second; it++) {
+		ms = it->second;
 		if (tlliEq(ms->msTlli, tlli) || tlliEq(ms->msOldTlli,tlli)) {
 			// This is very important.
 			// If the SGSN looks up an MS by TLLI it is because it is about to use it,
@@ -990,7 +1027,7 @@ RLCBSN_t L1UplinkReservation::makeReservationInt(
 	// blocks are sent!  When this happens the RRBP reservations are not far
 	// enough in advance to be answered.  To fix that, use a minimum RRBP
 	// greater than 0.
-	int minrrbp = gConfig.getNum("GPRS.RRBP.Min");
+	int minrrbp = cfgRRBPMin.get();
 	if (tbf) {
 		// Count the reservations for reporting purposes.
 		switch (restype) {
@@ -1078,7 +1115,7 @@ RLCBSN_t L1UplinkReservation::makeCCCHReservation(
 {
 	mac_debug();
 	// TODO: Add a separate GPRS qmax, since it seems like MS cant handle much delay.
-	int qmax = gConfig.getNum("GSM.CCCH.AGCH.QMax");
+	int qmax = cfgAGCHQMax.get();
 	if (qmax > 0 && AGCH->load()>(unsigned)qmax) {
 		if (type == RLCBlockReservation::ForRACH) {
 			GPRSLOG(WARNING,GPRS_ERR) << "RACH dropped due to AGCH congestion.\n";
@@ -1106,7 +1143,7 @@ RLCBSN_t L1UplinkReservation::makeCCCHReservation(
 		// next occurrence of block B((x+2) mod 12) where block B(x) is
 		// radio block containing the PACKET CONTROL ACKNOWLEDGEMENT."
 		if (gConfig.defines("GPRS.MS.ResponseTime")) {
-			advanceblocks = gConfig.getNum("GPRS.MS.ResponseTime") + ExtraClockDelay;
+			advanceblocks = cfgMSResponseTime.get() + ExtraClockDelay;
 		}
 
 		// We also have to add one to compensate for FrameNumber2BSN rounding down.
@@ -1124,7 +1161,7 @@ RLCBSN_t L1UplinkReservation::makeCCCHReservation(
 
 		// For debugging, add a variable advance amount.
 		//int advanceframes = gConfig.getNum("GPRS.advanceframes",0);
-		advanceblocks = gConfig.getNum("GPRS.advanceblocks");	// This worked!
+		advanceblocks = cfgAdvanceBlocks.get();	// This worked!
 
 		resbsn = gBSNNext + (int32_t)(12 * AGCH->load() + advanceblocks);	// This is in blocks.
 	}
@@ -32,6 +32,7 @@
 #include "RList.h"
 #include "Utils.h"
 #include <list>
+#include <map>
 namespace GPRS {
 extern void mac_debug();
 
@@ -264,6 +265,14 @@ class L2MAC
 	TBFList_t macExpiredTBFs;
 	MSInfoList_t macExpiredMSs;
 
+	// Index of macMSs by msTlli and msOldTlli, used by macFindMSByTlli.
+	// The key is the TLLI without the local bit, see tlliEq.
+	// The MSInfo must be removed before changing its TLLIs and added back after.
+	typedef std::multimap<uint32_t,MSInfo*> MSTlliMap_t;
+	MSTlliMap_t macMSTlliMap;
+	void macIndexMS(MSInfo *ms);
+	bool macUnindexMS(MSInfo *ms);
+
 #define RN_MAC_FOR_ALL_PDCH(ch) RN_FOR_ALL(PDCHL1FECList_t,gL2MAC.macPDCHs,ch)
 #define RN_MAC_FOR_ALL_PACCH(ch) RN_FOR_ALL(PDCHL1FECList_t,gL2MAC.macPacchs,ch)
 #define RN_MAC_FOR_ALL_MS(ms) for (RListIterator<MSInfo*> itr(gL2MAC.macMSs); itr.next(ms); )
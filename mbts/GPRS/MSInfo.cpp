@@ -785,6 +785,8 @@ void SignalQuality::dumpSignalQuality(std::ostream&os) const
 	os << LOGVAR2("SigVar",msSigVar);
 	os << LOGVAR2("ChCoding",msChannelCoding);
 	os << LOGVAR2("RXLev",msRXLev);
+	os << LOGVAR2("LAUp",msLinkAdaptation[RLCDir::Up].laCS+1);
+	os << LOGVAR2("LADown",msLinkAdaptation[RLCDir::Down].laCS+1);
 	os << LOGVAR(mLastAlpha);
 	os << LOGVAR(mLastGamma);
 	os << LOGVAR(mGamma);
@@ -853,31 +855,94 @@ void SignalQuality::initRadData(float wRSSI,float wTimingError)
 	GPRSLOG(DEBUG,GPRS_MSG) << "initRadData TA=" << mNextTA << LOGVAR(mGamma);
 }
 
-// Determine whether we should use slow or fast channel coding for the specified direction.
-ChannelCodingType MSInfo::msGetChannelCoding(RLCDirType wdir) const
+// Minimum number of blocks counted in one direction before link adaptation changes the channel coding.
+// This is about half a second of data on a single timeslot.
+static const int cLinkAdaptationBlocks = 24;
+
+// Downlink channel coding limit for each RXQUAL value reported by the MS, GSM05.08 sec 8.2.4.
+static const int sRXQualMaxCoding[8] = {
+	ChannelCodingCS4, ChannelCodingCS4,		// BER below 0.4%
+	ChannelCodingCS3, ChannelCodingCS3,		// BER 0.4% to 1.6%
+	ChannelCodingCS2, ChannelCodingCS2,		// BER 1.6% to 6.4%
+	ChannelCodingCS1, ChannelCodingCS1		// BER above 6.4%
+};
+
+// Determine the channel coding CS-1..CS-4 to use for the specified direction.
+ChannelCodingType MSInfo::msGetChannelCoding(RLCDirType wdir)
 {
 	// Initial channel coding is determined from RSSI from most recent burst from MS.
-	// If the signal strength was low (less than -40db) then use the slow speed.
-	// TODO: For subsequent TBFs we should use statistics from previous TBFs.
+	// If the signal strength was low (less than -40db) then use a slower speed.
+	// After that the block error rate measured at the current channel coding moves it
+	// one step up or down among the allowed codecs, and the downlink is additionally
+	// limited by the RXQUAL the MS reports in the downlink ack/nack channel quality report.
+	// Uplink errors are duplicated blocks and gaps in the received BSN sequence,
+	// downlink errors are retransmitted blocks.
+	// The link adaptation state is kept in the MSInfo so it carries over to subsequent TBFs.
 	// BEGINCONFIG
-	// 'GPRS.ChannelCodingControl.RSSI',-40,0,0,'If the initial signal strength is less than this amount in DB GPRS uses a lower bandwidth but more robust encoding CS-1'
+	// 'GPRS.ChannelCodingControl.RSSI',-40,0,0,'If the initial signal strength is less than this amount in DB GPRS uses a lower bandwidth but more robust encoding'
+	// 'GPRS.ChannelCodingControl.BLER.Upgrade',5,0,0,'Block error rate in percent below which GPRS switches to the next faster allowed codec'
+	// 'GPRS.ChannelCodingControl.BLER.Downgrade',20,0,0,'Block error rate in percent above which GPRS switches to the next more robust allowed codec'
 	// ENDCONFIG
 
 	// Allow user full control over the codecs with these options:
 	const char *option = (wdir == RLCDir::Up) ? "GPRS.Codecs.Uplink" : "GPRS.Codecs.Downlink";
-	const char *codecs = gConfig.getStr(option).c_str();
-	// We only support CS1 and CS4.
-	bool cs1allowed = strchr(codecs,'1');
-	bool cs4allowed = strchr(codecs,'4');
-	if (cs1allowed && cs4allowed) {
-		// Choose codec based on initial signal strength:
+	std::string codecs = gConfig.getStr(option);
+	bool allowed[4];
+	int lowest = -1, highest = -1;
+	for (int cs = ChannelCodingCS1; cs <= ChannelCodingCS4; cs++) {
+		allowed[cs] = strchr(codecs.c_str(),'1' + cs);
+		if (!allowed[cs]) { continue; }
+		if (lowest < 0) { lowest = cs; }
+		highest = cs;
+	}
+	if (lowest < 0) { return ChannelCodingCS1; }
+
+	LinkAdaptation &la = msLinkAdaptation[wdir == RLCDir::Up ? RLCDir::Up : RLCDir::Down];
+	int cs = la.laCS, bler = -1;
+	if (cs < 0) {
+		// Choose initial codec based on signal strength.
+		// The CS-3 and CS-2 steps follow the C/I difference between the coding schemes.
+		int rssi = msRSSI.getCurrent();
 		int fastRSSI = gConfig.getNum("GPRS.ChannelCodingControl.RSSI");
-		return (msRSSI.getCurrent() < fastRSSI) ? ChannelCodingCS1 : ChannelCodingCS4;
-	} else if (cs4allowed) {
-		return ChannelCodingCS4;
-	} else {
-		return ChannelCodingCS1;
+		if (rssi >= fastRSSI) { cs = ChannelCodingCS4; }
+		else if (rssi >= fastRSSI - 8) { cs = ChannelCodingCS3; }
+		else if (rssi >= fastRSSI - 10) { cs = ChannelCodingCS2; }
+		else { cs = ChannelCodingCS1; }
+		while (cs > lowest && !allowed[cs]) { cs--; }
+		while (!allowed[cs]) { cs++; }
+	} else if (la.laGood + la.laBad >= cLinkAdaptationBlocks) {
+		bler = 100 * la.laBad / (la.laGood + la.laBad);
+		if (bler > gConfig.getNum("GPRS.ChannelCodingControl.BLER.Downgrade")) {
+			for (int next = cs - 1; next >= lowest; next--) {
+				if (allowed[next]) { cs = next; break; }
+			}
+		} else if (bler < gConfig.getNum("GPRS.ChannelCodingControl.BLER.Upgrade")) {
+			for (int next = cs + 1; next <= highest; next++) {
+				if (allowed[next]) { cs = next; break; }
+			}
+		}
+		la.laGood = la.laBad = 0;
+	}
+	// The allowed codecs may have been changed in the config since the last decision.
+	if (!allowed[cs]) {
+		while (cs > lowest && !allowed[cs]) { cs--; }
+		while (!allowed[cs]) { cs++; }
+	}
+	if (wdir == RLCDir::Down && msRXQual.mCnt) {
+		int limit = sRXQualMaxCoding[msRXQual.getCurrent() & 7];
+		while (cs > limit && cs > lowest) {
+			for (cs--; !allowed[cs]; cs--) continue;
+		}
+	}
+
+	if (cs != la.laCS) {
+		GPRSLOG(INFO,GPRS_MSG) << "link adaptation "<<this<<" "<<RLCDir::name(wdir)
+			<<" CS-"<<(la.laCS+1)<<" -> CS-"<<(cs+1)<<LOGVAR(bler)
+			<<LOGVAR2("RSSI",msRSSI.getCurrent())<<LOGVAR2("RXQual",msRXQual.getCurrent());
+		la.laCS = cs;
+		la.laGood = la.laBad = 0;
 	}
+	return (ChannelCodingType) cs;
 }
 
 // UNUSED
@@ -917,6 +982,8 @@ MSInfo *bssgMSChangeTLLI(uint32_t oldTLLI,uint32_t newTLLI)
 // This function makes sure that newTlli is the current one.
 void MSInfo::msChangeTlli(uint32_t newTlli)
 {
+	// Remove from the TLLI index while the TLLIs change.
+	bool indexed = gL2MAC.macUnindexMS(this);
 	if (! tlliEq(newTlli,msTlli)) {
 		// If the message is in the queue for this MS, the MS must have been
 		// identified by either msTlli or msOldTlli.
@@ -938,6 +1005,7 @@ void MSInfo::msChangeTlli(uint32_t newTlli)
 	}
 	// The newTlli may differ by the TLLI_LOCAL_BIT, so always set msTlli.
 	msTlli = newTlli;
+	if (indexed) { gL2MAC.macIndexMS(this); }
 }
 
 // In addition to alias tllis, we also accept foreign TLLIs, see macFindMSByTlli.
@@ -960,7 +1028,9 @@ void MSInfo::msAliasTlli(uint32_t otherTlli)
 			// This code is processed by MAC when this message is first seen.
 			// Set oldTlli so that we will know the TLLI is the same MS.
 			// This may be switched by msChangeTlli when the message is processed.
+			bool indexed = gL2MAC.macUnindexMS(this);
 			this->msOldTlli = otherTlli;
+			if (indexed) { gL2MAC.macIndexMS(this); }
 		}
 	}
 }
@@ -142,6 +142,15 @@ class MSStopCause {
 #define TA_TIMER 5000
 #endif
 
+// Link adaptation state for one direction, see MSInfo::msGetChannelCoding.
+struct LinkAdaptation {
+	int laCS;				// ChannelCodingType currently in use, or -1 before the first decision.
+	Int_z laGood, laBad;	// Blocks counted since the last decision.
+	LinkAdaptation() : laCS(-1) {}
+	void laCount(bool good) { if (good) { laGood++; } else { laBad++; } }
+	void laMissed(int count) { laBad += count; }
+};
+
 struct SignalQuality {
 	// TODO: Get the Channel Quality Report from packet downlink ack/nack GSM04.60 11.2.6
 	Statistic<float> msTimingError;
@@ -152,6 +161,7 @@ struct SignalQuality {
 	Statistic<int> msRXQual;
 	Statistic<int> msSigVar;
 	Statistic<int> msRXLev; // save RXLEV information received in measurement reports
+	LinkAdaptation msLinkAdaptation[2];	// Indexed by RLCDir::Up or RLCDir::Down.
 	UInt16_z mLastAlpha; // last sent alpha value
 	UInt16_z mLastGamma; // last sent gamma value
 	UInt16_z mGamma; // current calculated gamma, might not have been sent
@@ -610,7 +620,7 @@ class MSInfo : public SGSN::MSUEAdapter, public SignalQuality, public MSStat
 	void msStop(RLCDir::type dir, MSStopCause::type cause, TbfCancelMode cmode, int unsigned howlong);
 	MSStopCause::type msStopCause;
 	//void msRestart();
-	ChannelCodingType msGetChannelCoding(RLCDirType wdir) const;
+	ChannelCodingType msGetChannelCoding(RLCDirType wdir);
 	void msDump(std::ostream&os, SGSN::PrintOptions options);
 	void msDumpCommon(std::ostream&os) const;
 	void msDumpChannels(std::ostream&os) const;
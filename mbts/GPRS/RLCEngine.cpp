@@ -706,9 +706,11 @@ void RLCUpEngine::engineRecvDataBlock(RLCUplinkDataBlock* block, int tn)
 		if (mSt.VN[BSN] == false) { GLOG(ERR) << getTBF() << " VN out of sync" <<LOGVAR(BSN) << LOGVAR(mSt.VN); }
 		delete mSt.RxQ[BSN];
 		mtMS->msCountBlocks.addMiss();
+		mtMS->msLinkAdaptation[RLCDir::Up].laCount(false);
 	} else {
 		mUniqueBlocksReceived++;
 		mtMS->msCountBlocks.addHit();
+		mtMS->msLinkAdaptation[RLCDir::Up].laCount(true);
 	}
 	mSt.VN[BSN]=true;
 	mSt.RxQ[BSN]=block;
@@ -717,6 +719,8 @@ void RLCUpEngine::engineRecvDataBlock(RLCUplinkDataBlock* block, int tn)
 	int VRm1 = addSN(mSt.VR,-1);
 	int deltaR = deltaSN(BSN,VRm1);
 	if (deltaR>0) {
+		// The blocks skipped between VR and BSN were lost on the uplink.
+		if (deltaR>1) { mtMS->msLinkAdaptation[RLCDir::Up].laMissed(deltaR-1); }
 		unsigned past = addSN(mSt.VR, -mWS - 2);	// -2 to be safe
 		mSt.VR=addSN(BSN,1);
 		unsigned pastend = addSN(mSt.VR, -mWS - 2);
@@ -800,7 +804,7 @@ RLCMsgPacketUplinkAckNack * RLCUpEngine::engineUpAckNack()
 // placing them in the mSt.TxQ.  They will be physically sent by the serviceloop.
 void RLCDownEngine::engineWriteHighSide(SGSN::GprsSgsnDownlinkPdu *dlmsg)
 {
-	if (dlmsg->mDlTime.elapsed() > gConfig.getNum("GPRS.LLC.PDUExpire")) {
+	if (dlmsg->mDlTime.elapsed() > gCfgPDUExpire.get()) {
 		GPRSLOG(WARNING,GPRS_ERR) << "Dropping PDU '"<< dlmsg->mDescr << "' " <<hex << dlmsg << dec << ", too old";
 		delete dlmsg;
 		return;
@@ -893,6 +897,7 @@ RLCDownlinkDataBlock *RLCDownEngine::getBlock(unsigned vs,
 		// Manufacture the next block.
 		mUniqueDataBlocksSent++;
 		mtMS->msCountBlocks.addHit();
+		mtMS->msLinkAdaptation[RLCDir::Down].laCount(true);
 		// Clean up behind ourselves when wrapping around.
 		if (mSt.TxQ[mSt.TxQNum]) { delete mSt.TxQ[mSt.TxQNum]; mSt.TxQ[mSt.TxQNum] = 0; }
 		RLCDownlinkDataBlock *block = engineFillBlock(mSt.TxQNum,tn);
@@ -905,6 +910,7 @@ RLCDownlinkDataBlock *RLCDownEngine::getBlock(unsigned vs,
 		incSN(mSt.TxQNum);
 	} else {
 		mtMS->msCountBlocks.addMiss();
+		mtMS->msLinkAdaptation[RLCDir::Down].laCount(false);
 	}
 #endif
 	assert(mSt.TxQ[vs]);
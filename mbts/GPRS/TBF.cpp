@@ -26,6 +26,14 @@ using namespace std;
 
 namespace GPRS {
 
+// Configuration values used per RLC block
+ConfigKey<long> gCfgPDUExpire("GPRS.LLC.PDUExpire");
+static ConfigKey<long> cfgTBFExpire("GPRS.TBF.Expire");
+static ConfigKey<long> cfgMSNonResponsive("GPRS.Timers.MS.NonResponsive");
+static ConfigKey<long> cfgTbfReleaseMax("GPRS.Counters.TbfRelease");
+static ConfigKey<long> cfgAssignMax("GPRS.Counters.Assign");
+static ConfigKey<long> cfgReassignMax("GPRS.Counters.Reassign");
+
 typedef SGSN::GprsSgsnDownlinkPdu DownlinkQPdu;
 
 static bool SendExtraTA = 0;// DEBUG: Send an extra TA message
@@ -846,7 +854,7 @@ void MSInfo::msRestart()
 
 static RLCDownEngine *createDownlinkTbf(MSInfo *ms, DownlinkQPdu *dlmsg, bool isRetry, ChannelCodingType codingMax)
 {
-	if (dlmsg->mDlTime.elapsed() > gConfig.getNum("GPRS.LLC.PDUExpire")) {
+	if (dlmsg->mDlTime.elapsed() > gCfgPDUExpire.get()) {
 		GPRSLOG(WARNING,GPRS_ERR) << "Not creating DL TBF for'"<< dlmsg->mDescr << "' [" <<hex << dlmsg << dec 
 			<< "] PDU, it's too old";
 		delete dlmsg;
@@ -1014,7 +1022,7 @@ void MSInfo::msService()
 	// I am defaulting this timer to 6 secs which is longer than any other.
 	if (msTBFs.size()) {
 		// TODO: Should be TBF.NonResponsivve.
-		int timerVal = gConfig.getNum("GPRS.Timers.MS.NonResponsive");	// value of 0 disables.
+		int timerVal = cfgMSNonResponsive.get();	// value of 0 disables.
 		if (timerVal > 0 && msTalkUpTime.elapsed() > timerVal) {
 			msStop(RLCDir::Either,MSStopCause::NonResponsive,TbfNoRetry,gL2MAC.macT3169Value);
 		}
@@ -1077,7 +1085,7 @@ void TBF::mtRetry()
 			dlmsg = mtMS->msDownlinkQueue.readNoBlock();
 		}
 		if (dlmsg) { // Not possible to be NULL, but be safe.
-			if (dlmsg->mDlTime.elapsed() < gConfig.getNum("GPRS.TBF.Expire")) {
+			if (dlmsg->mDlTime.elapsed() < cfgTBFExpire.get()) {
 				createDownlinkTbf(mtMS, dlmsg, true, chCoding);
 			} else {
 				// Too old.  Give up.
@@ -1269,7 +1277,7 @@ bool TBF::mtSendTbfRelease(PDCHL1Downlink *down)
 		mtRetry();
 		return false;
 	}
-	if ((int)mtTbfReleaseCounter > gConfig.getNum("GPRS.Counters.TbfRelease")) {
+	if ((int)mtTbfReleaseCounter > cfgTbfReleaseMax.get()) {
 		mtCancel(MSStopCause::ReleaseCounter,TbfRetryAfterWait);
 		return false;
 	}
@@ -1313,7 +1321,7 @@ bool TBF::mtServiceDownlink(PDCHL1Downlink *down)
 					// DEBUG: Try sending extra TA messages.
 					//if (mtAssignCounter > 6 && !mtTASent && sendTA(down,this)) { mtTASent=1; return true; }
 
-					if ((int)mtAssignCounter > gConfig.getNum("GPRS.Counters.Assign")) {
+					if ((int)mtAssignCounter > cfgAssignMax.get()) {
 						mtCancel(MSStopCause::AssignCounter,TbfNoRetry);
 						return false;
 					}
@@ -1361,7 +1369,7 @@ bool TBF::mtServiceDownlink(PDCHL1Downlink *down)
 					mtSetState(TBFState::DataTransmit);
 					continue;
 				}
-				if ((int)mtReassignCounter > gConfig.getNum("GPRS.Counters.Reassign")) {
+				if ((int)mtReassignCounter > cfgReassignMax.get()) {
 					mtCancel(MSStopCause::ReassignCounter,TbfRetryAfterWait);
 					return false;
 				}
@@ -1411,7 +1419,7 @@ bool TBF::mtServiceDownlink(PDCHL1Downlink *down)
 						// And fall through to service the TBF on this channel.
 					} else {
 						if (! mtMsgPending()) {
-							if ((int)mtReassignCounter > gConfig.getNum("GPRS.Counters.Reassign")) {
+							if ((int)mtReassignCounter > cfgReassignMax.get()) {
 								// The iphone is not answering these.  It may be because we are only allowed
 								// to have 3 RRBPs out at a time, but whatever, dont kill the TBF for this,
 								// just stop sending the messages.  If the MS wants 
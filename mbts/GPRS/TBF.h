@@ -502,6 +502,7 @@ class TBF :
 	void mtFreeTFI();
 };
 extern unsigned gTBFDebugId;
+extern ConfigKey<long> gCfgPDUExpire;	// GPRS.LLC.PDUExpire, checked for each downlink PDU
 
 std::ostream& operator<<(std::ostream& os, const TBF*tbf);
 #if TBF_IMPLEMENTATION
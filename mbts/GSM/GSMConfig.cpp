@@ -38,7 +38,8 @@ GSMConfig::GSMConfig()
 	mSI1(NULL),mSI2(NULL),mSI3(NULL),mSI4(NULL),
 	mSI5(NULL),mSI6(NULL),
 	mStartTime(::time(NULL)),
-	mChangemark(0)
+	mChangemark(0),
+	mPagingMultiframes(2)
 {
 }
 
@@ -46,6 +47,7 @@ void GSMConfig::init()
 {
 	mBand = (GSMBand)gConfig.getNum("GSM.Radio.Band");
 	mT3122 = gConfig.getNum("GSM.Timer.T3122Min");
+	mPagingMultiframes = L3ControlChannelDescription().getBS_PA_MFRMS();
  	regenerateBeacon();
 }
 
@@ -572,95 +574,30 @@ bool GSMConfig::hold() const
 
 
 
-#if ENABLE_PAGING_CHANNELS
-
-// 5-27-2012 pat added:
-// Routines for CCCH messages to add real paging channels.
-// Added in the simplest possible way to avoid destabilizing anything.
-// GPRS still needs a pretty major rewrite of the underlying CCCHLogicalChannel class
-// to reduce the latency, but paging queues at least relieve the congestion on CCCH.
-// In DRX [Discontinuous Reception] mode the MS listens only to a subset of CCCH based on its IMSI.
-// This is a GPRS thing but dependent on the configuration of CCCH in our system.
-// See: GSM 05.02 6.5.2: Determination of CCCH_GROUP and PAGING_GROUP for MS in idle mode.
-void GSMConfig::crackPagingFromImsi(	
-	unsigned imsiMod1000	// The phones imsi mod 1000, so just atoi the last 3 digits.
-	unsigned &paging_block_index,	// Returns which of the paging ccchs to use.
-	unsigned &multiframe_index	// Returns which 51-multiframe to use.
-	)
-{
-	L3ControlChannelDescription mCC;
-
-	// BS_CCCH_SDCCH_COMB is defined in GSM 05.02 3.3.2.3;
-	int bs_cc_chans;			// The number of ccch timeslots per 51-multiframe.
-	bool bs_ccch_sdcch_comb;	// temp var indicates if sdcch is on same TS as ccch.
-	switch (mCC.mCCCH_CONF) {
-	case 0: bs_cc_chans=1; bs_ccch_sdcch_comb=false; break;
-	case 1: bs_cc_chans=1; bs_ccch_sdcch_comb=true; break;
-	case 2: bs_cc_chans=2; bs_ccch_sdcch_comb=false; break;
-	case 4: bs_cc_chans=3; bs_ccch_sdcch_comb=false; break;
-	case 6: bs_cc_chans=4; bs_ccch_sdcch_comb=false; break;
-	default:
-		LOG(ERR) << "Invalid GSM.CCCH.CCCH-CONF value:"<<mCC.mCCCH_CONF <<" GPRS will fail until fixed";
-		return NULL;	// There will be no reliable GPRS service until you fix this.
-	}
+// Paging groups, see GSM 05.02 6.5.2 and 6.5.3.
+// We have a single CCCH timeslot so BS_CC_CHANS=1 and CCCH_GROUP is always 0.
+// N = number of paging blocks on the CCCH * BS_PA_MFRMS
+// PAGING_GROUP = (IMSI mod 1000) mod N
+// The paging block index inside the 51-multiframe is PAGING_GROUP mod (N div BS_PA_MFRMS)
+// and the MS listens to it when PAGING_GROUP div (N div BS_PA_MFRMS) = (FN div 51) mod BS_PA_MFRMS.
+// Each CCCHLogicalChannel in the PCH pool is a paging block and holds a paging queue
+// for each 51-multiframe of the paging cycle.
+void GSMConfig::sendPCH(const L3RRMessage& msg, unsigned group)
+{
+	unsigned blocks = mPCHPool.size();
+	assert(group < pagingGroups());
+	CCCHLogicalChannel* ch = mPCHPool[group % blocks];
+	ch->mPagingQ[group / blocks].write(new L3Frame((const L3Message&)msg,UNIT_DATA));
+}
 
-	// BS_PA_MFRMS is the number of 51-multiframes used for paging.
-	unsigned bs_pa_mfrms = mCC.getBS_PA_MFRMS();
-
-	// Here are some example numbers:
-	// We currently use CCCH_CONF=1 so cc_chans=1, so agch_avail=3.
-	// Since BS_CC_CHANS=1, then CCCH_GROUP is always 0.
-	// For BS_PA_MFRMS=2, BS_AG_BLKS_RES=2:
-	//	N=2; tmp = imsi % 2; CCCH_GROUP = 0; PAGING_GROUP = imsi % 2;
-	// For BS_PA_MFRMS=2, BS_AG_BLKS_RES=1:
-	//	N=4; tmp = imsi % 4; PAGING_GROUP = imsi % 4;
-	// For BS_PA_MFRMS=2, BS_AG_BLKS_RES=0:
-	//	N=6; tmp = imsi % 6; PAGING_GROUP = imsi % 6;
-	// For BS_PA_MFRMS=3, BS_AG_BLKS_RES=0:
-	//	N=9; tmp = imsi % 9; PAGING_GROUP = imsi % 9;
-	// Paging block index = PAGING_GROUP % BS_PA_MFRMS
-	// Multiframe index = PAGING_GROUP / pch_avail;
-	// correct multiframe when: multiframe_index == (FN div 51) % BA_PA_MFRMS
-
-	// From GSM 05.02 Clause 7 table 5 (located after sec 6.5)
-	unsigned agch_avail = bs_ccch_sdcch_comb ? 3 : 8;
-	// If you hit this assertion, go fix L3ControlChannelDescription
-	// to make sure you leave some paging channels available.
-	assert(agch_avail > mPCC.mBS_AG_BLKS_RES);
-
-	// GSM 05.02 6.5.2: N is number of paging blocks "available" on one CCCH.
-	// The "available" is in quotes and not specifically defined, but I believe
-	// they mean after subtracting out BS_AG_BLKS_RES, as per 6.5.1 paragraph v).
-	unsigned pch_avail = agch_avail - mPCC.mBS_AG_BLKS_RES;
-	unsigned Ntotal = pch_avail * bs_pa_mfrms;
-	unsigned tmp = (imsiMod1000 % (bs_cc_chans * Ntotal)) % Ntotal;
-	unsigned paging_group = tmp % Ntotal;
-	paging_block_index = paging_group / (Ntotal / bs_pa_mfrms);
-	// And I quote: The required 51-multiframe occurs when:
-	// PAGING_GROUP div (N div BS_PA_MFRMS) = (FN div 51) mod (BS_PA_MFRMS)
-	multiframe_index = paging_group / (Ntotal % bs_pa_mfrms); 
-}
-
-void GSMConfig::sendPCH(const L3RRMessage& msg,unsigned imsiMod1000)
-{
-	unsigned paging_block_index;	// which of the paging ccchs to use.
-	unsigned multiframe_index;	// which 51-multiframe to use.
-	crackPagingFromImsi(imsiMod1000,paging_block_index, multiframe_index);
-	assert(multiframe_index < sMax_BS_PA_MFRMS);
-	CCCHLogicalChannel* ch = getPCH(paging_block_index);
-	ch->mPagingQ[multiframe_index].write(new L3Frame((const L3Message&)msg,UNIT_DATA));
-}
-
-Time GSMConfig::getPchSendTime(imsiMod1000)
-{
-	unsigned paging_block_index;	// which of the paging ccchs to use.
-	unsigned multiframe_index;	// which 51-multiframe to use.
-	crackPagingFromImsi(imsiMod1000,paging_block_index, multiframe_index);
-	assert(multiframe_index < sMax_BS_PA_MFRMS);
-	CCCHLogicalChannel* ch = getPCH(paging_block_index);
-	return ch->getNextPchSendTime(multiframe_index);
+size_t GSMConfig::pagingLoad() const
+{
+	size_t total = 0;
+	for (unsigned i=0; i<mPCHPool.size(); i++) {
+		total += mPCHPool[i]->pagingLoad();
+	}
+	return total;
 }
-#endif
 
 
 // vim: ts=4 sw=4
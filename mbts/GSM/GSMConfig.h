@@ -40,10 +40,6 @@
 
 namespace GSM {
 
-// From GSM 05.02 6.5.
-const unsigned sMax_BS_PA_MFRMS = 9;
-
-
 class CCCHLogicalChannel;
 class SDCCHLogicalChannel;
 class CBCHLogicalChannel;
@@ -131,9 +127,7 @@ class GSMConfig {
 
 	unsigned mChangemark;
 
-
-
-	void crackPagingFromImsi(unsigned imsiMod1000,unsigned &ccch_group,unsigned &paging_Index);;
+	unsigned mPagingMultiframes;	///< BS_PA_MFRMS, 51-multiframes in a paging cycle
 
 	public:
 	
@@ -224,7 +218,7 @@ class GSMConfig {
 	public:
 
 	size_t AGCHLoad() { return totalLoad(mAGCHPool); }
-	size_t PCHLoad() { return totalLoad(mPCHPool); }
+	size_t PCHLoad() { return totalLoad(mPCHPool) + pagingLoad(); }
 
 	/**@name Manage CCCH subchannels. */
 	//@{
@@ -245,18 +239,28 @@ class GSMConfig {
 	// is going to be sent, none of which works properly at the moment.
 	CCCHLogicalChannel* getAGCH() { return minimumLoad(mAGCHPool); }
 
-#if ENABLE_PAGING_CHANNELS
-	///< (pat) Send a paging message for the specified imsi.
-	// This function should be used instead of getPCH(), etc. which should then be made private.
-	void sendPCH(const L3RRMessage& msg,unsigned imsiMod1000);
+	/**@name Paging groups, GSM 05.02 6.5. */
+	//@{
+	/** Return the number of paging groups, N in GSM 05.02 6.5.2. */
+	unsigned pagingGroups() const { return mPCHPool.size() * mPagingMultiframes; }
 
-	///< (pat) Return the approximate time of the next PCH message for this imsi.
-	// This routine should be elided after DRX mode in GPRS is fixed.
-	Time getPchSendTime(imsiMod1000);
+	/** Return the number of 51-multiframes in a paging cycle, BS_PA_MFRMS. */
+	unsigned pagingMultiframes() const { return mPagingMultiframes; }
 
-	///< (pat) Send a message on the avail AGCH.
-	void sendAGCH(const L3RRMessage& msg);
-#endif
+	/** Return the paging group of a MS given the last 3 digits of its IMSI. */
+	unsigned pagingGroup(unsigned imsiMod1000) const
+		{ return imsiMod1000 % pagingGroups(); }
+
+	/**
+		Queue a paging message for the paging block of a paging group.
+		@param msg The message to send.
+		@param group The paging group, less than pagingGroups().
+	*/
+	void sendPCH(const L3RRMessage& msg, unsigned group);
+
+	/** Return the number of paging messages waiting for their paging blocks. */
+	size_t pagingLoad() const;
+	//@}
 
 	/** Return a minimum-load PCH. */
 	CCCHLogicalChannel* getPCH() { return minimumLoad(mPCHPool); }
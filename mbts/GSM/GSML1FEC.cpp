@@ -45,6 +45,20 @@
 using namespace std;
 using namespace GSM;
 
+// Configuration values used per burst or frame
+static ConfigKey<long> cfgSimulatedFERUplink("Test.GSM.SimulatedFER.Uplink");
+static ConfigKey<long> cfgSimulatedFERDownlink("Test.GSM.SimulatedFER.Downlink");
+static ConfigKey<long> cfgUplinkFuzzingRate("Test.GSM.UplinkFuzzingRate");
+static ConfigKey<bool> cfgGsmTap("Control.GSMTAP.GSM");
+static ConfigKey<float> cfgCipherCCHBER("GSM.Cipher.CCHBER");
+static ConfigKey<long> cfgMaxSpeechLatency("GSM.MaxSpeechLatency");
+static ConfigKey<long> cfgRSSITarget("GSM.Radio.RSSITarget");
+static ConfigKey<long> cfgMSPowerMax("GSM.MS.Power.Max");
+static ConfigKey<long> cfgMSPowerMin("GSM.MS.Power.Min");
+static ConfigKey<long> cfgMSPowerDamping("GSM.MS.Power.Damping");
+static ConfigKey<long> cfgMSTAMax("GSM.MS.TA.Max");
+static ConfigKey<long> cfgMSTADamping("GSM.MS.TA.Damping");
+
 
 /*
 
@@ -218,6 +232,53 @@ void L1Encoder::rollForward()
 	mPrevWriteTime = mNextWriteTime;
 	mTotalBursts++;
 	mNextWriteTime.rollForward(mMapping.frameMapping(mTotalBursts),mMapping.repeatLength());
+	// Generate the keystream of the next burst now, the uplink burst of
+	// the same frame will find it too.
+	if (mEncrypted == ENCRYPT_YES) {
+		L1Decoder *dec = parent()->decoder();
+		dec->keystream().prepare(dec->kc(), mEncryptionAlgorithm, mNextWriteTime.FN());
+	}
+}
+
+
+
+
+L1Keystream::L1Keystream()
+	:mAlgorithm(0),mNext(0)
+{
+	memset(mKc,0,sizeof(mKc));
+	for (unsigned i=0; i<CacheSize; i++) mCache[i].count = -1;
+}
+
+
+void L1Keystream::get(const unsigned char *kc, int algorithm, int fn,
+	unsigned char *block1, unsigned char *block2)
+{
+	int cnt = count(fn);
+	ScopedLock lock(mLock);
+	if (algorithm != mAlgorithm || memcmp(kc,mKc,sizeof(mKc))) {
+		// New key, redo the key setup.
+		memcpy(mKc,kc,sizeof(mKc));
+		mAlgorithm = algorithm;
+		if (mAlgorithm == 1) A51_GSM_key(mKc,&mA51);
+		else A53_GSM_key(mKc,&mA53);
+		for (unsigned i=0; i<CacheSize; i++) mCache[i].count = -1;
+	}
+	Entry *e = NULL;
+	for (unsigned i=0; i<CacheSize; i++) {
+		if (mCache[i].count != cnt) continue;
+		e = &mCache[i];
+		break;
+	}
+	if (!e) {
+		e = &mCache[mNext];
+		mNext = (mNext + 1) % CacheSize;
+		e->count = cnt;
+		if (mAlgorithm == 1) A51_GSM_fast(&mA51,cnt,e->block1,e->block2);
+		else A53_GSM_fast(&mA53,cnt,e->block1,e->block2);
+	}
+	if (block1) memcpy(block1,e->block1,sizeof(e->block1));
+	if (block2) memcpy(block2,e->block2,sizeof(e->block2));
 }
 
 
@@ -306,6 +367,26 @@ void L1Encoder::waitToSend() const
 }
 
 
+unsigned L1Encoder::sendDelay() const
+{
+	int frames = mPrevWriteTime - gBTS.time();
+	if (frames<1) return 0;
+	return (frames*gFrameMicroseconds + 999) / 1000;
+}
+
+
+bool L1Encoder::writeHighSideNoWait(const L2Frame& frame, unsigned& delay)
+{
+	// The BTS clock only moves forward: once ready the encoder stays ready
+	// until it sends, and only the lock holder sends.
+	ScopedLock lock(mLock);
+	delay = sendDelay();
+	if (delay) return false;
+	writeHighSide(frame);
+	return true;
+}
+
+
 void L1Encoder::sendIdleFill()
 {
 	// Send the L1 idle filling pattern, if any.
@@ -631,11 +712,11 @@ SharedL1Decoder::SharedL1Decoder()
 	mHParity(0x06f,6,8),mHU(18),mHD(mHU.head(8))
 {
 	for (int i=0; i<4; i++) {
-		mE[i] = SoftVector(114);
-		mI[i] = SoftVector(114);
+		mE[i] = SoftVector8(114);
+		mI[i] = SoftVector8(114);
 		// Fill with zeros just to make Valgrind happy.
-		mE[i].fill(.0);
-		mI[i].fill(.0);
+		mE[i].fill(0);
+		mI[i].fill(0);
 	}
 }
 
@@ -699,21 +780,13 @@ void XCCHL1Decoder::writeLowSideRx(const RxBurst& inBurst)
 
 void XCCHL1Decoder::saveMi()
 {
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 114; j++) {
-			mE[i].settfb(j, mI[i].softbit(j));
-		}
-	}
+	for (int i = 0; i < 4; i++) mI[i].copyTo(mE[i]);
 }
 
 
 void XCCHL1Decoder::restoreMi()
 {
-	for (int i = 0; i < 4; i++) {
-		for (int j = 0; j < 114; j++) {
-			mI[i].settfb(j, mE[i].softbit(j));
-		}
-	}
+	for (int i = 0; i < 4; i++) mE[i].copyTo(mI[i]);
 }
 
 
@@ -721,25 +794,9 @@ void XCCHL1Decoder::decrypt()
 {
 	// decrypt y
 	for (int i = 0; i < 4; i++) {
-		unsigned char block1[15];
 		unsigned char block2[15];
-		// 03.20 C.1.2
-		// 05.02 3.3.2.2.1
-		int fn = mFN[i];
-		int t1 = fn / (26*51);
-		int t2 = fn % 26;
-		int t3 = fn % 51;
-		int count = (t1<<11) | (t3<<5) | t2;
-		if (mEncryptionAlgorithm == 1) {
-			A51_GSM(mKc, 64, count, block1, block2);
-		} else {
-			A53_GSM(mKc, 64, count, block1, block2);
-		}
-		for (int j = 0; j < 114; j++) {
-			if ((block2[j/8] & (0x80 >> (j%8)))) {
-				mI[i].settfb(j, 1.0 - mI[i].softbit(j));
-			}
-		}
+		mKeystream.get(mKc, mEncryptionAlgorithm, mFN[i], NULL, block2);
+		mI[i].invert(block2);
 	}
 }
 
@@ -795,7 +852,7 @@ void SharedL1Decoder::deinterleave()
 		// Mark this i[][] bit as unknown now.
 		// This makes it possible for the soft decoder to work around
 		// a missing burst.
-		mI[B][j] = 0.5F;
+		mI[B][j] = 0;
 	}
 }
 
@@ -821,7 +878,7 @@ bool SharedL1Decoder::decode()
 	unsigned syndrome = mBlockCoder.syndrome(mDP);
 	OBJLOG(DEBUG) <<"XCCHL1Decoder syndrome=" << hex << syndrome << dec;
 	// Simulate high FER for testing?
-	if (random()%100 < gConfig.getNum("Test.GSM.SimulatedFER.Uplink")) {
+	if (random()%100 < cfgSimulatedFERUplink.get()) {
 		LOG(NOTICE) << "simulating dropped uplink frame at " << mReadTime;
 		return false;
 	}
@@ -852,13 +909,13 @@ void XCCHL1Decoder::handleGoodFrame()
 
 	if (mUpstream) {
 		// Are we fuzzing ourselves?
-		if (random()%100 < gConfig.getNum("Test.GSM.UplinkFuzzingRate")) {
+		if (random()%100 < cfgUplinkFuzzingRate.get()) {
 			size_t i = random() % mD.size();
 			mD[i] = 1 - mD[i];
 			LOG(NOTICE) << "fuzzing input frame, flipped bit " << i;
 		}
 		// Send all bits to GSMTAP
-		if (gConfig.getBool("Control.GSMTAP.GSM")) {
+		if (cfgGsmTap.get()) {
 			// FIXME -- This repeatLengh>51 is a bit of a hack.
 			gWriteGSMTAP(ARFCN(),TN(),mReadTime.FN(),typeAndOffset(),mMapping.repeatLength()>51,true,mD);
 		}
@@ -959,10 +1016,8 @@ void SharedL1Encoder::initInterleave(int mIsize)
 	// Set up the interleaving buffers.
 	for(int k = 0; k<mIsize; k++) {
 		mI[k] = BitVector(114);
-		mE[k] = BitVector(114);
 		// Fill with zeros just to make Valgrind happy.
 		mI[k].fill(0);
-		mE[k].fill(0);
 	}
 }
 
@@ -1032,7 +1087,7 @@ void XCCHL1Encoder::sendFrame(const L2Frame& frame)
 
 	// Send to GSMTAP
 	frame.copyToSegment(mU,headerOffset());
-	if (gConfig.getBool("Control.GSMTAP.GSM")) {
+	if (cfgGsmTap.get()) {
 		gWriteGSMTAP(ARFCN(),TN(),mNextWriteTime.FN(),typeAndOffset(),mMapping.repeatLength()>51,false,mU);
 	}
 
@@ -1045,7 +1100,7 @@ void XCCHL1Encoder::sendFrame(const L2Frame& frame)
 	//mFECEnc.encodeFrame41(frame,headerOffset(),mFECEnc.mVCoder);
 	encodeFrame41(frame,headerOffset(), false);
 	const int qCS1[8] = { 1,1,1,1,1,1,1,1 };   // magically identifies CS-1.
-	transmit(mI,mE,qCS1);
+	transmit(mI,qCS1);
 }
 
 
@@ -1083,7 +1138,7 @@ void SharedL1Encoder::interleave41()
 // before each transmission, rather than having them be static.
 // The qbits, also called stealing bits, are defined in GSM05.03.
 // For GPRS they specify the encoding type: CS-1 through CS-4.
-void L1Encoder::transmit(BitVector *mI, BitVector *mE, const int *qbits)
+void L1Encoder::transmit(BitVector *mI, const int *qbits)
 {
 	// Format the bits into the bursts.
 	// GSM 05.03 4.1.5, 05.02 5.2.3
@@ -1098,53 +1153,11 @@ void L1Encoder::transmit(BitVector *mI, BitVector *mE, const int *qbits)
 
 	// add noise
 	// the noise insertion happens below, merged in with the ciphering
-	int p = gConfig.getFloat("GSM.Cipher.CCHBER") * (float)0xFFFFFF;
+	int p = cfgCipherCCHBER.get() * (float)0xFFFFFF;
 
 	for (int qi=0,B=0; B<4; B++) {
 		mBurst.time(mNextWriteTime);
-		// encrypt y
-		if (mEncrypted == ENCRYPT_YES) {
-			unsigned char block1[15];
-			unsigned char block2[15];
-			unsigned char *kc = parent()->decoder()->kc();
-			// 03.20 C.1.2
-			// 05.02 3.3.2.2.1
-			int fn = mNextWriteTime.FN();
-			int t1 = fn / (26*51);
-			int t2 = fn % 26;
-			int t3 = fn % 51;
-			int count = (t1<<11) | (t3<<5) | t2;
-			if (mEncryptionAlgorithm == 1) {
-				A51_GSM(kc, 64, count, block1, block2);
-			} else {
-				A53_GSM(kc, 64, count, block1, block2);
-			}
-			for (int i = 0; i < 114; i++) {
-				int b = p ? (random() & 0xFFFFFF) < p : 0;
-				b = b ^ (block1[i/8] >> (7-(i%8)));
-				mE[B].settfb(i, mI[B].bit(i) ^ (b&1));
-			}
-		} else {
-			if (p) {
-				for (int i = 0; i < 114; i++) {
-					int b = (random() & 0xFFFFFF) < p;
-					mE[B].settfb(i, mI[B].bit(i) ^ b);
-				}
-			} else {
-				// no noise or encryption. use mI below.
-			}
-		}
-
-		// Copy in the "encrypted" bits, GSM 05.03 4.1.5, 05.02 5.2.3.
-		OBJLOG(DEBUG) << "transmit mE["<<B<<"]=" << mE[B];
-		if (p || mEncrypted == ENCRYPT_YES) {
-			mE[B].segment(0,57).copyToSegment(mBurst,3);
-			mE[B].segment(57,57).copyToSegment(mBurst,88);
-		} else {
-			// no noise or encryption.  use mI.
-			mI[B].segment(0,57).copyToSegment(mBurst,3);
-			mI[B].segment(57,57).copyToSegment(mBurst,88);
-		}
+		mapBurst(mI[B],p);
 		mBurst.Hl(qbits[qi++]);
 		mBurst.Hu(qbits[qi++]);
 		// Send it to the radio.
@@ -1155,29 +1168,58 @@ void L1Encoder::transmit(BitVector *mI, BitVector *mE, const int *qbits)
 }
 
 
+void L1Encoder::mapBurst(const BitVector& iBits, int p)
+{
+	if (!p && mEncrypted != ENCRYPT_YES) {
+		// no noise or encryption. use i[] directly.
+		iBits.segment(0,57).copyToSegment(mBurst,3);
+		iBits.segment(57,57).copyToSegment(mBurst,88);
+		return;
+	}
+	mCipherE.pack(iBits);
+	if (mEncrypted == ENCRYPT_YES) {
+		unsigned char block1[15];
+		L1Decoder *dec = parent()->decoder();
+		dec->keystream().get(dec->kc(), mEncryptionAlgorithm, mNextWriteTime.FN(), block1, NULL);
+		mCipherE.xorBytes(block1);
+	}
+	if (p) {
+		for (int i = 0; i < 114; i++) {
+			if ((random() & 0xFFFFFF) < p) mCipherE.settfb(i, !mCipherE.bit(i));
+		}
+	}
+	OBJLOG(DEBUG) << "transmit e[]=" << mCipherE;
+	BitVector e1(mBurst.segment(3,57));
+	BitVector e2(mBurst.segment(88,57));
+	mCipherE.unpack(e1,0);
+	mCipherE.unpack(e2,57);
+}
+
+
 
 void GeneratorL1Encoder::start()
 {
 	L1Encoder::start();
-	mSendThread.start((void*(*)(void*))GeneratorL1EncoderServiceLoopAdapter,(void*)this,"bts:l1:generator");
+	gL1Scheduler.add(this);
 }
 
 
-
-void *GSM::GeneratorL1EncoderServiceLoopAdapter(GeneratorL1Encoder* gen)
+void GeneratorL1Encoder::frameTick(const Time& now)
 {
-	gen->serviceLoop();
-	// DONTREACH
-	return NULL;
+	if (mHold) {
+		if ((mHoldTime - now) > 0) return;
+		mHold = false;
+	}
+	resync();
+	if (!readyToSend(now)) return;
+	generate();
 }
 
-void GeneratorL1Encoder::serviceLoop()
+
+void GeneratorL1Encoder::hold(unsigned frames)
 {
-	while (mRunning) {
-		resync();
-		waitToSend();
-		generate();
-	}
+	mHoldTime = gBTS.time() + (int)frames;
+	mHold = true;
 }
 
 
@@ -1248,7 +1290,8 @@ void FCCHL1Encoder::generate()
 		mDownstream->writeHighSideTx(mBurst,"FCCH");
 		rollForward();
 	}
-	sleep(1);
+	// The transceiver repeats these as filler, refresh them about once a second.
+	hold(1000000 / gFrameMicroseconds);
 }
 
 
@@ -1257,23 +1300,14 @@ void FCCHL1Encoder::generate()
 void NDCCHL1Encoder::start()
 {
 	L1Encoder::start();
-	mSendThread.start((void*(*)(void*))NDCCHL1EncoderServiceLoopAdapter,(void*)this,"bts:l1:ndcch");
+	gL1Scheduler.add(this);
 }
 
 
-
-void *GSM::NDCCHL1EncoderServiceLoopAdapter(NDCCHL1Encoder* gen)
+void NDCCHL1Encoder::frameTick(const Time& now)
 {
-	gen->serviceLoop();
-	// DONTREACH
-	return NULL;
-}
-
-void NDCCHL1Encoder::serviceLoop()
-{
-	while (mRunning) {
-		generate();
-	}
+	if (!readyToSend(now)) return;
+	generate();
 }
 
 
@@ -1317,14 +1351,15 @@ TCHFACCHL1Decoder::TCHFACCHL1Decoder(
 	:XCCHL1Decoder(wCN,wTN, wMapping, wParent),
 	mTCHU(189),mTCHD(260),
 	mClass1_c(mC.head(378)),mClass1A_d(mTCHD.head(50)),mClass2_c(mC.segment(378,78)),
-	mTCHParity(0x0b,3,50)
+	mTCHParity(0x0b,3,50),
+	mSink(0)
 {
 	for (int i=0; i<8; i++) {
-		mE[i] = SoftVector(114);
-		mI[i] = SoftVector(114);
+		mE[i] = SoftVector8(114);
+		mI[i] = SoftVector8(114);
 		// Fill with zeros just to make Valgrind happy.
-		mI[i].fill(.0);
-		mE[i].fill(.0);
+		mI[i].fill(0);
+		mE[i].fill(0);
 	}
 }
 
@@ -1471,7 +1506,7 @@ bool TCHFACCHL1Decoder::processBurst( const RxBurst& inBurst)
 
 	// Always feed the traffic channel, even on a stolen frame.
 	// decodeTCH will handle the GSM 06.11 bad frmae processing.
-	bool traffic = decodeTCH(stolen);
+	bool traffic = decodeTCH(stolen,inBurst.time().FN());
 	if (traffic) {
 		OBJLOG(DEBUG) <<"TCHFACCHL1Decoder good TCH frame";
 		countGoodFrame();
@@ -1487,48 +1522,24 @@ bool TCHFACCHL1Decoder::processBurst( const RxBurst& inBurst)
 
 void TCHFACCHL1Decoder::saveMi()
 {
-	for (int i = 0; i < 8; i++) {
-		for (int j = 0; j < 114; j++) {
-			mE[i].settfb(j, mI[i].softbit(j));
-		}
-	}
+	for (int i = 0; i < 8; i++) mI[i].copyTo(mE[i]);
 }
 
 void TCHFACCHL1Decoder::restoreMi()
 {
-	for (int i = 0; i < 8; i++) {
-		for (int j = 0; j < 114; j++) {
-			mI[i].settfb(j, mE[i].softbit(j));
-		}
-	}
+	for (int i = 0; i < 8; i++) mE[i].copyTo(mI[i]);
 }
 
 
 void TCHFACCHL1Decoder::decrypt(int B)
 {
 	// decrypt x
-	unsigned char block1[15];
 	unsigned char block2[15];
 	int bb = B==7 ? 4 : 0;
 	int be = B<0 ? 8 : bb+4;
 	for (int i = bb; i < be; i++) {
-		// 03.20 C.1.2
-		// 05.02 3.3.2.2.1
-		int fn = mFN[i];
-		int t1 = fn / (26*51);
-		int t2 = fn % 26;
-		int t3 = fn % 51;
-		int count = (t1<<11) | (t3<<5) | t2;
-		if (mEncryptionAlgorithm == 1) {
-			A51_GSM(mKc, 64, count, block1, block2);
-		} else {
-			A53_GSM(mKc, 64, count, block1, block2);
-		}
-		for (int j = 0; j < 114; j++) {
-			if ((block2[j/8] & (0x80 >> (j%8)))) {
-				mI[i].settfb(j, 1.0 - mI[i].softbit(j));
-			}
-		}
+		mKeystream.get(mKc, mEncryptionAlgorithm, mFN[i], NULL, block2);
+		mI[i].invert(block2);
 	}
 }
 
@@ -1540,7 +1551,7 @@ void TCHFACCHL1Decoder::deinterleave(int blockOffset )
 		int B = ( k + blockOffset ) % 8;
 		int j = 2*((49*k) % 57) + ((k%8)/4);
 		mC[k] = mI[B][j];
-		mI[B][j] = 0.5F;
+		mI[B][j] = 0;
 	}
 }
 
@@ -1548,12 +1559,23 @@ void TCHFACCHL1Decoder::deinterleave(int blockOffset )
 
 
 
-bool TCHFACCHL1Decoder::decodeTCH(bool stolen)
+void TCHFACCHL1Decoder::setTCHSink(TCHFrameSink* sink)
+{
+	ScopedLock lock(mSinkLock);
+	mSink = sink;
+	// Frames queued before the sink was attached are stale now.
+	if (sink) {
+		while (unsigned char* frame = mSpeechQ.readNoBlock())
+			delete[] frame;
+	}
+}
+
+bool TCHFACCHL1Decoder::decodeTCH(bool stolen, uint32_t fn)
 {
 	// GSM 05.02 3.1.2, but backwards
 
 	// Simulate high FER for testing?
-	if (random()%100 < gConfig.getNum("Test.GSM.SimulatedFER.Uplink")) {
+	if (random()%100 < cfgSimulatedFERUplink.get()) {
 		LOG(DEBUG) << "simulating dropped uplink vocoder frame at " << mReadTime;
 		stolen = true;
 	}
@@ -1562,8 +1584,8 @@ bool TCHFACCHL1Decoder::decodeTCH(bool stolen)
 	bool good = !stolen;
 
 	// Good or bad, we will be sending *something* to the speech channel.
-	// Allocate it in this scope.
-	unsigned char * newFrame = new unsigned char[33];
+	// Pack it in the fixed buffer, it is copied only if it has to be queued.
+	unsigned char * newFrame = mTCHFrame;
 
 	if (!stolen) {
 
@@ -1634,7 +1656,14 @@ bool TCHFACCHL1Decoder::decodeTCH(bool stolen)
 	}
 
 	// Good or bad, we must feed the speech channel.
-	mSpeechQ.write(newFrame);
+	ScopedLock lock(mSinkLock);
+	if (mSink)
+		mSink->writeTCH(newFrame,good,fn);
+	else {
+		unsigned char* qFrame = new unsigned char[33];
+		memcpy(qFrame,newFrame,33);
+		mSpeechQ.write(qFrame);
+	}
 
 	return good;
 }
@@ -1646,16 +1675,6 @@ bool TCHFACCHL1Decoder::decodeTCH(bool stolen)
 
 
 
-void GSM::TCHFACCHL1EncoderRoutine( TCHFACCHL1Encoder * encoder )
-{
-	while (1) {
-		encoder->dispatch();
-	}
-}
-
-
-
-
 TCHFACCHL1Encoder::TCHFACCHL1Encoder(
 	unsigned wCN,
 	unsigned wTN,
@@ -1669,10 +1688,8 @@ TCHFACCHL1Encoder::TCHFACCHL1Encoder(
 {
 	for(int k = 0; k<8; k++) {
 		mI[k] = BitVector(114);
-		mE[k] = BitVector(114);
 		// Fill with zeros just to make Valgrind happy.
 		mI[k].fill(0);
-		mE[k].fill(0);
 	}
 }
 
@@ -1683,7 +1700,7 @@ void TCHFACCHL1Encoder::start()
 {
 	L1Encoder::start();
 	OBJLOG(DEBUG) <<"TCHFACCHL1Encoder";
-	mEncoderThread.start((void*(*)(void*))TCHFACCHL1EncoderRoutine,(void*)this,"bts:l1:tchfacch");
+	gL1Scheduler.add(this);
 }
 
 
@@ -1739,7 +1756,7 @@ void TCHFACCHL1Encoder::sendFrame( const L2Frame& frame )
 {
 	OBJLOG(DEBUG) << "TCHFACCHL1Encoder " << frame;
 	// Simulate high FER for testing.
-	if (random()%100 < gConfig.getNum("Test.GSM.SimulatedFER.Downlink")) {
+	if (random()%100 < cfgSimulatedFERDownlink.get()) {
 		LOG(NOTICE) << "simulating dropped downlink frame at " << mNextWriteTime;
 		return;
 	}
@@ -1748,7 +1765,7 @@ void TCHFACCHL1Encoder::sendFrame( const L2Frame& frame )
 
 
 
-void TCHFACCHL1Encoder::dispatch()
+void TCHFACCHL1Encoder::dispatch(const Time& now)
 {
 
 	// No downstream?  That's a problem.
@@ -1757,18 +1774,15 @@ void TCHFACCHL1Encoder::dispatch()
 	// Get right with the system clock.
 	resync();
 
-	// If the channel is not active, wait for a multiframe and return.
+	// If the channel is not active, check again on next frame.
 	// Most channels do not need this, becuase they are entirely data-driven
 	// from above.  TCH/FACCH, however, must feed the interleaver on time.
-	if (!active()) {
-		mNextWriteTime += 26;
-		gBTS.clock().wait(mNextWriteTime);
+	if (!active())
 		return;
-	}
 
 	// Let previous data get transmitted.
-	resync();
-	waitToSend();
+	if (!readyToSend(now))
+		return;
 	
 	// flag to control stealing bits
 	bool currentFACCH = false; 
@@ -1776,7 +1790,7 @@ void TCHFACCHL1Encoder::dispatch()
 	// Speech latency control.
 	// Since Asterisk is local, latency should be small.
 	OBJLOG(DEBUG) <<"TCHFACCHL1Encoder speechQ.size=" << mSpeechQ.size();
-	int maxQ = gConfig.getNum("GSM.MaxSpeechLatency");
+	int maxQ = cfgMaxSpeechLatency.get();
 	while ((int)mSpeechQ.size() > maxQ) delete mSpeechQ.read();
 
 	// Send, by priority: (1) FACCH, (2) TCH, (3) filler.
@@ -1784,7 +1798,7 @@ void TCHFACCHL1Encoder::dispatch()
 		OBJLOG(DEBUG) <<"TCHFACCHL1Encoder FACCH " << *fFrame;
 		currentFACCH = true;
 		// Send to GSMTAP
-		if (gConfig.getBool("Control.GSMTAP.GSM")) {
+		if (cfgGsmTap.get()) {
 			gWriteGSMTAP(ARFCN(),TN(),mNextWriteTime.FN(),typeAndOffset(),mMapping.repeatLength()>51,false,*fFrame);
 		}
 		// Copy the L2 frame into u[] for processing.
@@ -1825,7 +1839,7 @@ void TCHFACCHL1Encoder::dispatch()
 
 	// randomly toggle bits in control channel bursts
 	// the toggle happens below, merged in with the ciphering
-	int p = currentFACCH ? gConfig.getFloat("GSM.Cipher.CCHBER") * (float)0xFFFFFF : 0;
+	int p = currentFACCH ? cfgCipherCCHBER.get() * (float)0xFFFFFF : 0;
 
 	// "mapping on a burst"
 	// Map c[] into outgoing normal bursts, marking stealing flags as needed.
@@ -1833,47 +1847,8 @@ void TCHFACCHL1Encoder::dispatch()
 	for (int B=0; B<4; B++) {
 		// set TDMA position
 		mBurst.time(mNextWriteTime);
-		// encrypt x
-		if (mEncrypted == ENCRYPT_YES) {
-			unsigned char block1[15];
-			unsigned char block2[15];
-			unsigned char *kc = parent()->decoder()->kc();
-			// 03.20 C.1.2
-			// 05.02 3.3.2.2.1
-			int fn = mNextWriteTime.FN();
-			int t1 = fn / (26*51);
-			int t2 = fn % 26;
-			int t3 = fn % 51;
-			int count = (t1<<11) | (t3<<5) | t2;
-			if (mEncryptionAlgorithm == 1) {
-				A51_GSM(kc, 64, count, block1, block2);
-			} else {
-				A53_GSM(kc, 64, count, block1, block2);
-			}
-			for (int i = 0; i < 114; i++) {
-				int b = p ? (random() & 0xFFFFFF) < p : 0;
-				b = b ^ (block1[i/8] >> (7-(i%8)));
-				mE[B+mOffset].settfb(i, mI[B+mOffset].bit(i) ^ (b&1));
-			}
-		} else {
-			if (p) {
-				for (int i = 0; i < 114; i++) {
-					int b = (random() & 0xFFFFFF) < p;
-					mE[B+mOffset].settfb(i, mI[B+mOffset].bit(i) ^ b);
-				}
-			} else {
-				// no noise and no encryption - use mI below
-			}
-		}
-		// copy in the bits
-		if (p || mEncrypted == ENCRYPT_YES) {
-			mE[B+mOffset].segment(0,57).copyToSegment(mBurst,3);
-			mE[B+mOffset].segment(57,57).copyToSegment(mBurst,88);
-		} else {
-			// no noise and no encryption - use mI
-			mI[B+mOffset].segment(0,57).copyToSegment(mBurst,3);
-			mI[B+mOffset].segment(57,57).copyToSegment(mBurst,88);
-		}
+		// encrypt x, copy in the bits
+		mapBurst(mI[B+mOffset],p);
 		// stealing bits
 		mBurst.Hu(currentFACCH);
 		mBurst.Hl(mPreviousFACCH);
@@ -1973,12 +1948,12 @@ void SACCHL1Encoder::setPhy(float wRSSI, float wTimingError)
 	SACCHL1Decoder &sib = *SACCHSibling();
 	// RSSI
 	float RSSI = sib.RSSI();
-	float RSSITarget = gConfig.getNum("GSM.Radio.RSSITarget");
+	float RSSITarget = cfgRSSITarget.get();
 	float deltaP = RSSI - RSSITarget;
 	float actualPower = sib.actualMSPower();
 	mOrderedMSPower = actualPower - deltaP;
-	float maxPower = gConfig.getNum("GSM.MS.Power.Max");
-	float minPower = gConfig.getNum("GSM.MS.Power.Min");
+	float maxPower = cfgMSPowerMax.get();
+	float minPower = cfgMSPowerMin.get();
 	if (mOrderedMSPower>maxPower) mOrderedMSPower=maxPower;
 	else if (mOrderedMSPower<minPower) mOrderedMSPower=minPower;
 	OBJLOG(INFO) <<"SACCHL1Encoder RSSI=" << RSSI << " target=" << RSSITarget
@@ -1987,7 +1962,7 @@ void SACCHL1Encoder::setPhy(float wRSSI, float wTimingError)
 	float timingError = sib.timingError();
 	float actualTiming = sib.actualMSTiming();
 	mOrderedMSTiming = actualTiming + timingError;
-	float maxTiming = gConfig.getNum("GSM.MS.TA.Max");
+	float maxTiming = cfgMSTAMax.get();
 	if (mOrderedMSTiming<0.0F) mOrderedMSTiming=0.0F;
 	else if (mOrderedMSTiming>maxTiming) mOrderedMSTiming=maxTiming;
 	OBJLOG(INFO) << "SACCHL1Encoder timingError=" << timingError  <<
@@ -2049,14 +2024,14 @@ void SACCHL1Encoder::sendFrame(const L2Frame& frame)
 		// Power.  GSM 05.08 4.
 		// Power expressed in dBm, RSSI in dB wrt max.
 		float RSSI = sib.RSSI();
-		float RSSITarget = gConfig.getNum("GSM.Radio.RSSITarget");
+		float RSSITarget = cfgRSSITarget.get();
 		float deltaP = RSSI - RSSITarget;
 		float actualPower = sib.actualMSPower();
 		float targetMSPower = actualPower - deltaP;
-		float powerDamping = gConfig.getNum("GSM.MS.Power.Damping")*0.01F;
+		float powerDamping = cfgMSPowerDamping.get()*0.01F;
 		mOrderedMSPower = powerDamping*mOrderedMSPower + (1.0F-powerDamping)*targetMSPower;
-		float maxPower = gConfig.getNum("GSM.MS.Power.Max");
-		float minPower = gConfig.getNum("GSM.MS.Power.Min");
+		float maxPower = cfgMSPowerMax.get();
+		float minPower = cfgMSPowerMin.get();
 		if (mOrderedMSPower>maxPower) mOrderedMSPower=maxPower;
 		else if (mOrderedMSPower<minPower) mOrderedMSPower=minPower;
 		OBJLOG(DEBUG) <<"SACCHL1Encoder RSSI=" << RSSI << " target=" << RSSITarget
@@ -2066,9 +2041,9 @@ void SACCHL1Encoder::sendFrame(const L2Frame& frame)
 		float timingError = sib.timingError();
 		float actualTiming = sib.actualMSTiming();
 		float targetMSTiming = actualTiming + timingError;
-		float TADamping = gConfig.getNum("GSM.MS.TA.Damping")*0.01F;
+		float TADamping = cfgMSTADamping.get()*0.01F;
 		mOrderedMSTiming = TADamping*mOrderedMSTiming + (1.0F-TADamping)*targetMSTiming;
-		float maxTiming = gConfig.getNum("GSM.MS.TA.Max");
+		float maxTiming = cfgMSTAMax.get();
 		if (mOrderedMSTiming<0.0F) mOrderedMSTiming=0.0F;
 		else if (mOrderedMSTiming>maxTiming) mOrderedMSTiming=maxTiming;
 		OBJLOG(DEBUG) << "SACCHL1Encoder timingError=" << timingError
@@ -2105,4 +2080,74 @@ void CBCHL1Encoder::sendFrame(const L2Frame& frame)
 
 
 
+L1FrameScheduler GSM::gL1Scheduler;
+
+
+void L1FrameScheduler::add(L1Encoder* encoder)
+{
+	ScopedLock lock(mLock);
+	for (unsigned i=0; i<mEncoders.size(); i++) {
+		if (mEncoders[i]==encoder) return;
+	}
+	// Keep TDMA order: by timeslot, then by carrier.
+	std::vector<L1Encoder*>::iterator it = mEncoders.begin();
+	for (; it!=mEncoders.end(); ++it) {
+		if ((*it)->TN()>encoder->TN()) break;
+		if ((*it)->TN()==encoder->TN() && (*it)->CN()>encoder->CN()) break;
+	}
+	mEncoders.insert(it,encoder);
+	mChanged = true;
+	LOG(INFO) << "L1 frame scheduler added " << encoder->descriptiveString() << ", encoders=" << mEncoders.size();
+}
+
+
+void L1FrameScheduler::tick()
+{
+	if (mResync) {
+		mResync = false;
+		mNextTick = gBTS.time();
+	}
+	gBTS.clock().wait(mNextTick);
+	Time now = gBTS.time();
+	int late = now - mNextTick;
+	if (late<0 || late>51*26) {
+		// The clock moved: don't count it as late processing.
+		LOG(INFO) << "L1 frame scheduler resync next=" << mNextTick << " now=" << now;
+		late = 0;
+	}
+	if (mChanged) {
+		ScopedLock lock(mLock);
+		mTickList = mEncoders;
+		mChanged = false;
+	}
+	// Encoders are serviced without holding the lock: they may call add() from open().
+	Timeval start;
+	for (unsigned i=0; i<mTickList.size(); i++) {
+		mTickList[i]->frameTick(now);
+	}
+	Timeval end;
+	int32_t us = 1000000*(int32_t)(end.sec()-start.sec()) + (int32_t)end.usec() - (int32_t)start.usec();
+	if (us<0) us = 0;
+	mNextTick = now + 1;
+	ScopedLock lock(mLock);
+	mTicks++;
+	mSkipped += late;
+	mBusyUs += us;
+	if ((unsigned)us>mMaxUs) mMaxUs = us;
+	if ((unsigned)us>gFrameMicroseconds) mOverruns++;
+}
+
+
+void L1FrameScheduler::stats(std::ostream& os) const
+{
+	ScopedLock lock(mLock);
+	os << "L1 frame scheduler: encoders=" << mEncoders.size() << " ticks=" << mTicks
+		<< " skipped=" << mSkipped << " overruns=" << mOverruns
+		<< " avg=" << (mTicks ? (unsigned)(mBusyUs/mTicks) : 0) << "us"
+		<< " max=" << mMaxUs << "us budget=" << gFrameMicroseconds << "us" << endl;
+}
+
+
+
+
 // vim: ts=4 sw=4
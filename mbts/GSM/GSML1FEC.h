@@ -40,6 +40,7 @@
 #include "../GPRS/GPRSExport.h"
 
 #include <string>
+#include <vector>
 
 class ARFCNManager;
 
@@ -78,6 +79,58 @@ enum EncryptionType {
 
 
 
+/**
+	A5 keystream generator of a dedicated channel, shared by its encoder and decoder.
+	The key setup is done once per Kc and both directions of a frame come out of
+	one A5 run. The keystreams are kept in a small cache, the encoder generates
+	them ahead of the air time and the uplink bursts of the same frames reuse them.
+*/
+class L1Keystream {
+
+	private:
+
+	static const unsigned CacheSize = 16;
+
+	struct Entry {
+		int count;					///< A5 COUNT, -1 if unused
+		unsigned char block1[15];	///< downlink keystream
+		unsigned char block2[15];	///< uplink keystream
+	};
+
+	mutable Mutex mLock;
+	int mAlgorithm;					///< algorithm of the key setup, 0 if none
+	unsigned char mKc[8];			///< key of the key setup
+	A51Key mA51;					///< A5/1 key setup
+	A53Key mA53;					///< A5/3 key setup
+	Entry mCache[CacheSize];
+	unsigned mNext;					///< next cache entry to replace
+
+	public:
+
+	L1Keystream();
+
+	/** The A5 COUNT of a frame, GSM 03.20 C.1.2, 05.02 3.3.2.2.1. */
+	static int count(int fn)
+		{ return ((fn / (26*51)) << 11) | ((fn % 51) << 5) | (fn % 26); }
+
+	/**
+		Get the keystreams of a frame, generate them if not cached.
+		@param kc The ciphering key.
+		@param algorithm The A5 algorithm, 1 or 3.
+		@param fn The frame number.
+		@param block1 The downlink keystream, 15 bytes, or NULL.
+		@param block2 The uplink keystream, 15 bytes, or NULL.
+	*/
+	void get(const unsigned char *kc, int algorithm, int fn,
+		unsigned char *block1, unsigned char *block2);
+
+	/** Generate the keystreams of a frame ahead of use. */
+	void prepare(const unsigned char *kc, int algorithm, int fn)
+		{ get(kc,algorithm,fn,NULL,NULL); }
+};
+
+
+
 
 /**
 	Abstract class for L1 encoders.
@@ -90,6 +143,7 @@ class L1Encoder {
 
 	ARFCNManager *mDownstream;
 	TxBurst mBurst;					///< a preformatted burst template
+	PackedBitVector mCipherE;		///< e[] of a ciphered burst, packed
 	TxBurst mFillerBurst;			///< the filler burst for this channel
 
 	/**@name Config items that don't change. */
@@ -110,8 +164,10 @@ class L1Encoder {
 	//@{
 	// (pat) The way this works is rollForward() sets mNextWriteTime to the next
 	// frame time specified in mMapping.  Each logical channel combination has a
-	// custom serviceloop function running in a separate thread to multiplex the downstream data,
+	// custom service function to multiplex the downstream data,
 	// and send an appropriate frame to ARFCNManager::writeHighSideTx.
+	// Clock driven encoders (TCH/FACCH, BCCH, SCH, FCCH) are serviced by the
+	// L1FrameScheduler once per frame, the others are driven from L2.
 	// This is totally unlike decoders, for which AFCNManager:receiveBurst uses
 	// the encoder mapping (which it has cached) to send incoming bursts directly
 	// to the mapped L1Decoder::writeLowSideRx() for each frame.
@@ -153,7 +209,7 @@ class L1Encoder {
 
 	ARFCNManager *getRadio() { return mDownstream; }
 	// Used by XCCHEncoder
-	void transmit(BitVector *mI, BitVector *mE, const int *qbits);
+	void transmit(BitVector *mI, const int *qbits);
 
 	/**@name Accessors. */
 	//@{
@@ -191,9 +247,32 @@ class L1Encoder {
 	*/
 	virtual void writeHighSide(const L2Frame&) { assert(0); }
 
-	/** Start the service loop thread, if there is one.  */
+	/**
+		Return the time until writeHighSide() can send a frame without blocking.
+		@return Delay in milliseconds, 0 if ready.
+	*/
+	virtual unsigned sendDelay() const;
+
+	/**
+		Send a frame only if writeHighSide() would not block.
+		The clock check and the send are done under the encoder lock so
+		idle filling from open() or close() can't get in between.
+		@param frame The frame to send.
+		@param delay Set to the time in milliseconds until ready if not sent.
+		@return true if the frame was sent.
+	*/
+	virtual bool writeHighSideNoWait(const L2Frame& frame, unsigned& delay);
+
+	/** Start the service, register with the frame tick scheduler if clock driven.  */
 	virtual void start() { mRunning=true; }
 
+	/**
+		Per frame service of clock driven encoders, called by L1FrameScheduler.
+		Must not block.
+		@param now The current BTS clock.
+	*/
+	virtual void frameTick(const Time& now) { }
+
 	const char* descriptiveString() const { return mDescriptiveString; }
 
 	L1FEC* parent() { return mParent; }
@@ -217,12 +296,24 @@ class L1Encoder {
 	/** Block until the BTS clock catches up to mPrevWriteTime.  */
 	void waitToSend() const;
 
+	/** Return true if the BTS clock caught up to mPrevWriteTime (waitToSend() would not block).  */
+	bool readyToSend(const Time& now) const { return (mPrevWriteTime - now) < 1; }
+
 	/**
 		Send the idle filling pattern, if any.
 		The default is a dummy burst.
 	*/
 	virtual void sendIdleFill();
 
+	/**
+		Put the e-bits of a burst into mBurst, GSM 05.03 4.1.5, 05.02 5.2.3.
+		Apply ciphering (GSM 03.20 C.1.2) and the simulated BER, if any,
+		a word at a time in mCipherE.
+		@param iBits The 114 i[] bits of the burst.
+		@param p The bit toggle probability, scaled to 0xFFFFFF.
+	*/
+	void mapBurst(const BitVector& iBits, int p);
+
 };
 
 
@@ -277,6 +368,7 @@ class L1Decoder {
 	int mEncryptionAlgorithm;
 	unsigned char mKc[8];
 	int mFN[8];
+	L1Keystream mKeystream;			///< keystream of both directions
 
 
 	public:
@@ -382,6 +474,7 @@ class L1Decoder {
 
 	bool decrypt_maybe(std::string wIMSI, int wA5Alg);
 	unsigned char *kc() { return mKc; }
+	L1Keystream& keystream() { return mKeystream; }
 };
 
 
@@ -448,6 +541,8 @@ class L1Decoder {
 
 	Routines:
 	The start() routine is usually called once to create a thread to start a serviceloop thread.
+	Clock driven encoders don't have a thread: start() registers them with the
+	L1FrameScheduler which calls frameTick() in TDMA order once per frame.
 	Radio bursts are then delivered to the class endpoints forever.
 	The channels are turned on/off by calling open()/close(), which sets the active flag
 	to determine whether they will process those bursts or drop them.
@@ -523,6 +618,14 @@ class L1FEC {
 		assert(mEncoder); mEncoder->writeHighSide(frame);
 	}
 
+	/** Return the time in milliseconds until writeHighSide() does not block. */
+	virtual unsigned sendDelay() const
+		{ return mEncoder ? mEncoder->sendDelay() : 0; }
+
+	/** Send a frame only if writeHighSide() would not block, see L1Encoder. */
+	virtual bool writeHighSideNoWait(const L2Frame& frame, unsigned& delay)
+		{ assert(mEncoder); return mEncoder->writeHighSideNoWait(frame,delay); }
+
 	/** Attach L1 to a downstream radio. */
 	void downstream(ARFCNManager*);
 
@@ -683,7 +786,6 @@ class SharedL1Encoder
 	public:
     BitVector mD;               ///< d[], as per GSM 05.03 2.2		Incoming Data.
     BitVector mI[4];           ///< i[][], as per GSM 05.03 2.2	Outgoing Data.
-    BitVector mE[4];
 
 	/**
 	  Encode u[] to c[].
@@ -717,14 +819,14 @@ class SharedL1Decoder
 	ViterbiR2O4 mVCoder;	///< nearly all GSM channels use the same convolutional code
     Parity mBlockCoder;
 	public:
-    SoftVector mC;              ///< c[], as per GSM 05.03 2.2
+    SoftVector8 mC;             ///< c[], as per GSM 05.03 2.2
     BitVector mU;               ///< u[], as per GSM 05.03 2.2
     BitVector mP;               ///< p[], as per GSM 05.03 2.2
     BitVector mDP;              ///< d[]:p[] (data & parity)
 	public:
     BitVector mD;               ///< d[], as per GSM 05.03 2.2
-    SoftVector mE[4];
-    SoftVector mI[4];           ///< i[][], as per GSM 05.03 2.2
+    SoftVector8 mE[4];
+    SoftVector8 mI[4];          ///< i[][], as per GSM 05.03 2.2
 	/**@name Handover Access Burst FEC state. */
 	//@{
 	Parity mHParity;			///< block coder for handover access bursts
@@ -741,7 +843,7 @@ class SharedL1Decoder
 
     void deinterleave();
     bool decode();
-	SoftVector *result() { return mI; }
+	SoftVector8 *result() { return mI; }
 };
 
 
@@ -1004,7 +1106,6 @@ private:
 	bool mPreviousFACCH;	///< A copy of the previous stealing flag state.
 	size_t mOffset;			///< Current deinterleaving offset.
 
-	BitVector mE[8];
 	// (pat) Yes, the mI here duplicates but overrides the same
 	// vector down in XCCHL1Encoder.
 	BitVector mI[8];			///< deinterleaving history, 8 blocks instead of 4
@@ -1022,9 +1123,6 @@ private:
 
 	L2FrameFIFO mL2Q;				///< input queue for L2 FACCH frames
 
-	Thread mEncoderThread;
-	friend void TCHFACCHL1EncoderRoutine( TCHFACCHL1Encoder * encoder );	
-
 public:
 
 	TCHFACCHL1Encoder(unsigned wCN, unsigned wTN, 
@@ -1038,6 +1136,9 @@ public:
 	/** Extend open() to set up semaphores. */
 	void open();
 
+	/** FACCH frames are queued and sent by dispatch(), writes never block. */
+	unsigned sendDelay() const { return 0; }
+
 protected:
 
 	// GSM 05.03, 3.1.3
@@ -1051,36 +1152,55 @@ protected:
 	void sendFrame(const L2Frame&);
 
 	/**
-		dispatch called in a while loop.
+		dispatch called by the frame tick scheduler.
 		process reading transcoder and fifo to 
-		interleave and send.
+		interleave and send when the previous block was sent.
 	*/
-	void dispatch();
+	void dispatch(const Time& now);
 
-	/** Will start the dispatch thread. */
+	/** Register with the frame tick scheduler. */
 	void start();
 
+	void frameTick(const Time& now) { dispatch(now); }
+
 	/** Encode a vocoder frame into c[]. */
 	void encodeTCH(const VocoderFrame& vFrame);
 
 };
 
 
-/** The C adapter for pthreads. */
-void TCHFACCHL1EncoderRoutine( TCHFACCHL1Encoder * encoder );
+/**
+	Receiver of uplink traffic frames, fed directly by the TCH decoder.
+	It is called from the radio receive thread so it must not block.
+*/
+class TCHFrameSink {
+
+	public:
+
+	virtual ~TCHFrameSink() {}
+
+	/**
+		Deliver a speech frame.
+		@param frame The 33 byte GSM 06.10 frame, valid only during the call.
+		@param good False if the frame was bad or stolen and was replaced per GSM 06.11.
+		@param fn Frame number of the last burst of the speech frame.
+	*/
+	virtual void writeTCH(const unsigned char* frame, bool good, uint32_t fn) = 0;
+};
+
 
 /** L1 decoder used for full rate TCH and FACCH -- mostly from GSM 05.03 3.1 and 4.2 */
 class TCHFACCHL1Decoder : public XCCHL1Decoder {
 
 	protected:
 
-	SoftVector mE[8];	///< deinterleaving history, 8 blocks instead of 4
-	SoftVector mI[8];	///< deinterleaving history, 8 blocks instead of 4
+	SoftVector8 mE[8];	///< deinterleaving history, 8 blocks instead of 4
+	SoftVector8 mI[8];	///< deinterleaving history, 8 blocks instead of 4
 	BitVector mTCHU;					///< u[] (uncoded) in the spec
 	BitVector mTCHD;					///< d[] (data) in the spec
-	SoftVector mClass1_c;				///< the class 1 part of c[]
+	SoftVector8 mClass1_c;				///< the class 1 part of c[]
 	BitVector mClass1A_d;				///< the class 1A part of d[]
-	SoftVector mClass2_c;				///< the class 2 part of c[]
+	SoftVector8 mClass2_c;				///< the class 2 part of c[]
 
 	VocoderFrame mVFrame;		///< unpacking buffer for current vocoder frame
 	VocoderFrame mPrevGoodFrame;	///< previous good frame
@@ -1088,6 +1208,9 @@ class TCHFACCHL1Decoder : public XCCHL1Decoder {
 	Parity mTCHParity;
 
 	InterthreadQueue<unsigned char> mSpeechQ;					///< output queue for speech frames
+	unsigned char mTCHFrame[33];		///< packing buffer for the current speech frame
+	TCHFrameSink* mSink;				///< if set, receives speech frames instead of mSpeechQ
+	Mutex mSinkLock;					///< protects mSink
 
 
 	public:
@@ -1119,10 +1242,17 @@ class TCHFACCHL1Decoder : public XCCHL1Decoder {
 	void replaceFACCH( int blockOffset );
 
 	/**
-		Decode a traffic frame from TCHI[] and enqueue it.
+		Decode a traffic frame from TCHI[] and deliver it to the sink or enqueue it.
 		Return true if there's a good frame.
 	*/
-	bool decodeTCH(bool stolen);
+	bool decodeTCH(bool stolen, uint32_t fn);
+
+	/**
+		Attach or detach the uplink speech frame receiver.
+		While a sink is attached frames are not queued for recvTCH().
+		Returns only after any frame delivery to the previous sink has finished.
+	*/
+	void setTCHSink(TCHFrameSink* sink);
 
 	/**
 		Receive a traffic frame.
@@ -1150,7 +1280,8 @@ class GeneratorL1Encoder :
 
 	private:
 
-	Thread mSendThread;
+	bool mHold;					///< true if generation is suspended
+	Time mHoldTime;				///< end of generation suspend
 
 	public:
 
@@ -1159,28 +1290,27 @@ class GeneratorL1Encoder :
 		unsigned wTN,
 		const TDMAMapping& wMapping,
 		L1FEC* wParent)
-		:L1Encoder(wCN,wTN,wMapping,wParent)
+		:L1Encoder(wCN,wTN,wMapping,wParent),
+		mHold(false)
 	{ }
 
+	/** Register with the frame tick scheduler. */
 	void start();
 
+	/** Call generate when the previous output was sent and not on hold. */
+	void frameTick(const Time& now);
+
 	protected: 
 
 	/** The generate method actually produces output bursts. */
 	virtual void generate() =0;
 
-	/** The core service loop calls generate repeatedly. */
-	void serviceLoop();
-
-	/** Provide a C interface for pthreads. */
-	friend void *GeneratorL1EncoderServiceLoopAdapter(GeneratorL1Encoder*);
+	/** Don't call generate for a number of frames. */
+	void hold(unsigned frames);
 
 };
 
 
-void *GeneratorL1EncoderServiceLoopAdapter(GeneratorL1Encoder*);
-
-
 /**
 	The L1 encoder for the sync channel (SCH).
 	The SCH sends out an encoding of the current BTS clock.
@@ -1236,10 +1366,6 @@ class FCCHL1Encoder : public GeneratorL1Encoder {
 */
 class NDCCHL1Encoder : public XCCHL1Encoder {
 
-	protected:
-
-	Thread mSendThread;
-
 	public:
 
 
@@ -1251,20 +1377,17 @@ class NDCCHL1Encoder : public XCCHL1Encoder {
 		:XCCHL1Encoder(wCN, wTN, wMapping, wParent)
 	{ }
 
+	/** Register with the frame tick scheduler. */
 	void start();
 
+	/** Call generate when the previous block was sent. */
+	void frameTick(const Time& now);
+
 	protected:
 
 	virtual void generate() =0;
-
-	/** The core service loop. */
-	void serviceLoop();
-
-	friend void *NDCCHL1EncoderServiceLoopAdapter(NDCCHL1Encoder*);
 };
 
-void *NDCCHL1EncoderServiceLoopAdapter(NDCCHL1Encoder*);
-
 
 
 /**
@@ -1445,6 +1568,9 @@ public:
 	unsigned queueSize() const
 		{ assert(mTCHDecoder); return mTCHDecoder->queueSize(); }
 
+	void setTCHSink(TCHFrameSink* sink)
+		{ assert(mTCHDecoder); mTCHDecoder->setTCHSink(sink); }
+
 	bool radioFailure() const
 		{ assert(mTCHDecoder); return mTCHDecoder->uplinkLost(); }
 };
@@ -1587,6 +1713,62 @@ class BCCHL1FEC : public NDCCHL1FEC {
 
 
 
+/**
+	Frame tick scheduler for clock driven L1 encoders.
+	A single thread replaces the per encoder service loops: once per TDMA frame
+	each registered encoder is serviced (L1Encoder::frameTick), in TDMA order.
+	The thread is run by the TransceiverManager, which also resynchronizes
+	the scheduler when the BTS clock is set from the TRX clock interface.
+*/
+class L1FrameScheduler {
+
+	private:
+
+	mutable Mutex mLock;
+	std::vector<L1Encoder*> mEncoders;	///< registered encoders, sorted by TN, CN
+	std::vector<L1Encoder*> mTickList;	///< encoders serviced by the tick thread
+	volatile bool mChanged;				///< mEncoders was changed
+	volatile bool mResync;				///< the BTS clock was set
+	Time mNextTick;						///< frame of the next tick
+
+	/**@name Per frame CPU budget statistics. */
+	//@{
+	unsigned mTicks;					///< serviced frames
+	unsigned mSkipped;					///< frames skipped (tick thread late)
+	unsigned mOverruns;					///< ticks longer than a frame
+	uint64_t mBusyUs;					///< total tick processing time
+	unsigned mMaxUs;					///< longest tick
+	//@}
+
+	public:
+
+	L1FrameScheduler()
+		:mChanged(false),mResync(true),
+		mTicks(0),mSkipped(0),mOverruns(0),mBusyUs(0),mMaxUs(0)
+	{ }
+
+	/** Add a clock driven encoder. */
+	void add(L1Encoder* encoder);
+
+	/** Resynchronize with the BTS clock before next tick. */
+	void resync() { mResync = true; }
+
+	/**
+		Wait for the next frame, service registered encoders.
+		Called repeatedly by the tick thread.
+	*/
+	void tick();
+
+	/** Print the encoders count and per frame processing time statistics. */
+	void stats(std::ostream& os) const;
+};
+
+/** The global frame tick scheduler. */
+extern L1FrameScheduler gL1Scheduler;
+
+
+
+
 
 }; 	// namespace GSM
 
@@ -75,7 +75,10 @@ L2LAPDm::L2LAPDm(unsigned wC, unsigned wSAPI)
 	mC(wC),mR(1-wC),mSAPI(wSAPI),
 	mMaster(NULL),
 	mT200(T200ms),
-	mIdleFrame(DATA)
+	mQueued(false),mBusy(false),mPending(false),
+	mTimerSlot(-1),mTimerTick(0),
+	mIdleFrame(DATA),
+	mL1OutT200(NULL)
 {
 	// sanity checks
 	assert(mC<2);
@@ -91,7 +94,18 @@ L2LAPDm::L2LAPDm(unsigned wC, unsigned wSAPI)
 }
 
 
-void L2LAPDm::writeL1(const L2Frame& frame)
+L2LAPDm::~L2LAPDm()
+{
+	if (mRunning) gL2Executor.remove(this);
+	ScopedLock lock(mL1Lock);
+	while (mL1Out.size()) {
+		delete mL1Out.front();
+		mL1Out.pop_front();
+	}
+}
+
+
+void L2LAPDm::writeL1(const L2Frame& frame, bool startTimer)
 {
 	OBJLOG(DEBUG) <<"L2LAPDm::writeL1 " << frame;
 	//assert(mDownstream);
@@ -99,7 +113,35 @@ void L2LAPDm::writeL1(const L2Frame& frame)
 	// It is tempting not to lock this, but if we don't,
 	// the ::open operation can result in contention in L1.
 	ScopedLock lock(mL1Lock);
-	mDownstream->writeHighSide(frame);
+	unsigned delay = 0;
+	if (mL1Out.empty() && mDownstream->writeHighSideNoWait(frame,delay)) {
+		if (startTimer) startT200();
+		return;
+	}
+	// Keep frames in order, the executor sends them when L1 is ready.
+	L2Frame* queued = new L2Frame(frame);
+	mL1Out.push_back(queued);
+	if (startTimer) mL1OutT200 = queued;
+	gL2Executor.schedule(this);
+}
+
+
+unsigned L2LAPDm::flushL1()
+{
+	// Caller should hold mLock.
+	ScopedLock lock(mL1Lock);
+	while (mL1Out.size()) {
+		L2Frame* frame = mL1Out.front();
+		unsigned delay = 0;
+		if (!mDownstream->writeHighSideNoWait(*frame,delay)) return delay ? delay : 1;
+		mL1Out.pop_front();
+		if (frame==mL1OutT200) {
+			mL1OutT200 = NULL;
+			startT200();
+		}
+		delete frame;
+	}
+	return 0;
 }
 
 
@@ -118,8 +160,7 @@ void L2LAPDm::writeL1Ack(const L2Frame& frame)
 	OBJLOG(DEBUG) <<"L2LAPDm::writeL1Ack " << frame;
 	frame.copyTo(mSentFrame);
 	mSentFrame.primitive(frame.primitive());
-	writeL1(frame);
-	mT200.set(T200());
+	writeL1(frame,true);
 }
 
 
@@ -271,8 +312,7 @@ void L2LAPDm::retransmissionProcedure()
 	// GSM 04.08 5.5.7, bullet point (a)
 	OBJLOG(DEBUG) << "VS=" << mVS << " VA=" << mVA << " RC=" << mRC;
 	mRC++;
-	writeL1(mSentFrame);
-	mT200.set(T200());
+	writeL1(mSentFrame,true);
 	mAckSignal.signal();
 }
 
@@ -291,11 +331,20 @@ void L2LAPDm::open()
 			// since N201 may not be defined yet.
 			mMaxIPayloadBits = 8*N201(L2Control::IFormat);
 			mRunning = true;
-			mUpstreamThread.start((void *(*)(void*))LAPDmServiceLoopAdapter,this,"bts:l2lapdm");
+			gL2Executor.add(this);
 		}
 		OBJLOG(DEBUG);
 		mL3Out.clear();
 		mL1In.clear();
+		{
+			// Drop frames queued for a previous use of the channel.
+			ScopedLock l1lock(mL1Lock);
+			while (mL1Out.size()) {
+				delete mL1Out.front();
+				mL1Out.pop_front();
+			}
+			mL1OutT200 = NULL;
+		}
 		clearCounters();
 		mState = LinkReleased;
 		mAckSignal.signal();
@@ -307,14 +356,6 @@ void L2LAPDm::open()
 }
 
 
-void *GSM::LAPDmServiceLoopAdapter(L2LAPDm *lapdm)
-{
-	lapdm->serviceLoop();
-	return NULL;
-}
-
-
-
 void L2LAPDm::writeHighSide(const L3Frame& frame)
 {
 	OBJLOG(DEBUG) << frame;
@@ -351,7 +392,7 @@ void L2LAPDm::writeHighSide(const L3Frame& frame)
 			clearCounters();
 			mEstablishmentInProgress=false;
 			mState=AwaitingRelease;
-			mT200.set(T200());	// HACK?
+			startT200();	// HACK?
 			// Send DISC and wait for UA.
 			// Don't return until released.
 			sendUFrameDISC();
@@ -383,39 +424,45 @@ void L2LAPDm::writeLowSide(const L2Frame& frame)
 {
 	OBJLOG(DEBUG) << frame;
 	mL1In.write(new L2Frame(frame));
+	gL2Executor.schedule(this);
 }
 
 
 
-void L2LAPDm::serviceLoop()
+void L2LAPDm::startT200()
 {
-	mLock.lock();
-	while (mRunning) {
-		// Block for up to T200 expiration, then check T200.
-		// Allow other threads to modify state while blocked.
-		// Add 2 ms to prevent race condition due to roundoff error.
-		unsigned timeout = mT200.remaining() + 2;
+	// Caller should hold mLock.
+	mT200.set(T200());
+	// Add 2 ms to prevent race condition due to roundoff error.
+	gL2Executor.arm(this,T200()+2);
+}
+
+
+void L2LAPDm::service()
+{
+	ScopedLock lock(mLock);
+	while (true) {
 		// If SAP0 is released, other SAPs need to release also.
 		if (mMaster) {
 			if (mMaster->mState==LinkReleased) mState=LinkReleased;
 		}
-		if (!mT200.active()) {
-			if (mState==LinkReleased) timeout=3600000;
-			else timeout = T200();
-		}
-		OBJLOG(DEBUG) << "read blocking up to " << timeout << " ms, state=" << mState;
-		mLock.unlock();
-		// FIXME -- If the link is released, there should be no timeout at all.
-		L2Frame* frame = mL1In.read(timeout);
-		mLock.lock();
-		if (frame!=NULL) {
-			OBJLOG(DEBUG) << "state=" << mState << " received " << *frame;
-			receiveFrame(*frame);
-			delete frame;
-		}
 		if (mT200.expired()) T200Expiration();
+		L2Frame* frame = mL1In.readNoBlock();
+		if (frame==NULL) break;
+		OBJLOG(DEBUG) << "state=" << mState << " received " << *frame;
+		receiveFrame(*frame);
+		delete frame;
 	}
-	mLock.unlock();
+	// Send what L1 can take now, wake up when it can take the rest.
+	unsigned wait = flushL1();
+	// Wake up for T200 expiration.
+	// While the link is not released poll every T200 for SAP0 release.
+	unsigned timer = 0;
+	if (mT200.active()) timer = mT200.remaining()+2;
+	else if (mState!=LinkReleased) timer = T200();
+	if (timer && (!wait || timer<wait)) wait = timer;
+	if (wait) gL2Executor.arm(this,wait);
+	else gL2Executor.disarm(this);
 }
 	
 
@@ -1028,4 +1075,192 @@ void CBCHL2::writeHighSide(const GSM::L3Frame& l3)
 
 
 
+
+
+L2Executor GSM::gL2Executor;
+
+
+uint64_t L2Executor::nowTick()
+{
+	Timeval now;
+	return ((uint64_t)now.sec()*1000 + now.usec()/1000) / TickMs;
+}
+
+
+void L2Executor::startWorkers()
+{
+	// Caller should hold mLock.
+	unsigned n = gConfig.getNum("GSM.L2.Workers");
+	if (n<1) n = 1;
+	mWheelTick = nowTick();
+	for (unsigned i=0; i<n; i++) {
+		Thread* thread = new Thread;
+		thread->start((void*(*)(void*))L2ExecutorWorkerAdapter,this,"bts:l2work");
+		mWorkers.push_back(thread);
+	}
+	LOG(INFO) << "L2 executor started " << n << " workers";
+}
+
+
+void L2Executor::add(L2LAPDm* lapdm)
+{
+	ScopedLock lock(mLock);
+	if (!mWorkers.size()) startWorkers();
+	mEntities++;
+}
+
+
+void L2Executor::remove(L2LAPDm* lapdm)
+{
+	ScopedLock lock(mLock);
+	unlink(lapdm);
+	if (lapdm->mQueued) {
+		mReady.remove(lapdm);
+		lapdm->mQueued = false;
+	}
+	// Wait for a running task to finish.
+	while (lapdm->mBusy) mIdle.wait(mLock);
+	lapdm->mPending = false;
+	if (mEntities) mEntities--;
+}
+
+
+void L2Executor::enqueue(L2LAPDm* lapdm)
+{
+	// Caller should hold mLock.
+	if (lapdm->mBusy) {
+		// Serviced again by the current worker when done.
+		lapdm->mPending = true;
+		return;
+	}
+	if (lapdm->mQueued) return;
+	lapdm->mQueued = true;
+	mReady.push_back(lapdm);
+	if (mReady.size()>mMaxQueue) mMaxQueue = mReady.size();
+	mWork.signal();
+}
+
+
+void L2Executor::unlink(L2LAPDm* lapdm)
+{
+	// Caller should hold mLock.
+	if (lapdm->mTimerSlot<0) return;
+	mWheel[lapdm->mTimerSlot].remove(lapdm);
+	lapdm->mTimerSlot = -1;
+	mArmed--;
+}
+
+
+void L2Executor::schedule(L2LAPDm* lapdm)
+{
+	ScopedLock lock(mLock);
+	enqueue(lapdm);
+}
+
+
+void L2Executor::arm(L2LAPDm* lapdm, unsigned ms)
+{
+	ScopedLock lock(mLock);
+	unlink(lapdm);
+	// Round up, never expire early.
+	lapdm->mTimerTick = nowTick() + (ms + TickMs - 1) / TickMs + 1;
+	lapdm->mTimerSlot = lapdm->mTimerTick % WheelSlots;
+	mWheel[lapdm->mTimerSlot].push_back(lapdm);
+	mArmed++;
+	// Make sure a worker is ticking the wheel.
+	if (!mTicking) mWork.signal();
+}
+
+
+void L2Executor::disarm(L2LAPDm* lapdm)
+{
+	ScopedLock lock(mLock);
+	unlink(lapdm);
+}
+
+
+void L2Executor::advance()
+{
+	// Caller should hold mLock.
+	uint64_t now = nowTick();
+	if (now<mWheelTick) {
+		// The system time moved back.
+		mWheelTick = now;
+		return;
+	}
+	// Visit each slot at most once if we are late.
+	if (now-mWheelTick>WheelSlots) mWheelTick = now - WheelSlots;
+	while (mArmed && mWheelTick<now) {
+		mWheelTick++;
+		std::list<L2LAPDm*>& slot = mWheel[mWheelTick % WheelSlots];
+		std::list<L2LAPDm*>::iterator it = slot.begin();
+		while (it!=slot.end()) {
+			L2LAPDm* lapdm = *it;
+			// Deadlines more than one wheel turn away stay in the slot.
+			if (lapdm->mTimerTick>now) {
+				++it;
+				continue;
+			}
+			it = slot.erase(it);
+			lapdm->mTimerSlot = -1;
+			mArmed--;
+			mTimeouts++;
+			enqueue(lapdm);
+		}
+	}
+	mWheelTick = now;
+}
+
+
+void L2Executor::workerLoop()
+{
+	mLock.lock();
+	while (true) {
+		advance();
+		if (mReady.empty()) {
+			// One worker ticks the wheel, the others wait for work.
+			if (mArmed && !mTicking) {
+				mTicking = true;
+				mWork.wait(mLock,TickMs);
+				mTicking = false;
+			}
+			else mWork.wait(mLock);
+			continue;
+		}
+		L2LAPDm* lapdm = mReady.front();
+		mReady.pop_front();
+		lapdm->mQueued = false;
+		lapdm->mBusy = true;
+		mTasks++;
+		mLock.unlock();
+		lapdm->service();
+		mLock.lock();
+		lapdm->mBusy = false;
+		mIdle.broadcast();
+		if (lapdm->mPending) {
+			lapdm->mPending = false;
+			enqueue(lapdm);
+		}
+	}
+}
+
+
+void *GSM::L2ExecutorWorkerAdapter(L2Executor* executor)
+{
+	executor->workerLoop();
+	return NULL;
+}
+
+
+void L2Executor::stats(std::ostream& os) const
+{
+	ScopedLock lock(mLock);
+	os << "L2 executor: workers=" << mWorkers.size() << " entities=" << mEntities
+		<< " tasks=" << mTasks << " timeouts=" << mTimeouts
+		<< " armed=" << mArmed << " queued=" << mReady.size()
+		<< " maxqueue=" << mMaxQueue << endl;
+}
+
+
+
 // vim: ts=4 sw=4
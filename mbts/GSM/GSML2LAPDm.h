@@ -26,6 +26,7 @@ implementation, although no code is copied directly.
 
 #include "GSMCommon.h"
 #include "GSMTransfer.h"
+#include <list>
 
 
 namespace GSM {
@@ -203,8 +204,7 @@ class L2LAPDm : public L2DL {
 
 	protected:
 
-	Thread mUpstreamThread;		///< a thread for upstream traffic and T200 timeouts
-	bool mRunning;				///< true once the service loop starts
+	bool mRunning;				///< true once the first open() was done
 	L3FrameFIFO mL3Out;			///< we connect L2->L3 through a FIFO
 	L2FrameFIFO mL1In;			///< we connect L1->L2 through a FIFO
 
@@ -241,12 +241,27 @@ class L2LAPDm : public L2DL {
 	//@}
 	//@}
 
+	/**@name Scheduling state, protected by the L2Executor lock. */
+	//@{
+	bool mQueued;				///< in the executor run queue
+	bool mBusy;					///< being serviced by an executor worker
+	bool mPending;				///< new work arrived while being serviced
+	int mTimerSlot;				///< executor timer wheel slot, -1 if not armed
+	uint64_t mTimerTick;		///< executor timer deadline, in wheel ticks
+	//@}
+
 	/** A handy idle frame. */
 	L2Frame mIdleFrame;
 
 	/** A lock to control multi-threaded access to L1->L2. */
 	Mutex mL1Lock;
 
+	/**@name Downlink frames waiting for L1, protected by mL1Lock. */
+	//@{
+	std::list<L2Frame*> mL1Out;	///< frames not sent yet to avoid blocking on the L1 clock
+	L2Frame* mL1OutT200;		///< queued frame that starts T200 when sent
+	//@}
+
 	/** HACK -- A count of consecutive idle frames. Used to spot stuck channels. */
 	unsigned mIdleCount;
 
@@ -264,7 +279,7 @@ class L2LAPDm : public L2DL {
 	*/
 	L2LAPDm(unsigned wC=1, unsigned wSAPI=0);
 
-	virtual ~L2LAPDm() {}
+	virtual ~L2LAPDm();
 
 
 	/** Process an uplink L2 frame. */
@@ -304,8 +319,19 @@ class L2LAPDm : public L2DL {
 	/** Block until we receive any pending ack. */
 	void waitForAck();
 
-	/** Send an L2Frame on the L2->L1 interface. */
-	void writeL1(const L2Frame&);
+	/**
+		Send an L2Frame on the L2->L1 interface.
+		The frame is queued and sent later by service() if L1 would block.
+		@param startTimer Start T200 when the frame is sent, caller must hold mLock.
+	*/
+	void writeL1(const L2Frame&, bool startTimer = false);
+
+	/**
+		Send queued frames to L1 while it would not block.
+		Caller should hold mLock.
+		@return Delay in milliseconds until next frame can be sent, 0 if queue is empty.
+	*/
+	unsigned flushL1();
 
 	void writeL1Ack(const L2Frame&);			///< send an ack-able frame on L2->L1
 	void writeL1NoAck(const L2Frame&);			///< send a non-acked frame on L2->L1
@@ -419,20 +445,109 @@ class L2LAPDm : public L2DL {
 	*/
 	bool stuckChannel(const L2Frame&);
 
+	/** Start T200 and arm the executor timer for its expiration. */
+	void startT200();
+
 	/**
-		The upstream service loop handles incoming L2 frames and T200 timeouts.
+		Handle the incoming L2 frames and T200 timeouts.
+		Run as a task by the L2Executor, must not be called concurrently.
 	*/
-	void serviceLoop();
+	void service();
 
-	friend void *LAPDmServiceLoopAdapter(L2LAPDm*);
+	friend class L2Executor;
 };
 
 
 std::ostream& operator<<(std::ostream&, L2LAPDm::LAPDState);
 
 
-/** C-style adapter for LAPDm serice loop. */
-void *LAPDmServiceLoopAdapter(L2LAPDm*);
+
+/**
+	Executor for the LAPDm state machines.
+	Incoming L2 frames and T200 timeouts are serviced as tasks by a small pool
+	of worker threads (GSM.L2.Workers) instead of one upstream thread per L2LAPDm.
+	Timers are kept in a timer wheel with TickMs resolution.
+	Tasks never block on the L1 clock: downlink frames L1 can't take yet are
+	queued in the L2LAPDm and sent when the encoder is ready.
+	An L2LAPDm is never serviced by two workers at the same time.
+	Lock order is L2LAPDm::mLock, then the executor lock.
+*/
+class L2Executor {
+
+	public:
+
+	static const unsigned TickMs = 10;			///< timer wheel resolution
+	static const unsigned WheelSlots = 512;		///< timer wheel size, about 5 s
+
+	private:
+
+	mutable Mutex mLock;
+	Signal mWork;					///< signaled when tasks are queued or timers armed
+	Signal mIdle;					///< signaled when a worker finished a task
+	std::list<L2LAPDm*> mReady;		///< run queue
+	std::list<L2LAPDm*> mWheel[WheelSlots];	///< timers, by deadline tick modulo WheelSlots
+	uint64_t mWheelTick;			///< last tick processed by the timer wheel
+	unsigned mArmed;				///< number of armed timers
+	bool mTicking;					///< a worker is waiting for the next tick
+	std::vector<Thread*> mWorkers;	///< the worker pool, started on first use
+
+	/**@name Statistics. */
+	//@{
+	unsigned mEntities;				///< registered L2 entities
+	uint64_t mTasks;				///< serviced tasks
+	uint64_t mTimeouts;				///< expired timers
+	unsigned mMaxQueue;				///< longest run queue
+	//@}
+
+	/** Current time, in wheel ticks. */
+	static uint64_t nowTick();
+
+	/** Start the worker pool, caller must hold mLock. */
+	void startWorkers();
+
+	/** Queue an entity for service, caller must hold mLock. */
+	void enqueue(L2LAPDm* lapdm);
+
+	/** Remove an armed timer, caller must hold mLock. */
+	void unlink(L2LAPDm* lapdm);
+
+	/** Move expired timers to the run queue, caller must hold mLock. */
+	void advance();
+
+	public:
+
+	L2Executor()
+		:mWheelTick(0),mArmed(0),mTicking(false),
+		mEntities(0),mTasks(0),mTimeouts(0),mMaxQueue(0)
+	{ }
+
+	/** Register an entity, start the workers if needed. */
+	void add(L2LAPDm* lapdm);
+
+	/** Unregister an entity. */
+	void remove(L2LAPDm* lapdm);
+
+	/** Schedule an entity for service as soon as possible. */
+	void schedule(L2LAPDm* lapdm);
+
+	/** Schedule an entity for service after a delay in milliseconds. */
+	void arm(L2LAPDm* lapdm, unsigned ms);
+
+	/** Cancel a pending timer. */
+	void disarm(L2LAPDm* lapdm);
+
+	/** The worker thread loop. */
+	void workerLoop();
+
+	/** Print the entities count and task statistics. */
+	void stats(std::ostream& os) const;
+};
+
+/** The global LAPDm executor. */
+extern L2Executor gL2Executor;
+
+/** C-style adapter for the executor worker threads. */
+void *L2ExecutorWorkerAdapter(L2Executor*);
 
 
 
@@ -135,6 +135,9 @@ class L3CellSelectionParameters : public L3ProtocolElement {
 
 
 
+// From GSM 05.02 6.5.
+const unsigned sMax_BS_PA_MFRMS = 9;
+
 /** Control Channel Description, GSM 04.08 10.5.2.11 */
 class L3ControlChannelDescription : public L3ProtocolElement {
 
@@ -157,10 +160,12 @@ class L3ControlChannelDescription : public L3ProtocolElement {
 	/** Sets reasonable defaults for a single-ARFCN system. */
 	L3ControlChannelDescription():L3ProtocolElement()
 	{
-		// Values dictated by the current implementation are hard-coded.
-		mBS_AG_BLKS_RES=2;			// reserve 2 CCCHs for access grant
-		mBS_PA_MFRMS=0;				// minimum PCH spacing
 		// Configurable values.
+		// We always have a C-V beacon with 3 CCCH blocks, keep at least one for paging.
+		long res = gConfig.getNum("GSM.CCCH.AGCH.Reserved");
+		mBS_AG_BLKS_RES = (res>=0 && res<=2) ? res : 2;	// CCCHs reserved for access grant
+		long mfrms = gConfig.getNum("GSM.CCCH.PCH.Multiframes");
+		mBS_PA_MFRMS = (mfrms>=2 && mfrms<=(long)sMax_BS_PA_MFRMS) ? mfrms-2 : 0;	// PCH spacing
 		mATT=(unsigned)gConfig.getBool("Control.LUR.AttachDetach");
 		mCCCH_CONF=gConfig.getNum("GSM.CCCH.CCCH-CONF");
 		mT3212=gConfig.getNum("GSM.Timer.T3212")/6;
@@ -169,6 +174,9 @@ class L3ControlChannelDescription : public L3ProtocolElement {
 	// BS_PA_MFRMS is the number of 51-multiframes used for paging in the range 2..9.
 	unsigned getBS_PA_MFRMS();
 
+	// BS_AG_BLKS_RES is the number of CCCH blocks reserved for access grant.
+	unsigned getBS_AG_BLKS_RES() const { return mBS_AG_BLKS_RES; }
+
 	size_t lengthV() const { return 3; }
 	void writeV(L3Frame& dest, size_t &wp) const;
 	void parseV(const L3Frame&, size_t&) { assert(0); }
@@ -87,6 +87,10 @@ ostream& GSM::operator<<(ostream& os, L3RRMessage::MessageType val)
 			os << "Paging Response"; break;
 		case L3RRMessage::PagingRequestType1: 
 			os << "Paging Request Type 1"; break;
+		case L3RRMessage::PagingRequestType2: 
+			os << "Paging Request Type 2"; break;
+		case L3RRMessage::PagingRequestType3: 
+			os << "Paging Request Type 3"; break;
 		case L3RRMessage::MeasurementReport: 
 			os << "Measurement Report"; break;
 		case L3RRMessage::AssignmentComplete: 
@@ -223,6 +227,98 @@ void L3PagingRequestType1::text(ostream& os) const
 }
 
 
+
+size_t L3PagingRequestType2::l2BodyLength() const
+{
+	int sz = mMobileIDs.size();
+	assert(sz>=2 && sz<=3);
+	size_t sum = 1 + 4 + 4;
+	if (sz>2) sum += mMobileIDs[2].lengthTLV();
+	return sum;
+}
+
+
+void L3PagingRequestType2::writeBody(L3Frame& dest, size_t &wp) const
+{
+	// See GSM 04.08 9.1.23.
+	// Page Mode Page Mode M V 1/2 10.5.2.26
+	// Channels Needed M V 1/2
+	// Mobile Identity 1 TMSI/P-TMSI M V 4 10.5.2.42
+	// Mobile Identity 2 TMSI/P-TMSI M V 4 10.5.2.42
+	// 0x17 Mobile Identity 3 O TLV 3-10 10.5.1.4
+	// P2 Rest Octets M V 1-11 10.5.2.24
+
+	size_t wpstart = wp;
+	int sz = mMobileIDs.size();
+	assert(sz>=2 && sz<=3);
+	assert(mMobileIDs[0].type()==TMSIType && mMobileIDs[1].type()==TMSIType);
+	dest.writeField(wp,channelNeededCode(mChannelsNeeded[1]),2);
+	dest.writeField(wp,channelNeededCode(mChannelsNeeded[0]),2);
+	// "normal paging", GSM 04.08 Table 10.5.63
+	dest.writeField(wp,0x0,4);
+	dest.writeField(wp,mMobileIDs[0].TMSI(),32);
+	dest.writeField(wp,mMobileIDs[1].TMSI(),32);
+	if (sz>2) {
+		mMobileIDs[2].writeTLV(0x17,dest,wp);
+		// P2 Rest Octets, only the channel needed for the third mobile ID.
+		// The rest is L, same as the spare padding.
+		dest.writeH(wp);
+		dest.writeField(wp,channelNeededCode(mChannelsNeeded[2]),2);
+		while (wp & 7) { dest.writeL(wp); }
+	}
+	assert(wp-wpstart == fullBodyLength() * 8);
+}
+
+
+void L3PagingRequestType2::text(ostream& os) const
+{
+	L3RRMessage::text(os);
+	os << " mobileIDs=(";
+	for (unsigned i=0; i<mMobileIDs.size(); i++) {
+		os << "(" << mMobileIDs[i] << "," << mChannelsNeeded[i] << "),";
+	}
+	os << ")";
+}
+
+
+void L3PagingRequestType3::writeBody(L3Frame& dest, size_t &wp) const
+{
+	// See GSM 04.08 9.1.24.
+	// Page Mode Page Mode M V 1/2 10.5.2.26
+	// Channels Needed M V 1/2
+	// Mobile Identity 1..4 TMSI/P-TMSI M V 4 10.5.2.42
+	// P3 Rest Octets M V 3 10.5.2.25
+
+	size_t wpstart = wp;
+	dest.writeField(wp,channelNeededCode(mChannelsNeeded[1]),2);
+	dest.writeField(wp,channelNeededCode(mChannelsNeeded[0]),2);
+	// "normal paging", GSM 04.08 Table 10.5.63
+	dest.writeField(wp,0x0,4);
+	for (unsigned i=0; i<4; i++) {
+		assert(mMobileIDs[i].type()==TMSIType);
+		dest.writeField(wp,mMobileIDs[i].TMSI(),32);
+	}
+	// P3 Rest Octets, only the channels needed for the third and fourth mobile IDs.
+	// The rest is L, same as the spare padding.
+	dest.writeH(wp);
+	dest.writeField(wp,channelNeededCode(mChannelsNeeded[2]),2);
+	dest.writeField(wp,channelNeededCode(mChannelsNeeded[3]),2);
+	while (wp & 7) { dest.writeL(wp); }
+	assert(wp-wpstart == fullBodyLength() * 8);
+}
+
+
+void L3PagingRequestType3::text(ostream& os) const
+{
+	L3RRMessage::text(os);
+	os << " mobileIDs=(";
+	for (unsigned i=0; i<4; i++) {
+		os << "(" << mMobileIDs[i] << "," << mChannelsNeeded[i] << "),";
+	}
+	os << ")";
+}
+
+
 size_t L3PagingResponse::l2BodyLength() const
 {
 	return 1 + mClassmark.lengthLV() + mMobileID.lengthLV();
@@ -233,6 +233,83 @@ class L3PagingRequestType1 : public L3RRMessageNRO {
 };
 
 
+/**
+	Paging Request Type 2, GSM 04.08 9.1.23
+	The first two mobile IDs must be TMSIs, the optional third one can be of any type.
+*/
+class L3PagingRequestType2 : public L3RRMessageRO {
+
+	private:
+
+	std::vector<L3MobileIdentity> mMobileIDs;
+	ChannelType mChannelsNeeded[3];
+
+	public:
+
+	L3PagingRequestType2(const L3MobileIdentity& wId1, ChannelType wType1,
+			const L3MobileIdentity& wId2, ChannelType wType2)
+		:L3RRMessageRO()
+	{
+		mMobileIDs.push_back(wId1);
+		mChannelsNeeded[0]=wType1;
+		mMobileIDs.push_back(wId2);
+		mChannelsNeeded[1]=wType2;
+		mChannelsNeeded[2]=AnyDCCHType;
+	}
+
+	L3PagingRequestType2(const L3MobileIdentity& wId1, ChannelType wType1,
+			const L3MobileIdentity& wId2, ChannelType wType2,
+			const L3MobileIdentity& wId3, ChannelType wType3)
+		:L3RRMessageRO()
+	{
+		mMobileIDs.push_back(wId1);
+		mChannelsNeeded[0]=wType1;
+		mMobileIDs.push_back(wId2);
+		mChannelsNeeded[1]=wType2;
+		mMobileIDs.push_back(wId3);
+		mChannelsNeeded[2]=wType3;
+	}
+
+	int MTI() const { return PagingRequestType2; }
+
+	size_t l2BodyLength() const;
+	size_t restOctetsLength() const { return mMobileIDs.size()>2 ? 1 : 0; }
+	void writeBody(L3Frame& dest, size_t& wp) const;
+	void text(std::ostream&) const;
+};
+
+
+/**
+	Paging Request Type 3, GSM 04.08 9.1.24
+	All four mobile IDs must be TMSIs.
+*/
+class L3PagingRequestType3 : public L3RRMessageRO {
+
+	private:
+
+	L3MobileIdentity mMobileIDs[4];
+	ChannelType mChannelsNeeded[4];
+
+	public:
+
+	L3PagingRequestType3(const L3MobileIdentity* wIds, const ChannelType* wTypes)
+		:L3RRMessageRO()
+	{
+		for (unsigned i=0; i<4; i++) {
+			mMobileIDs[i]=wIds[i];
+			mChannelsNeeded[i]=wTypes[i];
+		}
+	}
+
+	int MTI() const { return PagingRequestType3; }
+
+	size_t l2BodyLength() const { return 1 + 4*4; }
+	size_t restOctetsLength() const { return 1; }
+	void writeBody(L3Frame& dest, size_t& wp) const;
+	void text(std::ostream&) const;
+};
+
+
 
 
 /** Paging Response, GSM 04.08 9.1.25 */
@@ -140,27 +140,31 @@ void CCCHLogicalChannel::serviceLoop()
 	// build the idle frame
 	static const L3PagingRequestType1 filler;
 	static const L3Frame idleFrame(filler,UNIT_DATA);
-#if ENABLE_PAGING_CHANNELS
 	L3ControlChannelDescription mCC;
 	unsigned bs_pa_mfrms = mCC.getBS_PA_MFRMS();
-#endif
+	// Poll the paging queues about once per 51-multiframe while idle
+	const unsigned pagingPollMs = 51 * 4615 / 1000;
 	// prime the first idle frame
 	LogicalChannel::send(idleFrame);
+	bool idle = true;
 	// run the loop
 	while (true) {
 		L3Frame* frame = NULL;
-#if ENABLE_PAGING_CHANNELS
-		// Check for paging message for this specific paging slot first,
+		// Check for paging message for this specific paging block first,
 		// and if none, send any message in the mQ.
 		// The multiframe paging logic is from GSM 05.02 6.5.3.
-		// See documentation at crackPagingFromImsi() which is used to
-		// get the messages into the proper mPagingQ.
-		GSM::Time next = getNextWriteTime();
-		unsigned multiframe_index = (next.FN() / 51) % bs_pa_mfrms;
-		frame = mPagingQ[multiframe_index].read();
-#endif
-		if (frame == NULL) {
-			frame = mQ.read();	// (pat) This is a blocking read; mQ is an InterThreadQueue
+		// See GSMConfig::sendPCH() which is used to get the messages
+		// into the proper mPagingQ.
+		bool paging = pagingLoad() != 0;
+		if (paging) {
+			GSM::Time next = getNextWriteTime();
+			unsigned multiframe_index = (next.FN() / 51) % bs_pa_mfrms;
+			frame = mPagingQ[multiframe_index].readNoBlock();
+			if (frame == NULL) frame = mQ.readNoBlock();
+		}
+		else {
+			// Wait for a message, wake up once in a while to check the paging queues.
+			frame = mQ.read(pagingPollMs);
 		}
 		if (frame) {
 			// (pat) This tortuously calls XCCCHL1Encoder::transmit (see my documentation
@@ -171,11 +175,14 @@ void CCCHLogicalChannel::serviceLoop()
 			mWaitingToSend = true;	// Waiting to send this block at mNextWriteTime.
 			LogicalChannel::send(*frame);
 			mWaitingToSend = false;
+			idle = false;
 			OBJLOG(DEBUG) << "CCCHLogicalChannel::serviceLoop sending " << *frame
 				<< " load: " << load() << " time: " << getNextWriteTime();
 			delete frame;
 		}
-		if (mQ.size()==0) {
+		// Send an idle frame after the last message, or to move to the next
+		//  block while paging messages wait for their 51-multiframe.
+		if (mQ.size()==0 && (paging || !idle)) {
 			// (pat) The radio continues to send the last frame forever,
 			// so we only send one idle frame here.
 			// Unfortunately, this slows the response.
@@ -183,6 +190,7 @@ void CCCHLogicalChannel::serviceLoop()
 			mWaitingToSend = true;	// Waiting to send an idle frame at mNextWriteTime.
 			LogicalChannel::send(idleFrame);
 			mWaitingToSend = false;
+			idle = true;
 			OBJLOG(DEBUG) << "CCCHLogicalChannel::serviceLoop sending idle frame";
 		}
 	}
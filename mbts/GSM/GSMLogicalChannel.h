@@ -500,9 +500,7 @@ class CCCHLogicalChannel : public NDCCHLogicalChannel {
 
 	Thread mServiceThread;	///< a thread for the service loop
 	L3FrameFIFO mQ;			///< because the CCCH is written by multiple threads
-#if ENABLE_PAGING_CHANNELS
-	L3FrameFIFO mPagingQ[sMax_BS_PA_MFRMS];	///< A queue for each paging channel on this timeslot.
-#endif
+	L3FrameFIFO mPagingQ[sMax_BS_PA_MFRMS];	///< A queue for each 51-multiframe of the paging cycle.
 	bool mRunning;			///< a flag to indication that the service loop is running
 	bool mWaitingToSend;	// If this is set, there is another CCCH message
 							// waiting in the encoder serviceloop.
@@ -530,6 +528,14 @@ class CCCHLogicalChannel : public NDCCHLogicalChannel {
 	/** Return the number of messages waiting for transmission. */
 	unsigned load() const { return mQ.size(); }
 
+	/** Return the number of paging messages waiting for their paging block. */
+	unsigned pagingLoad() const
+	{
+		unsigned total = 0;
+		for (unsigned i=0; i<sMax_BS_PA_MFRMS; i++) total += mPagingQ[i].size();
+		return total;
+	}
+
 	// (pat) GPRS needs to know exactly when the CCCH message will be sent downstream,
 	// because it needs to allocate an upstream radio block after that time,
 	// and preferably as quickly as possible after that time.
@@ -595,6 +601,9 @@ class TCHFACCHLogicalChannel : public LogicalChannel {
 	unsigned queueSize() const
 		{ assert(mTCHL1); return mTCHL1->queueSize(); }
 
+	void setTCHSink(TCHFrameSink* sink)
+		{ assert(mTCHL1); mTCHL1->setTCHSink(sink); }
+
 	bool radioFailure() const
 		{ assert(mTCHL1); return mTCHL1->radioFailure(); }
 };
@@ -35,6 +35,21 @@ void SAPMux::writeHighSide(const L2Frame& frame)
 
 
 
+bool SAPMux::writeHighSideNoWait(const L2Frame& frame, unsigned& delay)
+{
+	// Only data is paced by the L1 encoder, primitives don't block.
+	// The encoder checks its clock and sends under its own lock.
+	delay = 0;
+	OBJLOG(DEBUG) << frame;
+	ScopedLock lock(mLock);
+	if (frame.primitive()==DATA)
+		return mDownstream->writeHighSideNoWait(frame,delay);
+	mDownstream->writeHighSide(frame);
+	return true;
+}
+
+
+
 void SAPMux::writeLowSide(const L2Frame& frame)
 {
 	OBJLOG(DEBUG) << frame.SAPI() << " " << frame;
@@ -56,6 +56,14 @@ class SAPMux  {
 
 	virtual void writeHighSide(const L2Frame& frame); 
 	virtual void writeLowSide(const L2Frame& frame); 
+
+	/**
+		Send a frame to L1 only if L1 would not block.
+		@param frame The frame to send.
+		@param delay Set to the time in milliseconds until L1 is ready if not sent.
+		@return true if the frame was sent.
+	*/
+	virtual bool writeHighSideNoWait(const L2Frame& frame, unsigned& delay);
 	
 	void upstream( L2DL * wUpstream, unsigned wSAPI=0 )
 		{ assert(mUpstream[wSAPI]==NULL); mUpstream[wSAPI]=wUpstream; }
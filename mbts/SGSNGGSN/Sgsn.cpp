@@ -17,6 +17,7 @@
 */
 
 #include <list>
+#include <map>
 //#include "RList.h"
 #include "LLC.h"
 //#include "MSInfo.h"
@@ -44,6 +45,10 @@ using namespace Connection;
 namespace SGSN {
 typedef std::list<SgsnInfo*> SgsnInfoList_t;
 static SgsnInfoList_t sSgsnInfoList;
+// Index of sSgsnInfoList by mMsHandle, see findSgsnInfoByHandle.
+typedef std::multimap<uint32_t,SgsnInfo*> SgsnInfoMap_t;
+static SgsnInfoMap_t sSgsnInfoMap;
+static time_t sSgsnInfoSweepTime = 0;	// Last time idle SgsnInfo were removed.
 typedef std::list<GmmInfo*> GmmInfoList_t;
 static GmmInfoList_t sGmmInfoList;
 static Mutex sSgsnListMutex;	// One lock sufficient for all lists maintained by SGSN.
@@ -107,6 +112,22 @@ const char *GmmCause::name(unsigned mt, bool ornull)
 	}
 }
 
+static void sgsnInfoIndex(SgsnInfo *si)
+{
+	sSgsnInfoMap.insert(SgsnInfoMap_t::value_type(si->mMsHandle,si));
+}
+
+static void sgsnInfoUnindex(SgsnInfo *si)
+{
+	std::pair<SgsnInfoMap_t::iterator,SgsnInfoMap_t::iterator> range = sSgsnInfoMap.equal_range(si->mMsHandle);
+	for (SgsnInfoMap_t::iterator it = range.first; it != range.second; it++) {
+		if (it->second == si) {
+			sSgsnInfoMap.erase(it);
+			return;
+		}
+	}
+}
+
 SgsnInfo::SgsnInfo(uint32_t wMsHandle) :
 	//mState(GmmState::GmmNotOurTlli),
 	mGmmp(0),
@@ -124,6 +145,7 @@ SgsnInfo::SgsnInfo(uint32_t wMsHandle) :
 	mLlcEngine = new LlcEngine(this);
 #endif
 	sSgsnInfoList.push_back(this);
+	sgsnInfoIndex(this);
 	SGSNLOGF(INFO,GPRS_OK|GPRS_MSG,"SGSN","Created SgsnInfo:" << this);
 }
 
@@ -151,6 +173,7 @@ void SgsnInfo::sirm()
 	sgsnInfoDump(this,ss);
 	SGSNLOGF(INFO,GPRS_OK|GPRS_MSG,"SGSN","Removing SgsnInfo:"<<ss.str());
 	sSgsnInfoList.remove(this);
+	sgsnInfoUnindex(this);
 	GmmInfo *gmm = getGmm();
 	if (gmm && (gmm->getSI() == this)) {
 		gmm->msi = 0;
@@ -1880,20 +1903,39 @@ SgsnInfo *findSgsnInfoByHandle(uint32_t handle, bool create)
 	time_t now; time(&now);
 
 	ScopedLock lock(sSgsnListMutex);
-	RN_FOR_ALL(SgsnInfoList_t,sSgsnInfoList,si) {
-		if (si->mMsHandle == handle) {result=si; continue;}
+	// Kill off old ones, except ones that are the primary one for a gmm.
+	// The list may be long so walk it at most once per second.
+	if (now != sSgsnInfoSweepTime) {
+		sSgsnInfoSweepTime = now;
+		RN_FOR_ALL(SgsnInfoList_t,sSgsnInfoList,si) {
+			if (si->mMsHandle == handle) {continue;}
 #if RN_UMTS
 #else
 #if NEW_TLLI_ASSIGN_PROCEDURE
-		if (si->mAltTlli == handle) {result=si;continue;}
+			if (si->mAltTlli == handle) {continue;}
 #endif
 #endif
-		// Kill off old ones, except ones that are the primary one for a gmm.
-		GmmInfo *gmm = si->getGmm();
-		if (gmm==NULL || gmm->getSI() != si) {
-			if (now - si->mLastUseTime > idletime) { si->sirm(); }
+			GmmInfo *gmm = si->getGmm();
+			if (gmm==NULL || gmm->getSI() != si) {
+				if (now - si->mLastUseTime > idletime) { si->sirm(); }
+			}
+		}
+	}
+	// If there are several use the newest one, like the list order.
+	std::pair<SgsnInfoMap_t::iterator,SgsnInfoMap_t::iterator> range = sSgsnInfoMap.equal_range(handle);
+	for (SgsnInfoMap_t::iterator it = range.first; it != range.second; it++) {
+		result = it->second;
+	}
+#if RN_UMTS
+#else
+#if NEW_TLLI_ASSIGN_PROCEDURE
+	if (!result) {
+		RN_FOR_ALL(SgsnInfoList_t,sSgsnInfoList,si) {
+			if (si->mAltTlli == handle) {result=si;}
 		}
 	}
+#endif
+#endif
 	if (result) {
 		time(&result->mLastUseTime);
 		return result;
@@ -2268,7 +2310,9 @@ SgsnInfo * SgsnInfo::changeTlli(bool now)
 		killOtherTlli(si,newTlli);
 		if (now) {
 			si->mAltTlli = si->mMsHandle;
+			sgsnInfoUnindex(si);
 			si->mMsHandle = newTlli;
+			sgsnInfoIndex(si);
 		} else {
 			si->mAltTlli = newTlli;
 		}
@@ -80,7 +80,8 @@ TransceiverManager::TransceiverManager(int numARFCNs, int wBasePort,
 	mClockSocket(wBasePort+3,wLocalAddr),
 	mControlSocket(wBasePort+1,wTRXAddress,wBasePort,wLocalAddr),
         mStopRequest(false),
-	mExitRecv(false), m_statistics(false)
+	mExitRecv(false), m_statistics(false),
+	mDataTransport(TrxDataUdp)
 {
 	addAddr(mInitData,wLocalAddr,wBasePort + 1,"\r\nControl: ");
 	addAddr(mInitData,wTRXAddress,wBasePort," - ");
@@ -108,6 +109,7 @@ void TransceiverManager::logInit()
 void TransceiverManager::start()
 {
 	mClockThread.start((void*(*)(void*))ClockLoopAdapter,this,"bts:clock");
+	mTickThread.start((void*(*)(void*))TickLoopAdapter,this,"bts:l1tick");
 	for (unsigned i=0; i<mARFCNs.size(); i++) {
 		mARFCNs[i]->start();
 	}
@@ -164,7 +166,7 @@ int TransceiverManager::sendCommandPacket(const char* cmdString, const char* cmd
 }
 
 bool TransceiverManager::sendCommand(const char* cmd, int* iParam, const char* sParam,
-	int* rspParam, int arfcn)
+	int* rspParam, int arfcn, std::string* rspExtra)
 {
 	if (!cmd)
 		return false;
@@ -201,10 +203,6 @@ bool TransceiverManager::sendCommand(const char* cmd, int* iParam, const char* s
 			status = -2;
                 }
 	}
-	if (status == 0)
-		return true;
-	if (exiting())
-		return false;
 	char* extra = 0;
 	if (rspLen > 0) {
 		// 'RSP CMD_NAME {FIRST_NUMBER} [SECOND_NUMBER] ...'
@@ -217,6 +215,16 @@ bool TransceiverManager::sendCommand(const char* cmd, int* iParam, const char* s
 				extra = 0;
 		}
 	}
+	if (rspExtra) {
+		if (extra)
+			rspExtra->assign(extra + 1);
+		else
+			rspExtra->clear();
+	}
+	if (status == 0)
+		return true;
+	if (exiting())
+		return false;
 	if (extra) {
 		LOG(ALERT) << cmd << " failed with status " << status << " extra:" << extra;
 	}
@@ -237,6 +245,67 @@ bool TransceiverManager::sendCommand(const char* cmd, int* iParam, const char* s
 }
 
 
+bool TransceiverManager::reset()
+{
+	// Offer batched datagrams and shared memory burst data transports
+	// Old transceivers ignore the offer and keep using one datagram per burst
+	char param[64];
+	sprintf(param,"%u data=shm,mmsg",numARFCNs());
+	std::string extra;
+	if (!sendCommand("RESET",0,param,0,-1,&extra))
+		return false;
+	setupDataTransport(extra);
+	return true;
+}
+
+
+const char* TransceiverManager::dataTransportName() const
+{
+	switch (mDataTransport) {
+		case TrxDataShm:
+			return "shm";
+		case TrxDataMmsg:
+			return "mmsg";
+	}
+	return "udp";
+}
+
+
+void TransceiverManager::setupDataTransport(const std::string& rspExtra)
+{
+	for (unsigned i=0; i<mARFCNs.size(); i++)
+		mARFCNs[i]->closeShm();
+	mDataTransport = TrxDataUdp;
+	// 'data=udp', 'data=mmsg' or 'data=shm:<segment path prefix>'
+	size_t pos = rspExtra.find("data=");
+	if (pos == std::string::npos)
+		return;
+	std::string data = rspExtra.substr(pos + 5);
+	data = data.substr(0,data.find(' '));
+	if (data == "mmsg")
+		mDataTransport = TrxDataMmsg;
+	else if (data.compare(0,4,"shm:") == 0) {
+		std::string prefix = data.substr(4);
+		unsigned i = 0;
+		for (; i<mARFCNs.size(); i++) {
+			char tmp[16];
+			sprintf(tmp,"%u",i);
+			if (!mARFCNs[i]->openShm((prefix + tmp).c_str()))
+				break;
+		}
+		if (i == mARFCNs.size())
+			mDataTransport = TrxDataShm;
+		else {
+			LOG(WARNING) << "failed to attach shared memory data interface " << prefix << i
+				<< ": " << strerror(errno) << ", using datagrams";
+			for (i=0; i<mARFCNs.size(); i++)
+				mARFCNs[i]->closeShm();
+		}
+	}
+	LOG(INFO) << "burst data transport " << dataTransportName();
+}
+
+
 void* ClockLoopAdapter(TransceiverManager *transceiver)
 {
 	// This loop checks the clock messages from the transceiver.
@@ -254,6 +323,20 @@ void* ClockLoopAdapter(TransceiverManager *transceiver)
 }
 
 
+void* TickLoopAdapter(TransceiverManager *transceiver)
+{
+	// This loop drives the clocked L1 encoders (TCH/FACCH, BCCH, SCH, FCCH).
+	// It runs once per TDMA frame after the clock was received from transceiver.
+	while (1) {
+		if (transceiver->haveClock())
+			gL1Scheduler.tick();
+		else
+			sleepFrame();
+	}
+	return NULL;
+}
+
+
 
 void TransceiverManager::clockHandler()
 {
@@ -287,6 +370,7 @@ void TransceiverManager::clockHandler()
 		sscanf(buffer,"IND CLOCK %u", &FN);
 		LOG(INFO) << "CLOCK indication, current clock = " << gBTS.clock().get() << " new clock ="<<FN;
 		gBTS.clock().set(FN);
+		gL1Scheduler.resync();
 		mHaveClock = true;
 		return;
 	}
@@ -407,6 +491,10 @@ void TransceiverManager::scanTableUpdate(unsigned arfcn, int rssi)
 	const char* localIP, TransceiverManager &wTransceiver)
 	:mTransceiver(wTransceiver),
 	mDataSocket(wBasePort+1,wTRXAddress,wBasePort,localIP),
+	mDataShmOn(false),
+	mDataShmFull(0),
+	mRxBatchCount(0),
+	mRxBatchPos(0),
 	mArfcnPos(wArfcnPos),
         mScanning(false)
 {
@@ -427,6 +515,22 @@ void ::ARFCNManager::start()
 }
 
 
+bool ::ARFCNManager::openShm(const char* path)
+{
+	ScopedLock lock(mDataSocketLock);
+	mDataShmOn = mDataShm.open(path);
+	return mDataShmOn;
+}
+
+
+void ::ARFCNManager::closeShm()
+{
+	ScopedLock lock(mDataSocketLock);
+	mDataShmOn = false;
+	mDataShm.close();
+}
+
+
 void ::ARFCNManager::installDecoder(GSM::L1Decoder *wL1d)
 {
 	unsigned TN = wL1d->TN();
@@ -479,9 +583,13 @@ void ::ARFCNManager::writeHighSideTx(const GSM::TxBurst& burst,const char *culpr
 	for (unsigned i=0; i<gSlotLen; i++) {
 		*wp++ = (unsigned char)((*dp++) & 0x01);
 	}
-	// write to the socket
+	// write to the shared memory ring or socket
 	mDataSocketLock.lock();
-	mDataSocket.write(buffer,bufferSize);
+	if (!mDataShmOn)
+		mDataSocket.write(buffer,bufferSize);
+	else if (!mDataShm.write(buffer,bufferSize) && !(mDataShmFull++ % 1000)) {
+		LOG(WARNING) << "shared memory data ring full, dropped " << mDataShmFull << " burst(s)";
+	}
 	mDataSocketLock.unlock();
 }
 
@@ -491,9 +599,27 @@ void ::ARFCNManager::writeHighSideTx(const GSM::TxBurst& burst,const char *culpr
 void ::ARFCNManager::driveRx()
 {
 	// read the message
-	char buffer[MAX_UDP_LENGTH];
-	int msgLen = mDataSocket.read(buffer);
-	if (msgLen<=0) SOCKET_ERROR;
+	char* buffer = mRxBatch[0];
+	int msgLen = 0;
+	if (mDataShmOn) {
+		// timeout lets the loop check for thread cancellation
+		msgLen = mDataShm.read(buffer,MAX_UDP_LENGTH,500);
+		if (msgLen<=0) return;
+	}
+	else {
+		// handle packets received in a single batch before reading again
+		if (mRxBatchPos >= mRxBatchCount) {
+			mRxBatchPos = 0;
+			mRxBatchCount = mDataSocket.read(mRxBatch[0],mRxBatchLen,MAX_UDP_BATCH);
+			if (mRxBatchCount<=0) {
+				mRxBatchCount = 0;
+				SOCKET_ERROR;
+			}
+		}
+		buffer = mRxBatch[mRxBatchPos];
+		msgLen = mRxBatchLen[mRxBatchPos++];
+		if (msgLen<=0) SOCKET_ERROR;
+	}
         // decode
         unsigned char *rp = (unsigned char*)buffer;
         // timeslot number
@@ -689,7 +815,10 @@ bool ::ARFCNManager::powerOff()
 
 bool ::ARFCNManager::powerOn(bool warn)
 {
-	int status = sendCommand("POWERON");
+	// confirm the burst data transport, the transceiver waits for it to use shared memory
+	char param[32];
+	sprintf(param,"data=%s",mTransceiver.dataTransportName());
+	int status = sendCommand("POWERON",param);
 	if (status!=0) {
 		if (warn) {
 			LOG(ALERT) << "POWERON failed with status " << status;
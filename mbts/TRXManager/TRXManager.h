@@ -28,6 +28,7 @@
 #include "GSMTransfer.h"
 #include <list>
 #include <Timeval.h>
+#include "trxdata.h"
 
 
 /* Forward refs into the GSM namespace. */
@@ -58,6 +59,8 @@ class TransceiverManager {
 	UDPSocket mClockSocket;		
 	/// a thread to monitor the global clock socket
 	Thread mClockThread;	
+	/// a thread to run the L1 frame tick scheduler
+	Thread mTickThread;
 	Mutex mControlLock;			///< lock to prevent overlapping transactions
 	UDPSocket mControlSocket;		///< socket for radio control
 	std::string mInitData;			///< Init data (for debug)
@@ -66,6 +69,7 @@ class TransceiverManager {
 
 	bool mExitRecv;                         ///< Exiting received from lower layer
 	bool m_statistics;                      ///< Statistics are enabled (BTS started)
+	int mDataTransport;                     ///< Burst data transport (TrxDataTransport)
         
         int mScanTable[GSM::sGsmMaxArfcns];     ///< uplink interference scan results
         static const unsigned mScanStepMs = 100;
@@ -124,7 +128,7 @@ class TransceiverManager {
 	*/
 	void logInit();
 
-	/** Start the clock management thread and all ARFCN managers. */
+	/** Start the clock management and frame tick threads and all ARFCN managers. */
 	void start();
 
 	/**
@@ -136,18 +140,25 @@ class TransceiverManager {
 	*/
 	int sendCommandPacket(const char* cmdString, const char* cmdName, char* response);
 
+	/**
+		Send a command and check the response status.
+		@param rspExtra Optional destination for response text following status and parameter.
+		@return true on success.
+	*/
 	bool sendCommand(const char* cmd, int* iParam = 0, const char* sParam = 0,
-	    int* rspParam = 0, int arfcn = -1);
+	    int* rspParam = 0, int arfcn = -1, std::string* rspExtra = 0);
 
 	/**
-		Reset the transceiver
+		Reset the transceiver, negotiate the burst data transport.
 		@return true on success.
 	*/
-	inline bool reset()
-	{
-		int p = numARFCNs();
-		return sendCommand("RESET",&p);
-	}
+	bool reset();
+
+	/** Burst data transport in use (TrxDataTransport). */
+	int dataTransport() const { return mDataTransport; }
+
+	/** Burst data transport name, as used in transceiver commands. */
+	const char* dataTransportName() const;
 
 	/**
 		Stop the transceiver
@@ -169,6 +180,9 @@ class TransceiverManager {
 
 	/** Clock service loop. */
 	friend void* ClockLoopAdapter(TransceiverManager*);
+
+	/** Frame tick service loop. */
+	friend void* TickLoopAdapter(TransceiverManager*);
         
         void startScan();
         
@@ -193,6 +207,9 @@ class TransceiverManager {
 
 	/** Handler for messages on the clock interface. */
 	void clockHandler();
+
+	/** Attach to the burst data transport selected by transceiver in RESET response. */
+	void setupDataTransport(const std::string& rspExtra);
         
         void scanTableClear();
 };
@@ -202,6 +219,8 @@ class TransceiverManager {
 
 void* ClockLoopAdapter(TransceiverManager *TRXm);
 
+void* TickLoopAdapter(TransceiverManager *TRXm);
+
 
 
 
@@ -219,6 +238,17 @@ class ARFCNManager {
 	UDPSocket mDataSocket;			///< socket for data transfer
 	Thread mRxThread;				///< thread to receive data from rx
 
+	/**@name Burst data transport. */
+	//@{
+	TrxDataShmIface mDataShm;				///< shared memory data interface
+	bool mDataShmOn;					///< shared memory data interface in use
+	unsigned mDataShmFull;					///< bursts dropped on full shared memory ring
+	char mRxBatch[MAX_UDP_BATCH][MAX_UDP_LENGTH];		///< received packets
+	int mRxBatchLen[MAX_UDP_BATCH];				///< received packets length
+	int mRxBatchCount;					///< number of packets in mRxBatch
+	int mRxBatchPos;					///< next packet to handle in mRxBatch
+	//@}
+
 	/**@name The demux table. */
 	//@{
 	Mutex mTableLock;
@@ -243,6 +273,16 @@ class ARFCNManager {
 
 	unsigned ARFCN() const { return mARFCN; }
 
+	/**
+		Attach to the shared memory data interface created by transceiver.
+		@param path Segment file path.
+		@return true on success.
+	*/
+	bool openShm(const char* path);
+
+	/** Detach from shared memory data interface, use the data socket. */
+	void closeShm();
+
 	 // (pat) This passes the message through to UDPSocket::write(),
 	 // which maps to DatagramSocket::write() which does an immediate sendto() on the socket.
 	 // (pat) Renamed overloaded function to clarify code.
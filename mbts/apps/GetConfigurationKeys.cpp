@@ -352,13 +352,38 @@ ConfigurationKeyMap getConfigurationKeys()
 	map[tmp->getName()] = *tmp;
 	delete tmp;
 
+	tmp = new ConfigurationKey("GPRS.ChannelCodingControl.BLER.Downgrade","20",
+		"percent",
+		ConfigurationKey::DEVELOPER,
+		ConfigurationKey::VALRANGE,
+		"5:50",// educated guess
+		false,
+		"If the block error rate of a MS in one direction is higher than this amount in percent GPRS switches to the next more robust codec allowed by GPRS.Codecs.  "
+			"Must be greater than GPRS.ChannelCodingControl.BLER.Upgrade."
+	);
+	map[tmp->getName()] = *tmp;
+	delete tmp;
+
+	tmp = new ConfigurationKey("GPRS.ChannelCodingControl.BLER.Upgrade","5",
+		"percent",
+		ConfigurationKey::DEVELOPER,
+		ConfigurationKey::VALRANGE,
+		"0:20",// educated guess
+		false,
+		"If the block error rate of a MS in one direction is lower than this amount in percent GPRS switches to the next faster codec allowed by GPRS.Codecs."
+	);
+	map[tmp->getName()] = *tmp;
+	delete tmp;
+
 	tmp = new ConfigurationKey("GPRS.ChannelCodingControl.RSSI","-40",
 		"dB",
 		ConfigurationKey::DEVELOPER,
 		ConfigurationKey::VALRANGE,
 		"-65:-15",// educated guess
 		false,
-		"If the initial unlink signal strength is less than this amount in DB GPRS uses a lower bandwidth but more robust encoding CS-1.  "
+		"If the initial unlink signal strength is less than this amount in DB GPRS uses a lower bandwidth but more robust encoding: "
+			"CS-3 down to 8 dB below, CS-2 down to 10 dB below and CS-1 under that.  "
+			"Afterwards the codec follows the block error rate of the MS.  "
 			"This value should normally be GSM.Radio.RSSITarget + 10 dB."
 	);
 	map[tmp->getName()] = *tmp;
@@ -427,7 +452,8 @@ ConfigurationKeyMap getConfigurationKeys()
 		ConfigurationKey::STRING,
 		"^1{0,1}2{0,1}3{0,1}4{0,1}$",// "1234" with each number optional
 		false,
-		"List of allowed GPRS downlink codecs 1..4 for CS-1..CS-4.  Currently, only 1 and 4 are supported e.g. 14."
+		"List of allowed GPRS downlink codecs 1..4 for CS-1..CS-4 e.g. 14.  "
+			"CS-2 and CS-3 are supported but not enabled by default, use 1234 to let link adaptation use all of them."
 	);
 	map[tmp->getName()] = *tmp;
 	delete tmp;
@@ -438,7 +464,8 @@ ConfigurationKeyMap getConfigurationKeys()
 		ConfigurationKey::STRING,
 		"^1{0,1}2{0,1}3{0,1}4{0,1}$",// "1234" with each number optional
 		false,
-		"List of allowed GPRS uplink codecs 1..4 for CS-1..CS-4.  Currently, only 1 and 4 are supported e.g. 14."
+		"List of allowed GPRS uplink codecs 1..4 for CS-1..CS-4 e.g. 14.  "
+			"CS-2 and CS-3 are supported but not enabled by default, use 1234 to let link adaptation use all of them."
 	);
 	map[tmp->getName()] = *tmp;
 	delete tmp;
@@ -1018,6 +1045,32 @@ ConfigurationKeyMap getConfigurationKeys()
 	map[tmp->getName()] = *tmp;
 	delete tmp;
 
+	tmp = new ConfigurationKey("GSM.CCCH.AGCH.Reserved","2",
+		"blocks",
+		ConfigurationKey::CUSTOMERTUNE,
+		ConfigurationKey::VALRANGE,
+		"0:2",
+		true,
+		"Number of CCCH blocks in each 51-multiframe reserved for access grants (BS_AG_BLKS_RES).  "
+			"The other CCCH blocks are used as paging blocks, access grants may still use them when not paging.  "
+			"This is broadcast in the beacon and it cannot be changed once BTS is started."
+	);
+	map[tmp->getName()] = *tmp;
+	delete tmp;
+
+	tmp = new ConfigurationKey("GSM.CCCH.PCH.Multiframes","2",
+		"multiframes",
+		ConfigurationKey::CUSTOMERTUNE,
+		ConfigurationKey::VALRANGE,
+		"2:9",
+		true,
+		"Number of 51-multiframes between transmissions of paging requests to the same paging group (BS_PA_MFRMS).  "
+			"Higher values save idle mode battery in the handsets but increase the paging delay.  "
+			"This is broadcast in the beacon and it cannot be changed once BTS is started."
+	);
+	map[tmp->getName()] = *tmp;
+	delete tmp;
+
 	tmp = new ConfigurationKey("GSM.CCCH.CCCH-CONF","1",
 		"",
 		ConfigurationKey::CUSTOMERTUNE,
@@ -1345,6 +1398,17 @@ ConfigurationKeyMap getConfigurationKeys()
 	map[tmp->getName()] = *tmp;
 	delete tmp;
 
+	tmp = new ConfigurationKey("GSM.L2.Workers","2",
+		"threads",
+		ConfigurationKey::CUSTOMERTUNE,
+		ConfigurationKey::VALRANGE,
+		"1:8",
+		true,
+		"Number of worker threads running the LAPDm state machines of all channels."
+	);
+	map[tmp->getName()] = *tmp;
+	delete tmp;
+
 	tmp = new ConfigurationKey("GSM.MS.Power.Damping","50",
 		"?damping value",
 		ConfigurationKey::CUSTOMERTUNE,
@@ -1410,8 +1474,9 @@ ConfigurationKeyMap getConfigurationKeys()
 		ConfigurationKey::VALRANGE,
 		"1:5",// educated guess
 		false,
-		"Maximum allowed speech buffering latency, in 20 millisecond frames.  "
-			"If the jitter is larger than this delay, frames will be lost."
+		"Maximum allowed downlink speech buffering latency, in 20 millisecond frames.  "
+			"If the jitter is larger than this delay, frames will be lost.  "
+			"Uplink frames are sent as soon as they are decoded and are not affected."
 	);
 	map[tmp->getName()] = *tmp;
 	delete tmp;
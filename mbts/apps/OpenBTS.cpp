@@ -239,7 +239,9 @@ int main(int argc, char *argv[])
 	gParser.addCommands();
 
 	if (gCmdConn.valid()) {
-		gSigConn.start("bts:signaling");
+		// Signalling handlers call L2 primitives that may wait for LAPDm
+		// acknowledgements, keep them off the reactor serving media.
+		gSigConn.start("bts:signaling",true);
 		gLogConn.write("Starting MBTS...");
 	}
 	else
@@ -447,8 +449,11 @@ int main(int argc, char *argv[])
 
 	// Set up the pager.
 	// Set up paging channels.
-	// HACK -- For now, use a single paging channel, since paging groups are broken.
-	gBTS.addPCH(&CCCH2);
+	// The first BS_AG_BLKS_RES blocks are reserved for access grant, the others are paging blocks.
+	CCCHLogicalChannel* ccchBlocks[3] = { &CCCH0, &CCCH1, &CCCH2 };
+	for (unsigned i=L3ControlChannelDescription().getBS_AG_BLKS_RES(); i<3; i++) {
+		gBTS.addPCH(ccchBlocks[i]);
+	}
 
 	// Be sure we are not over-reserving.
 	if (gConfig.getNum("GSM.Channels.SDCCHReserve")>=(int)gBTS.SDCCHTotal()) {
@@ -49,7 +49,9 @@ typedef unsigned char Byte;
 #include <stdio.h>
 #include <ctype.h>
 
+#ifndef NO_TEST
 #define TEST
+#endif
  
 /*
  * rand[0..15]: the challenge from the base station
@@ -0,0 +1,739 @@
+/**
+ * nipcauth.cpp
+ * This file is part of the Yate-BTS Project http://www.yatebts.com
+ *
+ * In-process GSM (COMP128) and UMTS (MILENAGE) authentication
+ *
+ * Yet Another Telephony Engine - Base Transceiver Station
+ * Copyright (C) 2014-2023 Null Team Impex SRL
+ *
+ * This software is distributed under multiple licenses;
+ * see the COPYING file in the main directory for licensing
+ * information for this specific distribution.
+ *
+ * This use of this software may be subject to additional restrictions.
+ * See the LEGAL file in the main directory for details.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include <yatengine.h>
+
+#include <string.h>
+
+extern "C" {
+#include "milenage/milenage.h"
+
+typedef unsigned char Byte;
+void A3A8(Byte rand[16], Byte key[16], Byte simoutput[12]);
+}
+
+using namespace TelEngine;
+namespace { // anonymous
+
+// Handler priority: answer before the nipc_auth.sh script (installed at 95)
+#define AUTH_PRIORITY_DEF 90
+
+// Vectors kept ready for each subscriber
+#define AUTH_CACHE_DEPTH_DEF 2
+#define AUTH_CACHE_DEPTH_MAX 16
+// Maximum number of cached subscribers
+#define AUTH_CACHE_SUBSCRIBERS_DEF 1000
+// Drop subscribers not authenticated in this interval (seconds)
+#define AUTH_CACHE_IDLE_DEF 600
+#define AUTH_CACHE_IDLE_MIN 10
+// SQN increment between two authentications, see startAuth() in nipc.js
+#define AUTH_SQN_STEP_DEF 0x20
+
+// Default number of authentications computed by benchmark
+#define AUTH_BENCH_DEF 10000
+
+#define SQN_MASK 0xffffffffffffULL
+
+class AuthHandler;
+class AuthGenerator;
+
+// MILENAGE subscriber keys
+struct MilenageKey
+{
+    uint8_t ki[16];
+    uint8_t op[16];
+    uint8_t amf[2];
+    uint8_t opc;
+};
+
+// Precomputed authentication vector
+class AuthVector : public GenObject
+{
+public:
+    inline AuthVector(uint64_t sqn = 0)
+	: m_sqn(sqn), m_result("")
+	{}
+    uint64_t m_sqn;
+    NamedList m_result;
+};
+
+// Authentication vectors queue of a subscriber
+// Referenced while the generator builds a vector without holding the cache lock
+class AuthSubscriber : public RefObject
+{
+public:
+    inline AuthSubscriber(const String& id, const uint8_t* ki, const MilenageKey* key)
+	: m_id(id), m_umts(0 != key), m_nextSqn(0), m_lastUsed(0), m_fill(false) {
+	    if (key)
+		m_key = *key;
+	    else
+		::memcpy(m_key.ki,ki,16);
+	}
+    virtual const String& toString() const
+	{ return m_id; }
+    String m_id;
+    bool m_umts;
+    MilenageKey m_key;
+    ObjList m_vectors;
+    uint64_t m_nextSqn;
+    uint32_t m_lastUsed;
+    bool m_fill;
+};
+
+class NipcAuth : public Module
+{
+public:
+    NipcAuth();
+    ~NipcAuth();
+    virtual void initialize();
+    bool comp128Auth(Message& msg, int version);
+    bool milenageAuth(Message& msg);
+    // Generator thread: compute missing vectors, wait for requests
+    void fillCache();
+    void generatorStopped(AuthGenerator* gen);
+    bool unload();
+protected:
+    virtual bool received(Message& msg, int id);
+    virtual bool commandExecute(String& retVal, const String& line);
+    virtual void statusParams(String& str);
+private:
+    AuthVector* takeVector(const String& id, const uint8_t* ki, const MilenageKey* key,
+	uint64_t sqn = 0);
+    bool fillOne();
+    void expire();
+    void clearCache();
+    void stopGenerator();
+
+    AuthHandler* m_handler;
+    AuthGenerator* m_generator;
+    unsigned int m_generators;
+    Mutex m_cacheMutex;
+    Semaphore m_fillSem;
+    ObjList m_subscribers;
+    bool m_cache;
+    unsigned int m_cacheDepth;
+    unsigned int m_cacheMax;
+    unsigned int m_cacheIdle;
+    uint64_t m_sqnStep;
+    uint32_t m_nextExpire;
+    unsigned int m_hits;
+    unsigned int m_misses;
+    unsigned int m_generated;
+};
+
+class AuthHandler : public MessageHandler
+{
+public:
+    inline AuthHandler(unsigned int prio)
+	: MessageHandler("gsm.auth",prio,"nipcauth")
+	{}
+    virtual bool received(Message& msg);
+};
+
+class AuthGenerator : public Thread
+{
+public:
+    inline AuthGenerator()
+	: Thread("NipcAuthGen",Thread::Low)
+	{}
+    ~AuthGenerator();
+    virtual void run();
+};
+
+INIT_PLUGIN(NipcAuth);
+
+// MILENAGE keeps the Rijndael key schedule in a global buffer
+static Mutex s_milenageMutex(false,"NipcAuthMilenage");
+
+static const String s_benchCmd = "bench";
+
+
+// Retrieve a fixed length binary value from hexadecimal string
+static bool getHex(const String& str, uint8_t* buf, unsigned int len)
+{
+    DataBlock d;
+    if (!(d.unHexify(str) && d.length() == len))
+	return false;
+    ::memcpy(buf,d.data(),len);
+    return true;
+}
+
+static inline void setHex(NamedList& dest, const char* param, const uint8_t* buf,
+    unsigned int len)
+{
+    String tmp;
+    tmp.hexify((void*)buf,len,0,true);
+    dest.setParam(param,tmp);
+}
+
+static inline void sqnToBin(uint8_t* buf, uint64_t sqn)
+{
+    for (int i = 5; i >= 0; i--, sqn >>= 8)
+	buf[i] = (uint8_t)sqn;
+}
+
+static inline uint64_t sqnFromBin(const uint8_t* buf)
+{
+    uint64_t sqn = 0;
+    for (int i = 0; i < 6; i++)
+	sqn = (sqn << 8) | buf[i];
+    return sqn;
+}
+
+// Subscriber cache key: a hash of the keys so they are not kept or logged in clear
+static void cacheId(String& id, const char* proto, const void* key, unsigned int len)
+{
+    SHA1 sha(key,len);
+    id << proto << ":" << sha.hexDigest();
+}
+
+static void randomRand(uint8_t* rand)
+{
+    for (int i = 0; i < 16; i += 4) {
+	uint32_t r = Random::random();
+	::memcpy(rand + i,&r,4);
+    }
+}
+
+// COMP128 v1: compute SRES and Kc
+static void comp128(NamedList& dest, uint8_t* ki, uint8_t* rand)
+{
+    uint8_t out[12];
+    A3A8(rand,ki,out);
+    setHex(dest,"sres",out,4);
+    setHex(dest,"kc",out + 4,8);
+}
+
+// MILENAGE network side: compute XRES, CK, IK, AUTN for given SQN
+static void milenageVector(NamedList& dest, MilenageKey& k, uint8_t* rand, uint8_t* sqn)
+{
+    uint8_t macA[8], xres[8], ck[16], ik[16], ak[6], autn[16];
+    Lock lck(s_milenageMutex);
+    f1Opc(k.ki,rand,sqn,k.amf,macA,k.op,k.opc);
+    f2345Opc(k.ki,rand,xres,ck,ik,ak,k.op,k.opc);
+    lck.drop();
+    for (int i = 0; i < 6; i++)
+	autn[i] = sqn[i] ^ ak[i];
+    autn[6] = k.amf[0];
+    autn[7] = k.amf[1];
+    ::memcpy(autn + 8,macA,8);
+    setHex(dest,"xres",xres,8);
+    setHex(dest,"ck",ck,16);
+    setHex(dest,"ik",ik,16);
+    setHex(dest,"autn",autn,16);
+}
+
+// MILENAGE network side: recover SQN of the MS from AUTS
+static bool milenageResync(NamedList& dest, MilenageKey& k, uint8_t* rand, uint8_t* auts)
+{
+    uint8_t ak[6], sqn[6], macS[8];
+    Lock lck(s_milenageMutex);
+    f5starOpc(k.ki,rand,ak,k.op,k.opc);
+    for (int i = 0; i < 6; i++)
+	sqn[i] = ak[i] ^ auts[i];
+    f1starOpc(k.ki,rand,sqn,k.amf,macS,k.op,k.opc);
+    lck.drop();
+    if (::memcmp(macS,auts + 6,8))
+	return false;
+    setHex(dest,"sqn",sqn,6);
+    return true;
+}
+
+// MILENAGE MS side: build AUTS requesting given SQN
+static void milenageAuts(NamedList& dest, MilenageKey& k, uint8_t* rand, uint8_t* sqn)
+{
+    uint8_t ak[6], auts[14];
+    Lock lck(s_milenageMutex);
+    f5starOpc(k.ki,rand,ak,k.op,k.opc);
+    f1starOpc(k.ki,rand,sqn,k.amf,auts + 6,k.op,k.opc);
+    lck.drop();
+    for (int i = 0; i < 6; i++)
+	auts[i] = sqn[i] ^ ak[i];
+    setHex(dest,"auts",auts,14);
+}
+
+// MILENAGE MS side: check AUTN, compute XRES, CK, IK and retrieve SQN
+static bool milenageCheck(NamedList& dest, MilenageKey& k, uint8_t* rand, uint8_t* autn)
+{
+    uint8_t macA[8], xres[8], ck[16], ik[16], ak[6], sqn[6];
+    Lock lck(s_milenageMutex);
+    f2345Opc(k.ki,rand,xres,ck,ik,ak,k.op,k.opc);
+    for (int i = 0; i < 6; i++)
+	sqn[i] = ak[i] ^ autn[i];
+    k.amf[0] = autn[6];
+    k.amf[1] = autn[7];
+    f1Opc(k.ki,rand,sqn,k.amf,macA,k.op,k.opc);
+    lck.drop();
+    if (::memcmp(macA,autn + 8,8))
+	return false;
+    setHex(dest,"xres",xres,8);
+    setHex(dest,"ck",ck,16);
+    setHex(dest,"ik",ik,16);
+    setHex(dest,"sqn",sqn,6);
+    return true;
+}
+
+// Synthetic benchmark: compute authentications using random keys
+static void authBenchmark(String& retVal, unsigned int count)
+{
+    uint8_t ki[16], rand[16];
+    MilenageKey k;
+    randomRand(ki);
+    randomRand(k.ki);
+    randomRand(k.op);
+    k.amf[0] = k.amf[1] = 0;
+    k.opc = 0;
+    uint8_t sqn[6];
+    sqnToBin(sqn,AUTH_SQN_STEP_DEF);
+    NamedList res("");
+    for (int alg = 0; alg < 2; alg++) {
+	uint64_t t = Time::now();
+	for (unsigned int i = 0; i < count; i++) {
+	    randomRand(rand);
+	    if (alg)
+		milenageVector(res,k,rand,sqn);
+	    else
+		comp128(res,ki,rand);
+	}
+	t = Time::now() - t;
+	if (!t)
+	    t = 1;
+	retVal << (alg ? "milenage" : "comp128") << ": count=" << count <<
+	    " time=" << (unsigned int)(t / 1000) << "ms rate=" <<
+	    (unsigned int)((uint64_t)count * 1000000 / t) << "/s\r\n";
+    }
+}
+
+
+bool AuthHandler::received(Message& msg)
+{
+    const String& proto = msg[YSTRING("protocol")];
+    if (proto == YSTRING("comp128")) {
+	const String& op = msg[YSTRING("op")];
+	int version = 1;
+	if (op == YSTRING("2"))
+	    version = 2;
+	else if (op == YSTRING("3"))
+	    version = 3;
+	return __plugin.comp128Auth(msg,version);
+    }
+    if (proto == YSTRING("comp128-1"))
+	return __plugin.comp128Auth(msg,1);
+    if (proto == YSTRING("comp128-2"))
+	return __plugin.comp128Auth(msg,2);
+    if (proto == YSTRING("comp128-3"))
+	return __plugin.comp128Auth(msg,3);
+    if (proto == YSTRING("milenage"))
+	return __plugin.milenageAuth(msg);
+    return false;
+}
+
+
+AuthGenerator::~AuthGenerator()
+{
+    __plugin.generatorStopped(this);
+}
+
+void AuthGenerator::run()
+{
+    while (!Thread::check(false))
+	__plugin.fillCache();
+}
+
+
+NipcAuth::NipcAuth()
+    : Module("nipcauth","misc"),
+    m_handler(0), m_generator(0), m_generators(0),
+    m_cacheMutex(false,"NipcAuthCache"),
+    m_fillSem(1,"NipcAuthFill",0),
+    m_cache(false), m_cacheDepth(AUTH_CACHE_DEPTH_DEF),
+    m_cacheMax(AUTH_CACHE_SUBSCRIBERS_DEF), m_cacheIdle(AUTH_CACHE_IDLE_DEF),
+    m_sqnStep(AUTH_SQN_STEP_DEF), m_nextExpire(0),
+    m_hits(0), m_misses(0), m_generated(0)
+{
+    Output("Loaded module NipcAuth");
+}
+
+NipcAuth::~NipcAuth()
+{
+    Output("Unloading module NipcAuth");
+    if (m_handler)
+	Engine::uninstall(m_handler);
+    TelEngine::destruct(m_handler);
+    clearCache();
+}
+
+void NipcAuth::initialize()
+{
+    Output("Initializing module NipcAuth");
+    Configuration cfg(Engine::configFile("nipcauth"));
+    const NamedList& general = *cfg.createSection(YSTRING("general"));
+    if (!m_handler) {
+	setup();
+	installRelay(Help,120);
+	m_handler = new AuthHandler(general.getIntValue(YSTRING("priority"),
+	    AUTH_PRIORITY_DEF,0));
+	Engine::install(m_handler);
+    }
+    bool cache = general.getBoolValue(YSTRING("cache"));
+    Lock lck(m_cacheMutex);
+    m_cacheDepth = general.getIntValue(YSTRING("cache_depth"),AUTH_CACHE_DEPTH_DEF,
+	1,AUTH_CACHE_DEPTH_MAX);
+    m_cacheMax = general.getIntValue(YSTRING("cache_subscribers"),
+	AUTH_CACHE_SUBSCRIBERS_DEF,1);
+    m_cacheIdle = general.getIntValue(YSTRING("cache_idle"),AUTH_CACHE_IDLE_DEF,
+	AUTH_CACHE_IDLE_MIN);
+    m_sqnStep = general.getIntValue(YSTRING("sqn_step"),AUTH_SQN_STEP_DEF,1);
+    m_cache = cache;
+    if (!cache) {
+	m_subscribers.clear();
+	stopGenerator();
+	return;
+    }
+    if (m_generator)
+	return;
+    // A generator cancelled by a previous reload may still be running,
+    //  it won't touch the cache state of the new one
+    m_generator = new AuthGenerator;
+    m_generators++;
+    if (!m_generator->startup()) {
+	Alarm(this,"system",DebugWarn,"Failed to start vector generator thread");
+	m_generator = 0;
+	m_generators--;
+	m_cache = false;
+    }
+}
+
+bool NipcAuth::received(Message& msg, int id)
+{
+    if (id == Help) {
+	static const char s_help[] = "  nipcauth bench [count]\r\n";
+	const String& line = msg[YSTRING("line")];
+	if (line) {
+	    if (line != name())
+		return false;
+	    msg.retValue() << s_help;
+	    msg.retValue() << "bench measures authentication vectors computed per second\r\n";
+	    return true;
+	}
+	msg.retValue() << s_help;
+	return false;
+    }
+    return Module::received(msg,id);
+}
+
+bool NipcAuth::commandExecute(String& retVal, const String& line)
+{
+    String tmp = line;
+    if (tmp.startSkip(name())) {
+	if (tmp.startSkip(s_benchCmd)) {
+	    authBenchmark(retVal,tmp.toInteger(AUTH_BENCH_DEF,0,1,10000000));
+	    return true;
+	}
+    }
+    return Module::commandExecute(retVal,line);
+}
+
+void NipcAuth::statusParams(String& str)
+{
+    Lock lck(m_cacheMutex);
+    unsigned int vectors = 0;
+    for (ObjList* o = m_subscribers.skipNull(); o; o = o->skipNext())
+	vectors += static_cast<AuthSubscriber*>(o->get())->m_vectors.count();
+    str.append("cache=",",") << String::boolText(m_cache);
+    str << ",subscribers=" << m_subscribers.count() << ",vectors=" << vectors;
+    str << ",hits=" << m_hits << ",misses=" << m_misses << ",generated=" << m_generated;
+}
+
+bool NipcAuth::comp128Auth(Message& msg, int version)
+{
+    if (version != 1) {
+	// Only COMP128 v1 is built in, let other handlers try
+	DDebug(this,DebugAll,"Ignoring unsupported COMP128 version %d",version);
+	return false;
+    }
+    const String& kiStr = msg[YSTRING("ki")];
+    uint8_t ki[16];
+    if (!getHex(kiStr,ki,16)) {
+	Debug(this,DebugNote,"Invalid COMP128 ki (length %u)",kiStr.length());
+	return false;
+    }
+    if (m_cache && msg.getBoolValue(YSTRING("cached"))) {
+	String id;
+	cacheId(id,"comp128",ki,16);
+	AuthVector* v = takeVector(id,ki,0);
+	if (v) {
+	    msg.copyParams(v->m_result);
+	    TelEngine::destruct(v);
+	    return true;
+	}
+    }
+    uint8_t rand[16];
+    if (!getHex(msg[YSTRING("rand")],rand,16))
+	return false;
+    comp128(msg,ki,rand);
+    return true;
+}
+
+bool NipcAuth::milenageAuth(Message& msg)
+{
+    MilenageKey k;
+    k.amf[0] = k.amf[1] = 0;
+    const String& kiStr = msg[YSTRING("ki")];
+    const String& opStr = msg[YSTRING("op")];
+    const String& amfStr = msg[YSTRING("amf")];
+    if (!(getHex(kiStr,k.ki,16) && getHex(opStr,k.op,16))) {
+	Debug(this,DebugNote,"Invalid MILENAGE ki (length %u) or op (length %u)",
+	    kiStr.length(),opStr.length());
+	return false;
+    }
+    if (amfStr && !getHex(amfStr,k.amf,2))
+	return false;
+    k.opc = msg.getBoolValue(YSTRING("opc")) ? 1 : 0;
+    uint8_t rand[16];
+    uint8_t sqn[6];
+    uint8_t auts[14];
+    const String& sqnStr = msg[YSTRING("sqn")];
+    const String& autsStr = msg[YSTRING("auts")];
+    if (sqnStr) {
+	if (!getHex(sqnStr,sqn,6))
+	    return false;
+	if (autsStr) {
+	    if (!getHex(msg[YSTRING("rand")],rand,16))
+		return false;
+	    milenageAuts(msg,k,rand,sqn);
+	    return true;
+	}
+	if (m_cache && msg.getBoolValue(YSTRING("cached"))) {
+	    String id;
+	    cacheId(id,"milenage",&k,sizeof(k));
+	    AuthVector* v = takeVector(id,0,&k,sqnFromBin(sqn));
+	    if (v) {
+		msg.copyParams(v->m_result);
+		TelEngine::destruct(v);
+		return true;
+	    }
+	}
+	if (!getHex(msg[YSTRING("rand")],rand,16))
+	    return false;
+	milenageVector(msg,k,rand,sqn);
+	return true;
+    }
+    if (!getHex(msg[YSTRING("rand")],rand,16))
+	return false;
+    if (autsStr)
+	return getHex(autsStr,auts,14) && milenageResync(msg,k,rand,auts);
+    uint8_t autn[16];
+    return getHex(msg[YSTRING("autn")],autn,16) && milenageCheck(msg,k,rand,autn);
+}
+
+// Retrieve a cached vector, create the subscriber queue if missing
+// Request the generator to refill the queue
+AuthVector* NipcAuth::takeVector(const String& id, const uint8_t* ki,
+    const MilenageKey* key, uint64_t sqn)
+{
+    Lock lck(m_cacheMutex);
+    if (!m_cache)
+	return 0;
+    AuthSubscriber* s = static_cast<AuthSubscriber*>(m_subscribers[id]);
+    if (!s) {
+	if (m_subscribers.count() >= m_cacheMax) {
+	    m_misses++;
+	    return 0;
+	}
+	s = new AuthSubscriber(id,ki,key);
+	m_subscribers.append(s);
+    }
+    s->m_lastUsed = Time::secNow();
+    AuthVector* v = 0;
+    if (s->m_umts) {
+	// Pick the vector built for requested SQN, drop the older ones
+	for (ObjList* o = s->m_vectors.skipNull(); o; ) {
+	    AuthVector* a = static_cast<AuthVector*>(o->get());
+	    if (a->m_sqn > sqn) {
+		o = o->skipNext();
+		continue;
+	    }
+	    if (a->m_sqn == sqn)
+		v = static_cast<AuthVector*>(o->remove(false));
+	    else
+		o->remove();
+	    o = o->skipNull();
+	}
+	s->m_nextSqn = (sqn + m_sqnStep) & SQN_MASK;
+    }
+    else {
+	ObjList* o = s->m_vectors.skipNull();
+	if (o)
+	    v = static_cast<AuthVector*>(o->remove(false));
+    }
+    if (v)
+	m_hits++;
+    else
+	m_misses++;
+    s->m_fill = true;
+    lck.drop();
+    m_fillSem.unlock();
+    return v;
+}
+
+// Build one missing vector. Return false if there is nothing to do
+// The subscriber may be removed (expired, cache cleared or disabled) while the
+//  vector is computed so it is referenced and looked up again before storing
+bool NipcAuth::fillOne()
+{
+    Lock lck(m_cacheMutex);
+    AuthSubscriber* s = 0;
+    uint64_t sqn = 0;
+    for (ObjList* o = m_subscribers.skipNull(); o && !s; o = o->skipNext()) {
+	AuthSubscriber* crt = static_cast<AuthSubscriber*>(o->get());
+	if (!crt->m_fill)
+	    continue;
+	if (!crt->m_umts) {
+	    if (crt->m_vectors.count() < m_cacheDepth)
+		s = crt;
+	}
+	else {
+	    // Find the first expected SQN without a vector
+	    for (unsigned int i = 0; i < m_cacheDepth && !s; i++) {
+		sqn = (crt->m_nextSqn + i * m_sqnStep) & SQN_MASK;
+		ObjList* v = crt->m_vectors.skipNull();
+		for (; v; v = v->skipNext())
+		    if (static_cast<AuthVector*>(v->get())->m_sqn == sqn)
+			break;
+		if (!v)
+		    s = crt;
+	    }
+	}
+	if (!s)
+	    crt->m_fill = false;
+    }
+    if (!s)
+	return false;
+    RefPointer<AuthSubscriber> sub = s;
+    bool umts = s->m_umts;
+    MilenageKey k = s->m_key;
+    lck.drop();
+    uint8_t rand[16];
+    randomRand(rand);
+    AuthVector* v = new AuthVector(sqn);
+    setHex(v->m_result,"rand",rand,16);
+    if (umts) {
+	uint8_t sqnBin[6];
+	sqnToBin(sqnBin,sqn);
+	milenageVector(v->m_result,k,rand,sqnBin);
+    }
+    else
+	comp128(v->m_result,k.ki,rand);
+    lck.acquire(&m_cacheMutex);
+    if (m_subscribers.find(static_cast<AuthSubscriber*>(sub))) {
+	sub->m_vectors.append(v);
+	m_generated++;
+    }
+    else
+	TelEngine::destruct(v);
+    return true;
+}
+
+// Remove subscribers idle for too long
+void NipcAuth::expire()
+{
+    uint32_t now = Time::secNow();
+    if (now < m_nextExpire)
+	return;
+    m_nextExpire = now + AUTH_CACHE_IDLE_MIN;
+    Lock lck(m_cacheMutex);
+    for (ObjList* o = m_subscribers.skipNull(); o; ) {
+	AuthSubscriber* s = static_cast<AuthSubscriber*>(o->get());
+	if (s->m_lastUsed + m_cacheIdle > now) {
+	    o = o->skipNext();
+	    continue;
+	}
+	DDebug(this,DebugAll,"Removing idle subscriber '%s'",s->m_id.c_str());
+	o->remove();
+	o = o->skipNull();
+    }
+}
+
+void NipcAuth::fillCache()
+{
+    while (!Thread::check(false) && fillOne())
+	;
+    expire();
+    m_fillSem.lock(Thread::idleUsec() * 20);
+}
+
+// Only the current generator disables the cache when it stops,
+//  a cancelled one just leaves
+void NipcAuth::generatorStopped(AuthGenerator* gen)
+{
+    Lock lck(m_cacheMutex);
+    m_generators--;
+    if (gen != m_generator)
+	return;
+    m_generator = 0;
+    m_cache = false;
+    m_subscribers.clear();
+}
+
+bool NipcAuth::unload()
+{
+    clearCache();
+    Lock lck(m_cacheMutex);
+    if (m_generators)
+	return false;
+    lck.drop();
+    if (m_handler) {
+	Engine::uninstall(m_handler);
+	TelEngine::destruct(m_handler);
+    }
+    uninstallRelays();
+    return true;
+}
+
+void NipcAuth::clearCache()
+{
+    Lock lck(m_cacheMutex);
+    m_cache = false;
+    m_subscribers.clear();
+    stopGenerator();
+}
+
+// Cancel the current generator, must be called with the cache locked
+// The generator can't be destroyed meanwhile, its destructor needs the lock
+void NipcAuth::stopGenerator()
+{
+    if (!m_generator)
+	return;
+    m_generator->cancel();
+    m_generator = 0;
+}
+
+}; // anonymous namespace
+
+UNLOAD_PLUGIN(unloadNow)
+{
+    if (unloadNow)
+	return __plugin.unload();
+    return true;
+}
+
+/* vi: set ts=8 sw=4 sts=4 noet: */
@@ -1114,10 +1114,13 @@ function startAuth(msg,imsi,is_auth)
 	m.opc = opc;
 	m.rand = rand;
 	m.sqn = sqn;
+	// Allow a precomputed vector (and its RAND) to be returned
+	m.cached = true;
 	if (!m.dispatch(true)) {
 	    msg.error = "failure";
 	    return false;
 	}
+	rand = m.rand;
 	// Increment the sequence without changing index
 	sqn = 0xffffffffffff & (0x20 + parseInt(sqn,16));
 	sqn = strFix(sqn.toString(16),-12,'0');
@@ -1140,10 +1143,12 @@ function startAuth(msg,imsi,is_auth)
 	m.ki = ki;
 	m.op = op;
 	m.rand = rand;
+	m.cached = true;
 	if (!m.dispatch(true)) {
 	    msg.error = "failure";
 	    return false;
 	}
+	rand = m.rand;
 	// remember sres
 	subscribers[imsi]["sres"] = m.sres;
 	// Populate message with auth params
@@ -335,9 +335,10 @@ Defaults to 62 (maximum range)"
 			"MaxSpeechLatency" => array( 
 				array("selected" => 2, 1,2,3,4,5),
 				"display" => "select",
-				"comment" => "Maximum allowed speech buffering latency.
+				"comment" => "Maximum allowed downlink speech buffering latency.
 It is expressed in 20ms frames.
 Frames will be dropped if the jitter is larger than this delay.
+Uplink frames are sent as soon as they are decoded and are not affected.
 Interval allowed: 1..5.
 Defaults to 2."
 			),
@@ -588,15 +589,17 @@ Valid range is 0...10. Defaults to 2."
 			 "Codecs.Downlink" => array(
 				 "display" => "text",
 				"value" => "14",
-				"comment" => "List of allowed GPRS downlink codecs 1..4 for CS-1..CS-4.
-Currently, only 1 and 4 are supported e.g. 14."
+				"comment" => "List of allowed GPRS downlink codecs 1..4 for CS-1..CS-4 e.g. 14.
+CS-2 and CS-3 are supported but not enabled by default, use 1234 to let link adaptation use all of them.
+Defaults to 14."
 				
 			),
 			"Codecs.Uplink" => array(
 				"display" => "text",
                                 "value" => "14",
-				"comment" => "List of allowed GPRS uplink codecs 1..4 for CS-1..CS-4.
-Currently, only 1 and 4 are supported e.g. 14."
+				"comment" => "List of allowed GPRS uplink codecs 1..4 for CS-1..CS-4 e.g. 14.
+CS-2 and CS-3 are supported but not enabled by default, use 1234 to let link adaptation use all of them.
+Defaults to 14."
 	                 ),
 			 "Uplink.KeepAlive" => array(
 				 array("selected"=>300, 200,300,400,500,600,700,800,900,1000,1100,1200,1300,1400,1500,1600,1700,1800,1900,2000,2100,2200,2300,2400,2500,2600,2700,2800,2900,3000,3100,3200,3300,3400,3500,3600,3700,3800,3900,4000,4100,4200,4300,4400,4500,4600,4700,4800,4900,5000),
@@ -672,10 +675,28 @@ Value 0 implies 500msec
 2 implies 1500msec
 3 imples 0msec."			
 			),
+			"ChannelCodingControl.BLER.Downgrade" => array(
+				"display" => "text",
+				"value" => "20",
+				"comment" => "If the block error rate of a MS in one direction is higher than this amount in percent GPRS switches to the next more robust codec allowed by Codecs.Downlink or Codecs.Uplink.
+Must be greater than ChannelCodingControl.BLER.Upgrade.
+Interval allowed 5:50.
+Defaults to 20.",
+				"validity" => array("check_field_validity", 5, 50)
+			),
+			"ChannelCodingControl.BLER.Upgrade" => array(
+				"display" => "text",
+				"value" => "5",
+				"comment" => "If the block error rate of a MS in one direction is lower than this amount in percent GPRS switches to the next faster codec allowed by Codecs.Downlink or Codecs.Uplink.
+Interval allowed 0:20.
+Defaults to 5.",
+				"validity" => array("check_field_validity", 0, 20)
+			),
 			"ChannelCodingControl.RSSI" => array(
 				array("selected"=>-40,-65,-64,-63,-62,-61,-60,-59,-58,-57,-56,-55,-54,-53,-52,-51,-50,-49,-48,-47,-46,-45,-44,-43,-42,-41,-40,-39,-38,-37,-36,-35,-34,-33,-32,-31,-30,-29,-28,-27,-26,-25,-24,-23,-22,-21,-20,-19,-18,-17,-16,-15),
 				"display" => "select",
-				"comment" => "If the initial unlink signal strength is less than this amount in DB GPRS uses a lower bandwidth but more robust encoding CS-1.
+				"comment" => "If the initial unlink signal strength is less than this amount in DB GPRS uses a lower bandwidth but more robust encoding: CS-3 down to 8 dB below, CS-2 down to 10 dB below and CS-1 under that.
+Afterwards the codec follows the block error rate of the MS.
 This value should normally be GSM.Radio.RSSITarget + 10 dB.
 Interval allowed -65:-15
 Defaults to -40.",
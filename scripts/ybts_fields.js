@@ -42,6 +42,8 @@ YbtsConfig.prototype.validations =  {
 	"Channels.C1sFirst=": {"callback": checkOnOff},
 	"Channels.SDCCHReserve=": {"minimum": 0, "maximum": 10},
 	"CCCH.AGCH.QMax=": {"minimum": 3, "maximum": 8},
+	"CCCH.AGCH.Reserved=": {"minimum": 0, "maximum": 2},
+	"CCCH.PCH.Multiframes=": {"minimum": 2, "maximum": 9},
 	"CCCH.CCCH-CONF=": {"minimum": 1, "maximum": 2},
 	"CellOptions.RADIO-LINK-TIMEOUT=": {"minimum": 10, "maximum": 20},
 	"CellSelection.CELL-RESELECT-HYSTERESIS=": {"minimum": 0, "maximum": 7},
@@ -114,6 +116,8 @@ YbtsConfig.prototype.validations =  {
 	"advanceblocks=": {"minimim": 5, "maximum": 15},
 	"CellOptions.T3168Code=": {"minimim": 0,"maximum": 7},
 	"CellOptions.T3192Code=": {"minimim": 0,"maximum": 7},
+	"ChannelCodingControl.BLER.Downgrade=": {"minimum": 5, "maximum": 50},
+	"ChannelCodingControl.BLER.Upgrade=": {"minimum": 0, "maximum": 20},
 	"ChannelCodingControl.RSSI=": {"callback": checkChannelcodingcontrolRssi},
 	"Channels.Congestion.Threshold=": {"select": ["100", "105", "110", "115", "120", "125", "130", "135", "140", "145", "150", "155", "160", "165", "170", "175", "180", "185", "190", "195", "200", "205", "210", "215", "220", "225", "230", "235", "240", "245", "250", "255", "260", "265", "270", "275", "280", "285", "290", "295", "300"]},
 	"Channels.Congestion.Timer=": {"select": ["30", "35", "40", "45", "50", "55", "60", "65", "70", "75", "80", "85", "90"]},
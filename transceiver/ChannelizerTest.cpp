@@ -0,0 +1,409 @@
+/**
+ * ChannelizerTest.cpp
+ * This file is part of the Yate-BTS Project http://www.yatebts.com
+ *
+ * Polyphase filter bank channelizer check and benchmark against the QMF tree.
+ * The loopback check feeds both channelizers with internal loopback data
+ *  and compares demodulated bursts
+ *
+ * Yet Another Telephony Engine - Base Transceiver Station
+ * Copyright (C) 2014-2023 Null Team Impex SRL
+ *
+ * This software is distributed under multiple licenses;
+ * see the COPYING file in the main directory for licensing
+ * information for this specific distribution.
+ *
+ * This use of this software may be subject to additional restrictions.
+ * See the LEGAL file in the main directory for details.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "sigproc.h"
+#include "gsmutil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace TelEngine;
+
+#define ARFCNS 4
+#define OVERSAMPLING 8
+
+// Relative error accepted when comparing FFT and single bin DFT outputs
+static const float s_tolerance = 1e-3;
+
+static unsigned int s_slots = 200;       // Test slots (random bursts)
+static unsigned int s_loops = 2000;      // Benchmark iterations
+static float s_noise = 0.05;             // Noise amplitude (loopback signal is noise free)
+static unsigned int s_tsc = 0;           // Training sequence used in test bursts
+
+// QMF tree nodes frequency shift (see TransceiverQMF)
+// Leaves (at index 7, 9, 11, 13) hold ARFCN 0..3
+static const float s_qmfFreqShift[7] = {
+    (float)(PI / 2),
+    (float)(0.749149017394489),
+    (float)(2.3924436361953),
+    (float)(-0.821647309400407),
+    (float)(0.821647309400407),
+    (float)(-0.821647309400407),
+    (float)(0.821647309400407)
+};
+static const unsigned int s_qmfLeaf[ARFCNS] = {7, 9, 11, 13};
+
+// QMF tree reference implementation
+// Node input is frequency shifted, low/high band outputs are built using
+//  the half band filter and decimated by 2
+class QmfTree
+{
+public:
+    QmfTree();
+    void process(const ComplexVector& in, ComplexVector* out);
+
+private:
+    void node(unsigned int index, ComplexVector* out);
+
+    FloatVector m_halfBand;
+    ComplexVector m_data[15];
+    ComplexVector m_freqShift[7];
+    ComplexVector m_w;
+};
+
+QmfTree::QmfTree()
+{
+    m_halfBand.resize(11);
+    float lq_1 = m_halfBand.length() - 1;
+    float n0 = lq_1 / 2;
+    for (unsigned int i = 0; i < m_halfBand.length(); i++) {
+	float offset = (float)i - n0;
+	float omega = 0.54 - 0.46 * ::cosf(2 * PI * i / lq_1);
+	if (offset) {
+	    float func = PI / 2 * offset;
+	    m_halfBand[i] = omega * (::sinf(func) / func);
+	}
+	else
+	    m_halfBand[i] = omega;
+    }
+}
+
+void QmfTree::process(const ComplexVector& in, ComplexVector* out)
+{
+    m_data[0].resize(in.length());
+    m_data[0].copy(in);
+    node(0,out);
+}
+
+void QmfTree::node(unsigned int index, ComplexVector* out)
+{
+    ComplexVector& x = m_data[index];
+    if (index > 6) {
+	for (unsigned int i = 0; i < ARFCNS; i++)
+	    if (s_qmfLeaf[i] == index)
+		out[i].exchange(x);
+	return;
+    }
+    if (m_freqShift[index].length() < x.length())
+	SignalProcessing::setFreqShifting(&m_freqShift[index],s_qmfFreqShift[index],
+	    x.length());
+    Complex::multiply(x.data(),x.length(),m_freqShift[index].data(),x.length());
+    // w[i] = SUM(x[i + j - n0] * h[j]), j even, input padded with 0
+    int n0 = m_halfBand.length() / 2;
+    m_w.resize(x.length());
+    for (unsigned int i = 0; i < x.length(); i += 2) {
+	m_w[i].set();
+	for (unsigned int j = 0; j < m_halfBand.length(); j += 2) {
+	    int k = (int)(i + j) - n0;
+	    if (k >= 0 && k < (int)x.length())
+		Complex::sumMulF(m_w[i],x[k],m_halfBand[j]);
+	}
+    }
+    ComplexVector& lo = m_data[2 * index + 1];
+    ComplexVector& hi = m_data[2 * index + 2];
+    lo.resize(x.length() / 2);
+    hi.resize(x.length() / 2);
+    for (unsigned int i = 0; i < lo.length(); i++) {
+	Complex::sum(lo[i],x[2 * i],m_w[2 * i]);
+	lo[i] *= 0.5f;
+	Complex::diff(hi[i],x[2 * i],m_w[2 * i]);
+	hi[i] *= 0.5f;
+    }
+    node(2 * index + 1,out);
+    node(2 * index + 2,out);
+}
+
+// Demodulate a normal burst (see TransceiverQMF::processRadioBurst)
+// Return the number of bit errors, fill demodulated bits if requested
+static unsigned int demodulate(const ComplexVector& data, const FloatVector& tsc,
+    const uint8_t* bits, uint8_t* out = 0)
+{
+    if (data.length() < 156)
+	return GSM_BURST_LENGTH;
+    ComplexVector x(data);
+    SignalProcessing::applyMinusPIOverTwoFreqShift(x);
+    int start = x.length() / 2 - GSM_NB_TSC_LEN / 2;
+    int center = GSM_NB_TSC_LEN / 2 - 1;
+    ComplexVector he(GSM_NB_TSC_LEN);
+    SignalProcessing::correlate(he,x,start,GSM_NB_TSC_LEN,tsc);
+    float max = 0;
+    int maxIndex = -1;
+    for (int i = center - 5; i <= center + 5; i++) {
+	float pwr = he[i].mulConj();
+	if (pwr < max)
+	    continue;
+	max = pwr;
+	maxIndex = i;
+    }
+    if (maxIndex < 0)
+	return GSM_BURST_LENGTH;
+    int toaError = maxIndex - center;
+    if (toaError < 0) {
+	x.copySlice(0,-toaError,x.length() + toaError);
+	x.reset(0,-toaError);
+    }
+    else if (toaError) {
+	unsigned int n = x.length() - toaError;
+	x.copySlice(toaError,0,n);
+	x.reset(n);
+    }
+    for (unsigned int i = 0; i < 11; i++)
+	he[i] = he[maxIndex - 5 + i];
+    FloatVector v(x.length());
+    Equalizer::equalize(v,x,he,11);
+    unsigned int errors = 0;
+    for (unsigned int i = 0; i < GSM_BURST_LENGTH; i++) {
+	uint8_t b = (v[i + 4] >= 0) ? 1 : 0;
+	if (b != bits[i])
+	    errors++;
+	if (out)
+	    out[i] = b;
+    }
+    return errors;
+}
+
+// Build a normal burst with random data
+static void buildBurst(uint8_t* bits)
+{
+    const int8_t* tsc = GSMUtils::nbTscTable() + GSM_NB_TSC_LEN * s_tsc;
+    for (unsigned int i = 0; i < GSM_BURST_LENGTH; i++) {
+	if (i < 3 || i >= GSM_BURST_LENGTH - 3)
+	    bits[i] = 0;
+	else if (i >= 61 && i < 61 + GSM_NB_TSC_LEN)
+	    bits[i] = tsc[i - 61];
+	else
+	    bits[i] = ::rand() & 1;
+    }
+}
+
+// Build loopback data (see Transceiver::sendBurst)
+static void buildSlot(ComplexVector& out, uint8_t bits[ARFCNS][GSM_BURST_LENGTH],
+    const SignalProcessing& proc)
+{
+    ComplexVector mod;
+    out.resize(proc.gsmSlotLen(),true);
+    for (unsigned int a = 0; a < ARFCNS; a++) {
+	buildBurst(bits[a]);
+	proc.modulate(mod,bits[a],GSM_BURST_LENGTH);
+	proc.freqShift(mod,a);
+	Complex::sum(out.data(),out.length(),mod.data(),mod.length());
+    }
+    for (unsigned int i = 0; i < out.length() && s_noise > 0; i++)
+	out[i] += Complex(s_noise * ((float)(::rand() % 2001) / 1000 - 1),
+	    s_noise * ((float)(::rand() % 2001) / 1000 - 1));
+}
+
+// Build internal loopback data: parse and modulate TX bursts as received
+//  from upper layer, sum frequency shifted bursts (see Transceiver::sendBurst)
+// Loopback data is forwarded unchanged to RX (see Transceiver::sendLoopback)
+static bool buildLoopbackSlot(ComplexVector& out, uint8_t bits[ARFCNS][GSM_BURST_LENGTH],
+    const SignalProcessing& proc, GSMTxBurstStore& store, unsigned int fn)
+{
+    uint8_t pkt[GSM_BURST_TXPACKET];
+    for (unsigned int a = 0; a < ARFCNS; a++) {
+	buildBurst(bits[a]);
+	pkt[0] = 0;
+	pkt[1] = (uint8_t)(fn >> 24);
+	pkt[2] = (uint8_t)(fn >> 16);
+	pkt[3] = (uint8_t)(fn >> 8);
+	pkt[4] = (uint8_t)fn;
+	pkt[5] = 0;
+	::memcpy(pkt + GSM_BURST_TXHEADER,bits[a],GSM_BURST_LENGTH);
+	GSMTxBurst* burst = GSMTxBurst::parse(pkt,sizeof(pkt),store);
+	if (!burst)
+	    return false;
+	burst->buildTxData(proc);
+	const ComplexVector* fs = proc.arfcnFS(a);
+	if (!a) {
+	    out.resize(burst->txData().length());
+	    Complex::multiply(out.data(),out.length(),
+		burst->txData().data(),burst->txData().length(),fs->data(),fs->length());
+	}
+	else
+	    Complex::sumMul(out.data(),out.length(),
+		burst->txData().data(),burst->txData().length(),fs->data(),fs->length());
+	store.store(burst);
+    }
+    return true;
+}
+
+// Internal loopback check (transceiver 'internal-loopback' command)
+// Demodulated bursts must be the same for QMF tree and channelizer
+static int loopbackCheck(const SignalProcessing& proc, const FloatVector& tsc,
+    QmfTree& qmf, PolyphaseChannelizer& pfb)
+{
+    GSMTxBurstStore store(ARFCNS,"LoopbackTest");
+    uint8_t bits[ARFCNS][GSM_BURST_LENGTH];
+    uint8_t qmfBits[GSM_BURST_LENGTH];
+    uint8_t pfbBits[GSM_BURST_LENGTH];
+    ComplexVector slot;
+    ComplexVector qmfOut[ARFCNS];
+    ComplexVectorVector pfbOut;
+    unsigned int qmfErrors = 0;
+    unsigned int pfbErrors = 0;
+    unsigned int diff = 0;
+    int failed = 0;
+    for (unsigned int n = 0; n < s_slots; n++) {
+	if (!buildLoopbackSlot(slot,bits,proc,store,n / 8)) {
+	    ::printf("  FAILED slot %u loopback data build\n",n);
+	    return 1;
+	}
+	qmf.process(slot,qmfOut);
+	pfb.process(slot,pfbOut);
+	for (unsigned int a = 0; a < ARFCNS; a++) {
+	    qmfErrors += demodulate(qmfOut[a],tsc,bits[a],qmfBits);
+	    pfbErrors += demodulate(pfbOut[a],tsc,bits[a],pfbBits);
+	    unsigned int d = 0;
+	    for (unsigned int i = 0; i < GSM_BURST_LENGTH; i++)
+		if (qmfBits[i] != pfbBits[i])
+		    d++;
+	    if (d && !failed++)
+		::printf("  FAILED slot %u ARFCN %u loopback burst mismatch bits=%u\n",n,a,d);
+	    diff += d;
+	}
+    }
+    ::printf("Loopback: bit errors QMF=%u PFB=%u mismatch=%u (of %u)\n",qmfErrors,
+	pfbErrors,diff,s_slots * ARFCNS * GSM_BURST_LENGTH);
+    return failed;
+}
+
+static bool sameValue(const ComplexVector& v1, const ComplexVector& v2)
+{
+    if (v1.length() != v2.length())
+	return false;
+    for (unsigned int i = 0; i < v1.length(); i++) {
+	Complex d = v1[i];
+	d -= v2[i];
+	float m = v1[i].abs();
+	if (d.abs() > s_tolerance * (m > 1 ? m : 1))
+	    return false;
+    }
+    return true;
+}
+
+// Benchmark, print microseconds per slot
+static void benchmark(const ComplexVector& slot, QmfTree& qmf, PolyphaseChannelizer& pfb)
+{
+    ComplexVector out[ARFCNS];
+    uint64_t start = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	qmf.process(slot,out);
+    ::printf("QMF tree      channels=%u %.3f usec/slot\n",ARFCNS,
+	(float)(Time::now() - start) / s_loops);
+    ComplexVectorVector pfbOut;
+    for (unsigned int n = 1; n <= ARFCNS; n++) {
+	for (unsigned int a = 0; a < ARFCNS; a++)
+	    pfb.setActive(a,a < n);
+	uint64_t t[2];
+	start = Time::now();
+	for (unsigned int m = 0; m < 2; m++) {
+	    pfb.setFftChannels(m ? 1 : ARFCNS + 1);
+	    for (unsigned int i = 0; i < s_loops; i++)
+		pfb.process(slot,pfbOut);
+	    t[m] = Time::now();
+	}
+	::printf("PFB           channels=%u dft=%.3f fft=%.3f usec/slot\n",n,
+	    (float)(t[0] - start) / s_loops,(float)(t[1] - t[0]) / s_loops);
+    }
+    pfb.setFftChannels();
+}
+
+// Usage: ChannelizerTest [slots [loops [noise]]]
+int main(int argc, const char** argv)
+{
+    if (argc > 1)
+	s_slots = (unsigned int)::atoi(argv[1]);
+    if (argc > 2)
+	s_loops = (unsigned int)::atoi(argv[2]);
+    if (argc > 3)
+	s_noise = (float)::atof(argv[3]);
+    if (!(s_slots && s_loops)) {
+	::printf("Invalid parameters slots=%u loops=%u\n",s_slots,s_loops);
+	return 1;
+    }
+    ::srand(1);
+    SignalProcessing proc;
+    proc.initialize(OVERSAMPLING,ARFCNS);
+    // Normal burst TSC (see TransceiverQMF::initNormalBurstTSC)
+    FloatVector tsc(16);
+    const int8_t* p = GSMUtils::nbTscTable() + GSM_NB_TSC_LEN * s_tsc + 5;
+    for (unsigned int i = 0; i < tsc.length(); i++)
+	tsc[i] = p[i] ? 1.0F / 16.0F : -1.0F / 16.0F;
+    QmfTree qmf;
+    PolyphaseChannelizer pfb;
+    if (!pfb.initialize(OVERSAMPLING)) {
+	::printf("Failed to initialize channelizer\n");
+	return 1;
+    }
+    float freqShift[ARFCNS];
+    for (unsigned int a = 0; a < ARFCNS; a++)
+	freqShift[a] = SignalProcessing::arfcnFreqShift(a,OVERSAMPLING);
+    pfb.setChannels(freqShift,ARFCNS);
+    for (unsigned int a = 0; a < ARFCNS; a++)
+	pfb.setActive(a);
+    ::printf("Testing channelizers: slots=%u noise=%g bins=%u taps=%u\n",
+	s_slots,s_noise,pfb.bins(),pfb.taps());
+    uint8_t bits[ARFCNS][GSM_BURST_LENGTH];
+    ComplexVector slot;
+    ComplexVector qmfOut[ARFCNS];
+    ComplexVectorVector dftOut;
+    ComplexVectorVector fftOut;
+    unsigned int qmfErrors[ARFCNS];
+    unsigned int pfbErrors[ARFCNS];
+    for (unsigned int a = 0; a < ARFCNS; a++)
+	qmfErrors[a] = pfbErrors[a] = 0;
+    int failed = 0;
+    for (unsigned int n = 0; n < s_slots; n++) {
+	buildSlot(slot,bits,proc);
+	qmf.process(slot,qmfOut);
+	pfb.setFftChannels(ARFCNS + 1);
+	pfb.process(slot,dftOut);
+	pfb.setFftChannels(1);
+	pfb.process(slot,fftOut);
+	for (unsigned int a = 0; a < ARFCNS; a++) {
+	    if (!sameValue(dftOut[a],fftOut[a])) {
+		if (!failed)
+		    ::printf("  FAILED slot %u ARFCN %u FFT/DFT mismatch\n",n,a);
+		failed++;
+	    }
+	    qmfErrors[a] += demodulate(qmfOut[a],tsc,bits[a]);
+	    pfbErrors[a] += demodulate(fftOut[a],tsc,bits[a]);
+	}
+    }
+    pfb.setFftChannels();
+    for (unsigned int a = 0; a < ARFCNS; a++) {
+	::printf("ARFCN %u: bit errors QMF=%u PFB=%u (of %u)\n",a,qmfErrors[a],
+	    pfbErrors[a],s_slots * GSM_BURST_LENGTH);
+	// Demodulation must not be worse than QMF tree
+	if (pfbErrors[a] > qmfErrors[a]) {
+	    ::printf("  FAILED ARFCN %u demodulation\n",a);
+	    failed++;
+	}
+    }
+    failed += loopbackCheck(proc,tsc,qmf,pfb);
+    benchmark(slot,qmf,pfb);
+    ::printf("%s\n",failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
+
+/* vi: set ts=8 sw=4 sts=4 noet: */
@@ -0,0 +1,254 @@
+/**
+ * EqualizerTest.cpp
+ * This file is part of the Yate-BTS Project http://www.yatebts.com
+ *
+ * Equalizer modes bit error rate comparison (synthetic multipath) and benchmark
+ *
+ * Yet Another Telephony Engine - Base Transceiver Station
+ * Copyright (C) 2014-2023 Null Team Impex SRL
+ *
+ * This software is distributed under multiple licenses;
+ * see the COPYING file in the main directory for licensing
+ * information for this specific distribution.
+ *
+ * This use of this software may be subject to additional restrictions.
+ * See the LEGAL file in the main directory for details.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "sigproc.h"
+#include "gsmutil.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace TelEngine;
+
+#define MODES 2
+#define OVERSAMPLING 8
+#define PROFILES 4
+#define RX_BURST_LEN 156                 // Received burst length (see ARFCN_RXBURST_LEN)
+
+static unsigned int s_bursts = 1000;     // Test bursts for each profile and SNR
+static unsigned int s_loops = 20000;     // Benchmark iterations
+static unsigned int s_tsc = 0;           // Training sequence used in test bursts
+
+static const char* s_modeName[MODES] = {"default", "mlse"};
+
+// Multipath channel profiles: path gain (amplitude) at 0..3 symbols delay
+// Path phase is random in each burst
+struct Profile
+{
+    const char* name;
+    float gain[4];
+};
+static const Profile s_profile[PROFILES] = {
+    {"static",   {1.0F, 0.0F, 0.0F, 0.0F}},
+    {"2path",    {1.0F, 0.5F, 0.0F, 0.0F}},
+    {"3path",    {1.0F, 0.7F, 0.5F, 0.0F}},
+    {"echo",     {1.0F, 0.0F, 0.6F, 0.0F}},
+};
+
+// Signal to noise ratios (dB) used in test
+static const float s_snr[] = {100, 15, 10, 7};
+
+// Uniform random value in [0..1)
+static inline float randomValue()
+{
+    return (float)(::rand() % 1000000) / 1000000.0F;
+}
+
+// Gaussian random value (Box-Muller)
+static inline float randomGauss()
+{
+    float u = randomValue();
+    if (u < 1e-7)
+	u = 1e-7;
+    return ::sqrtf(-2 * ::logf(u)) * ::cosf(2 * PI * randomValue());
+}
+
+// Build a normal burst with random data
+static void buildBurst(uint8_t* bits)
+{
+    const int8_t* tsc = GSMUtils::nbTscTable() + GSM_NB_TSC_LEN * s_tsc;
+    for (unsigned int i = 0; i < GSM_BURST_LENGTH; i++) {
+	if (i < 3 || i >= GSM_BURST_LENGTH - 3)
+	    bits[i] = 0;
+	else if (i >= 61 && i < 61 + GSM_NB_TSC_LEN)
+	    bits[i] = tsc[i - 61];
+	else
+	    bits[i] = ::rand() & 1;
+    }
+}
+
+// Build received data (1 sample/symbol) from a modulated slot: burst bit i at index i + 4
+// Pass decimated data through multipath channel, add noise
+static void buildRx(ComplexVector& out, const ComplexVector& mod, const Profile& p,
+    float snr)
+{
+    out.resize(RX_BURST_LEN,true);
+    Complex g[4];
+    float pwr = 0;
+    for (unsigned int d = 0; d < 4; d++) {
+	if (!p.gain[d])
+	    continue;
+	float ph = d ? 2 * PI * randomValue() : 0;
+	g[d] = Complex(p.gain[d] * ::cosf(ph),p.gain[d] * ::sinf(ph));
+	pwr += p.gain[d] * p.gain[d];
+    }
+    // Normalize channel power
+    for (unsigned int d = 0; d < 4; d++)
+	g[d] *= 1.0F / ::sqrtf(pwr);
+    for (unsigned int i = 0; i < out.length(); i++) {
+	for (unsigned int d = 0; d < 4 && d <= i; d++) {
+	    unsigned int k = (i - d) * OVERSAMPLING;
+	    if (k < mod.length() && p.gain[d]) {
+		Complex c;
+		Complex::multiply(c,mod[k],g[d]);
+		out[i] += c;
+	    }
+	}
+    }
+    float sigma = ::sqrtf(::powf(10,-snr / 10) / 2);
+    for (unsigned int i = 0; i < out.length(); i++)
+	out[i] += Complex(sigma * randomGauss(),sigma * randomGauss());
+}
+
+// Build channel estimate and align received data (see TransceiverQMF::processRadioBurst)
+static bool prepare(ComplexVector& x, ComplexVector& he, const FloatVector& tsc)
+{
+    SignalProcessing::applyMinusPIOverTwoFreqShift(x);
+    int start = x.length() / 2 - GSM_NB_TSC_LEN / 2;
+    int center = GSM_NB_TSC_LEN / 2 - 1;
+    he.resize(GSM_NB_TSC_LEN);
+    SignalProcessing::correlate(he,x,start,GSM_NB_TSC_LEN,tsc);
+    float max = 0;
+    int maxIndex = -1;
+    for (int i = center - 5; i <= center + 5; i++) {
+	float pwr = he[i].mulConj();
+	if (pwr < max)
+	    continue;
+	max = pwr;
+	maxIndex = i;
+    }
+    if (maxIndex < 0)
+	return false;
+    int toaError = maxIndex - center;
+    if (toaError < 0) {
+	x.copySlice(0,-toaError,x.length() + toaError);
+	x.reset(0,-toaError);
+    }
+    else if (toaError) {
+	unsigned int n = x.length() - toaError;
+	x.copySlice(toaError,0,n);
+	x.reset(n);
+    }
+    for (unsigned int i = 0; i < 11; i++)
+	he[i] = he[maxIndex - 5 + i];
+    return true;
+}
+
+// Demodulate a normal burst, return the number of bit errors
+static unsigned int demodulate(const ComplexVector& data, const FloatVector& tsc,
+    const uint8_t* bits, int mode)
+{
+    ComplexVector x(data);
+    ComplexVector he;
+    if (!prepare(x,he,tsc))
+	return GSM_BURST_LENGTH;
+    FloatVector v(x.length());
+    Equalizer::equalize(v,x,he,11,mode);
+    unsigned int errors = 0;
+    for (unsigned int i = 0; i < GSM_BURST_LENGTH; i++)
+	if ((v[i + 4] >= 0 ? 1 : 0) != bits[i])
+	    errors++;
+    return errors;
+}
+
+// Usage: EqualizerTest [bursts [loops]]
+int main(int argc, const char** argv)
+{
+    if (argc > 1)
+	s_bursts = (unsigned int)::atoi(argv[1]);
+    if (argc > 2)
+	s_loops = (unsigned int)::atoi(argv[2]);
+    if (!(s_bursts && s_loops)) {
+	::printf("Invalid parameters bursts=%u loops=%u\n",s_bursts,s_loops);
+	return 1;
+    }
+    ::srand(1);
+    SignalProcessing proc;
+    proc.initialize(OVERSAMPLING,1);
+    // Normal burst TSC (see TransceiverQMF::initNormalBurstTSC)
+    FloatVector tsc(16);
+    const int8_t* p = GSMUtils::nbTscTable() + GSM_NB_TSC_LEN * s_tsc + 5;
+    for (unsigned int i = 0; i < tsc.length(); i++)
+	tsc[i] = p[i] ? 1.0F / 16.0F : -1.0F / 16.0F;
+    ::printf("Testing equalizer: bursts=%u loops=%u\n",s_bursts,s_loops);
+    ::printf("Bit errors, error free bursts (goodput) for each mode\n");
+    uint8_t bits[GSM_BURST_LENGTH];
+    ComplexVector mod;
+    ComplexVector rx;
+    int failed = 0;
+    unsigned int nSnr = sizeof(s_snr) / sizeof(s_snr[0]);
+    for (unsigned int pi = 0; pi < PROFILES; pi++) {
+	for (unsigned int si = 0; si < nSnr; si++) {
+	    unsigned int errors[MODES];
+	    unsigned int good[MODES];
+	    for (unsigned int m = 0; m < MODES; m++)
+		errors[m] = good[m] = 0;
+	    for (unsigned int n = 0; n < s_bursts; n++) {
+		buildBurst(bits);
+		proc.modulate(mod,bits,GSM_BURST_LENGTH);
+		buildRx(rx,mod,s_profile[pi],s_snr[si]);
+		for (unsigned int m = 0; m < MODES; m++) {
+		    unsigned int e = demodulate(rx,tsc,bits,m);
+		    errors[m] += e;
+		    if (!e)
+			good[m]++;
+		}
+	    }
+	    String tmp;
+	    for (unsigned int m = 0; m < MODES; m++) {
+		char buf[100];
+		::sprintf(buf," %s=%u/%.1f%%",s_modeName[m],errors[m],
+		    100.0F * good[m] / s_bursts);
+		tmp << buf;
+	    }
+	    ::printf("%-8s snr=%-3g%s\n",s_profile[pi].name,s_snr[si],tmp.c_str());
+	    // Noise free static channel must be demodulated without errors
+	    // MLSE must not be worse than default equalizer
+	    if ((s_snr[si] >= 100 && !pi && (errors[0] || errors[1])) ||
+		errors[Equalizer::Mlse] > errors[Equalizer::Default]) {
+		::printf("  FAILED profile %s snr=%g\n",s_profile[pi].name,s_snr[si]);
+		failed++;
+	    }
+	}
+    }
+    // Benchmark
+    buildBurst(bits);
+    proc.modulate(mod,bits,GSM_BURST_LENGTH);
+    buildRx(rx,mod,s_profile[2],15);
+    ComplexVector he;
+    if (!prepare(rx,he,tsc)) {
+	::printf("  FAILED to build channel estimate\n");
+	return 1;
+    }
+    FloatVector v(rx.length());
+    String tmp;
+    for (unsigned int m = 0; m < MODES; m++) {
+	uint64_t start = Time::now();
+	for (unsigned int i = 0; i < s_loops; i++)
+	    Equalizer::equalize(v,rx,he,11,m);
+	char buf[100];
+	::sprintf(buf," %s=%.3f",s_modeName[m],(float)(Time::now() - start) / s_loops);
+	tmp << buf;
+    }
+    ::printf("Equalizer%s (usec/burst)\n",tmp.c_str());
+    ::printf("%s\n",failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
+
+/* vi: set ts=8 sw=4 sts=4 noet: */
@@ -0,0 +1,165 @@
+/**
+ * ModulateTest.cpp
+ * This file is part of the Yate-BTS Project http://www.yatebts.com
+ *
+ * GMSK modulator and modulated burst cache check and benchmark
+ *
+ * Yet Another Telephony Engine - Base Transceiver Station
+ * Copyright (C) 2014-2023 Null Team Impex SRL
+ *
+ * This software is distributed under multiple licenses;
+ * see the COPYING file in the main directory for licensing
+ * information for this specific distribution.
+ *
+ * This use of this software may be subject to additional restrictions.
+ * See the LEGAL file in the main directory for details.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "gsmutil.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace TelEngine;
+
+// Error accepted when comparing with common convolution (different summation order)
+static const float s_tolerance = 1e-5;
+
+static unsigned int s_oversample = 8;    // Oversampling
+static unsigned int s_bursts = 200;      // Random bursts checked
+static unsigned int s_loops = 20000;     // Benchmark iterations
+
+static void fillRandom(uint8_t* bits, unsigned int len)
+{
+    for (unsigned int i = 0; i < len; i++)
+	bits[i] = ::rand() & 1;
+}
+
+static bool sameValue(const ComplexVector& v1, const ComplexVector& v2, unsigned int& idx)
+{
+    if (v1.length() != v2.length()) {
+	idx = v1.length();
+	return false;
+    }
+    for (idx = 0; idx < v1.length(); idx++) {
+	float dr = v1[idx].real() - v2[idx].real();
+	float di = v1[idx].imag() - v2[idx].imag();
+	if (dr > s_tolerance || dr < -s_tolerance || di > s_tolerance || di < -s_tolerance)
+	    return false;
+    }
+    return true;
+}
+
+// Check modulator against common convolution for given bits
+static bool check(const char* name, SignalProcessing& proc, const uint8_t* bits,
+    unsigned int len)
+{
+    ComplexVector ref;
+    ComplexVector out;
+    proc.modulateCommon(ref,bits,len);
+    proc.modulate(out,bits,len);
+    unsigned int idx = 0;
+    if (sameValue(ref,out,idx))
+	return true;
+    if (idx < ref.length() && idx < out.length())
+	::printf("  FAILED %s len=%u at index %u: (%g,%g) expected (%g,%g)\n",
+	    name,len,idx,out[idx].real(),out[idx].imag(),ref[idx].real(),ref[idx].imag());
+    else
+	::printf("  FAILED %s len=%u length %u expected %u\n",name,len,
+	    out.length(),ref.length());
+    return false;
+}
+
+// Usage: ModulateTest [oversample [bursts [loops]]]
+int main(int argc, const char** argv)
+{
+    if (argc > 1)
+	s_oversample = (unsigned int)::atoi(argv[1]);
+    if (argc > 2)
+	s_bursts = (unsigned int)::atoi(argv[2]);
+    if (argc > 3)
+	s_loops = (unsigned int)::atoi(argv[3]);
+    if (!(s_oversample && s_loops)) {
+	::printf("Invalid parameters oversample=%u bursts=%u loops=%u\n",
+	    s_oversample,s_bursts,s_loops);
+	return 1;
+    }
+    ::srand(1);
+    SignalProcessing proc;
+    proc.initialize(s_oversample,1);
+    ::printf("Testing modulator oversample=%u bursts=%u loops=%u\n",
+	s_oversample,s_bursts,s_loops);
+    int failed = 0;
+    uint8_t bits[GSM_BURST_LENGTH];
+    // Constant patterns, random bursts, short bursts
+    ::memset(bits,0,sizeof(bits));
+    if (!check("zeros",proc,bits,GSM_BURST_LENGTH))
+	failed++;
+    ::memset(bits,1,sizeof(bits));
+    if (!check("ones",proc,bits,GSM_BURST_LENGTH))
+	failed++;
+    for (unsigned int i = 0; i < s_bursts; i++) {
+	fillRandom(bits,GSM_BURST_LENGTH);
+	if (!check("random",proc,bits,GSM_BURST_LENGTH))
+	    failed++;
+    }
+    fillRandom(bits,GSM_BURST_LENGTH);
+    if (!check("short",proc,bits,100))
+	failed++;
+    // Cache must return the same data as modulator
+    // Repeated bursts must share the cached data, not copy it
+    GSMTxBurstCache cache(16);
+    ComplexVector ref;
+    RefPointer<GSMTxBurstData> data;
+    RefPointer<GSMTxBurstData> again;
+    unsigned int idx = 0;
+    for (unsigned int i = 0; i < 64; i++) {
+	// Repeat a small set of bursts
+	::srand(i % 4);
+	fillRandom(bits,GSM_BURST_LENGTH);
+	proc.modulate(ref,bits,GSM_BURST_LENGTH);
+	cache.modulate(data,proc,bits,GSM_BURST_LENGTH);
+	if (!(data && sameValue(ref,data->m_data,idx))) {
+	    ::printf("  FAILED cache burst %u at index %u\n",i,idx);
+	    failed++;
+	    break;
+	}
+	cache.modulate(again,proc,bits,GSM_BURST_LENGTH);
+	if ((GSMTxBurstData*)again != (GSMTxBurstData*)data) {
+	    ::printf("  FAILED cache burst %u not shared\n",i);
+	    failed++;
+	    break;
+	}
+    }
+    if (cache.hits() + cache.misses() != 128 || cache.misses() > 16) {
+	::printf("  FAILED cache hits=" FMT64U " misses=" FMT64U "\n",
+	    cache.hits(),cache.misses());
+	failed++;
+    }
+    // Benchmark
+    fillRandom(bits,GSM_BURST_LENGTH);
+    ComplexVector out;
+    FloatVector tmpV;
+    ComplexVector tmpW;
+    uint64_t t[3];
+    uint64_t start = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	proc.modulateCommon(out,bits,GSM_BURST_LENGTH,&tmpV,&tmpW);
+    t[0] = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	proc.modulate(out,bits,GSM_BURST_LENGTH,&tmpV,&tmpW);
+    t[1] = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	cache.modulate(data,proc,bits,GSM_BURST_LENGTH,&tmpV,&tmpW);
+    t[2] = Time::now();
+    ::printf("modulateCommon=%.3f modulate=%.3f cached=%.3f (usec/burst)\n",
+	(float)(t[0] - start) / s_loops,(float)(t[1] - t[0]) / s_loops,
+	(float)(t[2] - t[1]) / s_loops);
+    ::printf("%s\n",failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
+
+/* vi: set ts=8 sw=4 sts=4 noet: */
@@ -0,0 +1,229 @@
+/**
+ * SigProcTest.cpp
+ * This file is part of the Yate-BTS Project http://www.yatebts.com
+ *
+ * Signal processing array kernels check and benchmark
+ *
+ * Yet Another Telephony Engine - Base Transceiver Station
+ * Copyright (C) 2014-2023 Null Team Impex SRL
+ *
+ * This software is distributed under multiple licenses;
+ * see the COPYING file in the main directory for licensing
+ * information for this specific distribution.
+ *
+ * This use of this software may be subject to additional restrictions.
+ * See the LEGAL file in the main directory for details.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#include "sigproc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace TelEngine;
+
+// Relative error accepted when comparing with scalar kernels
+// Vector kernels use a different summation order (and fused multiply-add)
+static const float s_tolerance = 1e-4;
+
+static unsigned int s_len = 1250;        // Array length (8 ARFCNs slot at oversampling 8)
+static unsigned int s_taps = 31;         // Convolution/correlation taps (Laurent pulse)
+static unsigned int s_loops = 2000;      // Benchmark iterations
+
+static void fillRandom(ComplexVector& v)
+{
+    for (unsigned int i = 0; i < v.length(); i++)
+	v[i].set((float)(::rand() % 4096 - 2048) / 2047,(float)(::rand() % 4096 - 2048) / 2047);
+}
+
+static void fillRandom(FloatVector& v)
+{
+    for (unsigned int i = 0; i < v.length(); i++)
+	v[i] = (float)(::rand() % 4096) / 4095;
+}
+
+static inline bool sameValue(float v1, float v2)
+{
+    float d = v1 - v2;
+    if (d < 0)
+	d = -d;
+    float m = v1 < 0 ? -v1 : v1;
+    return d <= s_tolerance * (m > 1 ? m : 1);
+}
+
+static inline bool sameValue(const Complex& c1, const Complex& c2)
+{
+    return sameValue(c1.real(),c2.real()) && sameValue(c1.imag(),c2.imag());
+}
+
+static bool sameValue(const ComplexVector& v1, const ComplexVector& v2, unsigned int& idx)
+{
+    if (v1.length() != v2.length()) {
+	idx = v1.length();
+	return false;
+    }
+    for (idx = 0; idx < v1.length(); idx++)
+	if (!sameValue(v1[idx],v2[idx]))
+	    return false;
+    return true;
+}
+
+// Kernels results
+class KernelsResult
+{
+public:
+    inline KernelsResult()
+	: power(0)
+	{}
+    ComplexVector mul;
+    ComplexVector sumMul;
+    ComplexVector conv;
+    ComplexVector corr;
+    Complex dot;
+    Complex dotF;
+    float power;
+};
+
+// Run all kernels once
+static void runKernels(KernelsResult& r, const ComplexVector& a, const ComplexVector& b,
+    const ComplexVector& padded, const FloatVector& g, SignalProcessing& proc)
+{
+    r.mul.resize(a.length());
+    Complex::multiply(r.mul.data(),r.mul.length(),a.data(),a.length(),b.data(),b.length());
+    r.sumMul.assign(a.data(),a.length());
+    Complex::sumMul(r.sumMul.data(),r.sumMul.length(),a.data(),a.length(),b.data(),b.length());
+    r.dot.set();
+    Complex::sumMul(r.dot,a.data(),a.length(),b.data(),b.length());
+    r.dotF.set();
+    Complex::sumMulF(r.dotF,a.data(),g.data(),g.length());
+    r.power = Complex::sumMulConj(a.data(),a.length());
+    proc.convolution(r.conv,padded,g);
+    r.corr.resize(a.length());
+    proc.correlate(r.corr,padded,g.length() / 2,a.length(),g);
+}
+
+static bool check(const char* name, const KernelsResult& ref, const KernelsResult& r)
+{
+    bool ok = true;
+    unsigned int idx = 0;
+#define CHECK_VECT(v) \
+    if (!sameValue(ref.v,r.v,idx)) { \
+	::printf("  FAILED %s %s at index %u\n",name,#v,idx); \
+	ok = false; \
+    }
+    CHECK_VECT(mul);
+    CHECK_VECT(sumMul);
+    CHECK_VECT(conv);
+    CHECK_VECT(corr);
+#undef CHECK_VECT
+    if (!sameValue(ref.dot,r.dot)) {
+	::printf("  FAILED %s dot\n",name);
+	ok = false;
+    }
+    if (!sameValue(ref.dotF,r.dotF)) {
+	::printf("  FAILED %s dotF\n",name);
+	ok = false;
+    }
+    if (!sameValue(ref.power,r.power)) {
+	::printf("  FAILED %s power %g != %g\n",name,r.power,ref.power);
+	ok = false;
+    }
+    return ok;
+}
+
+// Benchmark kernels, print microseconds per call for each of them
+static void benchmark(const char* name, const ComplexVector& a, const ComplexVector& b,
+    const ComplexVector& padded, const FloatVector& g, SignalProcessing& proc)
+{
+    ComplexVector out(a.length());
+    ComplexVector conv;
+    float power = 0;
+    uint64_t t[5];
+    uint64_t start = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	Complex::multiply(out.data(),out.length(),a.data(),a.length(),b.data(),b.length());
+    t[0] = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	Complex::sumMul(out.data(),out.length(),a.data(),a.length(),b.data(),b.length());
+    t[1] = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	power += Complex::sumMulConj(a.data(),a.length());
+    t[2] = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	proc.convolution(conv,padded,g);
+    t[3] = Time::now();
+    for (unsigned int i = 0; i < s_loops; i++)
+	proc.correlate(out,padded,g.length() / 2,a.length(),g);
+    t[4] = Time::now();
+    ::printf("%-8s multiply=%.3f sumMul=%.3f sumMulConj=%.3f convolution=%.3f correlate=%.3f (usec/call)\n",
+	name,(float)(t[0] - start) / s_loops,(float)(t[1] - t[0]) / s_loops,
+	(float)(t[2] - t[1]) / s_loops,(float)(t[3] - t[2]) / s_loops,
+	(float)(t[4] - t[3]) / s_loops);
+    if (power < 0)
+	::printf("Unexpected power %g\n",power);
+}
+
+// Usage: SigProcTest [length [taps [loops]]]
+int main(int argc, const char** argv)
+{
+    if (argc > 1)
+	s_len = (unsigned int)::atoi(argv[1]);
+    if (argc > 2)
+	s_taps = (unsigned int)::atoi(argv[2]) | 1;
+    if (argc > 3)
+	s_loops = (unsigned int)::atoi(argv[3]);
+    if (s_len < 2 * s_taps || !s_loops) {
+	::printf("Invalid parameters length=%u taps=%u loops=%u\n",s_len,s_taps,s_loops);
+	return 1;
+    }
+    ::srand(1);
+    ComplexVector a(s_len);
+    ComplexVector b(s_len);
+    ComplexVector padded(s_len + s_taps);
+    FloatVector g(s_taps);
+    fillRandom(a);
+    fillRandom(b);
+    fillRandom(padded);
+    // Convolution expects symmetric filter
+    fillRandom(g);
+    for (unsigned int i = 0; i < s_taps / 2; i++)
+	g[s_taps - 1 - i] = g[i];
+    SignalProcessing proc;
+    String supported;
+    Complex::supportedKernels(supported);
+    ::printf("Testing kernels: %s length=%u taps=%u loops=%u\n",
+	supported.c_str(),s_len,s_taps,s_loops);
+    if (!Complex::setKernels("scalar")) {
+	::printf("Failed to set scalar kernels\n");
+	return 1;
+    }
+    KernelsResult ref;
+    runKernels(ref,a,b,padded,g,proc);
+    benchmark("scalar",a,b,padded,g,proc);
+    int failed = 0;
+    ObjList* list = supported.split(',',false);
+    for (ObjList* o = list->skipNull(); o; o = o->skipNext()) {
+	const String& name = *static_cast<String*>(o->get());
+	if (name == YSTRING("scalar"))
+	    continue;
+	if (!Complex::setKernels(name)) {
+	    ::printf("Failed to set kernels %s\n",name.c_str());
+	    failed++;
+	    continue;
+	}
+	KernelsResult r;
+	runKernels(r,a,b,padded,g,proc);
+	if (check(name,ref,r))
+	    benchmark(name,a,b,padded,g,proc);
+	else
+	    failed++;
+    }
+    TelEngine::destruct(list);
+    ::printf("%s\n",failed ? "FAILED" : "OK");
+    return failed ? 1 : 0;
+}
+
+/* vi: set ts=8 sw=4 sts=4 noet: */
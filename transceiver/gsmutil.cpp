@@ -66,11 +66,17 @@ const int8_t* GSMUtils::abSyncTable()
 //
 // Build TX data
 void GSMTxBurst::buildTxData(const SignalProcessing& proc,
-    FloatVector* tmpV, ComplexVector* tmpW, const DataBlock& buf)
+    FloatVector* tmpV, ComplexVector* tmpW, const DataBlock& buf, GSMTxBurstCache* cache)
 {
     const DataBlock& tmp = buf.length() ? buf : *static_cast<const DataBlock*>(this);
-    if (tmp.length())
+    if (!tmp.length())
+	return;
+    if (cache)
+	cache->modulate(m_shared,proc,tmp.data(0),tmp.length(),tmpV,tmpW);
+    else {
+	m_shared = 0;
 	proc.modulate(m_txData,tmp.data(0),tmp.length(),tmpV,tmpW);
+    }
     // Due testing purposes the frequency shifting is done on send time.
 }
 
@@ -118,6 +124,9 @@ GSMTxBurst* GSMTxBurst::parse(const uint8_t* buf, unsigned int len,
     }
     if (dataBits)
 	dataBits->assign((void*)(buf + GSM_BURST_TXHEADER),GSM_BURST_LENGTH,false);
+    else if (burst->length() == GSM_BURST_LENGTH)
+	// Avoid re-allocating recycled burst buffer
+	::memcpy(burst->data(0),buf + GSM_BURST_TXHEADER,GSM_BURST_LENGTH);
     else
 	burst->assign((void*)(buf + GSM_BURST_TXHEADER),GSM_BURST_LENGTH);
     return burst;
@@ -166,4 +175,77 @@ void GSMRxBurst::fillEstimatesBuffer()
     *buf++ = (int8_t)toa;
 }
 
+
+//
+// GSMTxBurstCache
+//
+// Modulate bits in new shared data
+static inline void buildTxBurstData(RefPointer<GSMTxBurstData>& data,
+    const SignalProcessing& proc, const uint8_t* bits, unsigned int len,
+    FloatVector* tmpV, ComplexVector* tmpW)
+{
+    GSMTxBurstData* d = new GSMTxBurstData;
+    proc.modulate(d->m_data,bits,len,tmpV,tmpW);
+    data = d;
+    TelEngine::destruct(d);
+}
+
+GSMTxBurstCache::GSMTxBurstCache(unsigned int len)
+    : m_mutex(false,"GSMTxBurstCache"),
+    m_entries(0), m_mask(0), m_hits(0), m_misses(0)
+{
+    unsigned int n = 1;
+    while (n < len)
+	n <<= 1;
+    m_entries = new Entry[n];
+    m_mask = n - 1;
+}
+
+GSMTxBurstCache::~GSMTxBurstCache()
+{
+    delete[] m_entries;
+}
+
+void GSMTxBurstCache::modulate(RefPointer<GSMTxBurstData>& data, const SignalProcessing& proc,
+    const uint8_t* bits, unsigned int len, FloatVector* tmpV, ComplexVector* tmpW)
+{
+    if (!(bits && len == GSM_BURST_LENGTH)) {
+	m_mutex.lock();
+	m_misses++;
+	m_mutex.unlock();
+	buildTxBurstData(data,proc,bits,len,tmpV,tmpW);
+	return;
+    }
+    // Pack bits (modulator only checks for non 0), compute FNV-1a hash
+    uint8_t key[sizeof(m_entries->key)];
+    ::memset(key,0,sizeof(key));
+    for (unsigned int i = 0; i < len; i++)
+	if (bits[i])
+	    key[i >> 3] |= 0x80 >> (i & 7);
+    uint32_t h = 2166136261U;
+    for (unsigned int i = 0; i < sizeof(key); i++)
+	h = (h ^ key[i]) * 16777619U;
+    Entry& e = m_entries[(h ^ (h >> 16)) & m_mask];
+    Lock lck(m_mutex);
+    if (e.data && !::memcmp(e.key,key,sizeof(key))) {
+	m_hits++;
+	data = e.data;
+	return;
+    }
+    m_misses++;
+    lck.drop();
+    // Data referenced by bursts is never changed: replace the entry
+    buildTxBurstData(data,proc,bits,len,tmpV,tmpW);
+    lck.acquire(m_mutex);
+    ::memcpy(e.key,key,sizeof(key));
+    e.data = data;
+}
+
+void GSMTxBurstCache::clear()
+{
+    Lock lck(m_mutex);
+    for (unsigned int i = 0; i <= m_mask; i++)
+	m_entries[i].data = 0;
+}
+
 /* vi: set ts=8 sw=4 sts=4 noet: */
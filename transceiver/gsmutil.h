@@ -30,6 +30,7 @@ namespace TelEngine {
 class GSMTime;                           // GSM time
 class GSMBurst;                          // A GSM burst
 class GSMTxBurst;                        // A GSM burst to send
+class GSMTxBurstCache;                   // Modulated TX burst data cache
 class GSMRxBurst;                        // A received GSM burst
 
 // TDMA frame number max value (see TS 100 908 (GSM 05.02) Section 4.3.3)
@@ -325,6 +326,25 @@ protected:
 };
 
 
+/**
+ * This class holds modulated TX burst data shared by bursts with the same content.
+ * Data is never changed once the object is shared
+ * @short Shared modulated TX burst data
+ */
+class GSMTxBurstData : public RefObject
+{
+    YNOCOPY(GSMTxBurstData);
+public:
+    /**
+     * Constructor
+     */
+    inline GSMTxBurstData()
+	{}
+
+    ComplexVector m_data;
+};
+
+
 /**
  * This class implements a GSM burst to be sent
  * @short A GSM burst to send
@@ -353,7 +373,7 @@ public:
      * @return TX data
      */
     inline const ComplexVector& txData() const
-	{ return m_txData; }
+	{ return m_shared ? m_shared->m_data : m_txData; }
 
     /**
      * Build TX data
@@ -361,10 +381,12 @@ public:
      * @param tmpV Optional temporary buffer to be passed to signal processing
      * @param tmpW Optional temporary buffer to be passed to signal processing
      * @param buf Optional buffer to parse, use this burst if empty
+     * @param cache Optional cache of already modulated bursts.
+     *  The burst references cached data instead of copying it
      */
     void buildTxData(const SignalProcessing& proc,
 	FloatVector* tmpV = 0, ComplexVector* tmpW = 0,
-	const DataBlock& buf = DataBlock::empty());
+	const DataBlock& buf = DataBlock::empty(), GSMTxBurstCache* cache = 0);
 
     /**
      * Obtain a burst from the given data.
@@ -425,6 +447,7 @@ public:
 		return 0;
 	    GSMTxBurst* ret = new GSMTxBurst();
 	    ret->m_txData.copy(burst->m_txData);
+	    ret->m_shared = burst->m_shared;
 	    ret->m_powerLevel = burst->m_powerLevel;
 	    ret->m_filler = burst->m_filler;
 	    ret->m_type = burst->m_type;
@@ -433,6 +456,7 @@ public:
 
 private:
     ComplexVector m_txData;
+    RefPointer<GSMTxBurstData> m_shared; // Shared modulated data (used instead of m_txData)
     float m_powerLevel;
     bool m_filler;                       // Filler burst
     int m_type;
@@ -441,6 +465,81 @@ private:
 typedef ObjStore<GSMTxBurst> GSMTxBurstStore;
 
 
+/**
+ * This class implements a cache of modulated TX burst data.
+ * Data is looked up by burst content (bits): repeated bursts (fillers,
+ *  system information, idle paging) are modulated only once.
+ * Modulated data does not depend on ARFCN: a transceiver keeps one cache shared
+ *  by all ARFCNs. Bursts (queued or in filler table) reference cached data.
+ * Entries are direct mapped by content hash, a new burst replaces the old one
+ * @short Modulated TX burst data cache
+ */
+class GSMTxBurstCache
+{
+public:
+    /**
+     * Constructor
+     * @param len Number of cache entries (rounded up to the next power of 2)
+     */
+    GSMTxBurstCache(unsigned int len = 256);
+
+    /**
+     * Destructor
+     */
+    ~GSMTxBurstCache();
+
+    /**
+     * Retrieve modulated data for burst bits. Modulate and store it if not found.
+     * This method is thread safe, modulation is done without holding the lock
+     * @param data Destination for modulated data
+     * @param proc The signal processor
+     * @param bits Burst bits
+     * @param len Burst bits length, bursts with other length than
+     *  GSM_BURST_LENGTH are modulated without being stored
+     * @param tmpV Optional temporary buffer to be passed to signal processing
+     * @param tmpW Optional temporary buffer to be passed to signal processing
+     */
+    void modulate(RefPointer<GSMTxBurstData>& data, const SignalProcessing& proc,
+	const uint8_t* bits, unsigned int len,
+	FloatVector* tmpV = 0, ComplexVector* tmpW = 0);
+
+    /**
+     * Remove all entries (signal processing parameters changed)
+     */
+    void clear();
+
+    /**
+     * Retrieve the number of bursts found in cache
+     * @return The number of cache hits
+     */
+    inline uint64_t hits() const {
+	    Lock lck(m_mutex);
+	    return m_hits;
+	}
+
+    /**
+     * Retrieve the number of bursts modulated
+     * @return The number of cache misses
+     */
+    inline uint64_t misses() const {
+	    Lock lck(m_mutex);
+	    return m_misses;
+	}
+
+private:
+    struct Entry {
+	uint8_t key[(GSM_BURST_LENGTH + 7) / 8];
+	RefPointer<GSMTxBurstData> data;
+    };
+
+    mutable Mutex m_mutex;
+    Entry* m_entries;
+    unsigned int m_mask;
+    uint64_t m_hits;
+    uint64_t m_misses;
+};
+
+
 /**
  * This class implements a received GSM burst
  * @short A received GSM burst
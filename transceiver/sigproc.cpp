@@ -48,6 +48,514 @@ static inline unsigned int safeStrLen(const char* str)
 }
 
 
+//
+// Complex array processing kernels
+// Complex numbers are kept interleaved in memory (real,imag) so arrays can be
+//  loaded directly in vector registers. Remaining elements are handled by
+//  scalar code
+//
+struct ComplexKernels
+{
+    const char* name;
+    bool (*supported)();
+    // dest[i] = c1[i] * c2[i]
+    void (*multiply)(Complex* dest, const Complex* c1, const Complex* c2, unsigned int n);
+    // dest[i] = dest[i] + c1[i] * c2[i]
+    void (*sumMul)(Complex* dest, const Complex* c1, const Complex* c2, unsigned int n);
+    // dest = dest + SUM(c1[i] * c2[i])
+    void (*sumMulSum)(Complex& dest, const Complex* c1, const Complex* c2, unsigned int n);
+    // dest = dest + SUM(c[i] * f[i])
+    void (*sumMulF)(Complex& dest, const Complex* c, const float* f, unsigned int n);
+    // SUM(c[i] * conj(c[i]))
+    float (*sumMulConj)(const Complex* c, unsigned int n);
+};
+
+static inline const float* cplxData(const Complex* c)
+{
+    return reinterpret_cast<const float*>(c);
+}
+
+static inline float* cplxData(Complex* c)
+{
+    return reinterpret_cast<float*>(c);
+}
+
+static bool scalarSupported()
+{
+    return true;
+}
+
+static void scalarMultiply(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    for (; n; --n, ++dest, ++c1, ++c2)
+	Complex::multiply(*dest,*c1,*c2);
+}
+
+static void scalarSumMul(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    for (; n; --n, ++dest, ++c1, ++c2)
+	Complex::sumMul(*dest,*c1,*c2);
+}
+
+static void scalarSumMulSum(Complex& dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    for (; n; --n, ++c1, ++c2)
+	Complex::sumMul(dest,*c1,*c2);
+}
+
+static void scalarSumMulF(Complex& dest, const Complex* c, const float* f,
+    unsigned int n)
+{
+    for (; n; --n, ++c, ++f)
+	Complex::sumMulF(dest,*c,*f);
+}
+
+static float scalarSumMulConj(const Complex* c, unsigned int n)
+{
+    float val = 0;
+    for (; n; --n, ++c)
+	val += c->mulConj();
+    return val;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIGPROC_KERNELS_X86
+#include <immintrin.h>
+
+#define KERNEL_TARGET(t) __attribute__((target(t)))
+
+static bool sse3Supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse3");
+}
+
+static bool avx2Supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool avx512Supported()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+}
+
+// Multiply 2 pairs of interleaved complex numbers
+// (ar*br - ai*bi, ai*br + ar*bi)
+KERNEL_TARGET("sse3")
+static inline __m128 sse3Mul(__m128 a, __m128 b)
+{
+    __m128 t = _mm_mul_ps(_mm_shuffle_ps(a,a,0xb1),_mm_movehdup_ps(b));
+    return _mm_addsub_ps(_mm_mul_ps(a,_mm_moveldup_ps(b)),t);
+}
+
+// Add a (real,imag,real,imag) accumulator to a complex number
+KERNEL_TARGET("sse3")
+static inline void sse3Add(Complex& dest, __m128 acc)
+{
+    float tmp[4];
+    _mm_storeu_ps(tmp,_mm_add_ps(acc,_mm_movehl_ps(acc,acc)));
+    dest.set(dest.real() + tmp[0],dest.imag() + tmp[1]);
+}
+
+KERNEL_TARGET("sse3")
+static void sse3Multiply(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 2 <= n; i += 2)
+	_mm_storeu_ps(cplxData(dest + i),
+	    sse3Mul(_mm_loadu_ps(cplxData(c1 + i)),_mm_loadu_ps(cplxData(c2 + i))));
+    scalarMultiply(dest + i,c1 + i,c2 + i,n - i);
+}
+
+KERNEL_TARGET("sse3")
+static void sse3SumMul(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 2 <= n; i += 2) {
+	float* d = cplxData(dest + i);
+	__m128 p = sse3Mul(_mm_loadu_ps(cplxData(c1 + i)),_mm_loadu_ps(cplxData(c2 + i)));
+	_mm_storeu_ps(d,_mm_add_ps(_mm_loadu_ps(d),p));
+    }
+    scalarSumMul(dest + i,c1 + i,c2 + i,n - i);
+}
+
+KERNEL_TARGET("sse3")
+static void sse3SumMulSum(Complex& dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    __m128 acc = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 2 <= n; i += 2)
+	acc = _mm_add_ps(acc,
+	    sse3Mul(_mm_loadu_ps(cplxData(c1 + i)),_mm_loadu_ps(cplxData(c2 + i))));
+    sse3Add(dest,acc);
+    scalarSumMulSum(dest,c1 + i,c2 + i,n - i);
+}
+
+KERNEL_TARGET("sse3")
+static void sse3SumMulF(Complex& dest, const Complex* c, const float* f,
+    unsigned int n)
+{
+    __m128 acc = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 2 <= n; i += 2) {
+	// (f0,f0,f1,f1)
+	__m128 g = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(f + i)));
+	acc = _mm_add_ps(acc,_mm_mul_ps(_mm_loadu_ps(cplxData(c + i)),_mm_unpacklo_ps(g,g)));
+    }
+    sse3Add(dest,acc);
+    scalarSumMulF(dest,c + i,f + i,n - i);
+}
+
+KERNEL_TARGET("sse3")
+static float sse3SumMulConj(const Complex* c, unsigned int n)
+{
+    __m128 acc = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 2 <= n; i += 2) {
+	__m128 a = _mm_loadu_ps(cplxData(c + i));
+	acc = _mm_add_ps(acc,_mm_mul_ps(a,a));
+    }
+    acc = _mm_hadd_ps(acc,acc);
+    acc = _mm_hadd_ps(acc,acc);
+    return _mm_cvtss_f32(acc) + scalarSumMulConj(c + i,n - i);
+}
+
+// Multiply 4 pairs of interleaved complex numbers
+KERNEL_TARGET("avx2,fma")
+static inline __m256 avx2Mul(__m256 a, __m256 b)
+{
+    __m256 t = _mm256_mul_ps(_mm256_permute_ps(a,0xb1),_mm256_movehdup_ps(b));
+    return _mm256_fmaddsub_ps(a,_mm256_moveldup_ps(b),t);
+}
+
+KERNEL_TARGET("avx2,fma")
+static inline void avx2Add(Complex& dest, __m256 acc)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc),_mm256_extractf128_ps(acc,1));
+    float tmp[4];
+    _mm_storeu_ps(tmp,_mm_add_ps(s,_mm_movehl_ps(s,s)));
+    dest.set(dest.real() + tmp[0],dest.imag() + tmp[1]);
+}
+
+KERNEL_TARGET("avx2,fma")
+static void avx2Multiply(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4)
+	_mm256_storeu_ps(cplxData(dest + i),
+	    avx2Mul(_mm256_loadu_ps(cplxData(c1 + i)),_mm256_loadu_ps(cplxData(c2 + i))));
+    scalarMultiply(dest + i,c1 + i,c2 + i,n - i);
+}
+
+KERNEL_TARGET("avx2,fma")
+static void avx2SumMul(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+	float* d = cplxData(dest + i);
+	__m256 p = avx2Mul(_mm256_loadu_ps(cplxData(c1 + i)),_mm256_loadu_ps(cplxData(c2 + i)));
+	_mm256_storeu_ps(d,_mm256_add_ps(_mm256_loadu_ps(d),p));
+    }
+    scalarSumMul(dest + i,c1 + i,c2 + i,n - i);
+}
+
+KERNEL_TARGET("avx2,fma")
+static void avx2SumMulSum(Complex& dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    __m256 acc = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4)
+	acc = _mm256_add_ps(acc,
+	    avx2Mul(_mm256_loadu_ps(cplxData(c1 + i)),_mm256_loadu_ps(cplxData(c2 + i))));
+    avx2Add(dest,acc);
+    scalarSumMulSum(dest,c1 + i,c2 + i,n - i);
+}
+
+KERNEL_TARGET("avx2,fma")
+static void avx2SumMulF(Complex& dest, const Complex* c, const float* f,
+    unsigned int n)
+{
+    const __m256i idx = _mm256_setr_epi32(0,0,1,1,2,2,3,3);
+    __m256 acc = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+	__m256 g = _mm256_castps128_ps256(_mm_loadu_ps(f + i));
+	acc = _mm256_fmadd_ps(_mm256_loadu_ps(cplxData(c + i)),
+	    _mm256_permutevar8x32_ps(g,idx),acc);
+    }
+    avx2Add(dest,acc);
+    scalarSumMulF(dest,c + i,f + i,n - i);
+}
+
+KERNEL_TARGET("avx2,fma")
+static float avx2SumMulConj(const Complex* c, unsigned int n)
+{
+    __m256 acc = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+	__m256 a = _mm256_loadu_ps(cplxData(c + i));
+	acc = _mm256_fmadd_ps(a,a,acc);
+    }
+    Complex tmp;
+    avx2Add(tmp,acc);
+    return tmp.real() + tmp.imag() + scalarSumMulConj(c + i,n - i);
+}
+
+// Multiply 8 pairs of interleaved complex numbers
+// Use in lane shuffles to swap and duplicate real/imaginary parts
+KERNEL_TARGET("avx512f")
+static inline __m512 avx512Mul(__m512 a, __m512 b)
+{
+    __m512 t = _mm512_mul_ps(_mm512_shuffle_ps(a,a,0xb1),_mm512_shuffle_ps(b,b,0xf5));
+    return _mm512_fmaddsub_ps(a,_mm512_shuffle_ps(b,b,0xa0),t);
+}
+
+KERNEL_TARGET("avx512f")
+static inline void avx512Add(Complex& dest, __m512 acc)
+{
+    __m256 s = _mm256_add_ps(_mm512_castps512_ps256(acc),
+	_mm512_castps512_ps256(_mm512_shuffle_f32x4(acc,acc,0xee)));
+    __m128 s1 = _mm_add_ps(_mm256_castps256_ps128(s),_mm256_extractf128_ps(s,1));
+    float tmp[4];
+    _mm_storeu_ps(tmp,_mm_add_ps(s1,_mm_movehl_ps(s1,s1)));
+    dest.set(dest.real() + tmp[0],dest.imag() + tmp[1]);
+}
+
+// Build the load mask for remaining complex numbers (n < 8)
+static inline __mmask16 avx512Mask(unsigned int n)
+{
+    return (__mmask16)((1u << (2 * n)) - 1);
+}
+
+KERNEL_TARGET("avx512f")
+static void avx512Multiply(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8)
+	_mm512_storeu_ps(cplxData(dest + i),
+	    avx512Mul(_mm512_loadu_ps(cplxData(c1 + i)),_mm512_loadu_ps(cplxData(c2 + i))));
+    if (i < n) {
+	__mmask16 m = avx512Mask(n - i);
+	_mm512_mask_storeu_ps(cplxData(dest + i),m,
+	    avx512Mul(_mm512_maskz_loadu_ps(m,cplxData(c1 + i)),
+	    _mm512_maskz_loadu_ps(m,cplxData(c2 + i))));
+    }
+}
+
+KERNEL_TARGET("avx512f")
+static void avx512SumMul(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8) {
+	float* d = cplxData(dest + i);
+	__m512 p = avx512Mul(_mm512_loadu_ps(cplxData(c1 + i)),_mm512_loadu_ps(cplxData(c2 + i)));
+	_mm512_storeu_ps(d,_mm512_add_ps(_mm512_loadu_ps(d),p));
+    }
+    if (i < n) {
+	__mmask16 m = avx512Mask(n - i);
+	float* d = cplxData(dest + i);
+	__m512 p = avx512Mul(_mm512_maskz_loadu_ps(m,cplxData(c1 + i)),
+	    _mm512_maskz_loadu_ps(m,cplxData(c2 + i)));
+	_mm512_mask_storeu_ps(d,m,_mm512_add_ps(_mm512_maskz_loadu_ps(m,d),p));
+    }
+}
+
+KERNEL_TARGET("avx512f")
+static void avx512SumMulSum(Complex& dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    __m512 acc = _mm512_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8)
+	acc = _mm512_add_ps(acc,
+	    avx512Mul(_mm512_loadu_ps(cplxData(c1 + i)),_mm512_loadu_ps(cplxData(c2 + i))));
+    if (i < n) {
+	__mmask16 m = avx512Mask(n - i);
+	acc = _mm512_add_ps(acc,avx512Mul(_mm512_maskz_loadu_ps(m,cplxData(c1 + i)),
+	    _mm512_maskz_loadu_ps(m,cplxData(c2 + i))));
+    }
+    avx512Add(dest,acc);
+}
+
+KERNEL_TARGET("avx512f")
+static void avx512SumMulF(Complex& dest, const Complex* c, const float* f,
+    unsigned int n)
+{
+    const __m512i idx = _mm512_setr_epi32(0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7);
+    __m512 acc = _mm512_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8) {
+	__m512 g = _mm512_maskz_loadu_ps(0xff,f + i);
+	acc = _mm512_fmadd_ps(_mm512_loadu_ps(cplxData(c + i)),
+	    _mm512_permutex2var_ps(g,idx,g),acc);
+    }
+    if (i < n) {
+	__m512 g = _mm512_maskz_loadu_ps((__mmask16)((1u << (n - i)) - 1),f + i);
+	acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(avx512Mask(n - i),cplxData(c + i)),
+	    _mm512_permutex2var_ps(g,idx,g),acc);
+    }
+    avx512Add(dest,acc);
+}
+
+KERNEL_TARGET("avx512f")
+static float avx512SumMulConj(const Complex* c, unsigned int n)
+{
+    __m512 acc = _mm512_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= n; i += 8) {
+	__m512 a = _mm512_loadu_ps(cplxData(c + i));
+	acc = _mm512_fmadd_ps(a,a,acc);
+    }
+    if (i < n) {
+	__m512 a = _mm512_maskz_loadu_ps(avx512Mask(n - i),cplxData(c + i));
+	acc = _mm512_fmadd_ps(a,a,acc);
+    }
+    Complex tmp;
+    avx512Add(tmp,acc);
+    return tmp.real() + tmp.imag();
+}
+#endif // x86
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIGPROC_KERNELS_NEON
+#include <arm_neon.h>
+
+static bool neonSupported()
+{
+    return true;
+}
+
+// Multiply 4 pairs of de-interleaved complex numbers
+static inline float32x4x2_t neonMul(float32x4x2_t a, float32x4x2_t b)
+{
+    float32x4x2_t r;
+    r.val[0] = vmlsq_f32(vmulq_f32(a.val[0],b.val[0]),a.val[1],b.val[1]);
+    r.val[1] = vmlaq_f32(vmulq_f32(a.val[0],b.val[1]),a.val[1],b.val[0]);
+    return r;
+}
+
+static inline float neonHSum(float32x4_t v)
+{
+    float32x2_t s = vadd_f32(vget_low_f32(v),vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(s,s),0);
+}
+
+static void neonMultiply(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4)
+	vst2q_f32(cplxData(dest + i),
+	    neonMul(vld2q_f32(cplxData(c1 + i)),vld2q_f32(cplxData(c2 + i))));
+    scalarMultiply(dest + i,c1 + i,c2 + i,n - i);
+}
+
+static void neonSumMul(Complex* dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+	float* d = cplxData(dest + i);
+	float32x4x2_t p = neonMul(vld2q_f32(cplxData(c1 + i)),vld2q_f32(cplxData(c2 + i)));
+	float32x4x2_t a = vld2q_f32(d);
+	a.val[0] = vaddq_f32(a.val[0],p.val[0]);
+	a.val[1] = vaddq_f32(a.val[1],p.val[1]);
+	vst2q_f32(d,a);
+    }
+    scalarSumMul(dest + i,c1 + i,c2 + i,n - i);
+}
+
+static void neonSumMulSum(Complex& dest, const Complex* c1, const Complex* c2,
+    unsigned int n)
+{
+    float32x4_t r = vdupq_n_f32(0);
+    float32x4_t im = vdupq_n_f32(0);
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+	float32x4x2_t p = neonMul(vld2q_f32(cplxData(c1 + i)),vld2q_f32(cplxData(c2 + i)));
+	r = vaddq_f32(r,p.val[0]);
+	im = vaddq_f32(im,p.val[1]);
+    }
+    dest.set(dest.real() + neonHSum(r),dest.imag() + neonHSum(im));
+    scalarSumMulSum(dest,c1 + i,c2 + i,n - i);
+}
+
+static void neonSumMulF(Complex& dest, const Complex* c, const float* f,
+    unsigned int n)
+{
+    float32x4_t r = vdupq_n_f32(0);
+    float32x4_t im = vdupq_n_f32(0);
+    unsigned int i = 0;
+    for (; i + 4 <= n; i += 4) {
+	float32x4x2_t a = vld2q_f32(cplxData(c + i));
+	float32x4_t g = vld1q_f32(f + i);
+	r = vmlaq_f32(r,a.val[0],g);
+	im = vmlaq_f32(im,a.val[1],g);
+    }
+    dest.set(dest.real() + neonHSum(r),dest.imag() + neonHSum(im));
+    scalarSumMulF(dest,c + i,f + i,n - i);
+}
+
+static float neonSumMulConj(const Complex* c, unsigned int n)
+{
+    float32x4_t acc = vdupq_n_f32(0);
+    unsigned int i = 0;
+    for (; i + 2 <= n; i += 2) {
+	float32x4_t a = vld1q_f32(cplxData(c + i));
+	acc = vmlaq_f32(acc,a,a);
+    }
+    return neonHSum(acc) + scalarSumMulConj(c + i,n - i);
+}
+#endif // NEON
+
+// Available kernels, best first
+static const ComplexKernels s_complexKernels[] = {
+#ifdef SIGPROC_KERNELS_X86
+    {"avx512", avx512Supported, avx512Multiply, avx512SumMul, avx512SumMulSum,
+	avx512SumMulF, avx512SumMulConj},
+    {"avx2", avx2Supported, avx2Multiply, avx2SumMul, avx2SumMulSum,
+	avx2SumMulF, avx2SumMulConj},
+    {"sse3", sse3Supported, sse3Multiply, sse3SumMul, sse3SumMulSum,
+	sse3SumMulF, sse3SumMulConj},
+#endif
+#ifdef SIGPROC_KERNELS_NEON
+    {"neon", neonSupported, neonMultiply, neonSumMul, neonSumMulSum,
+	neonSumMulF, neonSumMulConj},
+#endif
+    {"scalar", scalarSupported, scalarMultiply, scalarSumMul, scalarSumMulSum,
+	scalarSumMulF, scalarSumMulConj},
+    {0, 0, 0, 0, 0, 0, 0},
+};
+
+// Start with scalar kernels: constant initialized, safe to use before
+//  static constructors run
+static const ComplexKernels* s_kernels =
+    &s_complexKernels[sizeof(s_complexKernels) / sizeof(ComplexKernels) - 2];
+
+// Select the best kernels on library load
+class ComplexKernelsInit
+{
+public:
+    inline ComplexKernelsInit()
+	{ Complex::setKernels(); }
+};
+static ComplexKernelsInit s_complexKernelsInit;
+
+
 //
 // Complex
 //
@@ -68,10 +576,77 @@ float Complex::sumMulConj(const Complex* data, unsigned int len)
 {
     if (!data)
 	return 0;
-    float val = 0;
-    for (; len; len--, data++)
-	val += data->mulConj();
-    return val;
+    return s_kernels->sumMulConj(data,len);
+}
+
+// Multiply two complex arrays
+void Complex::multiply(Complex* dest, unsigned int len,
+    const Complex* c1, unsigned int len1, const Complex* c2, unsigned int len2)
+{
+    unsigned int n = SigProcUtils::min(len,len1,len2);
+    if (n)
+	s_kernels->multiply(dest,c1,c2,n);
+}
+
+// Compute the sum of product between 2 complex arrays
+Complex& Complex::sumMul(Complex& dest, const Complex* c1, unsigned int len1,
+    const Complex* c2, unsigned int len2)
+{
+    unsigned int n = SigProcUtils::min(len1,len2);
+    if (n)
+	s_kernels->sumMulSum(dest,c1,c2,n);
+    return dest;
+}
+
+// Compute the sum of dest and product of c1,c2
+void Complex::sumMul(Complex* dest, unsigned int len,
+    const Complex* c1, unsigned int len1, const Complex* c2, unsigned int len2)
+{
+    unsigned int n = SigProcUtils::min(len,len1,len2);
+    if (n)
+	s_kernels->sumMul(dest,c1,c2,n);
+}
+
+// Compute the sum of product between a complex array and a float array
+Complex& Complex::sumMulF(Complex& dest, const Complex* c, const float* f,
+    unsigned int len)
+{
+    if (len)
+	s_kernels->sumMulF(dest,c,f,len);
+    return dest;
+}
+
+// Retrieve the name of the array processing kernels currently in use
+const char* Complex::kernels()
+{
+    return s_kernels->name;
+}
+
+// Select the array processing kernels
+bool Complex::setKernels(const char* name)
+{
+    bool best = TelEngine::null(name) || !::strcmp(name,"auto");
+    for (const ComplexKernels* k = s_complexKernels; k->name; k++) {
+	if (!(best || !::strcmp(name,k->name)))
+	    continue;
+	if (!k->supported()) {
+	    if (best)
+		continue;
+	    return false;
+	}
+	s_kernels = k;
+	return true;
+    }
+    return false;
+}
+
+// Build the list of array processing kernels supported by the running CPU
+String& Complex::supportedKernels(String& dest, const char* sep)
+{
+    for (const ComplexKernels* k = s_complexKernels; k->name; k++)
+	if (k->supported())
+	    dest.append(k->name,sep);
+    return dest;
 }
 
 // Set complex elements from 16 bit integers array (pairs of real/imaginary parts)
@@ -110,7 +685,9 @@ SignalProcessing::SignalProcessing()
     : m_oversample(0),
     m_gsmSlotLen(0),
     m_rampOffset(0),
-    m_rampTrailIdx(0)
+    m_rampTrailIdx(0),
+    m_modSymbols(0),
+    m_modFirst(0)
 {
     setOversample(1);
 }
@@ -125,11 +702,16 @@ void SignalProcessing::initialize(unsigned int oversample, unsigned int arfcns,
 	    "SignalProcessing::initialize: modulate/convolution not tested for oversample %u",
 	    oversample);
     generateARFCNsFreqShift(m_arfcnFS,arfcns,m_oversample);
+    initModulateTable();
 }
 
 void SignalProcessing::modulate(ComplexVector& out, const uint8_t* b, unsigned int len,
     FloatVector* tmpV, ComplexVector* tmpW) const
 {
+    if (m_modSymbols) {
+	modulateTable(out,b,len,tmpV);
+	return;
+    }
     ComplexVector localW;
     if (!tmpW)
 	tmpW = &localW;
@@ -219,20 +801,12 @@ void SignalProcessing::convolution(ComplexVector& out, const ComplexVector& fVec
     }
     out.resize(fVect.length() - gVect.length());
     Complex* x = out.data();
-    unsigned int Lp_1 = gVect.length() / 2;
     const Complex* parseF = fVect.data();
+    // g is symmetric: g[Lp - 1 - i] == g[i], the convolution is a plain
+    //  sum of products which can be handled by array kernels
     for (unsigned int n = 0;n < out.length(); n++, ++x, ++parseF) {
 	x->set();
-	const Complex* f = parseF;
-	const Complex* fe = parseF + gVect.length() - 1;
-	const float* g = gVect.data();
-	for (unsigned int conv = 0; conv < Lp_1; conv++) {
-	    Complex::sumMulFSum(*x,*f,*fe,*g);
-	    f++;
-	    fe--;
-	    g++;
-	}
-	Complex::sumMulF(*x,*f,*g);
+	Complex::sumMulF(*x,parseF,gVect.data(),gVect.length());
     }
 }
 
@@ -306,13 +880,10 @@ void SignalProcessing::generateARFCNsFreqShift(ComplexVectorVector& out,
 {
     unsigned int K = oversample ? oversample : 1;
     unsigned int Ls = gsmSlotLen(K);
-    float Fs = GSM_SYMBOL_RATE * K;
     out.resize(arfcns);
     for (unsigned int i = 0; i < out.length(); ++i) {
 	out[i].resize(Ls);
-	float fk = (4 * (float)i - 6) * 1e5;
-	float omega = (PI2 * fk) / Fs;
-	generateGMSKFreqShift(out[i],omega);
+	generateGMSKFreqShift(out[i],arfcnFreqShift(i,K));
 #ifdef XDEBUG
 	String s;
 	out[i].dump(s,SigProcUtils::appendComplex);
@@ -433,8 +1004,8 @@ void SignalProcessing::correlate(ComplexVector& out, const ComplexVector& a1, un
     for (int i = 0;i < end1; i ++, x ++) {
 	(*x).set(0,0);
 	int tindex = i - substract + a1Start;
-	for (unsigned int j = (halfL - i);j <  length;j ++)
-	    Complex::sumMulF(*x,a1[tindex + j],a2[j]);
+	unsigned int j = halfL - i;
+	Complex::sumMulF(*x,a1.data() + tindex + j,a2.data() + j,length - j);
     }
     
     unsigned int end = a1Len - end1;
@@ -442,16 +1013,151 @@ void SignalProcessing::correlate(ComplexVector& out, const ComplexVector& a1, un
     for (unsigned int i = end1;i < end; i ++, x ++) {
 	(*x).set(0,0);
 	int tindex = i - substract + a1Start;
-	for (unsigned int j = 0;j < length;j ++)
-	    Complex::sumMulF(*x,a1[tindex + j],a2[j]);
+	Complex::sumMulF(*x,a1.data() + tindex,a2.data(),length);
     }
 
     for (unsigned int i = end;i < a1Len; i ++, x ++) {
 	unsigned int lastJ = (a1Len - i) + halfL;
 	(*x).set(0,0);
 	int tindex = i - substract + a1Start;
-	for (unsigned int j = 0;j < lastJ;j ++)
-	    Complex::sumMulF(*x,a1[tindex + j],a2[j]);
+	Complex::sumMulF(*x,a1.data() + tindex,a2.data(),lastJ);
+    }
+}
+
+// Add a real value rotated by j^q to a complex number
+static inline void sumRotated(Complex& x, float v, unsigned int q)
+{
+    switch (q & 3) {
+	case 0:
+	    x.real(x.real() + v);
+	    break;
+	case 1:
+	    x.imag(x.imag() + v);
+	    break;
+	case 2:
+	    x.real(x.real() - v);
+	    break;
+	default:
+	    x.imag(x.imag() - v);
+    }
+}
+
+// Build table driven modulator data
+// Modulated data is the convolution of w[k] = v[k] * j^k (k: symbol index)
+//  with the Laurent pulse. Output sample at phase 'p' of symbol 'm' only
+//  depends on the K symbols in pulse support (m - m_modFirst .. m - m_modFirst + K - 1):
+//  x = j^(m - m_modFirst) * SUM(r=0..K-1)(v[m - m_modFirst + r] * j^r * taps[p][r])
+// Inside the burst v[k] is +/-1: the sum only depends on the bits pattern
+void SignalProcessing::initModulateTable()
+{
+    m_modSymbols = 0;
+    m_modFirst = 0;
+    m_modTaps.clear();
+    m_modTable.clear();
+    unsigned int lp = m_laurentPA.length();
+    if (!lp)
+	return;
+    // Pulse index of sample at phase 'p' for symbol 'd' back from current one
+    //  idx = c + p + d * oversample, valid in [0..lp)
+    int c = lp - 1 - lp / 2;
+    unsigned int first = (lp - 1 - c) / m_oversample;
+    unsigned int last = (c + m_oversample - 1) / m_oversample;
+    unsigned int k = first + last + 1;
+    // Keep table small
+    if (k > 8)
+	return;
+    m_modTaps.resize(m_oversample * k,true);
+    for (unsigned int p = 0; p < m_oversample; p++)
+	for (unsigned int r = 0; r < k; r++) {
+	    int idx = c + (int)p + ((int)first - (int)r) * (int)m_oversample;
+	    if (idx >= 0 && idx < (int)lp)
+		m_modTaps[p * k + r] = m_laurentPA[idx];
+	}
+    unsigned int patterns = 1 << k;
+    m_modTable.resize(m_oversample * patterns,true);
+    Complex* x = m_modTable.data();
+    for (unsigned int p = 0; p < m_oversample; p++) {
+	const float* taps = m_modTaps.data() + p * k;
+	for (unsigned int pat = 0; pat < patterns; pat++, x++)
+	    for (unsigned int r = 0; r < k; r++)
+		sumRotated(*x,(pat & (1 << r)) ? taps[r] : -taps[r],r);
+    }
+    m_modSymbols = k;
+    m_modFirst = first;
+}
+
+// Table driven modulator
+void SignalProcessing::modulateTable(ComplexVector& out, const uint8_t* b, unsigned int len,
+    FloatVector* tmpV) const
+{
+    if (!(b && len)) {
+	out.resize(m_gsmSlotLen,true);
+	return;
+    }
+    FloatVector localV;
+    if (!tmpV)
+	tmpV = &localV;
+    // Symbol values, see modulatePrepareW()
+    unsigned int nSym = sigProcIters(m_gsmSlotLen,m_oversample);
+    tmpV->resize(nSym,true);
+    float* v = tmpV->data();
+    // Symbols in [bitsStart,bitsEnd) are +/-1
+    int bitsStart = m_rampOffset / m_oversample;
+    int bitsEnd = bitsStart;
+    unsigned int n = sigProcIters(m_gsmSlotLen - m_rampOffset,m_oversample);
+    for (; len && n; --len, --n, ++b, ++bitsEnd)
+	v[bitsEnd] = *b ? 1 : -1;
+    if (m_rampOffset) {
+	v[bitsStart - 1] = v[bitsStart] * 0.5F;
+	int k = m_rampTrailIdx / m_oversample;
+	v[k] = v[k - 1] * 0.71F;
+	if (k < bitsEnd)
+	    bitsEnd = k;
+    }
+    out.resize(m_gsmSlotLen);
+    Complex* x = out.data();
+    unsigned int patterns = 1 << m_modSymbols;
+    for (unsigned int m = 0, i = 0; i < m_gsmSlotLen; m++) {
+	int k0 = (int)m - (int)m_modFirst;
+	unsigned int nSamples = SigProcUtils::min(m_oversample,m_gsmSlotLen - i);
+	i += nSamples;
+	// Use the table if all symbols in pulse support are +/-1
+	if (k0 >= bitsStart && k0 + (int)m_modSymbols <= bitsEnd) {
+	    unsigned int pat = 0;
+	    for (unsigned int r = 0; r < m_modSymbols; r++)
+		pat |= (unsigned int)(v[k0 + r] > 0) << r;
+	    // Rotate by j^k0
+	    const Complex* t = m_modTable.data() + pat;
+	    const Complex* tEnd = t + nSamples * patterns;
+	    switch (k0 & 3) {
+		case 0:
+		    for (; t != tEnd; x++, t += patterns)
+			x->set(t->real(),t->imag());
+		    break;
+		case 1:
+		    for (; t != tEnd; x++, t += patterns)
+			x->set(-t->imag(),t->real());
+		    break;
+		case 2:
+		    for (; t != tEnd; x++, t += patterns)
+			x->set(-t->real(),-t->imag());
+		    break;
+		default:
+		    for (; t != tEnd; x++, t += patterns)
+			x->set(t->imag(),-t->real());
+	    }
+	}
+	else {
+	    const float* taps = m_modTaps.data();
+	    for (unsigned int p = 0; p < nSamples; p++, x++, taps += m_modSymbols) {
+		x->set();
+		for (unsigned int r = 0; r < m_modSymbols; r++) {
+		    int idx = k0 + (int)r;
+		    if (idx >= 0 && idx < (int)nSym && v[idx] != 0)
+			sumRotated(*x,v[idx] * taps[r],idx);
+		}
+	    }
+	}
     }
 }
 
@@ -589,6 +1295,205 @@ void SigProcUtils::callbackParse(Complex& obj, const String& data)
     obj.set(r,i);
 }
 
+//
+// PolyphaseChannelizer
+//
+PolyphaseChannelizer::PolyphaseChannelizer()
+    : m_decimation(1), m_bins(0), m_fftChannels(1)
+{
+}
+
+// Set the minimum number of active channels using FFT
+// Single bin DFT: 'bins' complex multiply per channel (vector kernels)
+// FFT: (bins / 2) * log2(bins) complex multiply (scalar) for all channels
+// Vector kernels make single bin DFT faster up to about bins / 4 channels
+void PolyphaseChannelizer::setFftChannels(unsigned int count)
+{
+    if (!count)
+	count = m_bins / 4;
+    m_fftChannels = count ? count : 1;
+}
+
+// Initialize the channelizer, build the prototype filter
+// Hamming windowed sinc, cut-off fc = 1 / (2 * decimation), L = (taps - 1) / 2
+// h[i] = w[i] * sin(2 * PI * fc * (i - L)) / (PI * (i - L))
+bool PolyphaseChannelizer::initialize(unsigned int decimation, unsigned int bins,
+    unsigned int taps)
+{
+    if (!decimation || bins < 2 || (bins & (bins - 1)))
+	return false;
+    if (!taps)
+	taps = 2 * bins + 1;
+    else if (taps < 3)
+	taps = 3;
+    taps |= 1;
+    m_decimation = decimation;
+    m_bins = bins;
+    m_filter.resize(taps);
+    float fc = 0.5F / decimation;
+    float center = (float)(taps / 2);
+    float sum = 0;
+    for (unsigned int i = 0; i < taps; i++) {
+	float n = (float)i - center;
+	float omega = 0.54 - 0.46 * ::cosf(PI2 * i / (taps - 1));
+	if (n)
+	    m_filter[i] = omega * ::sinf(PI2 * fc * n) / (PI * n);
+	else
+	    m_filter[i] = omega * 2 * fc;
+	sum += m_filter[i];
+    }
+    for (unsigned int i = 0; i < taps; i++)
+	m_filter[i] /= sum;
+    // FFT data
+    m_twiddle.resize(m_bins / 2);
+    for (unsigned int k = 0; k < m_twiddle.length(); k++)
+	Complex::exp(m_twiddle[k],0,-PI2 * k / m_bins);
+    m_bitRev.resize(m_bins);
+    unsigned int bits = 0;
+    for (unsigned int n = m_bins; n > 1; n >>= 1)
+	bits++;
+    for (unsigned int i = 0; i < m_bins; i++) {
+	unsigned int r = 0;
+	for (unsigned int b = 0; b < bits; b++)
+	    if (i & (1 << b))
+		r |= 1 << (bits - 1 - b);
+	m_bitRev[i] = r;
+    }
+    m_fold.resize(m_bins);
+    m_in.clear();
+    setFftChannels();
+    setChannels(m_chanFreqShift.data(),m_chanFreqShift.length());
+    return true;
+}
+
+// Set channels
+// Channel bin: b = round(freqShift * bins / (2 * PI))
+// Single bin DFT vector: dft[q] = e ^ (-j * 2 * PI * b * q / bins)
+void PolyphaseChannelizer::setChannels(const float* freqShift, unsigned int count)
+{
+    if (!freqShift)
+	count = 0;
+    if (freqShift != m_chanFreqShift.data())
+	m_chanFreqShift.assign(freqShift,count);
+    m_chanBin.resize(count);
+    m_chanActive.resize(count,true);
+    m_chanDft.resize(count);
+    m_chanRot.resize(count);
+    if (!m_bins)
+	return;
+    for (unsigned int i = 0; i < count; i++) {
+	int b = (int)::floor(m_chanFreqShift[i] * m_bins / PI2 + 0.5);
+	b %= (int)m_bins;
+	if (b < 0)
+	    b += m_bins;
+	m_chanBin[i] = b;
+	ComplexVector& dft = m_chanDft[i];
+	dft.resize(m_bins);
+	for (unsigned int q = 0; q < m_bins; q++)
+	    Complex::exp(dft[q],0,-PI2 * ((b * q) % m_bins) / m_bins);
+	m_chanRot[i].clear();
+    }
+}
+
+// Channelize data
+// Filter window for output sample n: x[n * D - L .. n * D + L]
+// Fold window into bins: u[q] = SUM(l)(h[l * bins + q] * x[n * D - L + l * bins + q])
+// Channel output: y[n] = DFT(u)[b] * e ^ (-j * (freqShift * n * D + 2 * PI * b * L / bins))
+bool PolyphaseChannelizer::process(const ComplexVector& in, ComplexVectorVector& out)
+{
+    if (out.length() != channels())
+	out.resize(channels());
+    unsigned int len = in.length() / m_decimation;
+    unsigned int active = 0;
+    for (unsigned int i = 0; i < channels(); i++) {
+	if (!m_chanActive[i])
+	    continue;
+	active++;
+	if (m_chanRot[i].length() < len)
+	    buildRotation(i,len);
+	out[i].resize(len);
+    }
+    if (!(len && active && m_bins))
+	return false;
+    unsigned int taps = m_filter.length();
+    if (m_in.length() != in.length() + taps - 1)
+	m_in.resize(in.length() + taps - 1,true);
+    m_in.copy(in.data(),in.length(),taps / 2);
+    bool useFft = active >= m_fftChannels;
+    const Complex* x = m_in.data();
+    const float* h = m_filter.data();
+    Complex* u = m_fold.data();
+    for (unsigned int n = 0; n < len; n++, x += m_decimation) {
+	// Fold the filter window into bins
+	unsigned int tap = SigProcUtils::min(m_bins,taps);
+	for (unsigned int q = 0; q < tap; q++)
+	    Complex::multiplyF(u[q],x[q],h[q]);
+	for (unsigned int q = tap; q < m_bins; q++)
+	    u[q].set();
+	while (tap < taps) {
+	    unsigned int count = SigProcUtils::min(m_bins,taps - tap);
+	    for (unsigned int q = 0; q < count; q++, tap++)
+		Complex::sumMulF(u[q],x[tap],h[tap]);
+	}
+	if (useFft)
+	    fft(u);
+	for (unsigned int c = 0; c < channels(); c++) {
+	    if (!m_chanActive[c])
+		continue;
+	    Complex& y = out[c][n];
+	    if (useFft)
+		y = u[m_chanBin[c]];
+	    else {
+		y.set();
+		Complex::sumMul(y,u,m_bins,m_chanDft[c].data(),m_bins);
+	    }
+	    Complex::multiply(y,y,m_chanRot[c][n]);
+	}
+    }
+    return true;
+}
+
+// Build channel output rotation vector
+// Compensate the residual frequency (bin center to channel center) and filter center
+// rot[n] = e ^ (-j * (freqShift * n * D + 2 * PI * b * L / bins))
+void PolyphaseChannelizer::buildRotation(unsigned int index, unsigned int len)
+{
+    ComplexVector& rot = m_chanRot[index];
+    rot.resize(len);
+    double step = (double)m_chanFreqShift[index] * m_decimation;
+    double phase = PI2 * m_chanBin[index] * (m_filter.length() / 2) / m_bins;
+    for (unsigned int n = 0; n < len; n++)
+	Complex::exp(rot[n],0,-(float)::fmod(phase + step * n,PI2));
+}
+
+// In place radix 2 FFT (decimation in time)
+// X[k] = SUM(n=0..bins-1)(x[n] * e ^ (-j * 2 * PI * k * n / bins))
+void PolyphaseChannelizer::fft(Complex* data)
+{
+    const int* rev = m_bitRev.data();
+    for (unsigned int i = 0; i < m_bins; i++) {
+	unsigned int j = rev[i];
+	if (i < j) {
+	    Complex tmp = data[i];
+	    data[i] = data[j];
+	    data[j] = tmp;
+	}
+    }
+    const Complex* tw = m_twiddle.data();
+    for (unsigned int half = 1, step = m_bins / 2; half < m_bins; half <<= 1, step >>= 1) {
+	for (unsigned int i = 0; i < m_bins; i += 2 * half) {
+	    Complex* a = data + i;
+	    Complex* b = a + half;
+	    for (unsigned int k = 0; k < half; k++, a++, b++) {
+		Complex t;
+		Complex::multiply(t,*b,tw[k * step]);
+		Complex::diff(*b,*a,t);
+		*a += t;
+	    }
+	}
+    }
+}
+
 void Equalizer::defaultEqualize(FloatVector& dataOut, const ComplexVector& in1, const ComplexVector& in2, int in2len)
 {
     if (dataOut.length() != in1.length())
@@ -641,6 +1546,171 @@ void Equalizer::defaultEqualize(FloatVector& dataOut, const ComplexVector& in1,
     }
 }
 
+// Reduced state MLSE
+// The trellis state holds the last (EQ_MLSE_TAPS - 1) symbols, a branch adds the newest one
+// Branch index: bit 0 is the newest symbol (channel tap -EQ_MLSE_PRE),
+//  bit (EQ_MLSE_TAPS - 1) is the oldest one (channel tap +EQ_MLSE_PRE)
+// Branch s * 2 + u leaves state s, reaches state (s * 2 + u) % EQ_MLSE_STATES
+#define EQ_MLSE_TAPS 5
+#define EQ_MLSE_PRE ((EQ_MLSE_TAPS - 1) / 2)
+#define EQ_MLSE_STATES (1 << (EQ_MLSE_TAPS - 1))
+#define EQ_MLSE_HALF (EQ_MLSE_STATES / 2)
+#define EQ_MLSE_BRANCHES (EQ_MLSE_STATES * 2)
+
+// Branch metrics are kept in 4 blocks of EQ_MLSE_HALF values to let the compiler
+//  vectorize the recursions (no strided access). Value p in block:
+//  0: branch 2p, 1: branch 2p + 1,
+//  2: branch 2p + EQ_MLSE_STATES, 3: branch 2p + 1 + EQ_MLSE_STATES
+// Block 0/1 branches leave state p, block 2/3 branches leave state p + EQ_MLSE_HALF
+// Block 0/2 branches reach state 2p (newest symbol -1), block 1/3 reach state 2p + 1
+static inline unsigned int mlseBranch(unsigned int j)
+{
+    unsigned int b = j / EQ_MLSE_HALF;
+    return (b >> 1) * EQ_MLSE_STATES + 2 * (j % EQ_MLSE_HALF) + (b & 1);
+}
+
+// Calculate the branch metrics (squared distance) for a received sample
+static inline void mlseBranchMetrics(float* bm, const Complex& y, const float* pRe,
+    const float* pIm)
+{
+    float re = y.real();
+    float im = y.imag();
+    for (unsigned int i = 0; i < EQ_MLSE_BRANCHES; i++) {
+	float dr = re - pRe[i];
+	float di = im - pIm[i];
+	bm[i] = dr * dr + di * di;
+    }
+}
+
+// Forward recursion: calculate state metrics after a sample
+static inline void mlseForward(float* cur, const float* prev, const float* bm)
+{
+    const float* b0 = bm;
+    const float* b1 = b0 + EQ_MLSE_HALF;
+    const float* b2 = b1 + EQ_MLSE_HALF;
+    const float* b3 = b2 + EQ_MLSE_HALF;
+    const float* prevHi = prev + EQ_MLSE_HALF;
+    float even[EQ_MLSE_HALF];
+    float odd[EQ_MLSE_HALF];
+    for (unsigned int p = 0; p < EQ_MLSE_HALF; p++) {
+	float m0 = prev[p] + b0[p];
+	float m1 = prevHi[p] + b2[p];
+	even[p] = m0 < m1 ? m0 : m1;
+	m0 = prev[p] + b1[p];
+	m1 = prevHi[p] + b3[p];
+	odd[p] = m0 < m1 ? m0 : m1;
+    }
+    // Keep values small: only metric differences are relevant
+    float ref = even[0];
+    for (unsigned int p = 0; p < EQ_MLSE_HALF; p++) {
+	cur[2 * p] = even[p] - ref;
+	cur[2 * p + 1] = odd[p] - ref;
+    }
+}
+
+// Backward recursion: calculate state metrics before a sample
+// Return the soft output for sample newest symbol: best path metric with
+//  symbol -1 minus best path metric with symbol 1
+static inline float mlseBackward(float* beta, const float* alpha, const float* bm)
+{
+    const float* b0 = bm;
+    const float* b1 = b0 + EQ_MLSE_HALF;
+    const float* b2 = b1 + EQ_MLSE_HALF;
+    const float* b3 = b2 + EQ_MLSE_HALF;
+    const float* alphaHi = alpha + EQ_MLSE_HALF;
+    float even[EQ_MLSE_HALF];
+    float odd[EQ_MLSE_HALF];
+    for (unsigned int p = 0; p < EQ_MLSE_HALF; p++) {
+	even[p] = beta[2 * p];
+	odd[p] = beta[2 * p + 1];
+    }
+    float lo[EQ_MLSE_HALF];
+    float hi[EQ_MLSE_HALF];
+    float t0[EQ_MLSE_HALF];
+    float t1[EQ_MLSE_HALF];
+    for (unsigned int p = 0; p < EQ_MLSE_HALF; p++) {
+	float p0 = b0[p] + even[p];
+	float p1 = b1[p] + odd[p];
+	float p2 = b2[p] + even[p];
+	float p3 = b3[p] + odd[p];
+	lo[p] = p0 < p1 ? p0 : p1;
+	hi[p] = p2 < p3 ? p2 : p3;
+	p0 += alpha[p];
+	p1 += alpha[p];
+	p2 += alphaHi[p];
+	p3 += alphaHi[p];
+	t0[p] = p0 < p2 ? p0 : p2;
+	t1[p] = p1 < p3 ? p1 : p3;
+    }
+    float ref = lo[0];
+    for (unsigned int p = 0; p < EQ_MLSE_HALF; p++) {
+	beta[p] = lo[p] - ref;
+	beta[p + EQ_MLSE_HALF] = hi[p] - ref;
+    }
+    float min0 = t0[0];
+    float min1 = t1[0];
+    for (unsigned int p = 1; p < EQ_MLSE_HALF; p++) {
+	min0 = min0 < t0[p] ? min0 : t0[p];
+	min1 = min1 < t1[p] ? min1 : t1[p];
+    }
+    return min0 - min1;
+}
+
+void Equalizer::mlseEqualize(FloatVector& dataOut, const ComplexVector& in1, const ComplexVector& in2, int in2len)
+{
+    unsigned int len = in1.length();
+    if (in2len < EQ_MLSE_TAPS || (int)in2.length() < in2len || len < EQ_MLSE_TAPS) {
+	defaultEqualize(dataOut,in1,in2,in2len);
+	return;
+    }
+    if (dataOut.length() != len)
+	dataOut.resize(len);
+    // Expected received value for each branch
+    // The channel estimate is built by correlation with a normalized training
+    //  sequence: it is already scaled to received signal level
+    const Complex* h = in2.data() + (in2len - 1) / 2 - EQ_MLSE_PRE;
+    float pRe[EQ_MLSE_BRANCHES];
+    float pIm[EQ_MLSE_BRANCHES];
+    for (unsigned int j = 0; j < EQ_MLSE_BRANCHES; j++) {
+	unsigned int i = mlseBranch(j);
+	Complex c;
+	for (unsigned int m = 0; m < EQ_MLSE_TAPS; m++) {
+	    if ((i >> m) & 1)
+		c += h[m];
+	    else
+		c -= h[m];
+	}
+	pRe[j] = c.real();
+	pIm[j] = c.imag();
+    }
+    // Forward recursion: keep state metrics for each sample, unknown start state
+    FloatVector alpha((len + 1) * EQ_MLSE_STATES);
+    float* a = alpha.data();
+    for (unsigned int s = 0; s < EQ_MLSE_STATES; s++)
+	a[s] = 0;
+    float bm[EQ_MLSE_BRANCHES];
+    for (unsigned int t = 0; t < len; t++, a += EQ_MLSE_STATES) {
+	mlseBranchMetrics(bm,in1[t],pRe,pIm);
+	mlseForward(a + EQ_MLSE_STATES,a,bm);
+    }
+    // Backward recursion, unknown end state
+    // Sample t holds the newest symbol of t + EQ_MLSE_PRE
+    float beta[EQ_MLSE_STATES];
+    for (unsigned int s = 0; s < EQ_MLSE_STATES; s++)
+	beta[s] = 0;
+    float* f = dataOut.data();
+    for (unsigned int i = 0; i < EQ_MLSE_PRE; i++)
+	f[i] = 0;
+    for (unsigned int t = len; t > 0; ) {
+	t--;
+	a -= EQ_MLSE_STATES;
+	mlseBranchMetrics(bm,in1[t],pRe,pIm);
+	float soft = mlseBackward(beta,a,bm);
+	if (t + EQ_MLSE_PRE < len)
+	    f[t + EQ_MLSE_PRE] = soft;
+    }
+}
+
 // Append float value to a String (using %g format)
 String& SigProcUtils::appendFloat(String& dest, const float& val, const char* sep)
 {
@@ -36,6 +36,7 @@ namespace TelEngine {
 class SigProcUtils;                      // Utility functions
 class Complex;                           // A Complex (float) number
 class SignalProcessing;                  // Signal processing
+class PolyphaseChannelizer;              // Polyphase filter bank channelizer
 
 #define GSM_SYMBOL_RATE (13e6 / 48) // 13 * 10^6 / 48
 #define BITS_PER_TIMESLOT 156.25
@@ -68,6 +69,20 @@ public:
     static inline unsigned int min(unsigned int v1, unsigned int v2, unsigned int v3)
 	{ return min(v1,min(v2,v3)); }
 
+    /**
+     * Hint the CPU we are in a busy wait loop.
+     * Lowers power usage and lets a sibling hardware thread run
+     */
+    static inline void cpuRelax() {
+#if defined(__i386__) || defined(__x86_64__)
+	    __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+	    __asm__ __volatile__("yield" ::: "memory");
+#else
+	    __asm__ __volatile__("" ::: "memory");
+#endif
+	}
+
     /**
      * Copy memory
      * @param dest Destination buffer
@@ -335,12 +350,8 @@ public:
      * @param c2 Second array
      * @param len2 Second array length
      */
-    static inline void multiply(Complex* dest, unsigned int len,
-	const Complex* c1, unsigned int len1, const Complex* c2, unsigned int len2) {
-	    unsigned int n = SigProcUtils::min(len,len1,len2);
-	    for (; n; --n, ++dest, ++c1, ++c2)
-		multiply(*dest,*c1,*c2);
-	}
+    static void multiply(Complex* dest, unsigned int len,
+	const Complex* c1, unsigned int len1, const Complex* c2, unsigned int len2);
 
     /**
      * Multiply two complex arrays.
@@ -432,12 +443,8 @@ public:
      * @param len2 Second array length
      * @return Destination number address
      */
-    static inline Complex& sumMul(Complex& dest, const Complex* c1, unsigned int len1,
-	const Complex* c2, unsigned int len2){
-	    for (unsigned int n = SigProcUtils::min(len1,len2); n; --n, ++c1, ++c2)
-		sumMul(dest,*c1,*c2);
-	    return dest;
-	}
+    static Complex& sumMul(Complex& dest, const Complex* c1, unsigned int len1,
+	const Complex* c2, unsigned int len2);
 
     /**
      * Compute the sum of dest and product of c1,c2
@@ -449,12 +456,8 @@ public:
      * @param c2 Second array
      * @param len2 Second array length
      */
-    static inline void sumMul(Complex* dest, unsigned int len,
-	const Complex* c1, unsigned int len1, const Complex* c2, unsigned int len2) {
-	    unsigned int n = SigProcUtils::min(len,len1,len2);
-	    for (; n; --n, ++dest, ++c1, ++c2)
-		sumMul(*dest,*c1,*c2);
-	}
+    static void sumMul(Complex* dest, unsigned int len,
+	const Complex* c1, unsigned int len1, const Complex* c2, unsigned int len2);
 
     /**
      * Multiply c1 by f. Add the result to c
@@ -465,6 +468,18 @@ public:
     static inline void sumMulF(Complex& c, const Complex& c1, float f)
 	{ c.set(c.real() + c1.real() * f,c.imag() + c1.imag() * f); }
 
+    /**
+     * Compute the sum of product between a complex array and a float array
+     * E.g. dest = dest + SUM(c[i] * f[i])
+     * @param dest Destination number
+     * @param c Pointer to complex array
+     * @param f Pointer to float array
+     * @param len The number of elements to process
+     * @return Destination number address
+     */
+    static Complex& sumMulF(Complex& dest, const Complex* c, const float* f,
+	unsigned int len);
+
     /**
      * Calculate : c = c + (c1 + c2) * f
      * @param c Destination number
@@ -548,6 +563,28 @@ public:
     static void dump(String& dest, const Complex* c, unsigned int len,
 	const char* sep = " ");
 
+    /**
+     * Retrieve the name of the array processing kernels currently in use
+     * @return Kernels name (scalar, sse3, avx2, avx512, neon)
+     */
+    static const char* kernels();
+
+    /**
+     * Select the array processing kernels.
+     * Kernels not supported by the running CPU can't be selected
+     * @param name Kernels name, empty or 'auto' to select the best available
+     * @return True on success, false if unknown or not supported
+     */
+    static bool setKernels(const char* name = 0);
+
+    /**
+     * Build the list of array processing kernels supported by the running CPU
+     * @param dest Destination string
+     * @param sep Optional separator between names
+     * @return Destination string address
+     */
+    static String& supportedKernels(String& dest, const char* sep = ",");
+
 private:
     float m_real;                        // The Real part of the complex number
     float m_imag;                        // The imaginary part of the complex numbers
@@ -1179,27 +1216,49 @@ typedef SigProcVector<ComplexVector,false,false> ComplexVectorVector;
 
 /**
  * Store objects to avoid re-alloc/re-init for large objects.
+ * The store is a fixed capacity lock-free free list (bounded multi producer/multi consumer
+ *  array queue): objects can be retrieved and stored back from any thread without locking.
+ * Objects may be preallocated when the store is set up: the store will allocate new
+ *  objects only when exhausted.
  * Template object must inherit GenObject
  * @short Object store/factory
  */
 template <class Obj> class ObjStore : protected String
 {
 public:
+    /**
+     * Object initializer used when preallocating objects
+     * @param obj Object to initialize
+     * @param param Initializer parameter
+     */
+    typedef void (*InitFunc)(Obj* obj, unsigned int param);
+
     /**
      * Constructor
      * @param maxLen Maximum number of objects to store
+     *  (the capacity is rounded up to the next power of 2)
      * @param name Store name
      */
     inline ObjStore(unsigned int maxLen, const char* name)
-	: m_name(name), m_mutex(false,m_name.c_str()),
+	: m_name(name), m_cells(0), m_mask(0),
+	m_enqueue(0), m_dequeue(0),
+	m_used(0), m_highWater(0), m_exhausted(0),
+	m_requested(0), m_created(0), m_returned(0), m_deleted(0) {
 #ifdef SIGPROC_OBJ_STORE_DISABLE
-	m_max(0),
-#else
-	m_max(maxLen),
+	    maxLen = 0;
 #endif
-	m_count(0),
-	m_requested(0), m_created(0), m_returned(0), m_deleted(0)
-	{}
+	    if (!maxLen)
+		return;
+	    unsigned int n = 1;
+	    while (n < maxLen)
+		n <<= 1;
+	    m_cells = new Cell[n];
+	    for (unsigned int i = 0; i < n; i++) {
+		m_cells[i].seq = i;
+		m_cells[i].obj = 0;
+	    }
+	    m_mask = n - 1;
+	}
 
     /**
      * Destructor
@@ -1207,34 +1266,112 @@ public:
     ~ObjStore() {
 	    if (m_requested)
 		printStatistics();
+	    for (Obj* o = pop(); o; o = pop())
+		TelEngine::destruct(o);
+	    if (m_cells)
+		delete[] m_cells;
 	}
-	
+
     /**
      * Print statistics
      */
     inline void printStatistics() {
 #ifdef SIGPROC_OBJ_STORE_DEBUG
-	    Output("ObjStore(%s) created=" FMT64U "/" FMT64U " deleted=" FMT64U "/" FMT64U,
-		m_name.c_str(),m_created,m_requested,m_deleted,m_returned);
+	    Output("ObjStore(%s) created=" FMT64U "/" FMT64U " deleted=" FMT64U "/" FMT64U
+		" high_water=%u exhausted=%u",
+		m_name.c_str(),m_created,m_requested,m_deleted,m_returned,
+		highWater(),exhausted());
 #endif
 	}
 
+    /**
+     * Retrieve the store capacity
+     * @return Maximum number of objects kept in store
+     */
+    inline unsigned int capacity() const
+	{ return m_cells ? m_mask + 1 : 0; }
+
+    /**
+     * Retrieve the maximum number of objects retrieved from store and not returned
+     * @return Objects high-water mark
+     */
+    inline unsigned int highWater() const
+	{ return __atomic_load_n(&m_highWater,__ATOMIC_RELAXED); }
+
+    /**
+     * Retrieve the number of requests made when the store was empty
+     *  (a new object was allocated)
+     * @return The number of times the store was exhausted
+     */
+    inline unsigned int exhausted() const
+	{ return __atomic_load_n(&m_exhausted,__ATOMIC_RELAXED); }
+
+    /**
+     * Retrieve the number of objects in store
+     * @return The number of objects in store (not accurate when changed by other threads)
+     */
+    inline unsigned int count() const
+	{ return __atomic_load_n(&m_enqueue,__ATOMIC_RELAXED) -
+	    __atomic_load_n(&m_dequeue,__ATOMIC_RELAXED); }
+
+    /**
+     * Allocate objects and put them in store until it holds the requested number of objects.
+     * This method should be called before the store is used
+     * @param count The number of objects to keep in store
+     * @param init Optional object initializer
+     * @param param Initializer parameter
+     * @return The number of objects added to store
+     */
+    inline unsigned int prealloc(unsigned int count, InitFunc init = 0,
+	unsigned int param = 0) {
+	    unsigned int n = 0;
+	    for (unsigned int crt = this->count(); crt < count; crt++, n++) {
+		Obj* o = new Obj;
+		if (init)
+		    (*init)(o,param);
+		if (!push(o)) {
+		    TelEngine::destruct(o);
+		    break;
+		}
+	    }
+	    return n;
+	}
+
+    /**
+     * Retrieve the number of objects retrieved from store and not returned yet
+     * @return The number of objects in use
+     */
+    inline unsigned int used() const
+	{ return __atomic_load_n(&m_used,__ATOMIC_RELAXED); }
+
+    /**
+     * Reset usage counters (high-water mark and exhausted counter).
+     * The high-water mark restarts from the number of objects currently in use
+     */
+    inline void resetCounters() {
+	    __atomic_store_n(&m_highWater,used(),__ATOMIC_RELAXED);
+	    __atomic_store_n(&m_exhausted,0,__ATOMIC_RELAXED);
+	}
+
     /**
      * Retrieve an object from store
      * @return Valid pointer (may be a newly created one)
      */
     inline Obj* get() {
 #ifdef SIGPROC_OBJ_STORE_DEBUG
-	    m_requested++;
+	    __atomic_add_fetch(&m_requested,1,__ATOMIC_RELAXED);
 #endif
-	    Lock lck(m_mutex);
-	    Obj* o = static_cast<Obj*>(m_list.remove(false));
-	    if (o) {
-		m_count--;
+	    unsigned int used = __atomic_add_fetch(&m_used,1,__ATOMIC_RELAXED);
+	    unsigned int hw = __atomic_load_n(&m_highWater,__ATOMIC_RELAXED);
+	    while (used > hw && !__atomic_compare_exchange_n(&m_highWater,&hw,
+		used,true,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+		;
+	    Obj* o = pop();
+	    if (o)
 		return o;
-	    }
+	    __atomic_add_fetch(&m_exhausted,1,__ATOMIC_RELAXED);
 #ifdef SIGPROC_OBJ_STORE_DEBUG
-	    m_created++;
+	    __atomic_add_fetch(&m_created,1,__ATOMIC_RELAXED);
 #endif
 	    return new Obj;
 	}
@@ -1247,27 +1384,104 @@ public:
 	    if (!o)
 		return;
 #ifdef SIGPROC_OBJ_STORE_DEBUG
-	    m_returned++;
+	    __atomic_add_fetch(&m_returned,1,__ATOMIC_RELAXED);
 #endif
-	    Lock lck(m_mutex);
-	    if (m_count < m_max) {
-		m_list.insert(o);
-		m_count++;
+	    // Objects not retrieved from store (allocated by caller) are not counted as used
+	    unsigned int used = __atomic_load_n(&m_used,__ATOMIC_RELAXED);
+	    while (used && !__atomic_compare_exchange_n(&m_used,&used,used - 1,true,
+		__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+		;
+	    if (push(o)) {
 		o = 0;
 		return;
 	    }
 #ifdef SIGPROC_OBJ_STORE_DEBUG
-	    m_deleted++;
+	    __atomic_add_fetch(&m_deleted,1,__ATOMIC_RELAXED);
 #endif
 	    TelEngine::destruct(o);
 	}
 
 private:
+    struct Cell {
+	unsigned int seq;
+	Obj* obj;
+    };
+
+    // Put an object in free list, return false if full
+    inline bool push(Obj* o) {
+	    if (!m_cells)
+		return false;
+	    unsigned int pos = __atomic_load_n(&m_enqueue,__ATOMIC_RELAXED);
+	    while (true) {
+		Cell& c = m_cells[pos & m_mask];
+		int dif = (int)(__atomic_load_n(&c.seq,__ATOMIC_ACQUIRE) - pos);
+		if (!dif) {
+		    if (__atomic_compare_exchange_n(&m_enqueue,&pos,pos + 1,true,
+			__ATOMIC_RELAXED,__ATOMIC_RELAXED)) {
+			c.obj = o;
+			__atomic_store_n(&c.seq,pos + 1,__ATOMIC_RELEASE);
+			return true;
+		    }
+		}
+		else if (dif < 0) {
+		    // Full or a consumer is still releasing the cell
+		    int n = (int)(pos - __atomic_load_n(&m_dequeue,__ATOMIC_ACQUIRE));
+		    if (n > (int)m_mask)
+			return false;
+		    if (n >= 0)
+			SigProcUtils::cpuRelax();
+		    pos = __atomic_load_n(&m_enqueue,__ATOMIC_RELAXED);
+		}
+		else
+		    pos = __atomic_load_n(&m_enqueue,__ATOMIC_RELAXED);
+	    }
+	    return false;
+	}
+
+    // Retrieve an object from free list, return 0 if empty
+    inline Obj* pop() {
+	    if (!m_cells)
+		return 0;
+	    unsigned int pos = __atomic_load_n(&m_dequeue,__ATOMIC_RELAXED);
+	    while (true) {
+		Cell& c = m_cells[pos & m_mask];
+		int dif = (int)(__atomic_load_n(&c.seq,__ATOMIC_ACQUIRE) - (pos + 1));
+		if (!dif) {
+		    if (__atomic_compare_exchange_n(&m_dequeue,&pos,pos + 1,true,
+			__ATOMIC_RELAXED,__ATOMIC_RELAXED)) {
+			Obj* o = c.obj;
+			c.obj = 0;
+			__atomic_store_n(&c.seq,pos + m_mask + 1,__ATOMIC_RELEASE);
+			return o;
+		    }
+		}
+		else if (dif < 0) {
+		    // Empty or a producer is still filling the cell
+		    int n = (int)(__atomic_load_n(&m_enqueue,__ATOMIC_ACQUIRE) - pos);
+		    if (!n)
+			return 0;
+		    if (n > 0)
+			SigProcUtils::cpuRelax();
+		    pos = __atomic_load_n(&m_dequeue,__ATOMIC_RELAXED);
+		}
+		else
+		    pos = __atomic_load_n(&m_dequeue,__ATOMIC_RELAXED);
+	    }
+	    return 0;
+	}
+
     String m_name;
-    Mutex m_mutex;
-    ObjList m_list;
-    unsigned int m_max;
-    unsigned int m_count;
+    Cell* m_cells;
+    unsigned int m_mask;
+    // Keep producer and consumer positions in separate cache lines
+    char m_pad0[64];
+    unsigned int m_enqueue;
+    char m_pad1[64];
+    unsigned int m_dequeue;
+    char m_pad2[64];
+    unsigned int m_used;                 // Objects retrieved and not returned
+    unsigned int m_highWater;
+    unsigned int m_exhausted;
     uint64_t m_requested;
     uint64_t m_created;
     uint64_t m_returned;
@@ -1352,7 +1566,9 @@ public:
 	LaurentPATable lpaTbl = LaurentPADef);
 
     /**
-     * Modulate bits using optimized algorithm
+     * Modulate bits using optimized algorithm.
+     * Output samples are taken from a table of waveform segments indexed by
+     *  the bits in Laurent pulse support, computed only around power ramping
      * @param out Destination vector for modulated data
      * @param bits Input bits (it will be used as received, no 0/1 checking is done)
      * @param len Input bits buffer length
@@ -1426,6 +1642,19 @@ public:
     static void generateLaurentPulseAproximation(FloatVector& out,
 	LaurentPATable lpaTbl = LaurentPADef, unsigned int oversample = 1);
 
+    /**
+     * Retrieve the ARFCN frequency shift value
+     * fk = (4 * k - 6)(100 * 10^3), omegaK = (2 * PI * fk) / Fs
+     * @param arfcn ARFCN index
+     * @param oversample The oversample value
+     * @return ARFCN frequency shift value (radians per sample)
+     */
+    static inline float arfcnFreqShift(unsigned int arfcn, unsigned int oversample = 1) {
+	    float fk = (4 * (float)arfcn - 6) * 1e5;
+	    float Fs = GSM_SYMBOL_RATE * (oversample ? oversample : 1);
+	    return (PI2 * fk) / Fs;
+	}
+
     /**
      * Generate ARFCNs frequency shifting vectors
      * @param out The output vector. It will be resized to required length
@@ -1548,6 +1777,11 @@ private:
     // Return true on success, false on failure (no input data)
     bool modulatePrepareW(ComplexVector& out, ComplexVector& tmpW,
 	const uint8_t* b, unsigned int len, FloatVector* tmpV) const;
+    // Build table driven modulator data
+    void initModulateTable();
+    // Table driven modulator
+    void modulateTable(ComplexVector& out, const uint8_t* b, unsigned int len,
+	FloatVector* tmpV) const;
 
     unsigned int m_oversample;           // Oversampling
     unsigned int m_gsmSlotLen;           // GSM slot length
@@ -1556,30 +1790,178 @@ private:
     // Modulate data
     unsigned int m_rampOffset;           // Power ramping offset
     unsigned int m_rampTrailIdx;         // Index of power ramping trailing edge
+    unsigned int m_modSymbols;           // Symbols in pulse support, 0 if no table
+    unsigned int m_modFirst;             // First symbol in support, back from current one
+    FloatVector m_modTaps;               // Pulse taps by sample phase and symbol
+    ComplexVector m_modTable;            // Waveform by sample phase and bits pattern
+};
+
+/**
+ * Polyphase filter bank channelizer.
+ * Split a wideband signal into narrowband channels in one pass.
+ * The input is filtered by a low pass prototype filter whose polyphase
+ *  components are shared by all channels. Each output sample folds the filter
+ *  output into 'bins' branches. Channels are extracted from the folded data by
+ *  FFT (many channels) or single bin DFT (few channels).
+ * Only one output sample per decimation step is computed.
+ * Channel frequencies are rounded to the nearest bin center: the residual
+ *  frequency offset is corrected after decimation
+ * NOTE: Class methods are not thread safe
+ * @short Polyphase filter bank channelizer
+ */
+class PolyphaseChannelizer
+{
+public:
+    /**
+     * Constructor
+     */
+    PolyphaseChannelizer();
+
+    /**
+     * Retrieve the decimation factor
+     * @return Decimation factor
+     */
+    inline unsigned int decimation() const
+	{ return m_decimation; }
+
+    /**
+     * Retrieve the number of filter bank bins
+     * @return The number of bins (FFT length)
+     */
+    inline unsigned int bins() const
+	{ return m_bins; }
+
+    /**
+     * Retrieve the prototype filter length
+     * @return Prototype filter length
+     */
+    inline unsigned int taps() const
+	{ return m_filter.length(); }
+
+    /**
+     * Retrieve the number of channels
+     * @return The number of channels
+     */
+    inline unsigned int channels() const
+	{ return m_chanBin.length(); }
+
+    /**
+     * Retrieve the minimum number of active channels using FFT
+     * @return Minimum number of active channels using FFT
+     */
+    inline unsigned int fftChannels() const
+	{ return m_fftChannels; }
+
+    /**
+     * Set the minimum number of active channels using FFT.
+     * Channels are extracted using single bin DFT below this value
+     * @param count Minimum number of active channels using FFT, 0 for default
+     */
+    void setFftChannels(unsigned int count = 0);
+
+    /**
+     * Check if a channel is active
+     * @param index Channel index
+     * @return True if the channel is active
+     */
+    inline bool active(unsigned int index) const
+	{ return index < m_chanActive.length() && m_chanActive[index]; }
+
+    /**
+     * Set channel active flag (the channel will be processed)
+     * @param index Channel index
+     * @param on True to activate, false to deactivate
+     */
+    inline void setActive(unsigned int index, bool on = true) {
+	    if (index < m_chanActive.length())
+		m_chanActive[index] = on ? 1 : 0;
+	}
+
+    /**
+     * Initialize the channelizer, build the prototype filter.
+     * The prototype filter cut-off is half the output sample rate, unity DC gain
+     * @param decimation Decimation factor (input samples per output sample)
+     * @param bins The number of filter bank bins, must be a power of 2
+     * @param taps Prototype filter length, 0 to use 2 * bins + 1
+     *  (it will be forced to an odd value to avoid fractional delay)
+     * @return True on success, false on failure (invalid parameters)
+     */
+    bool initialize(unsigned int decimation, unsigned int bins = 32,
+	unsigned int taps = 0);
+
+    /**
+     * Set channels. All channels are inactive after this call
+     * @param freqShift Channels center frequency (radians per input sample)
+     * @param count The number of channels
+     */
+    void setChannels(const float* freqShift, unsigned int count);
+
+    /**
+     * Channelize data.
+     * Output sample n is centered on input sample n * decimation (no delay).
+     * Input is assumed to be padded with 0 on both sides
+     * @param in Input data
+     * @param out Output vectors (one for each channel). It will be resized if its
+     *  length is not the number of channels. Only active channels data is set
+     * @return True on success, false if there is nothing to process
+     */
+    bool process(const ComplexVector& in, ComplexVectorVector& out);
+
+private:
+    // Build channel output rotation vector
+    void buildRotation(unsigned int index, unsigned int len);
+    // In place FFT of folded data
+    void fft(Complex* data);
+
+    unsigned int m_decimation;           // Decimation factor
+    unsigned int m_bins;                 // Number of bins (FFT length)
+    unsigned int m_fftChannels;          // Minimum active channels to use FFT
+    FloatVector m_filter;                // Prototype filter coefficients
+    ComplexVector m_in;                  // Zero padded input data
+    ComplexVector m_fold;                // Folded filter output
+    ComplexVector m_twiddle;             // FFT twiddle factors
+    IntVector m_bitRev;                  // FFT bit reversed indexes
+    FloatVector m_chanFreqShift;         // Channel center frequency
+    IntVector m_chanBin;                 // Channel bin
+    IntVector m_chanActive;              // Channel active flag
+    ComplexVectorVector m_chanDft;       // Channel single bin DFT vector
+    ComplexVectorVector m_chanRot;       // Channel output rotation
 };
 
+
 class Equalizer
 {
 public:
     enum {
 	Default,
+	Mlse,
     };
     /**
      * "The equalizer" TODO ask David for a better description!
+     * Mlse mode runs a reduced state (5 channel taps around the estimate peak)
+     *  maximum likelihood sequence estimator. The output holds soft bits
+     *  (max-log a posteriori symbol probability ratio), positive for 1
      * @param dataOut Data to be filled (u vector)
      * @param in1 First input data
-     * @param in2 Second input data
+     * @param in2 Second input data (channel estimate, peak in center)
+     * @param in2len The number of values to use from second input
      * @param mode The operating mode
      * @return True if the mode is recognized..
      */
     static bool equalize(FloatVector& dataOut, const ComplexVector& in1, const ComplexVector& in2, int in2len,int mode = Default) {
-	if (mode != Default)
-	    return false;
-	defaultEqualize(dataOut,in1,in2,in2len);
-	return true;
+	switch (mode) {
+	    case Default:
+		defaultEqualize(dataOut,in1,in2,in2len);
+		return true;
+	    case Mlse:
+		mlseEqualize(dataOut,in1,in2,in2len);
+		return true;
+	}
+	return false;
     }
 private:
     static void defaultEqualize(FloatVector& dataOut, const ComplexVector& in1, const ComplexVector& in2, int in2len);
+    static void mlseEqualize(FloatVector& dataOut, const ComplexVector& in1, const ComplexVector& in2, int in2len);
 };
 
 
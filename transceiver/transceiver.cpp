@@ -60,6 +60,11 @@
 
 // Minimum data length for radio Rx burst to be processed by an ARFCN
 #define ARFCN_RXBURST_LEN 156
+// Interval (in timeslots) TX bursts are accepted in advance
+#define ARFCN_TX_AHEAD (204 * 8)
+// TX queue length (in timeslots)
+// Must be a power of 2 dividing GSM_HYPERFRAME_TS, greater than ARFCN_TX_AHEAD
+#define ARFCN_TXQUEUE_LEN 2048
 
 #define RX_RSSI_DEF -64
 #define RX_RSSI_MIN -90
@@ -72,6 +77,14 @@
 #define RADIO_TX_SLOTS_DEF 16
 #define RADIO_LATENCY_SLOTS_DEF 5
 
+// Number of checks made by a ring queue producer/consumer before parking
+#define RING_QUEUE_SPIN 200
+
+// Radio data objects held by radio read thread: read buffers and one in process
+#define TRX_RX_READ_BUFS 4
+// Radio data objects held by a consumer thread while processing
+#define RX_PROCESS_BUFS 2
+
 namespace TelEngine {
 
 class TrxWorker : public Thread, public GenObject
@@ -83,7 +96,10 @@ public:
 	ARFCNTx = 0x0008,
 	ARFCNRx = 0x0010,
 	TrxRadioOut = 0x0020,
-	RadioMask = TrxRadioRead | TrxRadioIn | TrxRadioOut | ARFCNTx | ARFCNRx,
+	TrxQmfLow = 0x0040,
+	TrxQmfHigh = 0x0080,
+	RadioMask = TrxRadioRead | TrxRadioIn | TrxRadioOut | ARFCNTx | ARFCNRx |
+	    TrxQmfLow | TrxQmfHigh,
     };
     TrxWorker(unsigned int type, TransceiverObj* obj, Thread::Priority prio = Thread::Normal)
 	: Thread(buildName(type,obj),prio), m_type(type), m_obj(obj)
@@ -270,6 +286,8 @@ const TokenDict TrxWorker::s_name[] = {
     {"TrxRadioRead",  TrxRadioRead},
     {"TrxRadioIn",    TrxRadioIn},
     {"TrxRadioOut",   TrxRadioOut},
+    {"TrxQmfLow",     TrxQmfLow},
+    {"TrxQmfHigh",    TrxQmfHigh},
     {0,0},
 };
 
@@ -280,6 +298,8 @@ const TokenDict TrxWorker::s_info[] = {
     {"Radio read process",     TrxRadioIn},
     {"Radio input process",    TrxRadioIn},
     {"Radio device send",      TrxRadioOut},
+    {"QMF low band process",   TrxQmfLow},
+    {"QMF high band process",  TrxQmfHigh},
     {0,0},
 };
 
@@ -411,6 +431,12 @@ void TrxWorker::run()
 	case TrxRadioRead:
 	    (static_cast<Transceiver*>(m_obj))->runReadRadio();
 	    break;
+	case TrxQmfLow:
+	    (static_cast<TransceiverQMF*>(m_obj))->runQmfSubtree(1);
+	    break;
+	case TrxQmfHigh:
+	    (static_cast<TransceiverQMF*>(m_obj))->runQmfSubtree(2);
+	    break;
 	default:
 	    Debug(m_obj,DebugStub,"TrxWorker::run() type=%d not handled",m_type);
     }
@@ -528,6 +554,19 @@ static const TokenDict s_gsmBurstType[] = {
     {0,0}
 };
 
+static const TokenDict s_dataTransport[] = {
+    {"udp",   TrxDataUdp},
+    {"mmsg",  TrxDataMmsg},
+    {"shm",   TrxDataShm},
+    {0,0}
+};
+
+static const TokenDict s_equalizerMode[] = {
+    {"default", Equalizer::Default},
+    {"mlse",    Equalizer::Mlse},
+    {0,0}
+};
+
 static const TokenDict s_rxDropBurstReason[] = {
     {"LowSNR",             ARFCN::RxDropLowSNR},
     {"LowPower",           ARFCN::RxDropLowPower},
@@ -609,6 +648,25 @@ static inline bool thShouldExit(Transceiver* trx)
     return Thread::check(false) || trxShouldExit(trx);
 }
 
+// Radio data store initializer: allocate samples buffer
+static void initRadioRxData(RadioRxData* d, unsigned int len)
+{
+    d->m_data.resize(len);
+}
+
+// TX burst store initializer: allocate burst bits buffer
+static void initTxBurst(GSMTxBurst* b, unsigned int len)
+{
+    b->assign(0,len);
+}
+
+template <class Obj> static inline void appendStoreStatus(String& dest, const char* name,
+    const ObjStore<Obj>& store)
+{
+    dest << name << "high_water=" << store.highWater() << "/" << store.capacity();
+    dest << " exhausted=" << store.exhausted();
+}
+
 static inline unsigned int getUInt(const NamedList& p, const String& param,
     unsigned int defVal = 1, unsigned int minVal = 1,
     unsigned int maxVal = (unsigned int)INT_MAX)
@@ -651,104 +709,128 @@ static inline bool buildCmdRsp(String* rsp, const char* cmd, int status,
 
 
 //
-// GenQueue
+// RingQueue
 //
-GenQueue::GenQueue(unsigned int maxLen, const char* name)
+RingQueue::RingQueue(unsigned int maxLen, const char* name)
     : m_name(name),
-    m_mutex(false,m_name.safe("GenQueue")),
-    m_free(maxLen,"GenQueueFree"),
-    m_used(maxLen,"GenQueueUsed"),
-    m_empty(true),
-    m_count(0),
-    m_max(maxLen)
+    m_data(0),
+    m_size(maxLen + 1),
+    m_head(0),
+    m_tail(0),
+    m_consumerWait(0),
+    m_producerWait(0),
+    m_used(1,"RingQueueUsed",0),
+    m_free(1,"RingQueueFree",0)
+{
+    m_data = new GenObject*[m_size];
+    for (unsigned int i = 0; i < m_size; i++)
+	m_data[i] = 0;
+}
+
+RingQueue::~RingQueue()
 {
     clear();
+    delete[] m_data;
 }
 
-bool GenQueue::add(GenObject* obj, Transceiver* trx)
+// Producer: write the object, publish the tail, wake up a parked consumer
+// Tail publish and consumer wait check are ordered (sequentially consistent):
+//  the consumer sets its wait flag before checking the queue
+bool RingQueue::push(GenObject* obj)
 {
     if (!obj)
 	return false;
-    m_mutex.lock();
-    if (m_max <= m_count) {
-	m_mutex.unlock();
-	while (!m_free.lock(Thread::idleUsec()))
-	    if (thShouldExit(trx))
-		return false;
-	m_mutex.lock();
-    }
-    m_data.append(obj);
-    m_count++;
-    m_empty = false;
-    m_mutex.unlock();
-    if (m_max)
+    unsigned int t = __atomic_load_n(&m_tail,__ATOMIC_RELAXED);
+    unsigned int n = next(t);
+    if (n == __atomic_load_n(&m_head,__ATOMIC_ACQUIRE))
+	return false;
+    m_data[t] = obj;
+    __atomic_store_n(&m_tail,n,__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&m_consumerWait,__ATOMIC_SEQ_CST))
 	m_used.unlock();
     return true;
 }
 
+// Consumer: read the object, release the slot, wake up a parked producer
+GenObject* RingQueue::pop()
+{
+    unsigned int h = __atomic_load_n(&m_head,__ATOMIC_RELAXED);
+    if (h == __atomic_load_n(&m_tail,__ATOMIC_ACQUIRE))
+	return 0;
+    GenObject* obj = m_data[h];
+    m_data[h] = 0;
+    __atomic_store_n(&m_head,next(h),__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&m_producerWait,__ATOMIC_SEQ_CST))
+	m_free.unlock();
+    return obj;
+}
+
+bool RingQueue::add(GenObject* obj, Transceiver* trx)
+{
+    if (!obj)
+	return false;
+    while (true) {
+	for (unsigned int n = RING_QUEUE_SPIN; n; n--) {
+	    if (push(obj))
+		return true;
+	    SigProcUtils::cpuRelax();
+	}
+	// Park. Check again after signalling we are waiting
+	__atomic_store_n(&m_producerWait,1,__ATOMIC_SEQ_CST);
+	bool ok = push(obj);
+	if (!ok) {
+	    m_free.lock(Thread::idleUsec());
+	    ok = push(obj);
+	}
+	__atomic_store_n(&m_producerWait,0,__ATOMIC_SEQ_CST);
+	if (ok)
+	    return true;
+	if (thShouldExit(trx))
+	    return false;
+    }
+    return false;
+}
+
 // Wait for an object to be put in the queue.
 // Returns when there is something in the queue or the calling thread was
 //  cancelled or the given transceiver is exiting
-bool GenQueue::waitPop(GenObject*& obj, Transceiver* trx)
+bool RingQueue::waitPop(GenObject*& obj, Transceiver* trx)
 {
-    if (m_max)
-	while (true) {
-	    obj = internalPop();
-	    if (obj) {
-		m_free.unlock();
+    while (true) {
+	for (unsigned int n = RING_QUEUE_SPIN; n; n--) {
+	    obj = pop();
+	    if (obj)
 		return true;
-	    }
-	    if (m_used.lock(Thread::idleUsec())) {
-		obj = internalPop();
-		if (obj) {
-		    m_free.unlock();
-		    return true;
-		}
-	    }
-	    if (thShouldExit(trx))
-		return false;
+	    SigProcUtils::cpuRelax();
 	}
-    else
-	while (true) {
-	    if (!empty()) {
-		obj = internalPop();
-		if (obj)
-		    return true;
-	    }
-	    Thread::idle();
-	    if (thShouldExit(trx))
-		return false;
+	// Park. Check again after signalling we are waiting
+	__atomic_store_n(&m_consumerWait,1,__ATOMIC_SEQ_CST);
+	obj = pop();
+	if (!obj) {
+	    m_used.lock(Thread::idleUsec());
+	    obj = pop();
 	}
+	__atomic_store_n(&m_consumerWait,0,__ATOMIC_SEQ_CST);
+	if (obj)
+	    return true;
+	if (thShouldExit(trx))
+	    return false;
+    }
     return false;
 }
 
 // Clear the queue
-void GenQueue::clear()
+void RingQueue::clear()
 {
-    m_mutex.lock();
-    m_empty = true;
-    m_count = 0;
-    m_data.clear();
-    m_mutex.unlock();
-    if (!m_max)
-	return;
-    // Adjust semaphores
+    for (GenObject* obj = pop(); obj; obj = pop())
+	TelEngine::destruct(obj);
+    m_head = m_tail = 0;
+    m_consumerWait = m_producerWait = 0;
+    // Reset semaphores
     while (m_used.lock(0))
 	;
-    for (unsigned int n = m_max + 1; n; n--)
-	m_free.unlock();
-}
-
-GenObject* GenQueue::internalPop()
-{
-    Lock lck(m_mutex);
-    GenObject* ret = m_data.remove(false);
-    if (!ret)
-	return 0;
-    m_count--;
-    if (!m_count)
-	m_empty = true;
-    return ret;
+    while (m_free.lock(0))
+	;
 }
 
 
@@ -981,6 +1063,108 @@ int TransceiverSockIface::writeSocket(const void* buf, unsigned int len,
     return m_socket.canRetry() ? 0 : -1;
 }
 
+// Read a batch of datagrams from socket
+int TransceiverSockIface::readSocketBatch(unsigned int* lens, unsigned int count,
+    TransceiverObj& dbg)
+{
+    int r = readSocket(dbg);
+    if (r <= 0)
+	return r;
+    lens[0] = r;
+    unsigned int n = 1;
+#ifdef __linux__
+    if (count > TRX_DATA_BATCH)
+	count = TRX_DATA_BATCH;
+    if (count < 2)
+	return n;
+    unsigned int recLen = m_readBuffer.length();
+    if (m_batchBuffer.length() < (count - 1) * recLen)
+	m_batchBuffer.assign(0,(count - 1) * recLen);
+    struct mmsghdr msg[TRX_DATA_BATCH - 1];
+    struct iovec iov[TRX_DATA_BATCH - 1];
+    ::memset(msg,0,sizeof(msg));
+    for (unsigned int i = 0; i < count - 1; i++) {
+	iov[i].iov_base = m_batchBuffer.data(i * recLen,recLen);
+	iov[i].iov_len = recLen;
+	msg[i].msg_hdr.msg_iov = &iov[i];
+	msg[i].msg_hdr.msg_iovlen = 1;
+    }
+    // Retrieve datagrams already queued, don't wait for more
+    // Errors will be reported by next read
+    r = ::recvmmsg(m_socket.handle(),msg,count - 1,MSG_DONTWAIT,0);
+    for (int i = 0; i < r; i++)
+	lens[n++] = msg[i].msg_len;
+#endif
+    return n;
+}
+
+// Write a batch of records to socket
+int TransceiverSockIface::writeSocketBatch(const void* buf, unsigned int len,
+    unsigned int count, TransceiverObj& dbg)
+{
+    if (!(buf && len && count))
+	return 0;
+#ifdef __linux__
+    if (count == 1)
+	return writeSocket(buf,len,dbg) > 0 ? 1 : 0;
+    struct mmsghdr msg[TRX_DATA_BATCH];
+    struct iovec iov[TRX_DATA_BATCH];
+    unsigned int sent = 0;
+    unsigned int attempt = 0;
+    int error = 0;
+    while (sent < count) {
+	unsigned int n = count - sent;
+	if (n > TRX_DATA_BATCH)
+	    n = TRX_DATA_BATCH;
+	::memset(msg,0,n * sizeof(struct mmsghdr));
+	for (unsigned int i = 0; i < n; i++) {
+	    iov[i].iov_base = (uint8_t*)buf + (sent + i) * len;
+	    iov[i].iov_len = len;
+	    msg[i].msg_hdr.msg_name = (void*)m_remote.address();
+	    msg[i].msg_hdr.msg_namelen = m_remote.length();
+	    msg[i].msg_hdr.msg_iov = &iov[i];
+	    msg[i].msg_hdr.msg_iovlen = 1;
+	}
+	int r = ::sendmmsg(m_socket.handle(),msg,n,0);
+	if (r > 0) {
+	    sent += r;
+	    continue;
+	}
+	if (thShouldExit(dbg.transceiver()))
+	    return sent;
+	error = errno;
+	if ((error == EAGAIN || error == EWOULDBLOCK || error == EINTR || error == ENOBUFS) &&
+	    ++attempt < m_writeAttempts) {
+	    Thread::idle();
+	    continue;
+	}
+	break;
+    }
+    if (sent == count) {
+	if (m_printOne) {
+	    m_printOne = false;
+	    String tmp;
+	    tmp.hexify((void*)buf,len,' ');
+	    Debug(&dbg,DebugAll,"%sSocket(%s) sent %u datagrams of %u bytes, first: %s [%p]",
+		dbg.prefix(),name().c_str(),count,len,tmp.c_str(),&dbg);
+	}
+	return sent;
+    }
+    String s;
+    Thread::errorString(s,error);
+    Alarm(&dbg,"socket",DebugWarn,"%sSocket(%s) batch send failed (sent %u/%u): %d %s [%p]",
+	dbg.prefix(),name().c_str(),sent,count,error,s.c_str(),&dbg);
+    return (error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS) ? (int)sent : -1;
+#else
+    for (unsigned int i = 0; i < count; i++) {
+	int r = writeSocket((const uint8_t*)buf + i * len,len,dbg);
+	if (r <= 0)
+	    return r < 0 ? r : (int)i;
+    }
+    return count;
+#endif
+}
+
 //
 // Transceiver
 //
@@ -1005,6 +1189,9 @@ Transceiver::Transceiver(const char* name)
     m_arfcnCount(0),
     m_arfcnConf(1),
     m_clockIface("clock"),
+    m_dataTransport(TrxDataUdp),
+    m_dataFallback(TrxDataUdp),
+    m_dataOffered(false),
     m_clockUpdMutex(false,"TrxClockUpd"),
     m_clockUpdOffset(16),
     m_txSlots(1),
@@ -1013,6 +1200,7 @@ Transceiver::Transceiver(const char* name)
     m_printStatusBursts(true),
     m_printStatusChanged(false),
     m_radioSendChanged(false),
+    m_txCache(1024),
     m_tsc(0),
     m_radioRxStore(100,"TrxRadioRx"),
     m_rxFreq(0),
@@ -1026,6 +1214,7 @@ Transceiver::Transceiver(const char* name)
     m_txSilenceDebugTime(0),
     m_loopbackMutex(false,"TrxLoopbackData"),
     m_loopback(false),
+    m_loopbackQueue(4,"TrxLoopback"),
     m_loopbackSleep(0),
     m_loopbackNextSend(0),
     m_loopbackData(0),
@@ -1082,12 +1271,19 @@ bool Transceiver::init(RadioInterface* radio, const NamedList& params, unsigned
 	unsigned int nFillers = params.getIntValue(YSTRING("filler_frames"),
 	    FILLER_FRAMES_MIN,FILLER_FRAMES_MIN);
 	m_signalProcessing.initialize(m_oversamplingRate,arfcns);
+	const String& kernels = params[YSTRING("simd_kernels")];
+	if (!Complex::setKernels(kernels)) {
+	    String tmp;
+	    Debug(this,DebugConf,"Unsupported simd_kernels='%s' (supported: %s) using '%s' [%p]",
+		kernels.c_str(),Complex::supportedKernels(tmp).c_str(),Complex::kernels(),this);
+	}
 	int port = rAddr ? params.getIntValue(YSTRING("port")) : 0;
 	const char* lAddr = rAddr ? params.getValue(YSTRING("localaddr"),*rAddr) : 0;
 	if (rAddr &&
 	    !(m_clockIface.setAddr(true,lAddr,port + 2,*this) &&
 	    m_clockIface.setAddr(false,*rAddr,port + 3,*this)))
 	    break;
+	selectDataTransport(params,rAddr ? port : -1);
 	if (!resetARFCNs(arfcns,port,rAddr,lAddr,nFillers))
 	    break;
 	m_radioReadPrio = Thread::priority(params[YSTRING("radio_read_priority")],Thread::Highest);
@@ -1096,6 +1292,7 @@ bool Transceiver::init(RadioInterface* radio, const NamedList& params, unsigned
 	    String tmp;
 	    tmp << "\r\nARFCNs=" << m_arfcnCount;
 	    tmp << "\r\noversampling=" << m_oversamplingRate;
+	    tmp << "\r\nsimd_kernels=" << Complex::kernels();
 	    Debug(this,DebugAll,"Initialized [%p]%s",this,encloseDashes(tmp));
 	}
 	// Set GSM sample rate: (13e6 / 48) + 1
@@ -1247,6 +1444,11 @@ void Transceiver::runReadRadio()
 	    v->resize(bufs.bufSamples());
 	    bufs.crt.samples = (float*)v->data();
 	}
+	// Forward loopback data: we are the only producer of radio data queue
+	if (!m_loopbackQueue.empty()) {
+	    for (GenObject* gen = m_loopbackQueue.pop(); gen; gen = m_loopbackQueue.pop())
+		recvRadioData(static_cast<RadioRxData*>(gen));
+	}
 	// Advance radio clock. Signal TX
 	// Sync to next slot boundary if needed
 	if ((io.timestamp % m_signalProcessing.gsmSlotLen()) != 0) {
@@ -1425,6 +1627,10 @@ void Transceiver::dumpStatus(bool printBursts, GSMTime* radioTime)
     s << "\r\nRadioClock:\t" << *radioTime;
     s << "\r\nLastSyncUpper:\t" << m_lastClockUpd;
     s << "\r\nTxTime:\t\t" << m_txTime;
+    s << "\r\nSimdKernels:\t" << Complex::kernels();
+    s << "\r\nTxModulated:\t" << m_txCache.misses() << " (cached " << m_txCache.hits() << ")";
+    appendStoreStatus(s,"\r\nRxStore:\t",m_radioRxStore);
+    appendStatus(s);
     if (printBursts) {
 	s << "\r\nTxBursts:\t" << m_txIO.bursts;
 	s << "\r\nRxBursts:\t" << m_rxIO.bursts;
@@ -1436,6 +1642,8 @@ void Transceiver::dumpStatus(bool printBursts, GSMTime* radioTime)
 	a->getTxStats(aStats);
 	s << "\r\n  UplinkLastOutTime:\t" << a->m_lastUplinkBurstOutTime;
 	s << "\r\n  DownlinkLastInTime:\t" << aStats.burstLastInTime;
+	appendStoreStatus(s,"\r\n  RxStore:\t\t",a->m_radioRxStore);
+	appendStoreStatus(s,"\r\n  TxStore:\t\t",a->m_txBurstStore);
 	if (printBursts) {
 	    uint64_t rx = a->m_rxBursts;
 	    String tmp;
@@ -1670,6 +1878,7 @@ bool Transceiver::command(const char* str, String* rsp, unsigned int arfcn)
 	    status = handleCmdCustom(s,&rspParam,&reason);
 	    break;
 	case CmdPowerOn:
+	    confirmDataTransport(s);
 	    status = (radioPowerOn(&reason) ? CmdEOk : CmdEFailure);
 	    break;
 	case CmdPowerOff:
@@ -1762,6 +1971,13 @@ void Transceiver::destroyed()
 void Transceiver::radioPowerOnStarting()
 {
     m_rxQueue.clear();
+    m_loopbackQueue.clear();
+    // Preallocate radio data with samples buffer (exchanged with radio read buffers)
+    // Cover the radio data in flight: read buffers, RX and loopback queues
+    m_radioRxStore.prealloc(TRX_RX_READ_BUFS + m_rxQueue.capacity() +
+	m_loopbackQueue.capacity(),initRadioRxData,
+	(unsigned int)(BITS_PER_TIMESLOT * m_oversamplingRate));
+    m_radioRxStore.resetCounters();
     m_txPower = -20;
 }
 
@@ -1824,6 +2040,8 @@ bool Transceiver::radioPowerOn(String* reason)
 	    break;
 	if (!TrxWorker::create(m_radioOutThread,TrxWorker::TrxRadioOut,this,m_radioOutPrio))
 	    break;
+	if (!radioWorkersStart())
+	    break;
 	unsigned int i = 0;
 	for (; i < m_arfcnCount; i++)
 	    if (!m_arfcn[i]->radioPowerOn(reason))
@@ -1858,6 +2076,7 @@ void Transceiver::radioPowerOff()
     m_stateMutex.lock();
     TrxWorker::cancelThreads(this,0,&m_radioInThread,0,&m_radioOutThread,
 	0,&m_radioReadThread);
+    radioWorkersStop();
     // Signal Tx ready: this will stop us waiting for Tx ready
     m_txSync.unlock();
     for (unsigned int i = 0; i < m_arfcnCount; i++)
@@ -1865,6 +2084,7 @@ void Transceiver::radioPowerOff()
     if (m_state == PowerOn)
 	changeState(PowerOff);
     m_rxQueue.clear();
+    m_loopbackQueue.clear();
     m_stateMutex.unlock();
 }
 
@@ -1897,6 +2117,8 @@ bool Transceiver::resetARFCNs(unsigned int arfcns, int port, const String* rAddr
 	stopARFCNs();
 	clearARFCNs(m_arfcn,m_arfcnCount);
     }
+    // Signal processing parameters may have changed
+    m_txCache.clear();
     m_arfcnCount = arfcns;
     if (!m_arfcnCount) {
 	if (old)
@@ -1915,7 +2137,7 @@ bool Transceiver::resetARFCNs(unsigned int arfcns, int port, const String* rAddr
 	if (m_arfcn[i]->arfcn() == 0) {
 	    filler = GSMTxBurst::buildFiller();
 	    if (filler) {
-		filler->buildTxData(m_signalProcessing);
+		filler->buildTxData(m_signalProcessing,0,0,DataBlock::empty(),&m_txCache);
 		if (!filler->txData().length())
 		    TelEngine::destruct(filler);
 	    }
@@ -1933,6 +2155,21 @@ bool Transceiver::resetARFCNs(unsigned int arfcns, int port, const String* rAddr
 		arfcnListChanged();
 	    return false;
 	}
+	// Shared memory failure is not fatal: fallback to datagrams
+	unsigned int i = 0;
+	if (m_dataTransport == TrxDataShm)
+	    for (; i < m_arfcnCount; i++)
+		if (!static_cast<ARFCNSocket*>(m_arfcn[i])->initShm(m_dataShmPrefix + String(i)))
+		    break;
+	if (i < m_arfcnCount) {
+	    if (m_dataTransport == TrxDataShm) {
+		Debug(this,DebugNote,"Shared memory data interface not available, using '%s' [%p]",
+		    lookup(m_dataFallback,s_dataTransport),this);
+		m_dataTransport = m_dataFallback;
+	    }
+	    for (i = 0; i < m_arfcnCount; i++)
+		static_cast<ARFCNSocket*>(m_arfcn[i])->setDataTransport(m_dataTransport);
+	}
     }
     arfcnListChanged();
     return true;
@@ -1945,6 +2182,89 @@ void Transceiver::stopARFCNs()
 	m_arfcn[i]->stop();
 }
 
+// Select the burst data transport
+// Upper layer offers the transports it supports in RESET command ('data_offer' parameter)
+// Pick the first of them in our preference list, keep the first non shared memory one
+//  as fallback if the upper layer fails to attach to shared memory
+void Transceiver::selectDataTransport(const NamedList& params, int port)
+{
+    m_dataTransport = m_dataFallback = TrxDataUdp;
+    m_dataShmPrefix.clear();
+    const String& offer = params[YSTRING("data_offer")];
+    m_dataOffered = port >= 0 && !offer.null();
+    if (!m_dataOffered)
+	return;
+    ObjList* offered = offer.split(',',false);
+    ObjList* pref = String(params.getValue(YSTRING("data_transport"),"shm,mmsg,udp")).split(',',false);
+    bool found = false;
+    for (ObjList* o = pref->skipNull(); o; o = o->skipNext()) {
+	String* name = static_cast<String*>(o->get());
+	int t = lookup(name->trimBlanks(),s_dataTransport,-1);
+	if (t < 0) {
+	    Debug(this,DebugConf,"Unknown data transport '%s' [%p]",name->c_str(),this);
+	    continue;
+	}
+	if (t != TrxDataUdp && !offered->find(*name))
+	    continue;
+	if (!found) {
+	    m_dataTransport = t;
+	    found = true;
+	}
+	if (t != TrxDataShm) {
+	    m_dataFallback = t;
+	    break;
+	}
+    }
+    TelEngine::destruct(pref);
+    TelEngine::destruct(offered);
+    if (m_dataTransport == TrxDataShm) {
+	TrxDataShmIface::removeStale();
+	m_dataShmPrefix << TRX_DATA_SHM_DIR << TRX_DATA_SHM_NAME << (int)::getpid() <<
+	    "-" << port << "-";
+    }
+    Debug(this,DebugInfo,"Selected data transport '%s' (offered: %s, fallback: %s) [%p]",
+	lookup(m_dataTransport,s_dataTransport),offer.c_str(),
+	lookup(m_dataFallback,s_dataTransport),this);
+}
+
+// Handle upper layer data transport confirmation (POWERON 'data=' parameter)
+// Shared memory must be explicitly confirmed: the upper layer may have failed to attach
+// Once confirmed both sides mapped the segments: remove their files
+void Transceiver::confirmDataTransport(const String& param)
+{
+    if (m_dataTransport != TrxDataShm)
+	return;
+    String data;
+    int pos = param.find("data=");
+    if (pos >= 0 && (!pos || param.at(pos - 1) == ' ')) {
+	data = param.substr(pos + 5);
+	pos = data.find(' ');
+	if (pos >= 0)
+	    data = data.substr(0,pos);
+    }
+    if (data == lookup(TrxDataShm,s_dataTransport)) {
+	for (unsigned int i = 0; i < m_arfcnCount; i++)
+	    static_cast<ARFCNSocket*>(m_arfcn[i])->setDataTransport(TrxDataShm);
+	return;
+    }
+    Debug(this,DebugNote,"Shared memory data interface not confirmed (data=%s), using '%s' [%p]",
+	data.c_str(),lookup(m_dataFallback,s_dataTransport),this);
+    m_dataTransport = m_dataFallback;
+    for (unsigned int i = 0; i < m_arfcnCount; i++)
+	static_cast<ARFCNSocket*>(m_arfcn[i])->setDataTransport(m_dataTransport);
+}
+
+// Append the selected data transport to a RESET response
+String& Transceiver::dataTransportParam(String& dest) const
+{
+    if (!m_dataOffered)
+	return dest;
+    dest << "data=" << lookup(m_dataTransport,s_dataTransport);
+    if (m_dataTransport == TrxDataShm)
+	dest << ":" << m_dataShmPrefix;
+    return dest;
+}
+
 // Sync upper layer GSM clock (update time)
 bool Transceiver::syncGSMTime(const char* msg)
 {
@@ -2246,7 +2566,9 @@ void Transceiver::sendLoopback(ComplexVector& buf, const GSMTime& time)
 	r->m_data.copy(buf.data(),buf.length());
     }
     r->m_time = t;
-    recvRadioData(r);
+    // Radio data queue producer is the radio read thread: let it forward the data
+    if (!m_loopbackQueue.push(r))
+	m_radioRxStore.store(r);
 }
 
 // Adjust data to send (from test or dumper)
@@ -2522,14 +2844,21 @@ int Transceiver::handleCmdManageTx(unsigned int arfcn, String& cmd, String* rspP
 //
 TransceiverQMF::TransceiverQMF(const char* name)
     : Transceiver(name),
+    m_qmfParallelConf(false),
+    m_qmfParallel(false),
+    m_qmfLowQueue(8,"TrxQmfLow"),
+    m_qmfHighQueue(8,"TrxQmfHigh"),
+    m_qmfStore(32,"TrxQmfRx"),
     m_halfBandFltCoeffLen(11),
     m_tscSamples(26),
+    m_equalizer(Equalizer::Default),
 #ifdef TRANSCEIVER_DUMP_DEMOD_PERF
     m_checkDemodPerf(true)
 #else
     m_checkDemodPerf(false)
 #endif
 {
+    m_qmfThread[0] = m_qmfThread[1] = 0;
     initNormalBurstTSC();
     initAccessBurstSync();
 }
@@ -2571,6 +2900,8 @@ void TransceiverQMF::reInit(const NamedList& params)
 {
     Transceiver::reInit(params);
     m_tscSamples = getUInt(params,YSTRING("chan_estimator_tsc_samples"),26,2,26);
+    m_qmfParallelConf = params.getBoolValue(YSTRING("qmf_parallel"));
+    m_equalizer = params.getIntValue(YSTRING("equalizer"),s_equalizerMode,Equalizer::Default);
 }
 
 // Process a received radio burst
@@ -2768,7 +3099,7 @@ bool TransceiverQMF::processRadioBurst(unsigned int arfcn, ArfcnSlot& slot, GSMR
     a->addSlotDelay(slot.slot,delaySpread);
 
     FloatVector v(b.m_data.length());
-    Equalizer::equalize(v,b.m_data,he,11);
+    Equalizer::equalize(v,b.m_data,he,11,m_equalizer);
 
     dumpRxData("demod-u",arfcn,"",v.data(), v.length());
 
@@ -2814,6 +3145,7 @@ void TransceiverQMF::radioPowerOnStarting()
     for (unsigned int i = 0; i < 15; i++, d++) {
 	QmfBlock& b = m_qmf[i];
 	b.arfcn = d->arfcn;
+	b.resetStats();
 	if (b.freqShiftValue != d->freqShiftValue) {
 	    b.freqShiftValue = d->freqShiftValue;
 	    b.freqShift.clear();
@@ -2881,6 +3213,90 @@ void TransceiverQMF::arfcnListChanged()
 	m_qmf[i].chans = false;
 }
 
+// Start QMF subtree workers if parallel processing is enabled
+bool TransceiverQMF::radioWorkersStart()
+{
+    setQmfParallel(false);
+    if (!m_qmfParallelConf)
+	return true;
+    m_qmfLowQueue.clear();
+    m_qmfHighQueue.clear();
+    // Subtree input data in flight: queued and processed by each worker
+    m_qmfStore.prealloc(m_qmfLowQueue.capacity() + m_qmfHighQueue.capacity() +
+	2 * RX_PROCESS_BUFS);
+    m_qmfStore.resetCounters();
+    if (!(TrxWorker::create(m_qmfThread[0],TrxWorker::TrxQmfLow,this) &&
+	TrxWorker::create(m_qmfThread[1],TrxWorker::TrxQmfHigh,this)))
+	return false;
+    setQmfParallel(true);
+    Debug(this,DebugInfo,"Started parallel QMF processing [%p]",this);
+    return true;
+}
+
+// Stop QMF subtree workers
+void TransceiverQMF::radioWorkersStop()
+{
+    setQmfParallel(false);
+    TrxWorker::cancelThreads(this,0,&m_qmfThread[0],0,&m_qmfThread[1]);
+    m_qmfLowQueue.clear();
+    m_qmfHighQueue.clear();
+}
+
+// Worker terminated notification
+void TransceiverQMF::workerTerminated(Thread* th)
+{
+    if (!th)
+	return;
+    Lock lck(TrxWorker::s_mutex);
+    for (unsigned int i = 0; i < 2; i++) {
+	if (m_qmfThread[i] != th)
+	    continue;
+	m_qmfThread[i] = 0;
+	return;
+    }
+    lck.drop();
+    Transceiver::workerTerminated(th);
+}
+
+// Append QMF nodes processing statistics to status
+void TransceiverQMF::appendStatus(String& dest)
+{
+    bool parallel = qmfParallel();
+    dest << "\r\nQmfParallel:\t" << String::boolText(parallel);
+    if (parallel)
+	appendStoreStatus(dest,"\r\nQmfRxStore:\t",m_qmfStore);
+    for (unsigned int i = 0; i < 7; i++) {
+	const QmfBlock& b = m_qmf[i];
+	uint64_t runs = __atomic_load_n(&b.runs,__ATOMIC_RELAXED);
+	if (!runs)
+	    continue;
+	uint64_t runTime = __atomic_load_n(&b.runTime,__ATOMIC_RELAXED);
+	dest << "\r\nQMF[" << i << "]:\t\truns=" << runs;
+	dest << " avg=" << (unsigned int)(runTime / runs) << "us";
+	dest << " max=" << __atomic_load_n(&b.runTimeMax,__ATOMIC_RELAXED) << "us";
+    }
+}
+
+// Run QMF subtree process loop
+void TransceiverQMF::runQmfSubtree(unsigned int index)
+{
+    waitPowerOn();
+    RingQueue& queue = qmfQueue(index);
+    QmfBlock& b = m_qmf[index];
+    GenObject* gen = 0;
+    while (queue.waitPop(gen,this)) {
+	if (!gen)
+	    continue;
+	RadioRxData* d = static_cast<RadioRxData*>(gen);
+	gen = 0;
+	GSMTime time = d->m_time;
+	b.data.exchange(d->m_data);
+	b.power = d->m_power;
+	m_qmfStore.store(d);
+	qmf(time,index);
+    }
+}
+
 void TransceiverQMF::dumpFreqShift(unsigned int index) const
 {
     if (index > 14) {
@@ -2980,6 +3396,7 @@ void TransceiverQMF::qmf(const GSMTime& time, unsigned int index)
 	a->recvRadioData(r);
 	return;
     }
+    uint64_t start = Time::now();
     // Frequency shift
     qmfApplyFreqShift(crt);
 #ifdef TRANSCEIVER_DUMP_QMF_FREQSHIFTED
@@ -2997,14 +3414,38 @@ void TransceiverQMF::qmf(const GSMTime& time, unsigned int index)
 #endif
     dumpRxData("qmf[",index,"].w",crt.halfBandFilter.data(),crt.halfBandFilter.length());
 
-    if (indexLo >= 0 && !thShouldExit(this)) {
-	qmfBuildOutputLowBand(crt,m_qmf[indexLo].data,&m_qmf[indexLo].power);
-	qmf(time,indexLo);
+    // Root node in parallel mode: hand the subtrees to workers
+    if (!index && qmfParallel()) {
+	if (indexLo >= 0 && !thShouldExit(this))
+	    qmfForward(time,crt,indexLo);
+	if (indexHi >= 0 && !thShouldExit(this))
+	    qmfForward(time,crt,indexHi);
+	qmfUpdateStats(crt,start);
+	return;
     }
-    if (indexHi >= 0 && !thShouldExit(this)) {
+    if (indexLo >= 0 && !thShouldExit(this))
+	qmfBuildOutputLowBand(crt,m_qmf[indexLo].data,&m_qmf[indexLo].power);
+    if (indexHi >= 0 && !thShouldExit(this))
 	qmfBuildOutputHighBand(crt,m_qmf[indexHi].data,&m_qmf[indexHi].power);
+    qmfUpdateStats(crt,start);
+    if (indexLo >= 0 && !thShouldExit(this))
+	qmf(time,indexLo);
+    if (indexHi >= 0 && !thShouldExit(this))
 	qmf(time,indexHi);
-    }
+}
+
+// Forward low/high band output to a subtree worker
+void TransceiverQMF::qmfForward(const GSMTime& time, QmfBlock& b, unsigned int index)
+{
+    RadioRxData* r = m_qmfStore.get();
+    r->m_time = time;
+    if (index == 1)
+	qmfBuildOutputLowBand(b,r->m_data,&r->m_power);
+    else
+	qmfBuildOutputHighBand(b,r->m_data,&r->m_power);
+    // Wait for space in queue: keep bursts order, don't drop data
+    if (!qmfQueue(index).add(r,this))
+	m_qmfStore.store(r);
 }
 
 // Build the half band filter
@@ -3170,6 +3611,124 @@ void TransceiverQMF::checkDemodPerf(const ARFCN* a, const GSMRxBurst& b, int bTy
 	b.m_powerLevel,a,encloseDashes(tscDump,true));
 }
 
+
+//
+// TransceiverPFB
+//
+TransceiverPFB::TransceiverPFB(const char* name)
+    : TransceiverQMF(name),
+    m_pfbRuns(0),
+    m_pfbRunTime(0),
+    m_pfbRunTimeMax(0)
+{
+}
+
+// Starting radio power on notification
+void TransceiverPFB::radioPowerOnStarting()
+{
+    // Skip QMF tree setup
+    Transceiver::radioPowerOnStarting();
+    m_pfbRuns = m_pfbRunTime = m_pfbRunTimeMax = 0;
+    if (!m_pfb.initialize(m_oversamplingRate)) {
+	Debug(this,DebugFail,"Failed to initialize channelizer oversampling=%u [%p]",
+	    m_oversamplingRate,this);
+	fatalError();
+	return;
+    }
+    FloatVector freqShift(m_arfcnCount);
+    for (unsigned int i = 0; i < m_arfcnCount; i++)
+	freqShift[i] = SignalProcessing::arfcnFreqShift(i,m_oversamplingRate);
+    m_pfb.setChannels(freqShift.data(),freqShift.length());
+    for (unsigned int i = 0; i < m_arfcnCount; i++)
+	m_pfb.setActive(i,m_arfcn[i]->chans() != 0);
+    Debug(this,DebugAll,"%sChannelizer bins=%u taps=%u fft_channels=%u [%p]",
+	prefix(),m_pfb.bins(),m_pfb.taps(),m_pfb.fftChannels(),this);
+}
+
+// Append channelizer processing statistics to status
+void TransceiverPFB::appendStatus(String& dest)
+{
+    dest << "\r\nChannelizer:\tpfb bins=" << m_pfb.bins() << " taps=" << m_pfb.taps();
+    // Note: values are taken without protection
+    uint64_t runs = m_pfbRuns;
+    if (!runs)
+	return;
+    dest << "\r\nPFB:\t\truns=" << runs;
+    dest << " avg=" << (unsigned int)(m_pfbRunTime / runs) << "us";
+    dest << " max=" << m_pfbRunTimeMax << "us";
+}
+
+// Set channel (slot) type
+void TransceiverPFB::setChanType(unsigned int arfcn, unsigned int slot, int chanType)
+{
+    Transceiver::setChanType(arfcn,slot,chanType);
+    if (arfcn < m_arfcnCount && m_arfcn[arfcn]->chans())
+	m_pfb.setActive(arfcn);
+}
+
+// ARFCN list changed notification
+void TransceiverPFB::arfcnListChanged()
+{
+    Transceiver::arfcnListChanged();
+    for (unsigned int i = 0; i < m_pfb.channels(); i++)
+	m_pfb.setActive(i,false);
+}
+
+// Process received radio data
+void TransceiverPFB::processRadioData(RadioRxData* d)
+{
+    if (!d)
+	return;
+    GSMTime time = d->m_time;
+    XDebug(this,DebugAll,"Processing radio input TN=%u FN=%u len=%u [%p]",
+	time.tn(),time.fn(),d->m_data.length(),this);
+    if (s_dumper) {
+	s_dumper->addData(d->m_data);
+	m_radioRxStore.store(d);
+	return;
+    }
+#ifdef TRANSCEIVER_DUMP_RX_INPUT_OUTPUT
+    RxInData::add(d->m_data,time);
+#endif
+    float power = 0;
+    if (d->m_data.length())
+	power = SignalProcessing::power2db(Complex::sumMulConj(d->m_data.data(),
+	    d->m_data.length()) / d->m_data.length());
+    // Even if the power is too low compute noise from every 9th timeslot
+    if ((power < m_burstMinPower) && (time.timeslot() % 9)) {
+	m_radioRxStore.store(d);
+	return;
+    }
+    uint64_t start = Time::now();
+    bool ok = m_pfb.process(d->m_data,m_pfbOut);
+    m_radioRxStore.store(d);
+    if (!ok)
+	return;
+    uint64_t t = Time::now() - start;
+    m_pfbRuns++;
+    m_pfbRunTime += t;
+    if (m_pfbRunTimeMax < t)
+	m_pfbRunTimeMax = t;
+    for (unsigned int i = 0; i < m_arfcnCount && !thShouldExit(this); i++) {
+	if (!m_pfb.active(i))
+	    continue;
+	ComplexVector& y = m_pfbOut[i];
+	dumpRxData("pfb[",i,"].y",y.data(),y.length());
+	float chanPower = SignalProcessing::power2db(Complex::sumMulConj(y.data(),y.length()) /
+	    y.length());
+	if ((chanPower < m_burstMinPower) && (time.timeslot() % 9))
+	    continue;
+	ARFCN* a = m_arfcn[i];
+	RadioRxData* r = a->m_radioRxStore.get();
+	r->m_time = time;
+	r->m_data.exchange(y);
+	XDebug(this,DebugAll,"Forwarding radio data ARFCN=%u len=%u TN=%u FN=%u [%p]",
+	    a->arfcn(),r->m_data.length(),time.tn(),time.fn(),this);
+	a->recvRadioData(r);
+    }
+}
+
+
 //
 // TrafficShower
 //
@@ -3425,6 +3984,111 @@ void TxFillerTable::store(GSMTxBurst* burst)
 }
 
 
+//
+// TxBurstQueue
+//
+TxBurstQueue::TxBurstQueue(ARFCN* owner)
+    : m_slots(0), m_length(ARFCN_TXQUEUE_LEN), m_count(0), m_started(false),
+    m_owner(owner)
+{
+    m_slots = new GSMTxBurst*[m_length];
+    ::memset(m_slots,0,m_length * sizeof(GSMTxBurst*));
+}
+
+bool TxBurstQueue::add(GSMTxBurst* burst, GSMTxBurst*& old)
+{
+    old = 0;
+    if (!burst)
+	return true;
+    GSMTxBurst*& b = m_slots[index(burst->time())];
+    if (b) {
+	if (b->time() == burst->time())
+	    return false;
+	// Slot still holds a burst from previous ring round
+	old = b;
+	m_count--;
+    }
+    b = burst;
+    m_count++;
+    return true;
+}
+
+GSMTxBurst* TxBurstQueue::get(const GSMTime& time, TxFillerTable& fillers,
+    unsigned int& expired)
+{
+    // Expire bursts in slots passed since last request
+    int32_t n = m_started ? time.diff(m_next) : m_length;
+    // Radio time went back (clock restarted or re-synchronized): start over,
+    //  queued bursts and the last sent time belong to the old clock
+    if (n < -1) {
+	Debug(m_owner,DebugNote,"TX time went back from %u to %u, dropping %u queued bursts [%p]",
+	    m_next.fn(),time.fn(),m_count,m_owner);
+	reset();
+	n = m_length;
+    }
+    if (n > (int32_t)m_length)
+	n = m_length;
+    GSMTime t = m_next;
+    if (!m_started || n == (int32_t)m_length)
+	t = time;
+    m_next = time;
+    m_next++;
+    m_started = true;
+    for (; n > 0 && m_count; n--, t++) {
+	GSMTxBurst*& b = m_slots[index(t)];
+	if (b && b->time() < time) {
+	    fillers.set(b);
+	    b = 0;
+	    m_count--;
+	    expired++;
+	}
+    }
+    if (!m_count)
+	return 0;
+    GSMTxBurst*& b = m_slots[index(time)];
+    if (!b)
+	return 0;
+    GSMTxBurst* ret = 0;
+    if (b->time() == time)
+	ret = b;
+    else if (b->time() < time) {
+	fillers.set(b);
+	expired++;
+    }
+    else
+	return 0;
+    b = 0;
+    m_count--;
+    return ret;
+}
+
+void TxBurstQueue::dump()
+{
+    GSMTime t = m_next;
+    for (unsigned int n = m_length; n && m_count; n--, t++) {
+	GSMTxBurst* b = m_slots[index(t)];
+	if (b)
+	    Debug(m_owner,DebugAll,"Queued burst arfcn %u fn %u tn %u [%p]",
+		m_owner ? m_owner->arfcn() : 0,b->time().fn(),b->time().tn(),b);
+    }
+}
+
+void TxBurstQueue::reset()
+{
+    for (unsigned int i = 0; m_slots && i < m_length; i++)
+	TelEngine::destruct(m_slots[i]);
+    m_count = 0;
+    m_started = false;
+}
+
+void TxBurstQueue::clear()
+{
+    reset();
+    delete[] m_slots;
+    m_slots = 0;
+}
+
+
 //
 // ARFCN
 //
@@ -3443,6 +4107,7 @@ ARFCN::ARFCN(unsigned int index)
     m_arfcn(index),
     m_fillerTable(this),
     m_txMutex(false,"ARFCNTx"),
+    m_txQueue(this),
     m_shaper(this,index)
 {
     for (uint8_t i = 0; i < 8; i++) {
@@ -3525,6 +4190,17 @@ void ARFCN::stop()
 bool ARFCN::radioPowerOn(String* reason)
 {
     m_rxQueue.clear();
+    // Samples buffers are exchanged with channelizer output: allocated on first use
+    m_radioRxStore.prealloc(m_rxQueue.capacity() + RX_PROCESS_BUFS);
+    m_radioRxStore.resetCounters();
+    // Cover the bursts upper layer may send ahead of radio time
+    unsigned int txBursts = 8 + (transceiver() ? transceiver()->txLeadSlots() : 0);
+    m_txBurstStore.prealloc(txBursts,initTxBurst,GSM_BURST_LENGTH);
+    m_txBurstStore.resetCounters();
+    // Radio time restarts: don't reject new bursts as late
+    m_txMutex.lock();
+    m_txQueue.reset();
+    m_txMutex.unlock();
     Lock lck(m_mutex);
     if (!TrxWorker::create(m_radioInThread,TrxWorker::ARFCNRx,this))
 	return false;
@@ -3591,7 +4267,7 @@ void ARFCN::addBurst(GSMTxBurst* burst)
     m_txStats.burstLastInTime = burst->time();
     m_txStats.burstsDwIn++;
     m_txStats.burstsDwInSlot[burst->time().tn()]++;
-    if (burst->filler() || txTime > burst->time()) {
+    if (burst->filler() || txTime > burst->time() || m_txQueue.late(burst->time())) {
 	if (!burst->filler()) {
 	    if (txTimeDebugOk(txTime))
 		Debug(this,DebugNote,"%sReceived delayed burst %s at %s [%p]",
@@ -3601,7 +4277,7 @@ void ARFCN::addBurst(GSMTxBurst* burst)
 	m_expired.insert(burst);
 	return;
     }
-    GSMTime tmpTime = txTime + 204 * 8;
+    GSMTime tmpTime = txTime + ARFCN_TX_AHEAD;
     if (burst->time() > tmpTime) {
 	if (txTimeDebugOk(txTime))
 	    Debug(this,DebugNote,
@@ -3612,26 +4288,20 @@ void ARFCN::addBurst(GSMTxBurst* burst)
 	m_expired.insert(burst);
 	return;
     }
-    ObjList* last = &m_txQueue;
-    for (ObjList* o = m_txQueue.skipNull();o;o = o->skipNext()) {
-	GSMTxBurst* b = static_cast<GSMTxBurst*>(o->get());
-	if (burst->time() > b->time()) {
-	    XDebug(this,DebugAll,"%sInsert burst %s before %s [%p]",
-		prefix(),burst->time().c_str(t),b->time().c_str(tmp),this);
-	    o->insert(burst);
-	    return;
-	}
-	if (burst->time() == b->time()) {
-	    // Don't use tx silence debug status: this is a bad thing (should never happen)
-	    Debug(this,DebugNote,"%sDuplicate burst received at %s [%p]",
-		prefix(),burst->time().c_str(t),this);
-	    m_txBurstStore.store(burst);
-	    m_txStats.burstsDupOnRecv++;
-	    return;
-	}
-	last = o;
+    GSMTxBurst* old = 0;
+    if (!m_txQueue.add(burst,old)) {
+	// Don't use tx silence debug status: this is a bad thing (should never happen)
+	Debug(this,DebugNote,"%sDuplicate burst received at %s [%p]",
+	    prefix(),burst->time().c_str(t),this);
+	m_txBurstStore.store(burst);
+	m_txStats.burstsDupOnRecv++;
+	return;
+    }
+    if (old) {
+	// Burst left in queue for a whole ring round: TX is not running
+	m_txStats.burstsExpiredOnSend++;
+	m_expired.insert(old);
     }
-    last->append(burst);
 }
 
 static inline GSMTxBurst* checkType(ARFCN* arfcn, GSMTxBurst* burst, const GSMTime& time,
@@ -3685,46 +4355,30 @@ GSMTxBurst* ARFCN::getBurst(const GSMTime& time, bool& owner)
     ObjList* found = m_expired.skipNull();
     for (; found; found = found->skipNull())
 	m_fillerTable.set(static_cast<GSMTxBurst*>(found->remove(false)));
-    // Check if we have a burst to send
-    for (found = m_txQueue.skipNull(); found; found = found->skipNext()) {
-	GSMTxBurst* b = static_cast<GSMTxBurst*>(found->get());
-	if (b->time() <= time)
-	    break;
-    }
-    // found: burst time equals requested time or is in the past
-    if (found) {
-	unsigned int expired = 0;
-	GSMTxBurst* b = static_cast<GSMTxBurst*>(found->remove(false));
-	// Same time: don't use as filler if chan type is GPRS
-	// NOTE:
-	//  See why we are doing it only if time matches
-	//  Why don't we do the same for expired, non filler, bursts?
-	//  We should do the same for all GPRS chans assuming the upper
-	//   layer is using fixed allocation
-	if (b->time() == time) {
-	    if (!burst)
-		burst = b;
-	    if (m_slots[time.tn()].type != ChanIGPRS)
-		m_fillerTable.set(b);
-	    else if (burst == b)
-		owner = true;
-	    else
-		m_txBurstStore.store(b);
-	}
-	else {
+    // Check if we have a burst to send, expire older ones
+    unsigned int expired = 0;
+    GSMTxBurst* b = m_txQueue.get(time,m_fillerTable,expired);
+    // Same time: don't use as filler if chan type is GPRS
+    // NOTE:
+    //  See why we are doing it only if time matches
+    //  Why don't we do the same for expired, non filler, bursts?
+    //  We should do the same for all GPRS chans assuming the upper
+    //   layer is using fixed allocation
+    if (b) {
+	if (!burst)
+	    burst = b;
+	if (m_slots[time.tn()].type != ChanIGPRS)
 	    m_fillerTable.set(b);
-	    expired++;
-	}
-	for (found = found->skipNull(); found; found = found->skipNull()) {
-	    m_fillerTable.set(static_cast<GSMTxBurst*>(found->remove(false)));
-	    expired++;
-	}
-	if (expired) {
-	    m_txStats.burstsExpiredOnSend += expired;
-	    if (txTimeDebugOk(time))
-		Debug(this,DebugNote,"%s%u burst(s) expired at %s [%p]",
-		    prefix(),expired,time.c_str(t),this);
-	}
+	else if (burst == b)
+	    owner = true;
+	else
+	    m_txBurstStore.store(b);
+    }
+    if (expired) {
+	m_txStats.burstsExpiredOnSend += expired;
+	if (txTimeDebugOk(time))
+	    Debug(this,DebugNote,"%s%u burst(s) expired at %s [%p]",
+		prefix(),expired,time.c_str(t),this);
     }
     lck.drop();
     if (burst)
@@ -3800,9 +4454,16 @@ void ARFCN::runRadioDataProcess()
 	burst->m_data.exchange(d->m_data);
 	m_radioRxStore.store(d);
 	ArfcnSlot& slot = m_slots[burst->time().tn()];
-	if (!transceiver()->processRadioBurst(arfcn(),slot,*burst) ||
-	    recvBurst(burst))
-	    continue;
+	if (transceiver()->processRadioBurst(arfcn(),slot,*burst)) {
+	    if (recvBurst(burst))
+		continue;
+	}
+	else {
+	    // Burst dropped: let upper layer interface send pending data if idle
+	    GSMRxBurst* none = 0;
+	    if (!m_rxQueue.empty() || recvBurst(none))
+		continue;
+	}
 	transceiver()->fatalError();
 	break;
     }
@@ -3813,11 +4474,7 @@ void ARFCN::runRadioDataProcess()
 void ARFCN::dumpBursts()
 {
     Lock myLock(m_txMutex);
-    for (ObjList* o = m_txQueue.skipNull();o;o = o->skipNext()) {
-	GSMTxBurst* b = static_cast<GSMTxBurst*>(o->get());
-	Debug(this,DebugAll,"Queued burst arfcn %u fn %u tn %u [%p]",
-	    m_arfcn,b->time().fn(),b->time().tn(),b);
-    }
+    m_txQueue.dump();
 }
 
 // Retrieve the channel type dictionary
@@ -3975,7 +4632,10 @@ void ARFCN::dumpSlotsDelay(String& dest)
 //
 ARFCNSocket::ARFCNSocket(unsigned int index)
     : ARFCN(index), m_data("data",false,5),
-    m_dataReadThread(0)
+    m_dataReadThread(0),
+    m_dataTransport(TrxDataUdp),
+    m_rxBatchCount(0),
+    m_shmFull(0)
 {
 }
 
@@ -4031,12 +4691,28 @@ void ARFCNSocket::radioPowerOff()
 }
 
 // Forward a burst to upper layer
+// Batched bursts are sent when the batch is full or there is no more radio input pending
 bool ARFCNSocket::recvBurst(GSMRxBurst*& burst)
 {
     if (!burst)
-	return true;
+	return flushRxBatch();
     m_lastUplinkBurstOutTime = burst->time();
     burst->fillEstimatesBuffer();
+    switch (m_dataTransport) {
+	case TrxDataShm:
+	    if (!m_shm.write(burst->m_bitEstimate,ARFCN_RXBURST_LEN) && !(m_shmFull++ % 1000))
+		Debug(this,DebugNote,"%sShared memory data ring full, dropped %u burst(s) [%p]",
+		    prefix(),m_shmFull,this);
+	    return true;
+	case TrxDataMmsg:
+	    if (!m_rxBatch.length())
+		m_rxBatch.assign(0,TRX_DATA_BATCH * ARFCN_RXBURST_LEN);
+	    ::memcpy(m_rxBatch.data(m_rxBatchCount * ARFCN_RXBURST_LEN,ARFCN_RXBURST_LEN),
+		burst->m_bitEstimate,ARFCN_RXBURST_LEN);
+	    if (++m_rxBatchCount < TRX_DATA_BATCH && !m_rxQueue.empty())
+		return true;
+	    return flushRxBatch();
+    }
     return m_data.writeSocket(burst->m_bitEstimate,ARFCN_RXBURST_LEN,*this) >= 0;
 }
 
@@ -4048,24 +4724,57 @@ void ARFCNSocket::runReadDataSocket()
     transceiver()->waitPowerOn();
     FloatVector tmpV;
     ComplexVector tmpW;
+    uint8_t buf[TRX_DATA_SHM_RECORD];
+    unsigned int lens[TRX_DATA_BATCH];
     while (!thShouldExit(transceiver())) {
+	if (m_dataTransport == TrxDataShm) {
+	    int r = m_shm.read(buf,sizeof(buf),Thread::idleMsec());
+	    if (r < 0)
+		return;
+	    if (r)
+		processTxData(buf,r,tmpV,tmpW);
+	    continue;
+	}
+	if (m_dataTransport == TrxDataMmsg) {
+	    int n = m_data.readSocketBatch(lens,TRX_DATA_BATCH,*this);
+	    if (n < 0)
+		return;
+	    for (int i = 0; i < n; i++)
+		processTxData(m_data.batchRecord(i),lens[i],tmpV,tmpW);
+	    continue;
+	}
 	int r = m_data.readSocket(*this);
 	if (r < 0)
 	    return;
-	if (!r)
-	    continue;
-	DataBlock tmp;
-	GSMTxBurst* burst = GSMTxBurst::parse(m_data.m_readBuffer.data(0),r,m_txBurstStore,&tmp);
-	if (!burst)
-	    continue;
-	// Transform (modulate + freq shift)
-	burst->buildTxData(transceiver()->signalProcessing(),&tmpV,&tmpW,tmp);
-	tmp.clear(false);
-	m_txTraffic.show(burst);
-	addBurst(burst);
+	if (r)
+	    processTxData(m_data.m_readBuffer.data(0),r,tmpV,tmpW);
     }
 }
 
+// Handle a burst received from upper layer
+void ARFCNSocket::processTxData(const uint8_t* buf, unsigned int len, FloatVector& tmpV,
+    ComplexVector& tmpW)
+{
+    DataBlock tmp;
+    GSMTxBurst* burst = GSMTxBurst::parse(buf,len,m_txBurstStore,&tmp);
+    if (!burst)
+	return;
+    // Transform (modulate + freq shift)
+    burst->buildTxData(transceiver()->signalProcessing(),&tmpV,&tmpW,tmp,
+	&transceiver()->txCache());
+    tmp.clear(false);
+    m_txTraffic.show(burst);
+    addBurst(burst);
+}
+
+// Send pending uplink bursts batch
+bool ARFCNSocket::flushRxBatch()
+{
+    unsigned int n = m_rxBatchCount;
+    m_rxBatchCount = 0;
+    return !n || m_data.writeSocketBatch(m_rxBatch.data(0),ARFCN_RXBURST_LEN,n,*this) >= 0;
+}
+
 // Worker terminated notification
 void ARFCNSocket::workerTerminated(Thread* th)
 {
@@ -4089,4 +4798,35 @@ bool ARFCNSocket::initUDP(int rPort, const char* rAddr, int lPort,
 	m_data.setAddr(false,rAddr,rPort,*this);
 }
 
+// Create the shared memory data interface
+bool ARFCNSocket::initShm(const char* path)
+{
+    Lock lck(m_mutex);
+    if (m_shm.create(path)) {
+	m_dataTransport = TrxDataShm;
+	Debug(this,DebugInfo,"%sCreated shared memory data interface '%s' [%p]",
+	    prefix(),path,this);
+	return true;
+    }
+    int error = errno;
+    String s;
+    Thread::errorString(s,error);
+    Alarm(this,"system",DebugWarn,
+	"%sFailed to create shared memory data interface '%s': %d %s [%p]",
+	prefix(),path,error,s.c_str(),this);
+    return false;
+}
+
+// Set the data transport. Release the shared memory interface if not used,
+//  remove its file if used (the upper layer already attached to it)
+void ARFCNSocket::setDataTransport(int transport)
+{
+    Lock lck(m_mutex);
+    m_dataTransport = transport;
+    if (transport != TrxDataShm)
+	m_shm.close();
+    else
+	m_shm.unlinkPath();
+}
+
 /* vi: set ts=8 sw=4 sts=4 noet: */
@@ -26,59 +26,92 @@
 #include <yateradio.h>
 #include "gsmutil.h"
 #include "sigproc.h"
+#include "trxdata.h"
 
 namespace TelEngine {
 
-class GenQueue;                          // A queue of GenObject
+class RingQueue;                         // A single producer/consumer queue of GenObject
 class TransceiverObj;                    // A tranceiver related object
 class TransceiverSockIface;              // Transceiver socket interface
 class TrxRadioIO;                        // Radio tx/rx related data
 class RadioRxData;                       // Radio read data
 class Transceiver;                       // A transceiver
 class TransceiverQMF;                    // A QMF transceiver
+class TransceiverPFB;                    // A polyphase filter bank transceiver
 class TxFillerTable;                     // A transmit filler table
+class TxBurstQueue;                      // A transmit burst queue
 class ARFCN;                             // A transceiver ARFCN
 class ARFCNSocket;                       // A transceiver ARFCN with socket interface
 class TransceiverWorker;                 // Private worker thread
 
 
 /**
- * This class implements a generic queue
- * @short A generic queue
+ * This class implements a bounded lock-free queue for a single producer and
+ *  a single consumer thread.
+ * Producer and consumer exchange objects without taking any lock, they spin
+ *  for a short period when the queue is full/empty before parking on a semaphore.
+ * The semaphores are signalled only when the other side is parked
+ * @short A single producer/single consumer queue
  */
-class GenQueue
+class RingQueue
 {
 public:
     /**
      * Constructor
-     * @param maxLen Optional maximum queue length
+     * @param maxLen Maximum queue length
      * @param name Queue name
      */
-    GenQueue(unsigned int maxLen = 0, const char* name = "GenQueue");
+    RingQueue(unsigned int maxLen, const char* name = "RingQueue");
+
+    /**
+     * Destructor. Destroy the objects still in the queue
+     */
+    ~RingQueue();
 
     /**
      * Check if the queue is empty
      * @return True if the queue is empty
      */
     inline bool empty() const
-	{ return m_empty; }
+	{ return __atomic_load_n(&m_head,__ATOMIC_ACQUIRE) ==
+	    __atomic_load_n(&m_tail,__ATOMIC_ACQUIRE); }
+
+    /**
+     * Retrieve the maximum queue length
+     * @return Maximum number of objects in queue
+     */
+    inline unsigned int capacity() const
+	{ return m_size - 1; }
 
     /**
-     * Add an object to the queue.
-     * Wait for space to be freed if there is maximum queue length
+     * Add an object to the queue. Don't wait for free space.
+     * This method must be called from producer thread only
+     * @param obj Object to add
+     * @return True on success, false if the queue is full
+     */
+    bool push(GenObject* obj);
+
+    /**
+     * Extract the object at queue head. Don't wait for objects.
+     * This method must be called from consumer thread only
+     * @return Queue head object, 0 if the queue is empty
+     */
+    GenObject* pop();
+
+    /**
+     * Add an object to the queue. Wait for space to be freed.
+     * This method must be called from producer thread only.
      * Don't consume the given object on failure
      * @param obj Object to add
      * @param trx Optional transceiver to check for exiting condition
-     * @return True on success, false on failure (queue full, calling thread was cancelled or
+     * @return True on success, false on failure (calling thread was cancelled or
      *  given transceiver is exiting)
      */
     bool add(GenObject* obj, Transceiver* trx = 0);
 
     /**
      * Wait for an object to be put in the queue.
-     * Extract the first element
-     * Returns when there is something in the queue or the calling thread was
-     *  cancelled or the given transceiver is exiting
+     * This method must be called from consumer thread only
      * @param obj Destination for extracted object
      * @param trx Optional transceiver to check for exiting condition
      * @return True on success, false if the calling thread should exit
@@ -87,27 +120,24 @@ public:
     bool waitPop(GenObject*& obj, Transceiver* trx = 0);
 
     /**
-     * Clear the queue
+     * Clear the queue.
+     * This method must be called when there is no producer or consumer running
      */
     void clear();
 
 private:
-    String m_name;
-
-protected:
-    /**
-     * Pop an object from queue head
-     * @return Queue head object, 0 if empty
-     */
-    GenObject* internalPop();
+    inline unsigned int next(unsigned int idx) const
+	{ return (idx + 1 < m_size) ? idx + 1 : 0; }
 
-    Mutex m_mutex;                       // Queue mutex
-    Semaphore m_free;                    // 
-    Semaphore m_used;                    // 
-    ObjList m_data;                      // The queue
-    bool m_empty;                        // Queue is empty
-    unsigned int m_count;                // The number of objects in queue
-    unsigned int m_max;                  // Maximum length
+    String m_name;
+    GenObject** m_data;                  // Objects buffer
+    unsigned int m_size;                 // Buffer size (maximum length + 1)
+    unsigned int m_head;                 // Next index to read (changed by consumer)
+    unsigned int m_tail;                 // Next index to write (changed by producer)
+    int m_consumerWait;                  // Consumer is parked
+    int m_producerWait;                  // Producer is parked
+    Semaphore m_used;                    // Consumer park semaphore
+    Semaphore m_free;                    // Producer park semaphore
 };
 
 
@@ -258,6 +288,36 @@ public:
      */
     int writeSocket(const void* buf, unsigned int len, TransceiverObj& dbg);
 
+    /**
+     * Read a batch of datagrams from socket.
+     * Wait for the first one as readSocket() does, retrieve the other already
+     *  queued ones (if any) in a single call
+     * @param lens Destination for read datagrams length
+     * @param count Maximum number of datagrams to read
+     * @param dbg Debug holder (for debug purposes)
+     * @return The number of datagrams read, negative on non retryiable error
+     */
+    int readSocketBatch(unsigned int* lens, unsigned int count, TransceiverObj& dbg);
+
+    /**
+     * Retrieve a datagram read by readSocketBatch()
+     * @param index Datagram index in batch
+     * @return Datagram data pointer
+     */
+    inline const uint8_t* batchRecord(unsigned int index) const
+	{ return index ? m_batchBuffer.data((index - 1) * m_readBuffer.length()) : m_readBuffer.data(0); }
+
+    /**
+     * Write a batch of equal length records to socket, one datagram each
+     * @param buf Buffer containing the records
+     * @param len Record length
+     * @param count The number of records to send
+     * @param dbg Debug holder (for debug purposes)
+     * @return The number of records sent, negative on non retryiable error
+     */
+    int writeSocketBatch(const void* buf, unsigned int len, unsigned int count,
+	TransceiverObj& dbg);
+
     /**
      * Terminate the socket
      * @param linger Linger interval
@@ -279,6 +339,7 @@ public:
     SocketAddr m_local;                  // Socket local address
     SocketAddr m_remote;                 // Socket remote address
     DataBlock m_readBuffer;              // Socket read buffer
+    DataBlock m_batchBuffer;             // Socket batch read buffer (records after first one)
 
 private:
     bool m_text;                         // Text interface
@@ -384,10 +445,12 @@ public:
      * Constructor
      */
     inline RadioRxData()
+	: m_power(0)
 	{}
 
     GSMTime m_time;
     ComplexVector m_data;
+    float m_power;                       // Data power (set when forwarded between QMF nodes)
 };
 
 typedef ObjStore<RadioRxData> RadioRxDataStore;
@@ -449,6 +512,13 @@ public:
     inline unsigned int arfcnCount() const
 	{ return m_arfcnCount; }
 
+    /**
+     * Retrieve the number of timeslots upper layer may send bursts ahead of radio time
+     * @return TX lead in timeslots
+     */
+    inline unsigned int txLeadSlots() const
+	{ return m_clockUpdOffset + m_txSlots + m_radioLatencySlots; }
+
     /**
      * Retrieve an ARFCN
      * @return ARFCN pointer or 0
@@ -456,6 +526,21 @@ public:
     inline ARFCN* arfcn(unsigned int index) const
 	{ return index < m_arfcnCount ? m_arfcn[index] : 0; }
 
+    /**
+     * Retrieve the burst data transport selected for upper layer
+     * @return Data transport (TrxDataTransport)
+     */
+    inline int dataTransport() const
+	{ return m_dataTransport; }
+
+    /**
+     * Append the selected data transport to a RESET response ('data=' parameter).
+     * Nothing is appended if the upper layer didn't offer any data transport
+     * @param dest Destination string
+     * @return Destination string
+     */
+    String& dataTransportParam(String& dest) const;
+
     /**
      * Initialize the transceiver. This method should be called after construction
      * @param radio The radio interface. The transceiver will own of the object
@@ -525,6 +610,13 @@ public:
     inline const SignalProcessing& signalProcessing() const
 	{ return m_signalProcessing; }
 
+    /**
+     * Get the modulated TX data cache shared by all ARFCNs and their filler tables
+     * @return Reference to TX data cache
+     */
+    inline GSMTxBurstCache& txCache()
+	{ return m_txCache; }
+
     /**
      * Start the transceiver upper layer interface if not already done
      * @return True on success
@@ -660,6 +752,21 @@ protected:
      */
     virtual void radioPowerOnStarting();
 
+    /**
+     * Start additional radio data process workers.
+     * Called on radio power on after starting the radio workers
+     * @return True on success, false on failure
+     */
+    virtual bool radioWorkersStart()
+	{ return true; }
+
+    /**
+     * Stop additional radio data process workers.
+     * Called on radio power off after stopping the radio workers
+     */
+    virtual void radioWorkersStop()
+	{ }
+
     /**
      * Set channel (slot) type
      * @param arfcn ARFCN number
@@ -680,6 +787,13 @@ protected:
     virtual void dumpFreqShift(unsigned int index) const
 	{ }
 
+    /**
+     * Append specific data to status
+     * @param dest Destination string
+     */
+    virtual void appendStatus(String& dest)
+	{ }
+
     /**
      * Helper method to check if the burst type is matching the timeslot and the time.
      * @param burst, The mburst to be sent.
@@ -781,7 +895,7 @@ protected:
     Thread* m_radioInThread;             // Worker (process radio input) thread
     Thread* m_radioOutThread;            // Worker (radio feeder) thread
     Thread::Priority m_radioOutPrio;     // Send radio worker priority
-    GenQueue m_rxQueue;                  // Pending radio data
+    RingQueue m_rxQueue;                 // Pending radio data
     unsigned int m_oversamplingRate;     // Tranceiver oversampling rate
     int m_burstMinPower;                 // Minimum burst power level to accept
     float m_snrThreshold;                // Signal to noise threshold
@@ -793,6 +907,10 @@ protected:
     unsigned int m_arfcnCount;           // The number of ARFCNs
     unsigned int m_arfcnConf;            // The number of configured ARFCNs
     TransceiverSockIface m_clockIface;   // Upper layer clock sync socket
+    int m_dataTransport;                 // Data transport selected for ARFCNs
+    int m_dataFallback;                  // Data transport to use if shared memory is not confirmed
+    bool m_dataOffered;                  // Upper layer offered data transports
+    String m_dataShmPrefix;              // Shared memory data segments path prefix
     Mutex m_clockUpdMutex;               // Protect clock update and tx time
     GSMTime m_nextClockUpdTime;          // Next clock update time
     GSMTime m_lastClockUpd;              // Last clock value advertised to upper layer
@@ -806,6 +924,7 @@ protected:
     bool m_radioSendChanged;             // Flag used to signal data changed for radio send data thread
     ComplexVector m_sendBurstBuf;        // Send burst buffer
     SignalProcessing m_signalProcessing; // SignalProcessing class initialized for this tranceiver
+    GSMTxBurstCache m_txCache;           // Modulated TX data shared by ARFCNs
     unsigned int m_tsc;                  // GSM TSC index
     RadioRxDataStore m_radioRxStore;     // Radio rx bursts store
     double m_rxFreq;                     // Rx frequency
@@ -823,6 +942,7 @@ protected:
     // Test data
     Mutex m_loopbackMutex;               // Loopback mutex
     bool m_loopback;                     // Loopback mode flag
+    RingQueue m_loopbackQueue;           // Loopback data to be forwarded by radio read thread
     int m_loopbackSleep;                 // Time to sleep between two consecutive bursts sent in loopback mode
     uint64_t m_loopbackNextSend;         // Next time to send a loopback burst
     ComplexVector* m_loopbackData;       // Data to feed the RX part
@@ -848,6 +968,10 @@ private:
     // Initialize the ARFCNs list (set or release)
     bool resetARFCNs(unsigned int arfcns = 0, int port = 0,
 	const String* rAddr = 0, const char* lAddr = 0, unsigned int nFillers = 0);
+    // Select the burst data transport from upper layer offer and our preference
+    void selectDataTransport(const NamedList& params, int port);
+    // Handle upper layer data transport confirmation (POWERON 'data=' parameter)
+    void confirmDataTransport(const String& param);
     // Stop all ARFCNs
     void stopARFCNs();
     // Sync upper layer GSM clock (update time)
@@ -902,8 +1026,14 @@ private:
 struct QmfBlock
 {
     inline QmfBlock()
-	: chans(false), arfcn(0xffffffff), freqShiftValue(0), power(0)
+	: chans(false), arfcn(0xffffffff), freqShiftValue(0), power(0),
+	runs(0), runTime(0), runTimeMax(0)
 	{}
+    inline void resetStats() {
+	    __atomic_store_n(&runs,0,__ATOMIC_RELAXED);
+	    __atomic_store_n(&runTime,0,__ATOMIC_RELAXED);
+	    __atomic_store_n(&runTimeMax,0,__ATOMIC_RELAXED);
+	}
     bool chans;                          // ARFCN channels availablity in subtree
     unsigned int arfcn;                  // ARFCN
     float freqShiftValue;                // Frequency shift parameter
@@ -911,6 +1041,9 @@ struct QmfBlock
     ComplexVector freqShift;             // Frequency shifting vector
     ComplexVector halfBandFilter;        // Used when applying the half band filter
     float power;                         // Used to calculate the power level
+    uint64_t runs;                       // The number of processed timeslots
+    uint64_t runTime;                    // Total processing time (microseconds)
+    uint64_t runTimeMax;                 // Maximum processing time (microseconds)
 };
 
 
@@ -953,6 +1086,18 @@ public:
      */
     virtual bool processRadioBurst(unsigned int arfcn, ArfcnSlot& slot, GSMRxBurst& b);
 
+    /**
+     * Run QMF subtree process loop (parallel channelizer)
+     * @param index Subtree root node index (1: low band, 2: high band)
+     */
+    void runQmfSubtree(unsigned int index);
+
+    /**
+     * Worker terminated notification
+     * @param th Worker thread
+     */
+    virtual void workerTerminated(Thread* th);
+
 protected:
     /**
      * Process received radio data
@@ -965,6 +1110,23 @@ protected:
      */
     virtual void radioPowerOnStarting();
 
+    /**
+     * Start QMF subtree workers if parallel processing is enabled
+     * @return True on success, false on failure
+     */
+    virtual bool radioWorkersStart();
+
+    /**
+     * Stop QMF subtree workers
+     */
+    virtual void radioWorkersStop();
+
+    /**
+     * Append QMF nodes processing statistics to status
+     * @param dest Destination string
+     */
+    virtual void appendStatus(String& dest);
+
     /**
      * Set channel (slot) type
      * @param arfcn ARFCN number
@@ -987,6 +1149,24 @@ protected:
 private:
     // Run the QMF algorithm on node at given index
     void qmf(const GSMTime& time, unsigned int index = 0);
+    // Forward low/high band output to a subtree worker
+    void qmfForward(const GSMTime& time, QmfBlock& b, unsigned int index);
+    inline RingQueue& qmfQueue(unsigned int index)
+	{ return index == 1 ? m_qmfLowQueue : m_qmfHighQueue; }
+    // Parallel mode flag is changed on radio power on/off and read by radio input thread
+    inline bool qmfParallel() const
+	{ return __atomic_load_n(&m_qmfParallel,__ATOMIC_ACQUIRE); }
+    inline void setQmfParallel(bool on)
+	{ __atomic_store_n(&m_qmfParallel,on,__ATOMIC_RELEASE); }
+    // Node statistics are updated by the thread processing the node (radio input
+    //  or subtree worker) and read by status requests: access them atomically
+    static inline void qmfUpdateStats(QmfBlock& b, uint64_t start) {
+	    uint64_t t = Time::now() - start;
+	    __atomic_add_fetch(&b.runs,1,__ATOMIC_RELAXED);
+	    __atomic_add_fetch(&b.runTime,t,__ATOMIC_RELAXED);
+	    if (__atomic_load_n(&b.runTimeMax,__ATOMIC_RELAXED) < t)
+		__atomic_store_n(&b.runTimeMax,t,__ATOMIC_RELAXED);
+	}
     inline void qmfApplyFreqShift(QmfBlock& b) {
 	    if (b.freqShift.length() < b.data.length())
 		SignalProcessing::setFreqShifting(&b.freqShift,b.freqShiftValue,
@@ -1004,14 +1184,85 @@ private:
     void checkDemodPerf(const ARFCN* a, const GSMRxBurst& b, int bType);
 
     QmfBlock m_qmf[15];                  // QMF tree
+    bool m_qmfParallelConf;              // Configured parallel QMF processing
+    bool m_qmfParallel;                  // Parallel QMF processing (subtree workers running)
+    Thread* m_qmfThread[2];              // Subtree workers (low/high band)
+    RingQueue m_qmfLowQueue;             // Pending data for low band subtree
+    RingQueue m_qmfHighQueue;            // Pending data for high band subtree
+    RadioRxDataStore m_qmfStore;         // Subtree workers data store
     unsigned int m_halfBandFltCoeffLen;  // Half band filter coefficients length
     FloatVector m_halfBandFltCoeff;      // Half band filter coefficients vector
     unsigned int m_tscSamples;           // The number of TSC samples used to build the channel estimate
     FloatVector m_nbTSC[8];              // GSM Normal Burst TSC vectors
     FloatVector m_abSync;                // Access burst sync vector
+    int m_equalizer;                     // Equalizer mode
     bool m_checkDemodPerf;               // Check demodulator performance
 };
 
+/**
+ * This class implements a transceiver using a polyphase filter bank channelizer.
+ * Received data is split into ARFCNs in one pass instead of walking the QMF tree.
+ * Burst processing (demodulation) is the same as the QMF transceiver's
+ * @short A polyphase filter bank transceiver
+ */
+class TransceiverPFB : public TransceiverQMF
+{
+    YCLASS(TransceiverPFB,TransceiverQMF)
+    YNOCOPY(TransceiverPFB);
+public:
+    /**
+     * Constructor
+     * @param name Transceiver name
+     */
+    TransceiverPFB(const char* name = "transceiver");
+
+protected:
+    /**
+     * Process received radio data
+     * @param d Radio data, the pointer will be consumed
+     */
+    virtual void processRadioData(RadioRxData* d);
+
+    /**
+     * Starting radio power on notification
+     */
+    virtual void radioPowerOnStarting();
+
+    /**
+     * Start additional radio data process workers.
+     * The channelizer don't use workers (QMF subtree workers are not started)
+     * @return True
+     */
+    virtual bool radioWorkersStart()
+	{ return true; }
+
+    /**
+     * Append channelizer processing statistics to status
+     * @param dest Destination string
+     */
+    virtual void appendStatus(String& dest);
+
+    /**
+     * Set channel (slot) type
+     * @param arfcn ARFCN number
+     * @param slot Timeslot number
+     * @param chanType Channel type
+     */
+    virtual void setChanType(unsigned int arfcn, unsigned int slot, int chanType);
+
+    /**
+     * ARFCN list changed notification
+     */
+    virtual void arfcnListChanged();
+
+private:
+    PolyphaseChannelizer m_pfb;          // The channelizer
+    ComplexVectorVector m_pfbOut;        // Channelizer output
+    uint64_t m_pfbRuns;                  // Processed slots
+    uint64_t m_pfbRunTime;               // Total processing time
+    uint64_t m_pfbRunTimeMax;            // Maximum processing time
+};
+
 /**
  * Helper class to show mbts data excenge
  */
@@ -1137,6 +1388,89 @@ private:
 };
 
 
+/**
+ * This class implements a transmit burst queue.
+ * Bursts are kept in a ring of timeslots indexed by burst time modulo ring length.
+ * The ring must be longer than the interval bursts are accepted in advance
+ * @short A transmit burst queue
+ */
+class TxBurstQueue
+{
+public:
+    /**
+     * Constructor
+     * @param owner Queue owner
+     */
+    TxBurstQueue(ARFCN* owner);
+
+    /**
+     * Destructor
+     */
+    ~TxBurstQueue()
+	{ clear(); }
+
+    /**
+     * Retrieve the number of queued bursts
+     * @return The number of queued bursts
+     */
+    inline unsigned int count() const
+	{ return m_count; }
+
+    /**
+     * Check if a burst time was already handled by get()
+     * @param time Burst time to check
+     * @return True if the time is older than the last requested one
+     */
+    inline bool late(const GSMTime& time) const
+	{ return m_started && time < m_next; }
+
+    /**
+     * Add a burst to queue
+     * @param burst Burst to add, consumed on success
+     * @param old Set to the older burst found in burst slot (not sent in time)
+     * @return False if a burst with the same time is already queued
+     */
+    bool add(GSMTxBurst* burst, GSMTxBurst*& old);
+
+    /**
+     * Retrieve the burst to be sent at a specified time.
+     * Move older bursts to filler table
+     * @param time Burst time
+     * @param fillers Filler table receiving expired bursts
+     * @param expired Incremented with the number of expired bursts
+     * @return Queued burst to be sent at requested time, 0 if not found
+     */
+    GSMTxBurst* get(const GSMTime& time, TxFillerTable& fillers, unsigned int& expired);
+
+    /**
+     * Dump queued bursts in time order
+     */
+    void dump();
+
+    /**
+     * Release queued bursts, forget the next time to send.
+     * Called when the radio clock (re)starts
+     */
+    void reset();
+
+    /**
+     * Release all queued bursts
+     */
+    void clear();
+
+private:
+    inline unsigned int index(const GSMTime& time) const
+	{ return time.timeslot() & (m_length - 1); }
+
+    GSMTxBurst** m_slots;                // Ring of timeslots
+    unsigned int m_length;               // Ring length
+    unsigned int m_count;                // The number of queued bursts
+    bool m_started;                      // The next time to send was set
+    GSMTime m_next;                      // Next time to send
+    ARFCN* m_owner;
+};
+
+
 class ARFCNStatsTx
 {
 public:
@@ -1168,6 +1502,7 @@ class ARFCN : public TransceiverObj
     YNOCOPY(ARFCN);
     friend class Transceiver;
     friend class TransceiverQMF;
+    friend class TransceiverPFB;
 public:
     /**
      * Channel type
@@ -1427,13 +1762,14 @@ protected:
 
     /**
      * Forward a burst to upper layer
-     * @param burst The burst to process. The pointer must be reset if consumed
+     * @param burst The burst to process. The pointer must be reset if consumed.
+     *  0 if a burst was dropped and there is no more radio input pending
      * @return True on success, false on fatal error
      */
     virtual bool recvBurst(GSMRxBurst*& burst);
 
     Mutex m_mutex;                       // Protect data changes
-    GenQueue m_rxQueue;                  // Radio input
+    RingQueue m_rxQueue;                 // Radio input
     RadioRxDataStore m_radioRxStore;     // Radio rx bursts store
     Thread* m_radioInThread;             // Radio input processor
     uint8_t m_chans;                     // The number of channels whose type is not ChanNone
@@ -1465,7 +1801,7 @@ private:
     unsigned int m_arfcn;                // ARFCN
     TxFillerTable m_fillerTable;         // Fillers table
     Mutex m_txMutex;                     // Transmit queue blocker
-    ObjList m_txQueue;                   // Transmit queue
+    TxBurstQueue m_txQueue;              // Transmit queue
     ObjList m_expired;                   // List of expired bursts
     TrafficShaper m_shaper;              // Traffic shaper
 };
@@ -1537,7 +1873,8 @@ protected:
 
     /**
      * Forward a burst to upper layer
-     * @param burst The burst to process. The pointer must be reset if consumed
+     * @param burst The burst to process. The pointer must be reset if consumed.
+     *  0 if a burst was dropped and there is no more radio input pending
      * @return True on success, false on fatal error
      */
     virtual bool recvBurst(GSMRxBurst*& burst);
@@ -1552,8 +1889,35 @@ protected:
     bool initUDP(int rPort, const char* rAddr, int lPort,
 	const char* lAddr = "0.0.0.0");
 
+    /**
+     * Create the shared memory data interface
+     * @param path Segment file path
+     * @return True on success
+     */
+    bool initShm(const char* path);
+
+    /**
+     * Set the data transport. Release the shared memory interface if not used,
+     *  remove the segment file if used
+     * @param transport Data transport (TrxDataTransport)
+     */
+    void setDataTransport(int transport);
+
     TransceiverSockIface m_data;         // Data interface
     Thread* m_dataReadThread;            // Worker (read data socket) thread
+    TrxDataShmIface m_shm;               // Shared memory data interface
+    int m_dataTransport;                 // Data transport in use
+
+private:
+    // Handle a burst received from upper layer
+    void processTxData(const uint8_t* buf, unsigned int len, FloatVector& tmpV,
+	ComplexVector& tmpW);
+    // Send pending uplink bursts batch
+    bool flushRxBatch();
+
+    DataBlock m_rxBatch;                 // Uplink bursts waiting to be sent in batch
+    unsigned int m_rxBatchCount;         // The number of bursts in batch
+    unsigned int m_shmFull;              // Uplink bursts dropped on full shared memory ring
 };
 
 
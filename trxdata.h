@@ -0,0 +1,369 @@
+/**
+ * trxdata.h
+ * This file is part of the Yate-BTS Project http://www.yatebts.com
+ *
+ * Transceiver burst data interface shared by mbts and transceiver
+ *
+ * Yet Another Telephony Engine - Base Transceiver Station
+ * Copyright (C) 2014-2023 Null Team Impex SRL
+ *
+ * This software is distributed under multiple licenses;
+ * see the COPYING file in the main directory for licensing
+ * information for this specific distribution.
+ *
+ * This use of this software may be subject to additional restrictions.
+ * See the LEGAL file in the main directory for details.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+
+#ifndef __TRXDATA_H
+#define __TRXDATA_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+// Burst data transport between mbts and transceiver
+// Negotiated in RESET (offer/selection) and POWERON (confirmation) commands:
+//  RESET <arfcns> data=<offered list>, answered with RSP RESET 0 data=<selected>
+//  POWERON data=<transport> confirms the transport actually used by mbts
+// A peer not sending 'data=' is using the UDP interface
+enum TrxDataTransport
+{
+    TrxDataUdp = 0,                      // One datagram per burst
+    TrxDataMmsg,                         // Datagrams, batched with sendmmsg/recvmmsg
+    TrxDataShm                           // Shared memory ring pair
+};
+
+// Maximum number of datagrams read or sent in a single batch
+#define TRX_DATA_BATCH 16
+
+// Shared memory segment layout
+#define TRX_DATA_SHM_MAGIC 0x59425453    // 'YBTS'
+#define TRX_DATA_SHM_VERSION 1
+#define TRX_DATA_SHM_SLOTS 64            // Slots in each ring, must be a power of 2
+#define TRX_DATA_SHM_RECORD 160          // Maximum burst record length
+#define TRX_DATA_SHM_DIR "/dev/shm/"     // Directory holding segment files
+#define TRX_DATA_SHM_NAME "ybts-trx-"    // Segment file name prefix, followed by creator pid
+
+// A burst record in ring
+struct TrxDataShmRecord
+{
+    uint32_t len;
+    uint8_t data[TRX_DATA_SHM_RECORD];
+};
+
+// Single producer, single consumer ring
+// Producer and consumer indexes are kept in separate cache lines
+// The consumer sets 'waiting' before sleeping on 'doorbell', the producer
+//  rings the doorbell (increment + wake) only when the consumer is waiting
+struct TrxDataShmRing
+{
+    volatile uint32_t head;              // Producer index
+    uint8_t padHead[60];
+    volatile uint32_t tail;              // Consumer index
+    uint8_t padTail[60];
+    volatile uint32_t waiting;           // Consumer is waiting for data
+    volatile uint32_t doorbell;          // Futex word used to wake up the consumer
+    uint8_t padBell[56];
+    TrxDataShmRecord records[TRX_DATA_SHM_SLOTS];
+};
+
+// Segment: header and downlink (mbts to transceiver), uplink (transceiver to mbts) rings
+struct TrxDataShmSegment
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slots;
+    uint32_t record;
+    uint8_t padHeader[48];
+    TrxDataShmRing down;
+    TrxDataShmRing up;
+};
+
+/**
+ * This class holds one ARFCN shared memory data interface.
+ * The transceiver creates (and removes) the segment, mbts attaches to it.
+ * Each side is the only producer of its output ring and the only consumer of its input one
+ * @short Shared memory burst data interface
+ */
+class TrxDataShmIface
+{
+public:
+    /**
+     * Constructor
+     */
+    inline TrxDataShmIface()
+	: m_segment(0), m_tx(0), m_rx(0), m_owner(false)
+	{ m_path[0] = 0; }
+
+    /**
+     * Destructor. Detach from (remove if owned) segment
+     */
+    inline ~TrxDataShmIface()
+	{ close(); }
+
+    /**
+     * Check if the interface is usable
+     * @return True if attached to a segment
+     */
+    inline bool valid() const
+	{ return m_segment != 0; }
+
+    /**
+     * Retrieve the segment file path
+     * @return Segment file path, empty if not attached
+     */
+    inline const char* path() const
+	{ return m_path; }
+
+    /**
+     * Create a segment (transceiver side). Sends on uplink, receives from downlink ring
+     * @param path Segment file path
+     * @return True on success
+     */
+    inline bool create(const char* path)
+	{
+	    if (!attach(path,true))
+		return false;
+	    m_tx = &m_segment->up;
+	    m_rx = &m_segment->down;
+	    return true;
+	}
+
+    /**
+     * Attach to an existing segment (mbts side). Sends on downlink, receives from uplink ring
+     * @param path Segment file path
+     * @return True on success
+     */
+    inline bool open(const char* path)
+	{
+	    if (!attach(path,false))
+		return false;
+	    m_tx = &m_segment->down;
+	    m_rx = &m_segment->up;
+	    return true;
+	}
+
+    /**
+     * Detach from segment. Remove the segment file if created by this object
+     */
+    inline void close()
+	{
+	    if (m_segment) {
+		::munmap((void*)m_segment,sizeof(TrxDataShmSegment));
+		m_segment = 0;
+	    }
+	    if (m_owner && m_path[0])
+		::unlink(m_path);
+	    m_tx = m_rx = 0;
+	    m_owner = false;
+	    m_path[0] = 0;
+	}
+
+    /**
+     * Remove the segment file, keep the mapping.
+     * Called once both sides mapped the segment so it goes away with them
+     */
+    inline void unlinkPath()
+	{
+	    if (m_owner && m_path[0])
+		::unlink(m_path);
+	    m_owner = false;
+	}
+
+    /**
+     * Remove segment files left behind by crashed transceivers
+     * (created by processes no longer running)
+     */
+    static inline void removeStale()
+	{
+	    DIR* dir = ::opendir(TRX_DATA_SHM_DIR);
+	    if (!dir)
+		return;
+	    const unsigned int n = ::strlen(TRX_DATA_SHM_NAME);
+	    struct dirent* e;
+	    while ((e = ::readdir(dir)) != 0) {
+		if (::strncmp(e->d_name,TRX_DATA_SHM_NAME,n))
+		    continue;
+		char* end = 0;
+		long pid = ::strtol(e->d_name + n,&end,10);
+		if (pid <= 0 || !end || *end != '-')
+		    continue;
+		if (::kill((pid_t)pid,0) == 0 || errno != ESRCH)
+		    continue;
+		char path[128];
+		if (::strlen(TRX_DATA_SHM_DIR) + ::strlen(e->d_name) >= sizeof(path))
+		    continue;
+		::strcpy(path,TRX_DATA_SHM_DIR);
+		::strcat(path,e->d_name);
+		::unlink(path);
+	    }
+	    ::closedir(dir);
+	}
+
+    /**
+     * Put a record in output ring, wake up the consumer if waiting.
+     * Never blocks
+     * @param buf Record data
+     * @param len Record length
+     * @return True on success, false if not attached, ring is full or record too long
+     */
+    inline bool write(const void* buf, unsigned int len)
+	{
+	    if (!(m_tx && len <= TRX_DATA_SHM_RECORD))
+		return false;
+	    uint32_t head = m_tx->head;
+	    if (head - __atomic_load_n(&m_tx->tail,__ATOMIC_ACQUIRE) >= TRX_DATA_SHM_SLOTS)
+		return false;
+	    TrxDataShmRecord& r = m_tx->records[head & (TRX_DATA_SHM_SLOTS - 1)];
+	    ::memcpy(r.data,buf,len);
+	    r.len = len;
+	    __atomic_store_n(&m_tx->head,head + 1,__ATOMIC_SEQ_CST);
+	    if (__atomic_load_n(&m_tx->waiting,__ATOMIC_SEQ_CST)) {
+		__atomic_add_fetch(&m_tx->doorbell,1,__ATOMIC_SEQ_CST);
+		wake(&m_tx->doorbell);
+	    }
+	    return true;
+	}
+
+    /**
+     * Retrieve a record from input ring
+     * @param buf Destination buffer
+     * @param len Destination buffer length, longer records are truncated
+     * @param timeoutMs Interval to wait for data, 0 to return immediately
+     * @return Record length, 0 if nothing was available, negative if not attached
+     */
+    inline int read(void* buf, unsigned int len, unsigned int timeoutMs)
+	{
+	    if (!m_rx)
+		return -1;
+	    uint32_t tail = m_rx->tail;
+	    if (__atomic_load_n(&m_rx->head,__ATOMIC_ACQUIRE) == tail) {
+		if (!timeoutMs)
+		    return 0;
+		__atomic_store_n(&m_rx->waiting,1,__ATOMIC_SEQ_CST);
+		uint32_t bell = __atomic_load_n(&m_rx->doorbell,__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&m_rx->head,__ATOMIC_SEQ_CST) == tail)
+		    wait(&m_rx->doorbell,bell,timeoutMs);
+		__atomic_store_n(&m_rx->waiting,0,__ATOMIC_RELAXED);
+		if (__atomic_load_n(&m_rx->head,__ATOMIC_ACQUIRE) == tail)
+		    return 0;
+	    }
+	    const TrxDataShmRecord& r = m_rx->records[tail & (TRX_DATA_SHM_SLOTS - 1)];
+	    unsigned int n = r.len;
+	    if (n > len)
+		n = len;
+	    ::memcpy(buf,r.data,n);
+	    __atomic_store_n(&m_rx->tail,tail + 1,__ATOMIC_RELEASE);
+	    return n;
+	}
+
+    /**
+     * Retrieve the number of records waiting in input ring
+     * @return The number of records waiting to be read
+     */
+    inline unsigned int pending() const
+	{
+	    return m_rx ? (__atomic_load_n(&m_rx->head,__ATOMIC_ACQUIRE) - m_rx->tail) : 0;
+	}
+
+private:
+    inline bool attach(const char* path, bool create)
+	{
+	    close();
+	    if (!(path && *path && ::strlen(path) < sizeof(m_path)))
+		return false;
+	    int fd = create ? ::open(path,O_RDWR | O_CREAT | O_EXCL,0600) : ::open(path,O_RDWR);
+	    if (fd < 0)
+		return false;
+	    bool ok = false;
+	    void* p = MAP_FAILED;
+	    if (create)
+		ok = (0 == ::ftruncate(fd,sizeof(TrxDataShmSegment)));
+	    else {
+		struct stat st;
+		ok = (0 == ::fstat(fd,&st)) && st.st_size == (off_t)sizeof(TrxDataShmSegment);
+	    }
+	    if (ok)
+		p = ::mmap(0,sizeof(TrxDataShmSegment),PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+	    ::close(fd);
+	    ok = (p != MAP_FAILED);
+	    if (ok) {
+		TrxDataShmSegment* s = (TrxDataShmSegment*)p;
+		if (create) {
+		    ::memset(p,0,sizeof(TrxDataShmSegment));
+		    s->version = TRX_DATA_SHM_VERSION;
+		    s->slots = TRX_DATA_SHM_SLOTS;
+		    s->record = TRX_DATA_SHM_RECORD;
+		    __atomic_store_n(&s->magic,TRX_DATA_SHM_MAGIC,__ATOMIC_RELEASE);
+		}
+		else
+		    ok = __atomic_load_n(&s->magic,__ATOMIC_ACQUIRE) == TRX_DATA_SHM_MAGIC &&
+			s->version == TRX_DATA_SHM_VERSION && s->slots == TRX_DATA_SHM_SLOTS &&
+			s->record == TRX_DATA_SHM_RECORD;
+		if (ok)
+		    m_segment = s;
+		else
+		    ::munmap(p,sizeof(TrxDataShmSegment));
+	    }
+	    if (create && !ok)
+		::unlink(path);
+	    if (!ok)
+		return false;
+	    ::strcpy(m_path,path);
+	    m_owner = create;
+	    return true;
+	}
+
+    // Sleep until doorbell changes from given value or timeout
+    static inline void wait(volatile uint32_t* bell, uint32_t val, unsigned int timeoutMs)
+	{
+#ifdef __linux__
+	    struct timespec ts;
+	    ts.tv_sec = timeoutMs / 1000;
+	    ts.tv_nsec = (timeoutMs % 1000) * 1000000;
+	    ::syscall(SYS_futex,bell,FUTEX_WAIT,val,&ts,0,0);
+#else
+	    // No process shared wait primitive: poll the doorbell
+	    for (unsigned int i = 0; i < timeoutMs; i++) {
+		if (__atomic_load_n(bell,__ATOMIC_ACQUIRE) != val)
+		    break;
+		::usleep(1000);
+	    }
+#endif
+	}
+
+    static inline void wake(volatile uint32_t* bell)
+	{
+#ifdef __linux__
+	    ::syscall(SYS_futex,bell,FUTEX_WAKE,1,0,0,0);
+#endif
+	}
+
+    TrxDataShmSegment* m_segment;        // Mapped segment
+    TrxDataShmRing* m_tx;                // Output ring
+    TrxDataShmRing* m_rx;                // Input ring
+    bool m_owner;                        // Segment created by this object
+    char m_path[128];                    // Segment file path
+};
+
+#endif /* __TRXDATA_H */
+
+/* vi: set ts=8 sw=4 sts=4 noet: */
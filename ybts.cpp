@@ -89,6 +89,36 @@ namespace { // anonymous
 // Maximum GPRS authentication attempts
 #define YBTS_GPRS_MAX_AUTHS 2
 
+// UE index size and number of locks protecting it
+// The number of locks must divide the index size
+#define YBTS_UE_INDEX_SIZE 4096
+#define YBTS_UE_INDEX_LOCKS 64
+
+// Default number of UEs registered by UE index benchmark (debug builds only)
+#define YBTS_UE_BENCH_DEF 100000
+
+// Default number of messages of each kind processed by signalling benchmark (debug builds only)
+#define YBTS_SIG_BENCH_DEF 100000
+
+// Maximum number of media datagrams read by one system call
+#define YBTS_RECV_BATCH 16
+
+// Worker pool threads and queued tasks
+#define YBTS_WORKERS_DEF 64
+#define YBTS_WORKERS_MIN 1
+#define YBTS_WORKERS_MAX 1024
+#define YBTS_TASK_QUEUE_DEF 2048
+#define YBTS_TASK_QUEUE_MIN 16
+#define YBTS_TASK_QUEUE_MAX 100000
+// Maximum time (in milliseconds) a task may wait in queue, defaults to MS T3210
+#define YBTS_TASK_WAIT_DEF 20000
+#define YBTS_TASK_WAIT_MIN 1000
+#define YBTS_TASK_WAIT_MAX 600000
+// Interval (in microseconds) a worker waits for tasks before checking exit conditions
+#define YBTS_WORKER_WAIT_US 100000
+// Number of wait intervals after which an idle worker exits
+#define YBTS_WORKER_IDLE_WAITS 100
+
 #define YBTS_SET_REASON_BREAK(s) { reason = s; break; }
 
 #define NO_CONN_ID 0xffff
@@ -164,6 +194,9 @@ class YBTSThreadOwner;
 class YBTSMessage;                       // YBTS <-> BTS PDU
 class YBTSTransport;
 class YBTSGlobalThread;                  // GenObject and Thread descendent
+class YBTSTask;                          // Task executed by worker pool
+class YBTSWorker;                        // Worker pool thread
+class YBTSTaskPool;                      // Bounded worker pool
 class YBTSConnAuthThread;                // Authenticator for MT services
 class YBTSLAI;                           // Holds local area id
 class YBTSTid;                           // Transaction identifier holder
@@ -173,8 +206,9 @@ class YBTSCommand;                       // Command interface
 class YBTSSignalling;                    // Signalling interface
 class YBTSMedia;                         // Media interface
 class YBTSUE;                            // A registered equipment
+class YBTSUEIndex;                       // UE hash index
 class YBTSLocationUpd;                   // Running location update from UE
-class YBTSSubmit;                        // MO SMS/SS submit thread
+class YBTSSubmit;                        // MO SMS/SS submit task
 class YBTSSmsInfo;                       // Holds data describing a pending SMS
 class YBTSMtSms;                         // Holds data describing a pending MT SMS
 class YBTSMtSmsList;                     // A list of MT SMS for the same UE target
@@ -183,7 +217,7 @@ class YBTSDataSource;
 class YBTSDataConsumer;
 class YBTSCallDesc;
 class YBTSChan;
-class YBTSChanThread;                    // Channel utility thread (authentication)
+class YBTSChanThread;                    // Channel utility task (authentication)
 class YBTSDriver;
 class YBTSMsgHandler;
 class YBTSGprsAttach;
@@ -192,6 +226,7 @@ class YBTSGprsAttach;
 // Section 8.5 / Section 10.5.3.6 / Annex G
 enum RejectCause {
 
+    CauseCongestion = 22,                // Congestion
     CauseServNotSupp = 32,               // Service option not implemented
     CauseMMTemporaryFailure = 34,        // MM Service temporary out of order
     CauseInvalidIE = 96,                 // Invalid mandatory IE
@@ -259,6 +294,8 @@ public:
     ~YBTSConnAuth();
     // Set connection
     bool authSetConn(uint16_t connid);
+    // Check if the connection was released
+    bool authConnReleased() const;
     // Send auth request. Wait for completion.
     // Return true if sent (a response was receveid of request was dropped)
     bool authSend(NamedList& params, String& reason, unsigned int* intervals = 0);
@@ -332,7 +369,8 @@ public:
     inline YBTSMessage(uint8_t pri = 0, uint8_t info = 0, uint16_t cid = NO_CONN_ID,
 	XmlElement* xml = 0)
         : YBTSConnIdHolder(cid),
-        m_primitive(pri), m_info(info), m_xml(xml), m_error(false)
+        m_primitive(pri), m_info(info), m_xml(xml), m_error(false),
+	m_payload(0), m_payloadLen(0), m_l3Type(-1)
 	{}
     ~YBTSMessage()
 	{ TelEngine::destruct(m_xml); }
@@ -350,6 +388,16 @@ public:
 	{ XmlElement* x = m_xml; m_xml = 0; return x; }
     inline bool error() const
 	{ return m_error; }
+    // Raw payload of a received message not decoded to XML
+    // Valid only while the receive buffer is not reused
+    inline const uint8_t* payload() const
+	{ return m_payload; }
+    inline unsigned int payloadLen() const
+	{ return m_payloadLen; }
+    // L3 message left undecoded (lazy decode): PD in upper octet, MTI in lower one
+    // Negative if the message was decoded
+    inline int l3Type() const
+	{ return m_l3Type; }
     // Parse message. Return 0 on failure
     static YBTSMessage* parse(YBTSSignalling* receiver, uint8_t* data, unsigned int len);
     // Build a message
@@ -364,6 +412,9 @@ protected:
     uint8_t m_info;
     XmlElement* m_xml;
     bool m_error;                        // Encode/decode error flag
+    const uint8_t* m_payload;            // Undecoded payload
+    unsigned int m_payloadLen;           // Undecoded payload length
+    int m_l3Type;                        // Undecoded L3 message PD and MTI
 };
 
 class YBTSDataSource : public DataSource, public YBTSConnIdHolder
@@ -414,9 +465,17 @@ protected:
 	{ return send(data.data(),data.length(),ignoreError); }
     // Read socket data. Return 0: nothing read, >1: read data, negative: fatal error
     int recv(bool ignoreError = false);
+    // Read all available datagrams (up to YBTS_RECV_BATCH)
+    // Return the number of messages read, 0 if nothing was read, negative on fatal error
+    int recvBatch(bool ignoreError = false);
+    // Retrieve a message read by recvBatch()
+    inline uint8_t* batchMsg(unsigned int index, unsigned int& len) {
+	    len = m_batchLen[index];
+	    return (uint8_t*)m_batchBuf.data() + index * m_readBuf.length();
+	}
     bool initTransport(bool stream, unsigned int buflen, bool reserveNull);
     void resetTransport();
-    void alarmError(Socket& sock, const char* oper);
+    void alarmError(Socket& sock, const char* oper, int error = 0);
 
     Socket m_socket;
     Socket m_readSocket;
@@ -424,6 +483,12 @@ protected:
     Socket m_remoteSocket;
     DataBlock m_readBuf;
     unsigned int m_maxRead;
+    DataBlock m_batchBuf;
+    unsigned int m_batchLen[YBTS_RECV_BATCH];
+
+private:
+    // Wait for socket data. Return 1: can read, 0: nothing to read, negative: fatal error
+    int waitRead(bool ignoreError);
 };
 
 class YBTSGlobalThread : public Thread, public GenObject
@@ -451,21 +516,111 @@ public:
     static Mutex s_threadsMutex;
 };
 
-class YBTSConnAuthThread : public YBTSGlobalThread, public YBTSConnAuthMt
+// Task executed by a pool worker thread
+// Tasks with the same key (UE identity) are executed one at a time, in queue order
+class YBTSTask : public GenObject
 {
+    friend class YBTSTaskPool;
 public:
-    inline YBTSConnAuthThread(uint16_t connid, YBTSUE* ue, int origin)
-	: YBTSGlobalThread("YBTSConnAuth"), YBTSConnAuthMt(connid,ue,origin)
+    inline YBTSTask(const char* name)
+	: m_name(name), m_enqueueTime(0)
+	{}
+    inline const char* name() const
+	{ return m_name; }
+    inline const String& key() const
+	{ return m_key; }
+    // Execute the task in a worker thread
+    virtual void run() = 0;
+    // Task removed from queue without being executed
+    virtual void cancelled()
 	{}
+    // Check if the connection the task works for was released
+    virtual bool released() const
+	{ return false; }
+protected:
+    // Set key from UE. The UE object is kept when its IMSI or TMSI changes
+    void setKey(const YBTSUE* ue);
+    const char* m_name;
+    String m_key;
+private:
+    uint64_t m_enqueueTime;
+};
+
+class YBTSWorker : public YBTSGlobalThread
+{
+    friend class YBTSTaskPool;
+public:
+    inline YBTSWorker(YBTSTaskPool* pool, const char* name)
+	: YBTSGlobalThread(name), m_pool(pool), m_task(0), m_taskStart(0),
+	m_drop(false)
+	{}
+    ~YBTSWorker();
+protected:
+    virtual void run();
+    YBTSTaskPool* m_pool;                // The pool owning the worker
+    YBTSTask* m_task;                    // Running task
+    uint64_t m_taskStart;                // Running task start time
+    bool m_drop;                         // Running task must be cancelled, not executed
+};
+
+// Bounded pool of worker threads executing queued tasks
+class YBTSTaskPool : public Mutex
+{
+public:
+    YBTSTaskPool(const char* name, const char* workerName, const char* prefix);
+    // Set the maximum number of worker threads, queued tasks and queue wait (in milliseconds)
+    void setLimits(unsigned int workers, unsigned int queue, unsigned int waitMs);
+    // Queue a task. Return false if the task was not queued (queue full)
+    bool enqueue(YBTSTask* task);
+    // Cancel a task: remove it from queue or cancel the thread running it
+    void cancel(YBTSTask* task);
+    // Remove all queued tasks, wake up idle workers
+    void clear();
+    void status(String& buf);
+    // Retrieve the next task to run, wait for one if none is available
+    // A task which waited too long or whose connection was released is returned
+    //  with the worker's drop flag set
+    // Return 0 if the worker should exit
+    YBTSTask* take(YBTSWorker* worker);
+    // Running task terminated
+    void taskDone(YBTSWorker* worker);
+    void workerTerminated(YBTSWorker* worker);
+private:
+    bool startWorker();
+    const char* m_workerName;            // Name of worker threads
+    const char* m_prefix;                // Status parameters prefix
+    ObjList m_queue;                     // Queued tasks
+    unsigned int m_queued;               // Number of queued tasks
+    ObjList m_busy;                      // Keys of running tasks
+    ObjList m_workers;                   // Worker threads (not owned)
+    unsigned int m_idle;                 // Workers waiting for tasks
+    unsigned int m_maxWorkers;
+    unsigned int m_maxQueue;
+    uint64_t m_maxWait;                  // Maximum time a task may wait in queue
+    Semaphore m_semaphore;
+    unsigned int m_rejected;             // Tasks rejected due to full queue
+    unsigned int m_dropped;              // Tasks dropped (released connection or waited too long)
+    unsigned int m_executed;             // Executed tasks
+    uint64_t m_waitSum;                  // Total time spent by tasks in queue
+    uint64_t m_waitMax;                  // Maximum time spent by a task in queue
+    uint64_t m_runSum;                   // Total tasks run time
+};
+
+class YBTSConnAuthThread : public YBTSTask, public YBTSConnAuthMt
+{
+public:
+    YBTSConnAuthThread(uint16_t connid, YBTSUE* ue, int origin);
     ~YBTSConnAuthThread()
 	{ notify(true); }
-    virtual void cleanup()
-	{ notify(true); }
+    virtual void cancelled()
+	{ notify(false); }
+    virtual bool released() const
+	{ return authConnReleased(); }
+    // Task could not be queued: release the connection
+    void congestion();
 protected:
-    virtual void run() {
-	    set(this,true);
-	    notify(false,authMt() == 0);
-	}
+    virtual void run()
+	{ notify(false,authMt() == 0); }
     void notify(bool final, bool ok = false);
 };
 
@@ -669,15 +824,27 @@ public:
 	}
     inline void getPhyInfo(String& info) {
 	    Lock lck(this);
+	    buildPhyInfo();
 	    info = m_phyInfo;
 	}
     inline void addPhyInfo(NamedList& msg) {
 	    Lock lck(this);
+	    buildPhyInfo();
 	    msg.addParam("phy_info",m_phyInfo,false);
 	}
     inline void setPhyInfo(const String& info) {
 	    Lock lck(this);
 	    m_phyInfo = info;
+	    m_phyBinLen = 0;
+	}
+    // Set binary physical channel information
+    // The text is built only when needed
+    inline void setPhyInfo(const uint8_t* data, unsigned int len) {
+	    if (len > sizeof(m_phyBin))
+		len = sizeof(m_phyBin);
+	    Lock lck(this);
+	    ::memcpy(m_phyBin,data,len);
+	    m_phyBinLen = len;
 	}
     inline const String& extraRelease() const
 	{ return m_extraRelease; }
@@ -768,6 +935,8 @@ public:
     bool serialize(String& str);
 protected:
     YBTSConn(YBTSSignalling* owner, uint16_t connId);
+    // Build physical channel information text from pending binary data
+    void buildPhyInfo();
     // Set connection UE. Return false if requested to change an existing, different UE
     bool setUE(YBTSUE* ue);
 
@@ -782,6 +951,8 @@ protected:
     YBTSTid* m_ss;                       // Pending non call related SS transaction
     String m_extraRelease;               // Extra octets for Channel Release
     String m_phyInfo;                    // Latest physical channel information
+    uint8_t m_phyBin[PhyInfoMediaLen];   // Latest binary physical channel information
+    uint8_t m_phyBinLen;                 // Binary physical channel information not yet converted
     String m_savedState;                 // GSM state prepared for Handover
     uint8_t m_traffic;                   // Traffic channel available (mode)
     uint8_t m_waitForTraffic;            // Waiting for traffic to start
@@ -879,6 +1050,14 @@ public:
 	{ return m_state; }
     inline bool dumpData() const
 	{ return m_printMsg > 0; }
+    // Decode to XML only the L3 messages handled or forwarded
+    // Always decode when printing message data
+    inline bool lazyDecode()
+	{ return m_lazyDecode && !(m_printMsg && m_printMsgData && debugAt(DebugInfo)); }
+#ifdef DEBUG
+    // Receive path benchmark
+    static void benchmark(String& retVal, unsigned int count);
+#endif
     inline YBTSTransport& transport()
 	{ return m_transport; }
     inline GSML3Codec& codec()
@@ -1125,6 +1304,8 @@ protected:
     uint64_t m_connsTimeout;             // Minimum connections timeout
     unsigned int m_connIdleIntervalMs;   // Interval to timeout a connection after becoming idle
     unsigned int m_connIdleMtSmsIntervalMs; // Interval to timeout a connection after becoming idle (MT SMS was used)
+    bool m_lazyDecode;                   // Don't decode L3 messages not handled
+    bool m_binaryPhyInfo;                // Accept binary physical channel information
 };
 
 class YBTSMedia : public GenObject, public DebugEnabler, public Mutex,
@@ -1163,6 +1344,40 @@ protected:
     ObjList m_sources;
 };
 
+// UE identities indexed by MM
+enum YBTSUEIdent {
+    UEIdentTmsi = 0,
+    UEIdentImsi,
+    UEIdentImei,
+    UEIdentPaging,
+    UEIdentCount
+};
+
+// Hash index of UEs keyed by one of their identities
+// Buckets are protected by a pool of locks: lookups of different UEs don't contend
+// UEs are not referenced by index, they are removed from it before being destroyed
+class YBTSUEIndex
+{
+public:
+    inline YBTSUEIndex()
+	: m_locks(YBTS_UE_INDEX_LOCKS,false,"YBTSUEIndex")
+	{}
+    // Add an UE with given identity
+    void add(const String& id, YBTSUE* ue);
+    // Remove an UE with given identity
+    void remove(const String& id, YBTSUE* ue);
+    // Append referenced alive UEs with given identity to list
+    void find(ObjList& dest, const String& id);
+    void clear();
+
+private:
+    inline unsigned int bucket(const String& id) const
+	{ return id.hash() % YBTS_UE_INDEX_SIZE; }
+
+    MutexPool m_locks;
+    ObjList m_lists[YBTS_UE_INDEX_SIZE];
+};
+
 class YBTSUE : public RefObject, public Mutex, public YBTSConnIdHolder
 {
     friend class YBTSMM;
@@ -1216,15 +1431,26 @@ protected:
     inline YBTSUE(YBTSMM* mm, const char* imsi, const char* tmsi)
 	: Mutex(false,"YBTSUE"),
 	m_mm(mm), m_registered(true), m_imsiDetached(false), m_removed(false),
-	m_askIMEI(false), m_pageCnt(0), m_imsi(imsi), m_tmsi(tmsi)
+	m_indexed(false), m_askIMEI(false), m_pageCnt(0), m_imsi(imsi), m_tmsi(tmsi)
 	{}
     YBTSUE(YBTSMM* mm, String& state);
     virtual void destroyed();
+    // Change identities, keep MM indexes in sync. UE must be locked
+    inline void setTmsi(const String& val)
+	{ setIdent(m_tmsi,val,UEIdentTmsi); }
+    inline void setImsi(const String& val)
+	{ setIdent(m_imsi,val,UEIdentImsi); }
+    inline void setImei(const String& val)
+	{ setIdent(m_imei,val,UEIdentImei); }
+    inline void setPaging(const String& val)
+	{ setIdent(m_paging,val,UEIdentPaging); }
+    void setIdent(String& dest, const String& val, int ident);
 
     YBTSMM* m_mm;
     bool m_registered;
     bool m_imsiDetached;                 // Unregistered due to IMSI detached
     bool m_removed;                      // Removed from MM list
+    bool m_indexed;                      // In MM list and indexes
     bool m_askIMEI;                      // Ask IMEI
     uint32_t m_pageCnt;
     String m_imsi;
@@ -1233,7 +1459,7 @@ protected:
     String m_paging;
 };
 
-class YBTSLocationUpd : public YBTSGlobalThread, public YBTSConnIdHolder,
+class YBTSLocationUpd : public YBTSTask, public YBTSConnIdHolder,
     public YBTSConnAuth
 {
 public:
@@ -1244,8 +1470,15 @@ public:
 	{ return m_ue; }
     inline uint64_t startTime() const
 	{ return m_startTime; }
-    virtual void cleanup()
-	{ notify(); }
+    virtual void cancelled()
+	{ notify(false,false); }
+    virtual bool released() const
+	{ return authConnReleased(); }
+    // Reject the location update without running it
+    inline void reject(int cause) {
+	    m_msg.setParam(s_error,String(cause));
+	    notify(false,false);
+	}
 protected:
     virtual void run();
     void notify(bool final = true, bool ok = false);
@@ -1255,7 +1488,7 @@ protected:
     uint64_t m_startTime;
 };
 
-class YBTSSubmit : public YBTSGlobalThread, public YBTSConnIdHolder, public YBTSConnAuth
+class YBTSSubmit : public YBTSTask, public YBTSConnIdHolder, public YBTSConnAuth
 {
 public:
     YBTSSubmit(YBTSTid::Type t, YBTSConn* conn, const char* callRef);
@@ -1263,8 +1496,9 @@ public:
 	{ notify(); }
     inline Message& msg()
 	{ return m_msg; }
-    virtual void cleanup()
-	{ notify(); }
+    virtual void cancelled();
+    virtual bool released() const
+	{ return authConnReleased(); }
 protected:
     virtual void run();
     void notify(bool final = true);
@@ -1412,6 +1646,11 @@ public:
     bool createEmptyUE(RefPointer<YBTSUE>& ue);
     // Remove an UE from list
     void removeUE(YBTSUE* ue, const char* reason);
+    // Change an UE identity in index. UE must be locked
+    inline void reindexUE(YBTSUE* ue, int ident, const String& oldVal, const String& newVal) {
+	    m_index[ident].remove(oldVal,ue);
+	    m_index[ident].add(newVal,ue);
+	}
     virtual void destruct();
     static inline XmlElement* buildMM()
 	{ return new XmlElement("MM"); }
@@ -1437,6 +1676,12 @@ protected:
     void sendIdentityRequest(YBTSConn* conn, int type);
     // Find UE by paging identity
     bool findUEPagingSafe(RefPointer<YBTSUE>& ue, const String& paging);
+    // Find UE by identities in indexes, fill its empty identities
+    bool findUESafe(RefPointer<YBTSUE>& ue, const String& tmsi, const String& imsi,
+	const String& imei);
+    // Add/remove UE identities to/from indexes. UE must be locked
+    void indexUE(YBTSUE* ue);
+    void unindexUE(YBTSUE* ue);
     // Get IMSI/TMSI from request
     uint8_t getMobileIdentTIMSI(YBTSMessage& m, const XmlElement& request,
 	const XmlElement& identXml, const String*& ident, bool& isTMSI);
@@ -1449,6 +1694,7 @@ protected:
     String m_name;
     Mutex m_ueMutex;
     ObjList m_ues;                       // List of UEs
+    YBTSUEIndex m_index[UEIdentCount];   // UE indexes, by identity
 };
 
 class YBTSCallDesc : public String, public YBTSConnIdHolder
@@ -1696,17 +1942,19 @@ protected:
     unsigned int m_authIndex;            // Number of auth requests sent
 };
 
-class YBTSChanThread : public Thread, public YBTSConnAuthMt
+class YBTSChanThread : public YBTSTask, public YBTSConnAuthMt
 {
 public:
     YBTSChanThread(YBTSChan& chan, Message* msg);
     ~YBTSChanThread()
 	{ notify(); }
-    virtual void cleanup()
-	{ notify(); }
+    virtual void cancelled()
+	{ notify(0,true); }
+    virtual bool released() const
+	{ return authConnReleased(); }
 protected:
     virtual void run();
-    void notify(const char* error = "failure");
+    void notify(const char* error = "failure", bool cancelled = false);
     RefPointer<YBTSChan> m_chan;
     Message* m_route;
 };
@@ -1839,6 +2087,8 @@ public:
 	bool sapiEstablish = false);
     // Check if there is any paging MT service for a given UE
     int havePagingMtService(YBTSUE* ue, bool call, bool sms, bool ussd);
+    // Hangup the MT call waiting for a paging response we can't handle
+    void mtCongestion(YBTSUE* ue);
     // Handle media start/alloc response
     void handleMediaStartRsp(YBTSConn* conn, bool ok);
     // Add a pending (wait termination) call
@@ -2135,6 +2385,10 @@ static const String s_statusCmd = "status";
 static const String s_startCmd = "start";
 static const String s_stopCmd = "stop";
 static const String s_restartCmd = "restart";
+#ifdef DEBUG
+static const String s_ueBenchCmd = "uebench";
+static const String s_sigBenchCmd = "sigbench";
+#endif
 static const String s_all = "all";
 static const String s_statusUeImsi = "imsi";
 static const String s_statusUeTmsi = "tmsi";
@@ -2145,6 +2399,7 @@ static const String s_pdpMedia = "data";
 
 ObjList YBTSGlobalThread::s_threads;
 Mutex YBTSGlobalThread::s_threadsMutex(false,"YBTSGlobal");
+static YBTSTaskPool s_tasks("YBTSTasks","YBTSWorker","tasks");
 
 #define YBTS_MAKENAME(x) {#x, x}
 #define YBTS_XML_GETCHILD_PTR_CONTINUE(x,tag,ptr) \
@@ -2916,6 +3171,12 @@ bool YBTSConnAuth::authSetConn(uint16_t connid)
     return __plugin.signalling() && __plugin.signalling()->findConn(m_conn,connid,false);
 }
 
+// Check if the connection was released
+bool YBTSConnAuth::authConnReleased() const
+{
+    return m_conn && m_conn->removed();
+}
+
 static inline bool decIntervals(unsigned int* intervals, String& reason)
 {
     if (!intervals)
@@ -2966,6 +3227,11 @@ bool YBTSConnAuth::authSend(NamedList& params, String& reason, unsigned int* int
     // Wait for completion
     while (m_authSent) {
 	Thread::idle();
+	if (m_conn->removed()) {
+	    reason << "connection released";
+	    m_conn->owner()->authCancel(m_conn,this);
+	    return false;
+	}
 	if (threadExiting(reason) || !decIntervals(intervals,reason)) {
 	    m_conn->owner()->authCancel(m_conn,this);
 	    return true;
@@ -3252,6 +3518,31 @@ static XmlElement* decodeTagged(const char* name, const String& str)
     return xml;
 }
 
+// Utility used in YBTSMessage::parse() in lazy decode mode
+// Check if an L3 message is handled or forwarded and needs to be decoded
+static inline bool l3NeedDecode(const uint8_t* data, unsigned int len)
+{
+    // Let the codec report short messages
+    if (len < 2)
+	return true;
+    switch (data[0] & 0x0f) {
+	case 0x03: // CC
+	case 0x05: // MM
+	case 0x09: // SMS
+	case 0x0b: // SS
+	    return true;
+	case 0x06: // RR
+	    switch (data[1]) {
+		case 0x27: // PagingResponse
+		case 0x28: // HandoverFailure
+		case 0x2c: // HandoverComplete
+		    return true;
+	    }
+	    break;
+    }
+    return false;
+}
+
 // Parse message. Return 0 on failure
 YBTSMessage* YBTSMessage::parse(YBTSSignalling* recv, uint8_t* data, unsigned int len)
 {
@@ -3289,10 +3580,21 @@ YBTSMessage* YBTSMessage::parse(YBTSSignalling* recv, uint8_t* data, unsigned in
 		Debug(recv,DebugAll,"Recv L3 message: %s",tmp.c_str());
 	    }
 #endif
+	    if (recv->lazyDecode() && !l3NeedDecode(data,len)) {
+		m->m_payload = data;
+		m->m_payloadLen = len;
+		m->m_l3Type = ((data[0] & 0x0f) << 8) | data[1];
+		break;
+	    }
 	    decodeMsg(recv->codec(),data,len,m->m_xml,reason);
 	    break;
 	case SigPhysicalInfo:
-	    m->m_xml = new XmlElement("PhysicalInfo",String((const char*)data,len));
+	    if (m->info() == PhyInfoBinary) {
+		m->m_payload = data;
+		m->m_payloadLen = len;
+	    }
+	    else
+		m->m_xml = new XmlElement("PhysicalInfo",String((const char*)data,len));
 	    break;
 	case SigHandoverRequired:
 	    m->m_xml = new XmlElement("HandoverRequired",String((const char*)data,len));
@@ -3312,8 +3614,12 @@ YBTSMessage* YBTSMessage::parse(YBTSSignalling* recv, uint8_t* data, unsigned in
 	case SigPdpDeactivate:
 	    m->m_xml = decodeTagged("PdpContext",String((const char*)data,len));
 	    break;
-	case SigEstablishSAPI:
 	case SigHandshake:
+	    // Optional peer capabilities
+	    if (len)
+		m->m_xml = decodeTagged("Handshake",String((const char*)data,len));
+	    break;
+	case SigEstablishSAPI:
 	case SigRadioReady:
 	case SigHeartbeat:
 	case SigConnLost:
@@ -3445,8 +3751,14 @@ bool YBTSMessage::build(YBTSSignalling* sender, DataBlock& buf, const YBTSMessag
 	    if (msg.xml())
 		buf.append(msg.xml()->getText());
 	    return true;
-	case SigHeartbeat:
 	case SigHandshake:
+	    if (msg.xml()) {
+		String tmp;
+		encodeTagged(tmp,msg.xml());
+		buf.append(tmp);
+	    }
+	    return true;
+	case SigHeartbeat:
 	case SigHandoverRequest:
 	case SigStartMedia:
 	case SigStopMedia:
@@ -3511,8 +3823,8 @@ bool YBTSTransport::send(const void* buf, unsigned int len, bool ignoreError)
     return false;
 }
 
-// Read socket data. Return 0: nothing read, >1: read data, negative: fatal error
-int YBTSTransport::recv(bool ignoreError)
+// Wait for socket data. Return 1: can read, 0: nothing to read, negative: fatal error
+int YBTSTransport::waitRead(bool ignoreError)
 {
     if (!m_readSocket.valid())
 	return 0;
@@ -3528,6 +3840,15 @@ int YBTSTransport::recv(bool ignoreError)
 	if (!ok)
 	    return 0;
     }
+    return 1;
+}
+
+// Read socket data. Return 0: nothing read, >1: read data, negative: fatal error
+int YBTSTransport::recv(bool ignoreError)
+{
+    int ok = waitRead(ignoreError);
+    if (ok <= 0)
+	return ok;
     uint8_t* buf = (uint8_t*)m_readBuf.data();
     int rd = m_readSocket.recv(buf,m_maxRead);
     if (rd >= 0) {
@@ -3550,6 +3871,57 @@ int YBTSTransport::recv(bool ignoreError)
     return -1;
 }
 
+// Read all available datagrams using a single system call
+// Return the number of messages read, 0 if nothing was read, negative on fatal error
+int YBTSTransport::recvBatch(bool ignoreError)
+{
+#ifdef __linux__
+    int ok = waitRead(ignoreError);
+    if (ok <= 0)
+	return ok;
+    unsigned int bufLen = m_readBuf.length();
+    if (m_batchBuf.length() != bufLen * YBTS_RECV_BATCH)
+	m_batchBuf.assign(0,bufLen * YBTS_RECV_BATCH);
+    uint8_t* buf = (uint8_t*)m_batchBuf.data();
+    struct mmsghdr msgs[YBTS_RECV_BATCH];
+    struct iovec iov[YBTS_RECV_BATCH];
+    ::memset(msgs,0,sizeof(msgs));
+    for (unsigned int i = 0; i < YBTS_RECV_BATCH; i++) {
+	iov[i].iov_base = buf + i * bufLen;
+	iov[i].iov_len = m_maxRead;
+	msgs[i].msg_hdr.msg_iov = &iov[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int n = ::recvmmsg(m_readSocket.handle(),msgs,YBTS_RECV_BATCH,MSG_DONTWAIT,0);
+    if (n > 0) {
+	__plugin.setPeerAlive();
+	for (int i = 0; i < n; i++) {
+	    m_batchLen[i] = msgs[i].msg_len;
+	    if (m_maxRead < bufLen)
+		buf[i * bufLen + m_batchLen[i]] = 0;
+	}
+	return n;
+    }
+    if (!n)
+	return 0;
+    int error = errno;
+    if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR)
+	return 0;
+    if (!ignoreError)
+	alarmError(m_readSocket,"read",error);
+    return -1;
+#else
+    int rd = recv(ignoreError);
+    if (rd <= 0)
+	return rd;
+    if (m_batchBuf.length() != m_readBuf.length() * YBTS_RECV_BATCH)
+	m_batchBuf.assign(0,m_readBuf.length() * YBTS_RECV_BATCH);
+    ::memcpy(m_batchBuf.data(),m_readBuf.data(),m_readBuf.length());
+    m_batchLen[0] = rd;
+    return 1;
+#endif
+}
+
 bool YBTSTransport::initTransport(bool stream, unsigned int buflen, bool reserveNull)
 {
     resetTransport();
@@ -3588,10 +3960,10 @@ void YBTSTransport::resetTransport()
     m_remoteSocket.terminate();
 }
 
-void YBTSTransport::alarmError(Socket& sock, const char* oper)
+void YBTSTransport::alarmError(Socket& sock, const char* oper, int error)
 {
     String tmp;
-    addLastError(tmp,sock.error());
+    addLastError(tmp,error ? error : sock.error());
     Alarm(m_enabler,"socket",DebugWarn,"Socket %s error%s [%p]",
 	oper,tmp.c_str(),m_ptr);
 }
@@ -3604,6 +3976,7 @@ void YBTSTransport::alarmError(Socket& sock, const char* oper)
 // Return true if there are no running threads
 bool YBTSGlobalThread::cancelAll(bool hard, unsigned int waitMs)
 {
+    s_tasks.clear();
     Lock lck(s_threadsMutex);
     ObjList* o = s_threads.skipNull();
     if (!o)
@@ -3630,9 +4003,258 @@ bool YBTSGlobalThread::cancelAll(bool hard, unsigned int waitMs)
 }
 
 
+
+//
+// YBTSTask
+//
+void YBTSTask::setKey(const YBTSUE* ue)
+{
+    if (ue)
+	m_key.printf("%p",ue);
+    else
+	m_key.clear();
+}
+
+
+//
+// YBTSWorker
+//
+YBTSWorker::~YBTSWorker()
+{
+    m_pool->workerTerminated(this);
+}
+
+void YBTSWorker::run()
+{
+    set(this,true);
+    while (!Thread::check(false)) {
+	YBTSTask* task = m_pool->take(this);
+	if (!task)
+	    break;
+	if (m_drop)
+	    task->cancelled();
+	else
+	    task->run();
+	m_pool->taskDone(this);
+    }
+}
+
+
+//
+// YBTSTaskPool
+//
+YBTSTaskPool::YBTSTaskPool(const char* name, const char* workerName, const char* prefix)
+    : Mutex(true,name),
+    m_workerName(workerName), m_prefix(prefix),
+    m_queued(0), m_idle(0),
+    m_maxWorkers(YBTS_WORKERS_DEF), m_maxQueue(YBTS_TASK_QUEUE_DEF),
+    m_maxWait(YBTS_TASK_WAIT_DEF * 1000),
+    m_semaphore(YBTS_WORKERS_MAX,name,0),
+    m_rejected(0), m_dropped(0), m_executed(0), m_waitSum(0), m_waitMax(0), m_runSum(0)
+{
+}
+
+void YBTSTaskPool::setLimits(unsigned int workers, unsigned int queue, unsigned int waitMs)
+{
+    Lock lck(this);
+    m_maxWorkers = workers;
+    m_maxQueue = queue;
+    m_maxWait = (uint64_t)waitMs * 1000;
+}
+
+bool YBTSTaskPool::enqueue(YBTSTask* task)
+{
+    if (!task)
+	return false;
+    Lock lck(this);
+    if (m_queued >= m_maxQueue) {
+	m_rejected++;
+	Debug(&__plugin,DebugMild,"Task queue full (%u), rejecting %s key=%s",
+	    m_queued,task->name(),task->key().safe());
+	return false;
+    }
+    task->m_enqueueTime = Time::now();
+    m_queue.append(task);
+    m_queued++;
+    if (!m_idle && m_workers.count() < m_maxWorkers && !startWorker() &&
+	!m_workers.skipNull()) {
+	m_queue.remove(task,false);
+	m_queued--;
+	return false;
+    }
+    lck.drop();
+    m_semaphore.unlock();
+    return true;
+}
+
+void YBTSTaskPool::cancel(YBTSTask* task)
+{
+    Lock lck(this);
+    if (m_queue.remove(task,false)) {
+	m_queued--;
+	lck.drop();
+	task->cancelled();
+	TelEngine::destruct(task);
+	return;
+    }
+    for (ObjList* o = m_workers.skipNull(); o; o = o->skipNext()) {
+	YBTSWorker* w = static_cast<YBTSWorker*>(o->get());
+	if (w->m_task == task) {
+	    w->cancel();
+	    break;
+	}
+    }
+}
+
+void YBTSTaskPool::clear()
+{
+    Lock lck(this);
+    ObjList tasks;
+    for (ObjList* o = m_queue.skipNull(); o; o = m_queue.skipNull())
+	tasks.append(o->remove(false));
+    m_queued = 0;
+    unsigned int idle = m_idle;
+    lck.drop();
+    if (tasks.skipNull())
+	Debug(&__plugin,DebugAll,"Removed %u queued tasks",tasks.count());
+    for (ObjList* o = tasks.skipNull(); o; o = o->skipNext())
+	static_cast<YBTSTask*>(o->get())->cancelled();
+    tasks.clear();
+    while (idle--)
+	m_semaphore.unlock();
+}
+
+void YBTSTaskPool::status(String& buf)
+{
+    Lock lck(this);
+    unsigned int running = 0;
+    for (ObjList* o = m_workers.skipNull(); o; o = o->skipNext())
+	if (static_cast<YBTSWorker*>(o->get())->m_task)
+	    running++;
+    unsigned int started = m_executed + m_dropped + running;
+    buf << "," << m_prefix << "_queued=" << m_queued;
+    buf << "," << m_prefix << "_running=" << running;
+    buf << "," << m_prefix << "_workers=" << m_workers.count();
+    buf << "," << m_prefix << "_executed=" << m_executed;
+    buf << "," << m_prefix << "_rejected=" << m_rejected;
+    buf << "," << m_prefix << "_dropped=" << m_dropped;
+    buf << "," << m_prefix << "_wait_avg=" <<
+	(unsigned int)(started ? m_waitSum / started / 1000 : 0);
+    buf << "," << m_prefix << "_wait_max=" << (unsigned int)(m_waitMax / 1000);
+    buf << "," << m_prefix << "_run_avg=" <<
+	(unsigned int)(m_executed ? m_runSum / m_executed / 1000 : 0);
+}
+
+YBTSTask* YBTSTaskPool::take(YBTSWorker* worker)
+{
+    unsigned int waits = 0;
+    Lock lck(this);
+    while (!Thread::check(false)) {
+	for (ObjList* o = m_queue.skipNull(); o; o = o->skipNext()) {
+	    YBTSTask* task = static_cast<YBTSTask*>(o->get());
+	    // Keep order of tasks for the same UE
+	    if (task->key() && m_busy.find(task->key()))
+		continue;
+	    o->remove(false);
+	    m_queued--;
+	    if (task->key())
+		m_busy.append(new String(task->key()));
+	    worker->m_task = task;
+	    worker->m_taskStart = Time::now();
+	    uint64_t wait = worker->m_taskStart - task->m_enqueueTime;
+	    m_waitSum += wait;
+	    if (wait > m_waitMax)
+		m_waitMax = wait;
+	    // The UE gave up waiting (or is gone): don't run the task
+	    bool released = task->released();
+	    worker->m_drop = released || (m_maxWait && wait > m_maxWait);
+	    if (worker->m_drop) {
+		m_dropped++;
+		if (released)
+		    Debug(&__plugin,DebugNote,"Dropping %s key=%s: connection released",
+			task->name(),task->key().safe());
+		else
+		    Debug(&__plugin,DebugNote,"Dropping %s key=%s: queued for %u ms",
+			task->name(),task->key().safe(),(unsigned int)(wait / 1000));
+	    }
+	    return task;
+	}
+	if (waits++ >= YBTS_WORKER_IDLE_WAITS)
+	    break;
+	m_idle++;
+	lck.drop();
+	if (m_semaphore.lock(YBTS_WORKER_WAIT_US))
+	    waits = 0;
+	lck.acquire(this);
+	m_idle--;
+    }
+    return 0;
+}
+
+void YBTSTaskPool::taskDone(YBTSWorker* worker)
+{
+    Lock lck(this);
+    YBTSTask* task = worker->m_task;
+    worker->m_task = 0;
+    if (!task)
+	return;
+    if (!worker->m_drop) {
+	m_executed++;
+	m_runSum += Time::now() - worker->m_taskStart;
+    }
+    worker->m_drop = false;
+    bool wake = false;
+    if (task->key()) {
+	ObjList* o = m_busy.find(task->key());
+	if (o)
+	    o->remove();
+	wake = (0 != m_queued);
+    }
+    lck.drop();
+    TelEngine::destruct(task);
+    if (wake)
+	m_semaphore.unlock();
+}
+
+void YBTSTaskPool::workerTerminated(YBTSWorker* worker)
+{
+    Lock lck(this);
+    bool started = (0 != m_workers.remove(worker,false));
+    YBTSTask* task = worker->m_task;
+    worker->m_task = 0;
+    if (task && task->key()) {
+	ObjList* o = m_busy.find(task->key());
+	if (o)
+	    o->remove();
+    }
+    // Replace a cancelled worker if there are queued tasks
+    if (started && m_queued && !Engine::exiting() && m_workers.count() < m_maxWorkers)
+	startWorker();
+    lck.drop();
+    TelEngine::destruct(task);
+}
+
+bool YBTSTaskPool::startWorker()
+{
+    YBTSWorker* w = new YBTSWorker(this,m_workerName);
+    if (w->startup()) {
+	m_workers.append(w)->setDelete(false);
+	return true;
+    }
+    delete w;
+    Alarm(&__plugin,"system",DebugWarn,"Failed to start worker thread");
+    return false;
+}
+
 //
 // YBTSConnAuthThread
 //
+YBTSConnAuthThread::YBTSConnAuthThread(uint16_t connid, YBTSUE* ue, int origin)
+    : YBTSTask("YBTSConnAuth"), YBTSConnAuthMt(connid,ue,origin)
+{
+    setKey(ue);
+}
+
 void YBTSConnAuthThread::notify(bool final, bool ok)
 {
     if (!m_ue)
@@ -3646,6 +4268,19 @@ void YBTSConnAuthThread::notify(bool final, bool ok)
     m_ue = 0;
 }
 
+void YBTSConnAuthThread::congestion()
+{
+    RefPointer<YBTSUE> ue = m_ue;
+    m_ue = 0;
+    if (!ue)
+	return;
+    ue->stopPagingNow();
+    if (m_conn && __plugin.signalling())
+	__plugin.signalling()->dropConn(m_conn,true);
+    __plugin.mtCongestion(ue);
+    ue = 0;
+}
+
 
 //
 // YBTSLAI
@@ -3695,7 +4330,8 @@ YBTSConn::YBTSConn(YBTSSignalling* owner, uint16_t connId)
     m_auth(0),
     m_authTout(0),
     m_authenticated(false),
-    m_authOrigin(0)
+    m_authOrigin(0),
+    m_phyBinLen(0)
 {
 }
 
@@ -3705,6 +4341,44 @@ YBTSConn::~YBTSConn()
     TelEngine::destruct(m_ss);
 }
 
+static inline int phyInfoInt16(const uint8_t* data)
+{
+    return (int16_t)((data[0] << 8) | data[1]);
+}
+
+static inline unsigned int phyInfoUInt(const uint8_t* data, unsigned int len)
+{
+    unsigned int val = 0;
+    while (len--)
+	val = (val << 8) | *data++;
+    return val;
+}
+
+// Build physical channel information text from pending binary data
+// The text is the same as the one sent by peer when not using binary format
+void YBTSConn::buildPhyInfo()
+{
+    if (!m_phyBinLen)
+	return;
+    unsigned int len = m_phyBinLen;
+    m_phyBinLen = 0;
+    if (len < PhyInfoBaseLen) {
+	m_phyInfo.clear();
+	return;
+    }
+    const uint8_t* d = m_phyBin;
+    m_phyInfo.printf("TA=%u TE=%0.3f UpRSSI=%d TxPwr=%d DnRSSIdBm=%d time=%9.3f",
+	d[PhyInfoTA],phyInfoInt16(d + PhyInfoTE) / 1000.0,phyInfoInt16(d + PhyInfoUpRSSI),
+	(int8_t)d[PhyInfoTxPwr],(int8_t)d[PhyInfoDnRSSI],
+	phyInfoUInt(d + PhyInfoTimeSec,4) + phyInfoUInt(d + PhyInfoTimeMsec,2) / 1000.0);
+    if (len < PhyInfoMediaLen)
+	return;
+    String tmp;
+    m_phyInfo << tmp.printf(" UpFrames=%u UpBadFrames=%u UpJitter=%0.1f",
+	phyInfoUInt(d + PhyInfoUpFrames,4),phyInfoUInt(d + PhyInfoUpBadFrames,4),
+	phyInfoInt16(d + PhyInfoUpJitter) / 10.0);
+}
+
 bool YBTSConn::serialize(String& str)
 {
     if (!(ue() && ue()->serialize(str)))
@@ -4192,7 +4866,9 @@ YBTSSignalling::YBTSSignalling()
     m_haveConnTout(false),
     m_connsTimeout(0),
     m_connIdleIntervalMs(2000),
-    m_connIdleMtSmsIntervalMs(5000)
+    m_connIdleMtSmsIntervalMs(5000),
+    m_lazyDecode(true),
+    m_binaryPhyInfo(true)
 {
     m_name = "ybts-signalling";
     debugName(m_name);
@@ -4656,6 +5332,8 @@ void YBTSSignalling::init(Configuration& cfg)
 	YBTS_HB_TIMEOUT_DEF,m_hbIntervalMs + 3000,YBTS_HB_TIMEOUT_MAX);
     m_printMsg = getPrintData(ybts,YSTRING("print_msg"),-1);
     m_printMsgData = getPrintData(ybts,YSTRING("print_msg_data"),1);
+    m_lazyDecode = ybts.getBoolValue(YSTRING("lazy_decode"),true);
+    m_binaryPhyInfo = ybts.getBoolValue(YSTRING("binary_phyinfo"),true);
 #ifdef DEBUG
     String s;
     s << "\r\nheartbeat_ping=" << m_hbIntervalMs;
@@ -4665,6 +5343,8 @@ void YBTSSignalling::init(Configuration& cfg)
 	(m_printMsg > 0 ? "dump" : String::boolText(m_printMsg < 0));
     s << "\r\nprint_msg_data=" <<
 	(m_printMsgData > 0 ? "verbose" : String::boolText(m_printMsgData < 0));
+    s << "\r\nlazy_decode=" << String::boolText(m_lazyDecode);
+    s << "\r\nbinary_phyinfo=" << String::boolText(m_binaryPhyInfo);
     Debug(this,DebugAll,"Initialized [%p]\r\n-----%s\r\n-----",this,s.c_str());
 #endif
 }
@@ -4965,6 +5645,9 @@ int YBTSSignalling::handlePDU(YBTSMessage& msg)
 		    Debug(this,DebugNote,"Unknown '%s' protocol in %s [%p]",
 			proto.c_str(),msg.name(),this);
 	    }
+	    else if (msg.l3Type() >= 0)
+		Debug(this,DebugNote,"Unhandled PD=%d MTI=0x%02x in %s conn=%u [%p]",
+		    msg.l3Type() >> 8,msg.l3Type() & 0xff,msg.name(),msg.connId(),this);
 	    else if (msg.error()) {
 		// TODO: close message connection ?
 	    }
@@ -4995,11 +5678,15 @@ int YBTSSignalling::handlePDU(YBTSMessage& msg)
 	    }
 	    return Ok;
 	case SigPhysicalInfo:
-	    if (msg.hasConnId() && msg.xml()) {
+	    if (msg.hasConnId() && (msg.xml() || msg.payloadLen())) {
 		RefPointer<YBTSConn> conn;
 		findConn(conn,msg.connId(),false);
-		if (conn)
+		if (!conn)
+		    return Ok;
+		if (msg.xml())
 		    conn->setPhyInfo(msg.xml()->getText());
+		else
+		    conn->setPhyInfo(msg.payload(),msg.payloadLen());
 	    }
 	    return Ok;
 	case SigHandoverRequired:
@@ -5129,7 +5816,15 @@ int YBTSSignalling::handleHandshake(YBTSMessage& msg)
 	    if (state() != WaitHandshake)
 		return Ok;
 	    changeState(Running);
-	    YBTSMessage m(SigHandshake);
+	    // Accept binary physical channel information if offered
+	    XmlElement* caps = 0;
+	    const String* phy = msg.xml() ? msg.xml()->childText(YSTRING("phyinfo")) : 0;
+	    if (m_binaryPhyInfo && phy && *phy == YSTRING("binary")) {
+		caps = new XmlElement("Handshake");
+		caps->addChildSafe(new XmlElement("phyinfo","binary"));
+		Debug(this,DebugInfo,"Using binary physical channel information [%p]",this);
+	    }
+	    YBTSMessage m(SigHandshake,0,NO_CONN_ID,caps);
 	    if (sendInternal(m))
 		return Ok;
 	}
@@ -5204,12 +5899,63 @@ void YBTSSignalling::printMsg(YBTSMessage& msg, bool recv)
 	    }
 	    msg.xml()->toString(data,false,indent,origindent);
 	}
+	else if (msg.l3Type() >= 0)
+	    data.printf("PD=%d MTI=0x%02x (not decoded)",msg.l3Type() >> 8,msg.l3Type() & 0xff);
 	s.append(data,"\r\n");
     }
     s << "\r\n-----";
     Debug(this,DebugInfo,"%s [%p]%s",recv ? "Received" : "Sending",this,s.safe());
 }
 
+#ifdef DEBUG
+// Synthetic receive path benchmark
+// Parse and handle messages in a private instance, measure handled messages per second
+void YBTSSignalling::benchmark(String& retVal, unsigned int count)
+{
+    YBTSSignalling* sig = new YBTSSignalling;
+    sig->debugChain(0);
+    sig->debugEnabled(false);
+    sig->m_printMsg = 0;
+    sig->m_state = Running;
+    RefPointer<YBTSConn> conn;
+    sig->findConn(conn,1,true);
+    // Same physical channel information in text and binary format
+    static const char s_phyText[] = "TA=2 TE=0.250 UpRSSI=-45 TxPwr=5 DnRSSIdBm=-63 "
+	"time=1700000000.125 UpFrames=1500 UpBadFrames=3 UpJitter=1.2";
+    uint8_t text[4 + sizeof(s_phyText)] = {SigPhysicalInfo,PhyInfoText,0,1};
+    ::memcpy(text + 4,s_phyText,sizeof(s_phyText) - 1);
+    uint8_t bin[4 + PhyInfoMediaLen] = {SigPhysicalInfo,PhyInfoBinary,0,1,
+	2,0x00,0xfa,0xff,0xd3,5,0xc1,0x65,0x53,0xf1,0x00,0x00,0x7d,
+	0x00,0x00,0x05,0xdc,0x00,0x00,0x00,0x03,0x00,0x0c};
+    // RR Status (not handled here), cause 0x62
+    uint8_t rr[] = {SigL3Message,0,0,1,0x06,0x12,0x62};
+    static const char* s_name[] = { "phyinfo_text", "phyinfo_binary", "l3_decode", "l3_lazy" };
+    uint8_t* data[] = { text, bin, rr, rr };
+    unsigned int len[] = { sizeof(text) - 1, sizeof(bin), sizeof(rr), sizeof(rr) };
+    for (unsigned int i = 0; i < 4; i++) {
+	sig->m_lazyDecode = (i == 3);
+	unsigned int handled = 0;
+	uint64_t t = Time::now();
+	for (unsigned int n = 0; n < count; n++) {
+	    YBTSMessage* m = YBTSMessage::parse(sig,data[i],len[i]);
+	    if (!m)
+		continue;
+	    if (!m->error() && sig->handlePDU(*m) == Ok)
+		handled++;
+	    TelEngine::destruct(m);
+	}
+	t = Time::now() - t;
+	retVal << s_name[i] << ": handled=" << handled << " time=" << (unsigned int)(t / 1000) <<
+	    "ms rate=" << (unsigned int)(t ? (uint64_t)handled * 1000000 / t : 0) << "/s\r\n";
+    }
+    String phy;
+    conn->getPhyInfo(phy);
+    retVal << "phy_info=" << phy << "\r\n";
+    conn = 0;
+    TelEngine::destruct(sig);
+}
+#endif
+
 
 //
 // YBTSMedia
@@ -5322,9 +6068,10 @@ void YBTSMedia::processLoop()
     while (__plugin.state() == YBTSDriver::WaitHandshake && !Thread::check())
 	Thread::idle();
     while (!Thread::check(false)) {
-	int rd = m_transport.recv();
-	if (rd > 0) {
-	    uint16_t* d = (uint16_t*)m_transport.m_readBuf.data();
+	int n = m_transport.recvBatch();
+	for (int i = 0; i < n; i++) {
+	    unsigned int rd = 0;
+	    uint16_t* d = (uint16_t*)m_transport.batchMsg(i,rd);
 	    YBTSDataSource* src = rd >= 2 ? find(ntohs(*d)) : 0;
 	    if (!src)
 		continue;
@@ -5335,11 +6082,11 @@ void YBTSMedia::processLoop()
 	    tmp.clear(false);
 	    TelEngine::destruct(src);
 	}
-	else if (!rd) {
+	if (!n) {
 	    if (!m_transport.canSelect())
 		Thread::idle();
 	}
-	else {
+	else if (n < 0) {
 	    // Socket non retryable error
 	    __plugin.restart();
 	    break;
@@ -5363,6 +6110,65 @@ YBTSDataSource* YBTSMedia::find(unsigned int connId)
 }
 
 
+//
+// YBTSUEIndex
+//
+class YBTSUEIndexEntry : public String
+{
+public:
+    inline YBTSUEIndexEntry(const String& id, YBTSUE* ue)
+	: String(id), m_ue(ue)
+	{}
+    YBTSUE* m_ue;
+};
+
+void YBTSUEIndex::add(const String& id, YBTSUE* ue)
+{
+    if (!(id && ue))
+	return;
+    unsigned int idx = bucket(id);
+    Lock lck(m_locks.mutex(idx));
+    m_lists[idx].insert(new YBTSUEIndexEntry(id,ue));
+}
+
+void YBTSUEIndex::remove(const String& id, YBTSUE* ue)
+{
+    if (!(id && ue))
+	return;
+    unsigned int idx = bucket(id);
+    Lock lck(m_locks.mutex(idx));
+    for (ObjList* o = m_lists[idx].skipNull(); o; o = o->skipNext()) {
+	YBTSUEIndexEntry* e = static_cast<YBTSUEIndexEntry*>(o->get());
+	if (e->m_ue == ue && *e == id) {
+	    o->remove();
+	    return;
+	}
+    }
+}
+
+// Append referenced alive UEs with given identity to list
+void YBTSUEIndex::find(ObjList& dest, const String& id)
+{
+    if (!id)
+	return;
+    unsigned int idx = bucket(id);
+    Lock lck(m_locks.mutex(idx));
+    for (ObjList* o = m_lists[idx].skipNull(); o; o = o->skipNext()) {
+	YBTSUEIndexEntry* e = static_cast<YBTSUEIndexEntry*>(o->get());
+	if (*e == id && e->m_ue->ref())
+	    dest.append(e->m_ue);
+    }
+}
+
+void YBTSUEIndex::clear()
+{
+    for (unsigned int i = 0; i < YBTS_UE_INDEX_SIZE; i++) {
+	Lock lck(m_locks.mutex(i));
+	m_lists[i].clear();
+    }
+}
+
+
 //
 // YBTSUE
 //
@@ -5371,11 +6177,21 @@ void YBTSUE::update(const NamedList& params, const String& prefix)
 {
     Lock lck(this);
     if (!m_tmsi)
-	m_tmsi = params[prefix + "tmsi"];
+	setTmsi(params[prefix + "tmsi"]);
     if (!m_imsi)
-	m_imsi = params[prefix + "imsi"];
+	setImsi(params[prefix + "imsi"]);
     if (!m_imei)
-	m_imei = params[prefix + "imei"];
+	setImei(params[prefix + "imei"]);
+}
+
+// Change an identity, update MM index if we are in its list
+void YBTSUE::setIdent(String& dest, const String& val, int ident)
+{
+    if (dest == val)
+	return;
+    if (m_indexed && m_mm)
+	m_mm->reindexUE(this,ident,dest,val);
+    dest = val;
 }
 
 // Start paging, return true if already paging
@@ -5410,7 +6226,7 @@ bool YBTSUE::startPaging(BtsPagingChanType type)
 	Debug(&__plugin,DebugAll,"Started paging %s",tmp.c_str());
 	lck.acquire(this);
 	if (!m_paging)
-	    m_paging = tmp;
+	    setPaging(tmp);
 	return true;
     }
     return false;
@@ -5444,7 +6260,7 @@ void YBTSUE::stopPagingNow()
 	Debug(&__plugin,DebugAll,"Stopped paging %s",tmp.c_str());
 	lock();
 	if (m_paging == tmp)
-	    m_paging.clear();
+	    setPaging(String::empty());
 	unlock();
     }
 }
@@ -5464,7 +6280,7 @@ void YBTSUE::destroyed()
 YBTSUE::YBTSUE(YBTSMM* mm, String& state)
     : Mutex(false,"YBTSUE"),
       m_mm(mm), m_registered(true), m_imsiDetached(false), m_removed(false),
-      m_askIMEI(false), m_pageCnt(0)
+      m_indexed(false), m_askIMEI(false), m_pageCnt(0)
 {
     int sep = state.find(':');
     if (sep < 0)
@@ -5498,13 +6314,15 @@ bool YBTSUE::serialize(String& str)
 // YBTSLocationUpd
 //
 YBTSLocationUpd::YBTSLocationUpd(YBTSConn& conn)
-    : YBTSGlobalThread("YBTSLocUpd"),
+    : YBTSTask("YBTSLocUpd"),
     YBTSConnIdHolder(conn.connId()),
     YBTSConnAuth(conn.connId(),YBTSConn::FLocUpd),
     m_ue(conn.ue()),
     m_msg("user.register"),
     m_startTime(Time::now())
 {
+    // UE is already locked by the caller
+    setKey(m_ue);
     conn.addPhyInfo(m_msg);
     if (conn.isCSFB())
 	m_msg.addParam("csfb",String::boolText(true));
@@ -5524,7 +6342,6 @@ YBTSLocationUpd::YBTSLocationUpd(YBTSConn& conn)
 
 void YBTSLocationUpd::run()
 {
-    set(this,true);
     if (!m_ue)
 	return;
     Lock lckUe(m_ue);
@@ -5613,7 +6430,7 @@ void YBTSLocationUpd::notify(bool final, bool ok)
 // YBTSSubmit
 //
 YBTSSubmit::YBTSSubmit(YBTSTid::Type t, YBTSConn* conn, const char* callRef)
-    : YBTSGlobalThread("YBTSSubmit"),
+    : YBTSTask("YBTSSubmit"),
     YBTSConnIdHolder(conn->connId()),
     YBTSConnAuth(conn->connId(),0),
     m_type(t),
@@ -5642,13 +6459,13 @@ YBTSSubmit::YBTSSubmit(YBTSTid::Type t, YBTSConn* conn, const char* callRef)
 	    return;
     }
     Lock lck(m_ue);
+    setKey(m_ue);
     m_ue->addCaller(m_msg);
     m_ue->addParams(m_msg);
 }
 
 void YBTSSubmit::run()
 {
-    set(this,true);
     if (!m_ue)
 	return;
     Debug(&__plugin,DebugAll,
@@ -5698,6 +6515,16 @@ void YBTSSubmit::run()
     notify(false);
 }
 
+// Not run: reject the request, don't leave the MS waiting for a response
+void YBTSSubmit::cancelled()
+{
+    m_ok = false;
+    m_cause = 42; // Congestion
+    m_data.clear();
+    m_msg.setParam(s_error,"facility-rejected");
+    notify(false);
+}
+
 void YBTSSubmit::notify(bool final)
 {
     RefPointer<YBTSUE> ue = m_ue;
@@ -5956,8 +6783,8 @@ void YBTSMM::locUpdTerminated(uint64_t startTime, YBTSUE* ue, uint16_t connId,
 		    "UE (%p) registered TMSI '%s' -> '%s', IMSI '%s' -> '%s' conn=%u [%p]",
 		    ue,ue->tmsi().safe(),tmsi.c_str(),
 		    ue->imsi().safe(),imsi.safe(),connId,this);
-		ue->m_tmsi = tmsi;
-		ue->m_imsi = imsi;
+		ue->setTmsi(tmsi);
+		ue->setImsi(imsi);
 	    }
 	}
 	else {
@@ -5973,10 +6800,10 @@ void YBTSMM::locUpdTerminated(uint64_t startTime, YBTSUE* ue, uint16_t connId,
 	bool askIMSI = params.getBoolValue(YSTRING("askimsi"));
 	ue->m_askIMEI = params.getBoolValue(YSTRING("askimei"));
 	if (ue->m_askIMEI)
-	    ue->m_imei.clear();
+	    ue->setImei(String::empty());
 	if (askIMSI) {
-	    ue->m_imsi.clear();
-	    ue->m_tmsi.clear();
+	    ue->setImsi(String::empty());
+	    ue->setTmsi(String::empty());
 	    lckUE.drop();
 	    sendIdentityRequest(conn,YBTSConn::FAskIMSI);
 	    return;
@@ -6049,12 +6876,47 @@ bool YBTSMM::getUESafe(RefPointer<YBTSUE>& ue, const String& tmsi, const String&
 {
     if (!(tmsi || imsi || imei))
 	return false;
+    if (findUESafe(ue,tmsi,imsi,imei) || !create)
+	return ue != 0;
+    // UEs are added with list locked: check again, it might have been added meanwhile
     Lock lck(m_ueMutex);
-    for (ObjList* o = m_ues.skipNull(); o; o = o->skipNext()) {
+    if (findUESafe(ue,tmsi,imsi,imei))
+	return true;
+    YBTSUE* u = new YBTSUE(this,imsi,tmsi);
+    ue = u;
+    if (ue) {
+	Lock lckUE(u);
+	if (imei)
+	    u->m_imei = imei;
+	else
+	    u->m_askIMEI = s_askIMEI;
+	m_ues.insert(u)->setDelete(false);
+	indexUE(u);
+	Debug(this,DebugAll,"Added UE (%p) TMSI=%s IMSI=%s [%p]",
+	    u,tmsi.safe(),imsi.safe(),this);
+    }
+    TelEngine::destruct(u);
+    return ue != 0;
+}
+
+// Find UE by identities in indexes, fill its empty identities
+// Matching rules: TMSI and IMSI must match if both given and set in UE
+// TMSI or IMSI matched: IMEI must match if not empty
+// Otherwise: IMEI must be given and match (we MUST have something to match!!!)
+bool YBTSMM::findUESafe(RefPointer<YBTSUE>& ue, const String& tmsi, const String& imsi,
+    const String& imei)
+{
+    ue = 0;
+    // Any matching UE has at least one of the given identities
+    ObjList list;
+    m_index[UEIdentTmsi].find(list,tmsi);
+    m_index[UEIdentImsi].find(list,imsi);
+    m_index[UEIdentImei].find(list,imei);
+    for (ObjList* o = list.skipNull(); o; o = o->skipNext()) {
 	YBTSUE* u = static_cast<YBTSUE*>(o->get());
-	if (!u->alive())
-	    continue;
 	Lock lckUE(u);
+	if (!u->m_indexed)
+	    continue;
 	bool matched = false;
 	if (tmsi && u->tmsi()) {
 	    if (tmsi != u->tmsi())
@@ -6066,8 +6928,6 @@ bool YBTSMM::getUESafe(RefPointer<YBTSUE>& ue, const String& tmsi, const String&
 		continue;
 	    matched = true;
 	}
-	// TMSI or IMSI matched: IMEI must match if not empty
-	// Otherwise: IMEI must be given and match (we MUST have something to match!!!)
 	if (matched) {
 	    if (imei && u->imei() && imei != u->imei())
 		continue;
@@ -6078,28 +6938,14 @@ bool YBTSMM::getUESafe(RefPointer<YBTSUE>& ue, const String& tmsi, const String&
 	if (!ue)
 	    continue;
 	if (!ue->tmsi())
-	    ue->m_tmsi = tmsi;
+	    ue->setTmsi(tmsi);
 	if (!ue->imsi())
-	    ue->m_imsi = imsi;
+	    ue->setImsi(imsi);
 	if (!ue->imei())
-	    ue->m_imei = imei;
+	    ue->setImei(imei);
 	return true;
     }
-    if (!create)
-	return false;
-    YBTSUE* u = new YBTSUE(this,imsi,tmsi);
-    ue = u;
-    if (ue) {
-	if (imei)
-	    u->m_imei = imei;
-	else
-	    u->m_askIMEI = s_askIMEI;
-	m_ues.append(u)->setDelete(false);
-	Debug(this,DebugAll,"Added UE (%p) TMSI=%s IMSI=%s [%p]",
-	    u,tmsi.safe(),imsi.safe(),this);
-    }
-    TelEngine::destruct(u);
-    return ue != 0;
+    return false;
 }
 
 bool YBTSMM::createEmptyUE(RefPointer<YBTSUE>& ue)
@@ -6108,14 +6954,38 @@ bool YBTSMM::createEmptyUE(RefPointer<YBTSUE>& ue)
     ue = u;
     if (ue) {
 	Lock lck(m_ueMutex);
+	Lock lckUE(u);
 	u->m_askIMEI = s_askIMEI;
-	m_ues.append(u)->setDelete(false);
+	m_ues.insert(u)->setDelete(false);
+	indexUE(u);
 	Debug(this,DebugAll,"Added empty UE (%p) [%p]",u,this);
     }
     TelEngine::destruct(u);
     return ue != 0;
 }
 
+// Add UE identities to indexes. UE must be locked
+void YBTSMM::indexUE(YBTSUE* ue)
+{
+    m_index[UEIdentTmsi].add(ue->tmsi(),ue);
+    m_index[UEIdentImsi].add(ue->imsi(),ue);
+    m_index[UEIdentImei].add(ue->imei(),ue);
+    m_index[UEIdentPaging].add(ue->paging(),ue);
+    ue->m_indexed = true;
+}
+
+// Remove UE identities from indexes. UE must be locked
+void YBTSMM::unindexUE(YBTSUE* ue)
+{
+    if (!ue->m_indexed)
+	return;
+    ue->m_indexed = false;
+    m_index[UEIdentTmsi].remove(ue->tmsi(),ue);
+    m_index[UEIdentImsi].remove(ue->imsi(),ue);
+    m_index[UEIdentImei].remove(ue->imei(),ue);
+    m_index[UEIdentPaging].remove(ue->paging(),ue);
+}
+
 void YBTSMM::destruct()
 {
     m_ueMutex.lock();
@@ -6127,9 +6997,12 @@ void YBTSMM::destruct()
 	    if (!u->alive())
 		continue;
 	    Lock lckUE(u);
+	    u->m_indexed = false;
 	    u->m_mm = 0;
 	}
     }
+    for (unsigned int i = 0; i < UEIdentCount; i++)
+	m_index[i].clear();
     m_ueMutex.unlock();
     GenObject::destruct();
 }
@@ -6142,12 +7015,14 @@ void YBTSMM::removeUE(YBTSUE* ue, const char* reason)
     if (!(m_ues.remove(ue,false)))
 	return;
     lck.drop();
+    // Destroyed UEs are still in indexes: remove them before memory is released
+    lck.acquire(ue);
+    unindexUE(ue);
     if (!ue->alive()) {
 	Debug(this,DebugAll,"Removed UE (%p): %s [%p]",
 	    ue,reason,this);
 	return;
     }
-    lck.acquire(ue);
     ue->m_removed = true;
     ue->m_mm = 0;
     Debug(this,DebugAll,"Removed UE (%p) TMSI=%s IMSI=%s: %s [%p]",
@@ -6249,12 +7124,13 @@ bool YBTSMM::handlePagingResponse(YBTSMessage& m, YBTSConn* conn, XmlElement& rs
     }
     if (auth) {
 	YBTSConnAuthThread* th = new YBTSConnAuthThread(conn->connId(),ue,auth);
-	if (th->startup())
+	if (s_tasks.enqueue(th))
 	    return true;
-	delete th;
-	Debug(this,DebugNote,"Failed to start MT auth thread for conn=%u [%p]",
+	Debug(this,DebugNote,"Releasing conn=%u: congestion, can't queue MT auth [%p]",
 	    m.connId(),this);
-	conn = 0;
+	th->congestion();
+	delete th;
+	return true;
     }
     ue->stopPagingNow();
     if (conn && setConnUE(*conn,ue,rsp) != 0)
@@ -6295,7 +7171,7 @@ void YBTSMM::handleIdentityResponse(YBTSMessage& m, const XmlElement& xml, YBTSC
 	    return;
 	}
 	if (!ue->imsi()) {
-	    ue->m_imsi = ident;
+	    ue->setImsi(ident);
 	    Debug(this,DebugAll,"UE (%p) IMSI set to %s on conn=%u [%p]",
 		conn->ue(),ue->imsi().safe(),m.connId(),this);
 	}
@@ -6315,7 +7191,7 @@ void YBTSMM::handleIdentityResponse(YBTSMessage& m, const XmlElement& xml, YBTSC
 	    return;
 	}
 	type= YBTSConn::FAskIMEI;
-	ue->m_imei = ident;
+	ue->setImei(ident);
 	ue->m_askIMEI = false;
     }
     else {
@@ -6400,7 +7276,7 @@ void YBTSMM::handleLocationUpdate(YBTSMessage& m, const XmlElement* xml, YBTSCon
     }
     Lock lckUE(ue);
     if (ue->m_askIMEI) {
-	ue->m_imei.clear();
+	ue->setImei(String::empty());
 	lckUE.drop();
 	sendIdentityRequest(conn,YBTSConn::FAskIMEI);
 	return;
@@ -6408,15 +7284,15 @@ void YBTSMM::handleLocationUpdate(YBTSMessage& m, const XmlElement* xml, YBTSCon
     ue->m_imsiDetached = false;
     YBTSLocationUpd* th = new YBTSLocationUpd(*conn);
     lckUE.drop();
-    if (th->startup())
+    if (s_tasks.enqueue(th))
 	return;
-    delete th;
     ue->lock();
     Debug(this,DebugNote,
-	"Location updating for TMSI=%s IMSI=%s: failed to start thread [%p]",
+	"Location updating for TMSI=%s IMSI=%s: congestion [%p]",
 	ue->tmsi().safe(),ue->imsi().safe(),this);
     ue->unlock();
-    sendLocationUpdateReject(m,conn,CauseProtoError);
+    th->reject(CauseCongestion);
+    delete th;
 }
 
 // Handle location update (TMSI reallocation) complete
@@ -6610,13 +7486,12 @@ bool YBTSMM::findUEPagingSafe(RefPointer<YBTSUE>& ue, const String& paging)
 {
     if (!paging)
 	return false;
-    Lock lck(m_ueMutex);
-    for (ObjList* o = m_ues.skipNull(); o; o = o->skipNext()) {
+    ObjList list;
+    m_index[UEIdentPaging].find(list,paging);
+    for (ObjList* o = list.skipNull(); o; o = o->skipNext()) {
 	YBTSUE* u = static_cast<YBTSUE*>(o->get());
-	if (!u->alive())
-	    continue;
 	Lock lckUE(u);
-	if (paging == u->paging()) {
+	if (u->m_indexed && paging == u->paging()) {
 	    ue = u;
 	    return (ue != 0);
 	}
@@ -7479,12 +8354,15 @@ bool YBTSChan::startAuthThread()
 	if (!m)
 	    return false;
     }
-    m_authThread = new YBTSChanThread(*this,m);
-    if (m_authThread->startup())
+    YBTSChanThread* th = new YBTSChanThread(*this,m);
+    m_authThread = th;
+    if (s_tasks.enqueue(th))
 	return true;
-    delete m_authThread;
     m_authThread = 0;
-    Debug(this,DebugNote,"Failed to start auth thread [%p]",this);
+    Debug(this,DebugNote,"Failed to queue auth task: congestion [%p]",this);
+    th->cancelled();
+    delete th;
+    hangup("congestion");
     return false;
 }
 
@@ -7496,7 +8374,7 @@ void YBTSChan::cancelAuthThread()
     if (!m_authThread)
 	return;
     DDebug(this,DebugAll,"Cancelling auth thread [%p]",this);
-    m_authThread->cancel();
+    s_tasks.cancel(m_authThread);
     lck.drop();
     while (m_authThread && !Thread::check(false))
 	Thread::idle();
@@ -7794,12 +8672,13 @@ void YBTSChan::destroyed()
 // YBTSChanThread
 //
 YBTSChanThread::YBTSChanThread(YBTSChan& chan, Message* msg)
-    : Thread("YBTSChan"),
+    : YBTSTask("YBTSChan"),
     YBTSConnAuthMt(chan.connId(),0,
 	chan.isIncoming() ? YBTSConn::FMoCall : YBTSConn::FMtCall),
     m_chan(&chan),
     m_route(msg)
 {
+    setKey(m_conn ? m_conn->ue() : 0);
 }
 
 void YBTSChanThread::run()
@@ -7849,7 +8728,7 @@ void YBTSChanThread::run()
     }
 }
 
-void YBTSChanThread::notify(const char* error)
+void YBTSChanThread::notify(const char* error, bool cancelled)
 {
     TelEngine::destruct(m_route);
     RefPointer<YBTSChan> chan = m_chan;
@@ -7858,7 +8737,7 @@ void YBTSChanThread::notify(const char* error)
 	return;
     XDebug(chan,DebugAll,"Authentication thread terminated ref=%u [%p]",
 	chan->refcount(),(YBTSChan*)chan);
-    if (chan->isOutgoing() && !Thread::check(false)) {
+    if (!cancelled && chan->isOutgoing() && !Thread::check(false)) {
 	if (!error) {
 	    Lock lck(chan->m_mutex);
 	    if (!chan->m_hungup)
@@ -8525,6 +9404,16 @@ int YBTSDriver::havePagingMtService(YBTSUE* ue, bool call, bool sms, bool ussd)
     return 0;
 }
 
+void YBTSDriver::mtCongestion(YBTSUE* ue)
+{
+    RefPointer<YBTSChan> chan;
+    if (!(findChan(ue,chan) && chan->isOutgoing() && !chan->conn()))
+	return;
+    chan->stopPaging();
+    chan->hangup("congestion");
+    chan = 0;
+}
+
 // Handle media start/alloc response
 void YBTSDriver::handleMediaStartRsp(YBTSConn* conn, bool ok)
 {
@@ -9276,10 +10165,14 @@ void YBTSDriver::handleSmsCPData(YBTSMessage& m, YBTSConn* conn,
 	}
 	th->msg().addParam("rpdu",*rpdu);
 	conn->addPhyInfo(th->msg());
-	if (th->startup())
+	if (s_tasks.enqueue(th))
 	    return;
-	causeRp = 41; // Temporary failure
-	SMS_CPDATA_DONE_MILD("failed to start thread");
+	Debug(this,DebugMild,"Rejecting SMS CP-DATA conn=%u RP-Cause=42: congestion",
+	    conn->connId());
+	// Sends the RP-ERROR
+	th->cancelled();
+	delete th;
+	return;
 #undef SMS_CPDATA_DONE
 #undef SMS_CPDATA_DONE_MILD
     }
@@ -9742,11 +10635,13 @@ bool YBTSDriver::submitUssd(YBTSConn* conn, const String& callRef, const String&
 	th->msg().addParam("text",text);
 	textXml->copyAttributes(th->msg(),"text.");
 	exportXml(th->msg(),facilityXml);
-	if (th->startup())
+	if (s_tasks.enqueue(th))
 	    return true;
+	Debug(this,DebugNote,"Rejecting MO USSD on conn=%u: congestion",conn->connId());
+	// Releases the SS transaction
+	th->cancelled();
 	delete th;
-	reason = "failed to start routing thread";
-	break;
+	return false;
     }
     Debug(this,DebugNote,"Rejecting MO USSD on conn=%u: %s",conn->connId(),reason);
     NamedList p("");
@@ -10435,9 +11330,63 @@ void YBTSDriver::ybtsStatus(String& line, String& retVal)
     }
     lck.drop();
     retVal << ",state_time=" << (val ? ((Time::now() - val) / 1000000)  : 0);
+    s_tasks.status(retVal);
     retVal << "\r\n";
 }
 
+#ifdef DEBUG
+// Synthetic UE index benchmark
+// Register UEs in a private MM list, measure lookup time by each identity
+// Allocates a lot of memory: built only in debug builds, not for a running BTS
+static void ueBenchmark(String& retVal, unsigned int count)
+{
+    YBTSMM* mm = new YBTSMM;
+    mm->debugChain(0);
+    mm->debugEnabled(false);
+    YBTSUE** ues = new YBTSUE*[count];
+    unsigned int n = 0;
+    uint64_t t = Time::now();
+    for (; n < count; n++) {
+	String tmsi, imsi, imei;
+	tmsi.printf("%08x",n + 1);
+	imsi.printf("00101%010u",n);
+	imei.printf("35000000%07u",n);
+	RefPointer<YBTSUE> ue;
+	if (!(mm->getUESafe(ue,tmsi,imsi,imei) && ue->ref()))
+	    break;
+	ues[n] = ue;
+    }
+    t = Time::now() - t;
+    retVal << "registered=" << n << " time=" << (unsigned int)(t / 1000) << "ms\r\n";
+    static const char* s_ident[] = { "tmsi", "imsi", "imei" };
+    for (unsigned int i = 0; n && i < 3; i++) {
+	unsigned int found = 0;
+	t = Time::now();
+	// Scatter lookups over the whole list
+	for (unsigned int j = 0, k = 0; j < n; j++, k = (k + 7919) % n) {
+	    YBTSUE* u = ues[k];
+	    RefPointer<YBTSUE> ue;
+	    if (i == 0)
+		mm->getUESafe(ue,u->tmsi(),String::empty(),String::empty(),false);
+	    else if (i == 1)
+		mm->getUESafe(ue,String::empty(),u->imsi(),String::empty(),false);
+	    else
+		mm->getUESafe(ue,String::empty(),String::empty(),u->imei(),false);
+	    if ((YBTSUE*)ue == u)
+		found++;
+	}
+	t = Time::now() - t;
+	retVal << s_ident[i] << ": found=" << found << " lookup=" <<
+	    (unsigned int)(t * 1000 / n) << "ns\r\n";
+    }
+    // Release newest first: UEs are inserted at list head
+    while (n)
+	TelEngine::destruct(ues[--n]);
+    delete[] ues;
+    TelEngine::destruct(mm);
+}
+#endif
+
 static inline void addTout(String& dest, uint64_t toutUs, bool msec)
 {
     if (!toutUs)
@@ -10605,6 +11554,13 @@ void YBTSDriver::initialize()
 	YBTS_USSD_TIMEOUT_DEF,YBTS_USSD_TIMEOUT_MIN);
     s_gprsTimeout = ybts.getIntValue(YSTRING("gprs.timeout"),
 	YBTS_GPRS_TIMEOUT_DEF,YBTS_GPRS_TIMEOUT_MIN,YBTS_GPRS_TIMEOUT_MAX);
+    unsigned int workers = ybts.getIntValue(YSTRING("worker_threads"),
+	YBTS_WORKERS_DEF,YBTS_WORKERS_MIN,YBTS_WORKERS_MAX);
+    unsigned int queue = ybts.getIntValue(YSTRING("worker_queue"),
+	YBTS_TASK_QUEUE_DEF,YBTS_TASK_QUEUE_MIN,YBTS_TASK_QUEUE_MAX);
+    unsigned int wait = ybts.getIntValue(YSTRING("worker_queue_timeout"),
+	YBTS_TASK_WAIT_DEF,YBTS_TASK_WAIT_MIN,YBTS_TASK_WAIT_MAX);
+    s_tasks.setLimits(workers,queue,wait);
     const String& expXml = ybts[YSTRING("export_xml_as")];
     if (expXml == YSTRING("string"))
 	m_exportXml = -1;
@@ -10655,6 +11611,8 @@ void YBTSDriver::initialize()
     s << "\r\nt313=" << s_t313;
     s << "\r\nsms.timeout=" << s_mtSmsTimeout;
     s << "\r\nussd.session_timeout=" << s_ussdTimeout;
+    s << "\r\nworker_threads=" << workers;
+    s << "\r\nworker_queue=" << queue;
     s << "\r\npeer_cmd=" << s_peerCmd;
     s << "\r\npeer_arg=" << s_peerArg;
     s << "\r\npeer_dir=" << s_peerDir;
@@ -10921,13 +11879,21 @@ bool YBTSDriver::received(Message& msg, int id)
 	    break;
 	case Help:
 	    {
-		static const char s_ybtsHelp[] = "  ybts {start|stop|restart|status}\r\n";
+		static const char s_ybtsHelp[] = "  ybts {start|stop|restart|status"
+#ifdef DEBUG
+		    "|uebench [count]|sigbench [count]"
+#endif
+		    "}\r\n";
 		static const char s_mbtsHelp[] = "  " BTS_CMD " {commands...}\r\n";
 		const String& line = msg[YSTRING("line")];
 		if (line) {
 		    if (line == name()) {
 			msg.retValue() << s_ybtsHelp;
 			msg.retValue() << "Controls BTS operational state\r\n";
+#ifdef DEBUG
+			msg.retValue() << "uebench registers UEs in a private list and measures lookup time\r\n";
+			msg.retValue() << "sigbench measures signalling messages handled per second\r\n";
+#endif
 		    }
 		    else if (line == YSTRING(BTS_CMD)) {
 			msg.retValue() << s_mbtsHelp;
@@ -10963,6 +11929,12 @@ bool YBTSDriver::commandExecute(String& retVal, const String& line)
 	    cmdStartStop(true);
 	    restart(tmp.toInteger(1,0,0));
 	}
+#ifdef DEBUG
+	else if (tmp.startSkip(s_ueBenchCmd))
+	    ueBenchmark(retVal,tmp.toInteger(YBTS_UE_BENCH_DEF,0,1,10000000));
+	else if (tmp.startSkip(s_sigBenchCmd))
+	    YBTSSignalling::benchmark(retVal,tmp.toInteger(YBTS_SIG_BENCH_DEF,0,1,10000000));
+#endif
 	else
 	    return Driver::commandExecute(retVal,line);
 	return true;
@@ -10990,6 +11962,10 @@ bool YBTSDriver::commandComplete(Message& msg, const String& partLine, const Str
 	itemComplete(msg.retValue(),s_startCmd,partWord);
 	itemComplete(msg.retValue(),s_stopCmd,partWord);
 	itemComplete(msg.retValue(),s_restartCmd,partWord);
+#ifdef DEBUG
+	itemComplete(msg.retValue(),s_ueBenchCmd,partWord);
+	itemComplete(msg.retValue(),s_sigBenchCmd,partWord);
+#endif
     }
     else if (partLine == m_statusCmd || partLine == m_statusOverCmd) {
 	itemComplete(msg.retValue(),YSTRING("ue"),partWord);
@@ -74,6 +74,31 @@ enum BtsPrimitive {
     SigHeartbeat        = 255            // Heartbeat
 };
 
+// Physical channel information encoding (info octet of SigPhysicalInfo)
+// The binary encoding is used only if negotiated in handshake ("phyinfo=binary")
+enum BtsPhyInfoFormat {
+    PhyInfoText         = 0,             // Text: TA=... TE=... UpRSSI=...
+    PhyInfoBinary       = 1,             // Binary, see BtsPhyInfoField
+};
+
+// Octet offsets in binary physical channel information
+// Multi-octet fields are in network byte order
+// Media statistics are present only when a traffic channel receives speech
+enum BtsPhyInfoField {
+    PhyInfoTA           =   0,           // 1 octet: timing advance
+    PhyInfoTE           =   1,           // 2 octets: signed timing error (1/1000 symbol)
+    PhyInfoUpRSSI       =   3,           // 2 octets: signed uplink RSSI (dB)
+    PhyInfoTxPwr        =   5,           // 1 octet: signed MS power (dBm)
+    PhyInfoDnRSSI       =   6,           // 1 octet: signed downlink RXLEV (dBm)
+    PhyInfoTimeSec      =   7,           // 4 octets: measurement time seconds
+    PhyInfoTimeMsec     =  11,           // 2 octets: measurement time milliseconds
+    PhyInfoUpFrames     =  13,           // 4 octets: uplink speech frames
+    PhyInfoUpBadFrames  =  17,           // 4 octets: uplink bad speech frames
+    PhyInfoUpJitter     =  21,           // 2 octets: uplink jitter (1/10 ms)
+    PhyInfoBaseLen      =  13,           // Length without media statistics
+    PhyInfoMediaLen     =  23,           // Length with media statistics
+};
+
 // Paging channel types
 enum BtsPagingChanType {
     ChanTypeVoice  = 0,